@@ -321,6 +321,81 @@ Background Subtraction using Local SVD Binary Pattern. More details about the al
  */
 CV_EXPORTS_W Ptr<BackgroundSubtractorLSBP> createBackgroundSubtractorLSBP(int mc = LSBP_CAMERA_MOTION_COMPENSATION_NONE, int nSamples = 20, int LSBPRadius = 16, float Tlower = 2.0f, float Tupper = 32.0f, float Tinc = 1.0f, float Tdec = 0.05f, float Rscale = 10.0f, float Rincdec = 0.005f, float noiseRemovalThresholdFacBG = 0.0004f, float noiseRemovalThresholdFacFG = 0.0008f, int LSBPthreshold = 8, int minCount = 2);
 
+/** @brief Background subtraction of several independent streams at once.
+
+Every stream has its own background model. The frames of all the streams are processed together,
+so the work is distributed over the threads once per batch instead of once per stream, which pays off
+for many low-resolution streams.
+ */
+class CV_EXPORTS_W BackgroundSubtractorBatch : public Algorithm
+{
+public:
+    /** @brief Updates the background models of all the streams and computes their foreground masks.
+
+    @param images Next frame of every stream, images[i] belongs to stream i. The number of frames must be
+    equal to the number of streams. The frame size of a stream may change, its model is reinitialized then.
+    @param fgmasks Output foreground masks, one 8-bit binary image per stream.
+    @param learningRate The learning rate of all the streams, see BackgroundSubtractor::apply.
+     */
+    CV_WRAP virtual void apply(InputArrayOfArrays images, OutputArrayOfArrays fgmasks, double learningRate=-1) = 0;
+
+    /** @brief Computes the background image of a stream.
+
+    @param stream Index of the stream.
+    @param backgroundImage The output background image.
+     */
+    CV_WRAP virtual void getBackgroundImage(int stream, OutputArray backgroundImage) const = 0;
+
+    /** @brief Returns the number of streams.
+    */
+    CV_WRAP virtual int getNumStreams() const = 0;
+};
+
+/** @brief Creates a batch of Gaussian Mixture-based background subtractors.
+
+The models of all the streams are kept in a single allocation and the rows of all the streams are
+processed by one parallel loop. The result of every stream is the same as the one of
+BackgroundSubtractorMOG with the same parameters.
+
+@param nstreams Number of streams.
+@param history Length of the history.
+@param nmixtures Number of Gaussian mixtures.
+@param backgroundRatio Background ratio.
+@param noiseSigma Noise strength (standard deviation of the brightness or each color channel). 0
+means some automatic value.
+ */
+CV_EXPORTS_W Ptr<BackgroundSubtractorBatch>
+    createBackgroundSubtractorMOGBatch(int nstreams, int history=200, int nmixtures=5,
+                                       double backgroundRatio=0.7, double noiseSigma=0);
+
+/** @brief Creates a batch of CNT background subtractors.
+
+The models of all the streams are kept in a single allocation and the rows of all the streams are
+processed by one parallel loop. The result of every stream is the same as the one of
+BackgroundSubtractorCNT with the same parameters.
+
+@param nstreams Number of streams.
+@param minPixelStability number of frames with same pixel color to consider stable
+@param useHistory determines if we're giving a pixel credit for being stable for a long time
+@param maxPixelStability maximum allowed credit for a pixel in history
+ */
+CV_EXPORTS_W Ptr<BackgroundSubtractorBatch>
+    createBackgroundSubtractorCNTBatch(int nstreams, int minPixelStability = 15, bool useHistory = true,
+                                       int maxPixelStability = 15*60);
+
+/** @brief Creates a batch from existing background subtractors, one per stream.
+
+This works with any background subtractor, e.g. BackgroundSubtractorGMG, BackgroundSubtractorGSOC or
+BackgroundSubtractorLSBP. The streams are distributed over the threads. Whether the parallel loops of
+the subtractors themselves also run in parallel depends on the threading backend (e.g. TBB nests them),
+so subtractors drawing random numbers inside these loops, like GSOC and LSBP, are only reproducible
+with a single thread.
+
+@param subtractors The background subtractor of every stream. They must be distinct objects.
+ */
+CV_EXPORTS Ptr<BackgroundSubtractorBatch>
+    createBackgroundSubtractorBatch(const std::vector< Ptr<BackgroundSubtractor> >& subtractors);
+
 /** @brief Synthetic frame sequence generator for testing background subtraction algorithms.
 
  It will generate the moving object on top of the background.
@@ -0,0 +1,47 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+enum { BATCH_MOG, BATCH_CNT };
+CV_ENUM(BatchType, BATCH_MOG, BATCH_CNT)
+
+typedef tuple<BatchType, int> BatchParams;
+typedef TestBaseWithParam<BatchParams> BackgroundSubtractorBatchPerfTest;
+
+PERF_TEST_P(BackgroundSubtractorBatchPerfTest, apply,
+            Combine(BatchType::all(), Values(4, 16, 64)))
+{
+    const int batchType = get<0>(GetParam());
+    const int nstreams = get<1>(GetParam());
+    const Size sz(szQVGA);
+
+    const int nframes = 8;
+    vector<Mat> sequence;
+    generateBGFGSequence(sz, CV_8UC3, nframes, sequence);
+
+    Ptr<BackgroundSubtractorBatch> batch = batchType == BATCH_MOG ? createBackgroundSubtractorMOGBatch(nstreams)
+                                                                  : createBackgroundSubtractorCNTBatch(nstreams);
+    // the streams see the same sequence with different phases
+    vector< vector<Mat> > frames(nframes, vector<Mat>(nstreams));
+    for (int f = 0; f < nframes; f++)
+        for (int i = 0; i < nstreams; i++)
+            frames[f][i] = sequence[(f + i) % nframes];
+
+    vector<Mat> fgmasks;
+    for (int f = 0; f < nframes; f++)
+        batch->apply(frames[f], fgmasks);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        batch->apply(frames[frame], fgmasks);
+        frame = (frame + 1) % nframes;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
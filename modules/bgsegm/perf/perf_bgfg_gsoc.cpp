@@ -0,0 +1,70 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef TestBaseWithParam<Size> BackgroundSubtractorGSOCPerfTest;
+
+PERF_TEST_P(BackgroundSubtractorGSOCPerfTest, apply, Values(szQVGA, szVGA))
+{
+    Size sz = GetParam();
+
+    const int nframes = 8;
+    vector<Mat> frames;
+    generateBGFGSequence(sz, CV_8UC3, nframes, frames);
+
+    Ptr<BackgroundSubtractorGSOC> gsoc = createBackgroundSubtractorGSOC();
+    Mat fgmask;
+    for (int i = 0; i < nframes; i++)
+        gsoc->apply(frames[i], fgmask);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        gsoc->apply(frames[frame], fgmask);
+        frame = (frame + 1) % nframes;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+typedef TestBaseWithParam<Size> BackgroundSubtractorLSBPPerfTest;
+
+PERF_TEST_P(BackgroundSubtractorLSBPPerfTest, apply, Values(szQVGA, szVGA))
+{
+    Size sz = GetParam();
+
+    const int nframes = 8;
+    vector<Mat> frames;
+    generateBGFGSequence(sz, CV_8UC3, nframes, frames);
+
+    Ptr<BackgroundSubtractorLSBP> lsbp = createBackgroundSubtractorLSBP();
+    Mat fgmask;
+    for (int i = 0; i < nframes; i++)
+        lsbp->apply(frames[i], fgmask);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        lsbp->apply(frames[frame], fgmask);
+        frame = (frame + 1) % nframes;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(BackgroundSubtractorLSBPPerfTest, calcLocalSVDValues, Values(szVGA, sz1080p))
+{
+    Size sz = GetParam();
+
+    Mat frame(sz, CV_32FC3), localSVDValues;
+    declare.in(frame, WARMUP_RNG);
+
+    TEST_CYCLE() BackgroundSubtractorLSBPDesc::calcLocalSVDValues(localSVDValues, frame);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
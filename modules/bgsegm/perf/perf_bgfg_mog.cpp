@@ -0,0 +1,36 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<Size, int> MOGParams;
+typedef TestBaseWithParam<MOGParams> BackgroundSubtractorMOGPerfTest;
+
+PERF_TEST_P(BackgroundSubtractorMOGPerfTest, apply,
+            Combine(Values(szVGA, sz720p), Values(CV_8UC1, CV_8UC3)))
+{
+    Size sz = get<0>(GetParam());
+    int type = get<1>(GetParam());
+
+    const int nframes = 16;
+    vector<Mat> frames;
+    generateBGFGSequence(sz, type, nframes, frames);
+
+    Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+    Mat fgmask;
+    for (int i = 0; i < nframes; i++)
+        mog->apply(frames[i], fgmask);
+
+    int frame = 0;
+    TEST_CYCLE()
+    {
+        mog->apply(frames[frame], fgmask);
+        frame = (frame + 1) % nframes;
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
@@ -0,0 +1,36 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#ifndef __OPENCV_PERF_PRECOMP_HPP__
+#define __OPENCV_PERF_PRECOMP_HPP__
+
+#include "opencv2/ts.hpp"
+#include "opencv2/imgproc.hpp"
+#include "opencv2/bgsegm.hpp"
+
+namespace opencv_test {
+using namespace perf;
+using namespace cv::bgsegm;
+
+// Static noisy background with a bright rectangle moving across it
+inline void generateBGFGSequence(Size sz, int type, int nframes, vector<Mat>& frames)
+{
+    RNG rng(0);
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 256);
+    GaussianBlur(background, background, Size(7, 7), 3.0);
+
+    frames.resize(nframes);
+    for (int i = 0; i < nframes; i++)
+    {
+        Mat noise(sz, type);
+        rng.fill(noise, RNG::NORMAL, 0, 4);
+        add(background, noise, frames[i]);
+        Rect object(i * sz.width / (2 * nframes), sz.height / 4, sz.width / 4, sz.height / 4);
+        rectangle(frames[i], object, Scalar::all(255), FILLED);
+    }
+}
+
+}
+
+#endif
@@ -0,0 +1,72 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "precomp.hpp"
+
+namespace cv
+{
+namespace bgsegm
+{
+
+// Batch of arbitrary background subtractors: every stream is one task of the parallel loop
+class BackgroundSubtractorBatchImpl CV_FINAL : public BackgroundSubtractorBatch
+{
+public:
+    BackgroundSubtractorBatchImpl(const std::vector< Ptr<BackgroundSubtractor> >& _subtractors)
+        : subtractors(_subtractors)
+    {
+        CV_Assert(!subtractors.empty());
+        for (size_t i = 0; i < subtractors.size(); ++i)
+        {
+            CV_Assert(!subtractors[i].empty());
+            for (size_t j = 0; j < i; ++j)
+                CV_Assert(subtractors[i] != subtractors[j]);
+        }
+    }
+
+    virtual void apply(InputArrayOfArrays _images, OutputArrayOfArrays _fgmasks, double learningRate) CV_OVERRIDE
+    {
+        std::vector<Mat> images;
+        _images.getMatVector(images);
+        const int n = (int)subtractors.size();
+        CV_Assert((int)images.size() == n);
+
+        // the subtractors write their masks directly to the outputs
+        _fgmasks.create(n, 1, CV_8U);
+        std::vector<Mat> fgmasks(n);
+        for (int i = 0; i < n; ++i)
+        {
+            _fgmasks.create(images[i].size(), CV_8U, i);
+            fgmasks[i] = _fgmasks.getMat(i);
+        }
+
+        parallel_for_(Range(0, n), [&](const Range& range)
+        {
+            for (int i = range.start; i < range.end; ++i)
+                subtractors[i]->apply(images[i], fgmasks[i], learningRate);
+        }, n);
+    }
+
+    virtual void getBackgroundImage(int stream, OutputArray backgroundImage) const CV_OVERRIDE
+    {
+        CV_Assert(stream >= 0 && stream < (int)subtractors.size());
+        subtractors[stream]->getBackgroundImage(backgroundImage);
+    }
+
+    virtual int getNumStreams() const CV_OVERRIDE
+    {
+        return (int)subtractors.size();
+    }
+
+private:
+    std::vector< Ptr<BackgroundSubtractor> > subtractors;
+};
+
+Ptr<BackgroundSubtractorBatch> createBackgroundSubtractorBatch(const std::vector< Ptr<BackgroundSubtractor> >& subtractors)
+{
+    return makePtr<BackgroundSubtractorBatchImpl>(subtractors);
+}
+
+}
+}
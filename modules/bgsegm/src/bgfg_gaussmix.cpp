@@ -41,6 +41,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <float.h>
 
 // to make sure we can use these short names
@@ -77,6 +78,7 @@ public:
     {
         frameSize = Size(0,0);
         frameType = 0;
+        modelMixtures = 0;
 
         nframes = 0;
         nmixtures = defaultNMixtures;
@@ -92,6 +94,7 @@ public:
     {
         frameSize = Size(0,0);
         frameType = 0;
+        modelMixtures = 0;
 
         nframes = 0;
         nmixtures = std::min(_nmixtures > 0 ? _nmixtures : defaultNMixtures, 8);
@@ -117,8 +120,10 @@ public:
         // for each gaussian mixture of each pixel bg model we store ...
         // the mixture sort key (w/sum_of_variances), the mixture weight (w),
         // the mean (nchannels values) and
-        // the diagonal covariance matrix (another nchannels values)
-        bgmodel.create( 1, frameSize.height*frameSize.width*nmixtures*(2 + 2*nchannels), CV_32F );
+        // the diagonal covariance matrix (another nchannels values).
+        // Each row of the model holds the mixtures of one image row, see mixtureBlockSize().
+        modelMixtures = nmixtures;
+        bgmodel.create( frameSize.height, frameSize.width*mixtureBlockSize(nmixtures, nchannels), CV_32F );
         bgmodel = Scalar::all(0);
     }
 
@@ -161,6 +166,7 @@ protected:
     Size frameSize;
     int frameType;
     Mat bgmodel;
+    int modelMixtures;
     int nframes;
     int history;
     int nmixtures;
@@ -171,276 +177,195 @@ protected:
 };
 
 
-template<typename VT> struct MixData
+// Each pixel owns a block of mixtures stored as separate arrays:
+// sortKey[Kp], weight[Kp], mean[cn][Kp], var[cn][Kp],
+// where Kp is the number of mixtures rounded up to the SIMD width.
+// The padding mixtures keep a zero weight and are never used.
+static inline int mixturePitch(int nmixtures)
 {
-    float sortKey;
-    float weight;
-    VT mean;
-    VT var;
-};
-
+    return alignSize(nmixtures, 4);
+}
 
-static void process8uC1( const Mat& image, Mat& fgmask, double learningRate,
-                         Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+static inline int mixtureBlockSize(int nmixtures, int nchannels)
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
-    float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
-    int K = nmixtures;
-    MixData<float>* mptr = (MixData<float>*)bgmodel.data;
+    return mixturePitch(nmixtures)*(2 + 2*nchannels);
+}
 
-    const float w0 = (float)defaultInitialWeight;
-    const float sk0 = (float)(w0/(defaultNoiseSigma*2));
-    const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
-    const float minVar = (float)(noiseSigma*noiseSigma);
+static inline void swapMixtures(float* m, int Kp, int cn, int k0, int k1)
+{
+    for( int i = 0; i < 2 + 2*cn; i++, m += Kp )
+        std::swap(m[k0], m[k1]);
+}
 
-    for( y = 0; y < rows; y++ )
+// Returns the index of the first mixture that either has a negligible weight
+// or matches the pixel, K if there is no such mixture
+template<int cn> static inline int findMixture( const float* m, const float* pix, int K, int Kp, float vT )
+{
+    const float* weight = m + Kp;
+    const float* mean = m + 2*Kp;
+    const float* var = mean + cn*Kp;
+    int k = 0;
+#if CV_SIMD128
+    const v_float32x4 eps = v_setall_f32(FLT_EPSILON), vvT = v_setall_f32(vT);
+    for( ; k < K; k += v_float32x4::nlanes )
     {
-        const uchar* src = image.ptr<uchar>(y);
-        uchar* dst = fgmask.ptr<uchar>(y);
-
-        if( alpha > 0 )
+        v_float32x4 d2 = v_setzero_f32(), vsum = v_setzero_f32();
+        for( int c = 0; c < cn; c++ )
         {
-            for( x = 0; x < cols; x++, mptr += K )
-            {
-                float wsum = 0;
-                float pix = src[x];
-                int kHit = -1, kForeground = -1;
-
-                for( k = 0; k < K; k++ )
-                {
-                    float w = mptr[k].weight;
-                    wsum += w;
-                    if( w < FLT_EPSILON )
-                        break;
-                    float mu = mptr[k].mean;
-                    float var = mptr[k].var;
-                    float diff = pix - mu;
-                    float d2 = diff*diff;
-                    if( d2 < vT*var )
-                    {
-                        wsum -= w;
-                        float dw = alpha*(1.f - w);
-                        mptr[k].weight = w + dw;
-                        mptr[k].mean = mu + alpha*diff;
-                        var = std::max(var + alpha*(d2 - var), minVar);
-                        mptr[k].var = var;
-                        mptr[k].sortKey = w/std::sqrt(var);
-
-                        for( k1 = k-1; k1 >= 0; k1-- )
-                        {
-                            if( mptr[k1].sortKey >= mptr[k1+1].sortKey )
-                                break;
-                            std::swap( mptr[k1], mptr[k1+1] );
-                        }
-
-                        kHit = k1+1;
-                        break;
-                    }
-                }
-
-                if( kHit < 0 ) // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
-                {
-                    kHit = k = std::min(k, K-1);
-                    wsum += w0 - mptr[k].weight;
-                    mptr[k].weight = w0;
-                    mptr[k].mean = pix;
-                    mptr[k].var = var0;
-                    mptr[k].sortKey = sk0;
-                }
-                else
-                    for( ; k < K; k++ )
-                        wsum += mptr[k].weight;
-
-                float wscale = 1.f/wsum;
-                wsum = 0;
-                for( k = 0; k < K; k++ )
-                {
-                    wsum += mptr[k].weight *= wscale;
-                    mptr[k].sortKey *= wscale;
-                    if( wsum > T && kForeground < 0 )
-                        kForeground = k+1;
-                }
-
-                dst[x] = (uchar)(-(kHit >= kForeground));
-            }
+            v_float32x4 diff = v_setall_f32(pix[c]) - v_load(mean + c*Kp + k);
+            d2 += diff*diff;
+            vsum += v_load(var + c*Kp + k);
         }
-        else
+        int mask = v_signmask((v_load(weight + k) < eps) | (d2 < vvT*vsum));
+        if( mask )
+            return std::min(k + (int)trailingZeros32((unsigned)mask), K);
+    }
+    return K;
+#else
+    for( ; k < K; k++ )
+    {
+        if( weight[k] < FLT_EPSILON )
+            break;
+        float d2 = 0, vsum = 0;
+        for( int c = 0; c < cn; c++ )
         {
-            for( x = 0; x < cols; x++, mptr += K )
-            {
-                float pix = src[x];
-                int kHit = -1, kForeground = -1;
-
-                for( k = 0; k < K; k++ )
-                {
-                    if( mptr[k].weight < FLT_EPSILON )
-                        break;
-                    float mu = mptr[k].mean;
-                    float var = mptr[k].var;
-                    float diff = pix - mu;
-                    float d2 = diff*diff;
-                    if( d2 < vT*var )
-                    {
-                        kHit = k;
-                        break;
-                    }
-                }
-
-                if( kHit >= 0 )
-                {
-                    float wsum = 0;
-                    for( k = 0; k < K; k++ )
-                    {
-                        wsum += mptr[k].weight;
-                        if( wsum > T )
-                        {
-                            kForeground = k+1;
-                            break;
-                        }
-                    }
-                }
-
-                dst[x] = (uchar)(kHit < 0 || kHit >= kForeground ? 255 : 0);
-            }
+            float diff = pix[c] - mean[c*Kp + k];
+            d2 += diff*diff;
+            vsum += var[c*Kp + k];
         }
+        if( d2 < vT*vsum )
+            break;
     }
+    return k;
+#endif
 }
 
-
-static void process8uC3( const Mat& image, Mat& fgmask, double learningRate,
-                         Mat& bgmodel, int nmixtures, double backgroundRatio,
-                         double varThreshold, double noiseSigma )
+template<int cn> static void processRow( const uchar* src, uchar* dst, float* mptr, int cols,
+                                         float alpha, int K, float T, float vT, float minVar )
 {
-    int x, y, k, k1, rows = image.rows, cols = image.cols;
-    float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
-    int K = nmixtures;
-
+    const int Kp = mixturePitch(K), blockSize = mixtureBlockSize(K, cn);
     const float w0 = (float)defaultInitialWeight;
-    const float sk0 = (float)(w0/(defaultNoiseSigma*2*std::sqrt(3.)));
+    const float sk0 = (float)(w0/(defaultNoiseSigma*2*std::sqrt((double)cn)));
     const float var0 = (float)(defaultNoiseSigma*defaultNoiseSigma*4);
-    const float minVar = (float)(noiseSigma*noiseSigma);
-    MixData<Vec3f>* mptr = (MixData<Vec3f>*)bgmodel.data;
 
-    for( y = 0; y < rows; y++ )
+    for( int x = 0; x < cols; x++, src += cn, mptr += blockSize )
     {
-        const uchar* src = image.ptr<uchar>(y);
-        uchar* dst = fgmask.ptr<uchar>(y);
+        float* sortKey = mptr;
+        float* weight = mptr + Kp;
+        float* mean = mptr + 2*Kp;
+        float* var = mean + cn*Kp;
+        float pix[cn];
+        for( int c = 0; c < cn; c++ )
+            pix[c] = src[c];
+
+        int k = findMixture<cn>(mptr, pix, K, Kp, vT);
+        bool hit = k < K && weight[k] >= FLT_EPSILON;
+        int kHit = -1, kForeground = -1;
 
         if( alpha > 0 )
         {
-            for( x = 0; x < cols; x++, mptr += K )
-            {
-                float wsum = 0;
-                Vec3f pix(src[x*3], src[x*3+1], src[x*3+2]);
-                int kHit = -1, kForeground = -1;
+            float wsum = 0;
+            int k1;
+            for( k1 = 0; k1 < std::min(k + 1, K); k1++ )
+                wsum += weight[k1];
 
-                for( k = 0; k < K; k++ )
+            if( hit )
+            {
+                float w = weight[k];
+                wsum -= w;
+                weight[k] = w + alpha*(1.f - w);
+                float vsum = 0;
+                for( int c = 0; c < cn; c++ )
                 {
-                    float w = mptr[k].weight;
-                    wsum += w;
-                    if( w < FLT_EPSILON )
-                        break;
-                    Vec3f mu = mptr[k].mean;
-                    Vec3f var = mptr[k].var;
-                    Vec3f diff = pix - mu;
-                    float d2 = diff.dot(diff);
-                    if( d2 < vT*(var[0] + var[1] + var[2]) )
-                    {
-                        wsum -= w;
-                        float dw = alpha*(1.f - w);
-                        mptr[k].weight = w + dw;
-                        mptr[k].mean = mu + alpha*diff;
-                        var = Vec3f(std::max(var[0] + alpha*(diff[0]*diff[0] - var[0]), minVar),
-                                    std::max(var[1] + alpha*(diff[1]*diff[1] - var[1]), minVar),
-                                    std::max(var[2] + alpha*(diff[2]*diff[2] - var[2]), minVar));
-                        mptr[k].var = var;
-                        mptr[k].sortKey = w/std::sqrt(var[0] + var[1] + var[2]);
-
-                        for( k1 = k-1; k1 >= 0; k1-- )
-                        {
-                            if( mptr[k1].sortKey >= mptr[k1+1].sortKey )
-                                break;
-                            std::swap( mptr[k1], mptr[k1+1] );
-                        }
-
-                        kHit = k1+1;
-                        break;
-                    }
+                    float diff = pix[c] - mean[c*Kp + k];
+                    float v = var[c*Kp + k];
+                    mean[c*Kp + k] += alpha*diff;
+                    v = std::max(v + alpha*(diff*diff - v), minVar);
+                    var[c*Kp + k] = v;
+                    vsum += v;
                 }
+                sortKey[k] = w/std::sqrt(vsum);
 
-                if( kHit < 0 ) // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
+                for( k1 = k-1; k1 >= 0; k1-- )
                 {
-                    kHit = k = std::min(k, K-1);
-                    wsum += w0 - mptr[k].weight;
-                    mptr[k].weight = w0;
-                    mptr[k].mean = pix;
-                    mptr[k].var = Vec3f(var0, var0, var0);
-                    mptr[k].sortKey = sk0;
+                    if( sortKey[k1] >= sortKey[k1+1] )
+                        break;
+                    swapMixtures(mptr, Kp, cn, k1, k1+1);
                 }
-                else
-                    for( ; k < K; k++ )
-                        wsum += mptr[k].weight;
 
-                float wscale = 1.f/wsum;
-                wsum = 0;
-                for( k = 0; k < K; k++ )
+                kHit = k1+1;
+                for( ; k < K; k++ )
+                    wsum += weight[k];
+            }
+            else // no appropriate gaussian mixture found at all, remove the weakest mixture and create a new one
+            {
+                kHit = k = std::min(k, K-1);
+                wsum += w0 - weight[k];
+                weight[k] = w0;
+                for( int c = 0; c < cn; c++ )
                 {
-                    wsum += mptr[k].weight *= wscale;
-                    mptr[k].sortKey *= wscale;
-                    if( wsum > T && kForeground < 0 )
-                        kForeground = k+1;
+                    mean[c*Kp + k] = pix[c];
+                    var[c*Kp + k] = var0;
                 }
+                sortKey[k] = sk0;
+            }
 
-                dst[x] = (uchar)(-(kHit >= kForeground));
+            float wscale = 1.f/wsum;
+            wsum = 0;
+            for( k = 0; k < K; k++ )
+            {
+                wsum += weight[k] *= wscale;
+                sortKey[k] *= wscale;
+                if( wsum > T && kForeground < 0 )
+                    kForeground = k+1;
             }
+
+            dst[x] = (uchar)(-(kHit >= kForeground));
         }
         else
         {
-            for( x = 0; x < cols; x++, mptr += K )
+            if( hit )
             {
-                Vec3f pix(src[x*3], src[x*3+1], src[x*3+2]);
-                int kHit = -1, kForeground = -1;
-
+                kHit = k;
+                float wsum = 0;
                 for( k = 0; k < K; k++ )
                 {
-                    if( mptr[k].weight < FLT_EPSILON )
-                        break;
-                    Vec3f mu = mptr[k].mean;
-                    Vec3f var = mptr[k].var;
-                    Vec3f diff = pix - mu;
-                    float d2 = diff.dot(diff);
-                    if( d2 < vT*(var[0] + var[1] + var[2]) )
+                    wsum += weight[k];
+                    if( wsum > T )
                     {
-                        kHit = k;
+                        kForeground = k+1;
                         break;
                     }
                 }
-
-                if( kHit >= 0 )
-                {
-                    float wsum = 0;
-                    for( k = 0; k < K; k++ )
-                    {
-                        wsum += mptr[k].weight;
-                        if( wsum > T )
-                        {
-                            kForeground = k+1;
-                            break;
-                        }
-                    }
-                }
-
-                dst[x] = (uchar)(kHit < 0 || kHit >= kForeground ? 255 : 0);
             }
+
+            dst[x] = (uchar)(kHit < 0 || kHit >= kForeground ? 255 : 0);
         }
     }
 }
 
+template<int cn> static void process8u( const Mat& image, Mat& fgmask, double learningRate,
+                                        Mat& bgmodel, int nmixtures, double backgroundRatio,
+                                        double varThreshold, double noiseSigma )
+{
+    const float alpha = (float)learningRate, T = (float)backgroundRatio, vT = (float)varThreshold;
+    const float minVar = (float)(noiseSigma*noiseSigma);
+    const int cols = image.cols;
+
+    // every row of the image owns the corresponding row of the model
+    parallel_for_(Range(0, image.rows), [&](const Range& range)
+    {
+        for( int y = range.start; y < range.end; y++ )
+            processRow<cn>(image.ptr<uchar>(y), fgmask.ptr<uchar>(y), bgmodel.ptr<float>(y),
+                           cols, alpha, nmixtures, T, vT, minVar);
+    }, image.total()/(double)(1<<16));
+}
+
 void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask, double learningRate)
 {
     Mat image = _image.getMat();
-    bool needToInitialize = nframes == 0 || learningRate >= 1 || image.size() != frameSize || image.type() != frameType;
+    bool needToInitialize = nframes == 0 || learningRate >= 1 || image.size() != frameSize || image.type() != frameType ||
+                            nmixtures != modelMixtures;
 
     if( needToInitialize )
         initialize(image.size(), image.type());
@@ -454,9 +379,9 @@ void BackgroundSubtractorMOGImpl::apply(InputArray _image, OutputArray _fgmask,
     CV_Assert(learningRate >= 0);
 
     if( image.type() == CV_8UC1 )
-        process8uC1( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
+        process8u<1>( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
     else if( image.type() == CV_8UC3 )
-        process8uC3( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
+        process8u<3>( image, fgmask, learningRate, bgmodel, nmixtures, backgroundRatio, varThreshold, noiseSigma );
     else
         CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
 }
@@ -467,6 +392,163 @@ Ptr<BackgroundSubtractorMOG> createBackgroundSubtractorMOG(int history, int nmix
     return makePtr<BackgroundSubtractorMOGImpl>(history, nmixtures, backgroundRatio, noiseSigma);
 }
 
+// Number of image rows processed by one task of the batched subtractor
+static const int MOG_BATCH_BAND_ROWS = 16;
+
+class BackgroundSubtractorMOGBatchImpl CV_FINAL : public BackgroundSubtractorBatch
+{
+public:
+    BackgroundSubtractorMOGBatchImpl(int _nstreams, int _history, int _nmixtures, double _backgroundRatio, double _noiseSigma)
+    {
+        CV_Assert( _nstreams > 0 );
+        streams.resize(_nstreams);
+        // same parameters as BackgroundSubtractorMOGImpl
+        nmixtures = std::min(_nmixtures > 0 ? _nmixtures : defaultNMixtures, 8);
+        history = _history > 0 ? _history : defaultHistory;
+        varThreshold = defaultVarThreshold;
+        backgroundRatio = std::min(_backgroundRatio > 0 ? _backgroundRatio : 0.95, 1.);
+        noiseSigma = _noiseSigma <= 0 ? defaultNoiseSigma : _noiseSigma;
+    }
+
+    virtual void apply(InputArrayOfArrays images, OutputArrayOfArrays fgmasks, double learningRate=-1) CV_OVERRIDE;
+
+    virtual void getBackgroundImage(int, OutputArray) const CV_OVERRIDE
+    {
+        CV_Error( Error::StsNotImplemented, "" );
+    }
+
+    virtual int getNumStreams() const CV_OVERRIDE { return (int)streams.size(); }
+
+protected:
+    struct Stream
+    {
+        Stream() : frameSize(0, 0), frameType(0), nframes(0), offset(0) {}
+
+        Size frameSize;
+        int frameType;
+        int nframes;
+        size_t offset; //!< offset of the model in the pool
+    };
+
+    size_t modelSize(const Stream& s) const
+    {
+        return (size_t)s.frameSize.area()*mixtureBlockSize(nmixtures, CV_MAT_CN(s.frameType));
+    }
+
+    // Moves the models to a new pool which fits the current frame sizes of the streams
+    void reallocate(const std::vector<bool>& changed);
+
+    std::vector<Stream> streams;
+    std::vector<float> pool; //!< models of all the streams
+    int history;
+    int nmixtures;
+    double varThreshold;
+    double backgroundRatio;
+    double noiseSigma;
+};
+
+void BackgroundSubtractorMOGBatchImpl::reallocate(const std::vector<bool>& changed)
+{
+    size_t total = 0;
+    for( size_t i = 0; i < streams.size(); i++ )
+        total += modelSize(streams[i]);
+
+    std::vector<float> newPool(total, 0.f);
+    size_t offset = 0;
+    for( size_t i = 0; i < streams.size(); i++ )
+    {
+        Stream& s = streams[i];
+        size_t size = modelSize(s);
+        if( !changed[i] )
+            std::copy(pool.begin() + s.offset, pool.begin() + s.offset + size, newPool.begin() + offset);
+        s.offset = offset;
+        offset += size;
+    }
+    pool.swap(newPool);
+}
+
+void BackgroundSubtractorMOGBatchImpl::apply(InputArrayOfArrays _images, OutputArrayOfArrays _fgmasks, double learningRate)
+{
+    std::vector<Mat> images;
+    _images.getMatVector(images);
+    const int n = (int)streams.size();
+    CV_Assert( (int)images.size() == n );
+
+    std::vector<bool> changed(n, false);
+    bool anyChanged = false;
+    for( int i = 0; i < n; i++ )
+    {
+        const Mat& image = images[i];
+        if( image.type() != CV_8UC1 && image.type() != CV_8UC3 )
+            CV_Error( Error::StsUnsupportedFormat, "Only 1- and 3-channel 8-bit images are supported in BackgroundSubtractorMOG" );
+        Stream& s = streams[i];
+        if( image.size() != s.frameSize || image.type() != s.frameType )
+        {
+            s.frameSize = image.size();
+            s.frameType = image.type();
+            s.nframes = 0;
+            changed[i] = anyChanged = true;
+        }
+    }
+    if( anyChanged )
+        reallocate(changed);
+
+    _fgmasks.create(n, 1, CV_8U);
+    std::vector<Mat> fgmasks(n);
+    std::vector<float> alphas(n);
+    std::vector<Vec2i> tasks; // (stream, first row)
+    for( int i = 0; i < n; i++ )
+    {
+        Stream& s = streams[i];
+        if( s.nframes == 0 || learningRate >= 1 )
+        {
+            s.nframes = 0;
+            std::fill(pool.begin() + s.offset, pool.begin() + s.offset + modelSize(s), 0.f);
+        }
+
+        _fgmasks.create(s.frameSize, CV_8U, i);
+        fgmasks[i] = _fgmasks.getMat(i);
+
+        ++s.nframes;
+        double rate = learningRate >= 0 && s.nframes > 1 ? learningRate : 1./std::min( s.nframes, history );
+        CV_Assert(rate >= 0);
+        alphas[i] = (float)rate;
+
+        for( int y = 0; y < s.frameSize.height; y += MOG_BATCH_BAND_ROWS )
+            tasks.push_back(Vec2i(i, y));
+    }
+
+    const float T = (float)backgroundRatio, vT = (float)varThreshold;
+    const float minVar = (float)(noiseSigma*noiseSigma);
+
+    parallel_for_(Range(0, (int)tasks.size()), [&](const Range& range)
+    {
+        for( int t = range.start; t < range.end; t++ )
+        {
+            const int i = tasks[t][0];
+            const Stream& s = streams[i];
+            const Mat& image = images[i];
+            const int cols = s.frameSize.width, cn = image.channels();
+            const size_t rowSize = (size_t)cols*mixtureBlockSize(nmixtures, cn);
+            const int yEnd = std::min(tasks[t][1] + MOG_BATCH_BAND_ROWS, s.frameSize.height);
+            for( int y = tasks[t][1]; y < yEnd; y++ )
+            {
+                float* model = &pool[s.offset + y*rowSize];
+                if( cn == 1 )
+                    processRow<1>(image.ptr<uchar>(y), fgmasks[i].ptr<uchar>(y), model, cols, alphas[i], nmixtures, T, vT, minVar);
+                else
+                    processRow<3>(image.ptr<uchar>(y), fgmasks[i].ptr<uchar>(y), model, cols, alphas[i], nmixtures, T, vT, minVar);
+            }
+        }
+    });
+}
+
+Ptr<BackgroundSubtractorBatch> createBackgroundSubtractorMOGBatch(int nstreams, int history, int nmixtures,
+                                                                  double backgroundRatio, double noiseSigma)
+{
+    return makePtr<BackgroundSubtractorMOGBatchImpl>(nstreams, history, nmixtures, backgroundRatio, noiseSigma);
+}
+
 }
 }
 
@@ -53,6 +53,7 @@
 #include <opencv2/calib3d.hpp>
 #include <iostream>
 #include "opencv2/core/cvdef.h"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv
 {
@@ -81,38 +82,42 @@ inline int LSBPDist32(unsigned n) {
 #endif
 }
 
-inline float L2sqdist(const Point3f& a) {
-    return a.dot(a);
-}
-
-inline float L1dist(const Point3f& a) {
-    return std::abs(a.x) + std::abs(a.y) + std::abs(a.z);
-}
-
 inline float det3x3(float a11, float a12, float a13, float a22, float a23, float a33) {
     return a11 * (a22 * a33 - a23 * a23) + a12 * (2 * a13 * a23 - a33 * a12) - a13 * a13 * a22;
 }
 
-inline float localSVD(float a11, float a12, float a13, float a21, float a22, float a23, float a31, float a32, float a33) {
+// The singular values of the 3x3 neighbourhood A are the square roots of the eigenvalues of A*A^T,
+// which are found in closed form. localSVDCoeffs() computes the mean eigenvalue q, the scale p
+// of the deviatoric part and the normalized determinant r, localSVDFinish() solves the cubic.
+inline void localSVDCoeffs(float a11, float a12, float a13, float a21, float a22, float a23, float a31, float a32, float a33,
+                           float& q, float& p, float& r) {
     float b11 = a11 * a11 + a12 * a12 + a13 * a13;
     float b12 = a11 * a21 + a12 * a22 + a13 * a23;
     float b13 = a11 * a31 + a12 * a32 + a13 * a33;
     float b22 = a21 * a21 + a22 * a22 + a23 * a23;
     float b23 = a21 * a31 + a22 * a32 + a23 * a33;
     float b33 = a31 * a31 + a32 * a32 + a33 * a33;
-    const float q = (b11 + b22 + b33) / 3;
+    q = (b11 + b22 + b33) / 3;
 
     b11 -= q;
     b22 -= q;
     b33 -= q;
 
-    float p = std::sqrt((b11 * b11 + b22 * b22 + b33 * b33 + 2 * (b12 * b12 + b13 * b13 + b23 * b23)) / 6);
+    p = std::sqrt((b11 * b11 + b22 * b22 + b33 * b33 + 2 * (b12 * b12 + b13 * b13 + b23 * b23)) / 6);
+
+    if (p == 0) {
+        r = 0;
+        return;
+    }
+
+    const float pi = 1 / p;
+    r = det3x3(pi * b11, pi * b12, pi * b13, pi * b22, pi * b23, pi * b33) / 2;
+}
 
+inline float localSVDFinish(float q, float p, float r) {
     if (p == 0)
         return 0;
 
-    const float pi = 1 / p;
-    const float r = det3x3(pi * b11, pi * b12, pi * b13, pi * b22, pi * b23, pi * b33) / 2;
     float phi;
 
     if (r <= -1)
@@ -138,6 +143,51 @@ inline float localSVD(float a11, float a12, float a13, float a21, float a22, flo
     return std::sqrt(e2 / e1) + std::sqrt(e3 / e1);
 }
 
+// Computes the local SVD values of a row. The rows r0, r1 and r2 have one extra element on each side.
+void localSVDRow(const float* r0, const float* r1, const float* r2, int width, float* dst, float* buf) {
+    float* qbuf = buf;
+    float* pbuf = buf + width;
+    float* rbuf = buf + width * 2;
+    int j = 0;
+#if CV_SIMD128
+    const v_float32x4 z = v_setzero_f32(), one = v_setall_f32(1.f), two = v_setall_f32(2.f);
+    const v_float32x4 three = v_setall_f32(3.f), six = v_setall_f32(6.f);
+    for (; j <= width - v_float32x4::nlanes; j += v_float32x4::nlanes) {
+        const v_float32x4 a11 = v_load(r0 + j - 1), a12 = v_load(r0 + j), a13 = v_load(r0 + j + 1);
+        const v_float32x4 a21 = v_load(r1 + j - 1), a22 = v_load(r1 + j), a23 = v_load(r1 + j + 1);
+        const v_float32x4 a31 = v_load(r2 + j - 1), a32 = v_load(r2 + j), a33 = v_load(r2 + j + 1);
+
+        v_float32x4 b11 = a11 * a11 + a12 * a12 + a13 * a13;
+        v_float32x4 b12 = a11 * a21 + a12 * a22 + a13 * a23;
+        v_float32x4 b13 = a11 * a31 + a12 * a32 + a13 * a33;
+        v_float32x4 b22 = a21 * a21 + a22 * a22 + a23 * a23;
+        v_float32x4 b23 = a21 * a31 + a22 * a32 + a23 * a33;
+        v_float32x4 b33 = a31 * a31 + a32 * a32 + a33 * a33;
+        const v_float32x4 q = (b11 + b22 + b33) / three;
+
+        b11 -= q;
+        b22 -= q;
+        b33 -= q;
+
+        const v_float32x4 p = v_sqrt((b11 * b11 + b22 * b22 + b33 * b33 + two * (b12 * b12 + b13 * b13 + b23 * b23)) / six);
+        const v_float32x4 nz = p != z;
+        const v_float32x4 pi = one / v_select(nz, p, one);
+        b11 *= pi; b12 *= pi; b13 *= pi; b22 *= pi; b23 *= pi; b33 *= pi;
+        const v_float32x4 r = b11 * (b22 * b33 - b23 * b23) + b12 * (two * b13 * b23 - b33 * b12) - b13 * b13 * b22;
+
+        v_store(qbuf + j, q);
+        v_store(pbuf + j, p);
+        v_store(rbuf + j, (r / two) & nz);
+    }
+#endif
+    for (; j < width; ++j)
+        localSVDCoeffs(r0[j - 1], r0[j], r0[j + 1], r1[j - 1], r1[j], r1[j + 1], r2[j - 1], r2[j], r2[j + 1],
+                       qbuf[j], pbuf[j], rbuf[j]);
+
+    for (j = 0; j < width; ++j)
+        dst[j] = localSVDFinish(qbuf[j], pbuf[j], rbuf[j]);
+}
+
 void removeNoise(Mat& fgMask, const Mat& compMask, const size_t threshold, const uchar filler) {
     const Size sz = fgMask.size();
     Mat labels;
@@ -188,42 +238,83 @@ void FindSparseCorrLK(const Mat& src, const Mat& dst, std::vector<Point2f>& srcP
     dstPoints.resize(j);
 }
 
+// Moves an 8-bit value towards the target with the given rate. The value moves by at least one level,
+// otherwise small differences would be lost to the rounding and the value would never reach the target.
+inline uchar blendColor(uchar c, uchar target, float rate) {
+    const int d = target - c;
+    int step = cvRound(d * rate);
+    if (step == 0 && d != 0 && rate > 0)
+        step = d > 0 ? 1 : -1;
+    return saturate_cast<uchar>(c + step);
+}
+
 class BackgroundSampleGSOC {
 public:
-    Point3f color;
-    int desc;
-    uint64 time;
-    uint64 hits;
+    Vec3b color;
+    unsigned time;
+    ushort hits;
 
-    BackgroundSampleGSOC(Point3f c = Point3f(), int d = 0, uint64 t = 0, uint64 h = 0) : color(c), desc(d), time(t), hits(h) {}
+    BackgroundSampleGSOC(Vec3b c = Vec3b(), unsigned t = 0, ushort h = 0) : color(c), time(t), hits(h) {}
 };
 
 class BackgroundSampleLSBP {
 public:
-    Point3f color;
+    Vec3b color;
     int desc;
     float minDecisionDist;
 
-    BackgroundSampleLSBP(Point3f c = Point3f(), int d = 0, float mdd = 1e9f) : color(c), desc(d), minDecisionDist(mdd) {}
+    BackgroundSampleLSBP(Vec3b c = Vec3b(), int d = 0, float mdd = 1e9f) : color(c), desc(d), minDecisionDist(mdd) {}
 };
 
-template<typename BackgroundSampleType>
+// The samples of a pixel are stored as separate arrays of 8-bit colors, so that a pixel is matched
+// against several samples at once. For every pixel the blue, green and red values of all its samples
+// follow each other. The other fields of the samples are kept by the derived models.
 class BackgroundModel {
 protected:
-    std::vector<BackgroundSampleType> samples;
+    std::vector<uchar> colors;
     const Size size;
     const int nSamples;
-    const int stride;
 
-public:
-    BackgroundModel(Size sz, int S) : size(sz), nSamples(S), stride(sz.width * S) {
-        samples.resize(sz.area() * S);
+    size_t sampleIndex(int i, int j, int k) const {
+        return (size_t)(i * size.width + j) * nSamples + k;
+    }
+
+    const uchar* pixelColors(int i, int j) const {
+        return &colors[(size_t)(i * size.width + j) * nSamples * 3];
+    }
+
+    uchar* pixelColors(int i, int j) {
+        return &colors[(size_t)(i * size.width + j) * nSamples * 3];
+    }
+
+    Vec3b getColor(int i, int j, int k) const {
+        const uchar* c = pixelColors(i, j) + k;
+        return Vec3b(c[0], c[nSamples], c[nSamples * 2]);
+    }
+
+    void setColor(int i, int j, int k, const Vec3b& color) {
+        uchar* c = pixelColors(i, j) + k;
+        c[0] = color[0];
+        c[nSamples] = color[1];
+        c[nSamples * 2] = color[2];
+    }
+
+    void swapColors(BackgroundModel& bm) {
+        colors.swap(bm.colors);
+    }
+
+    // Copies all the samples of the pixel (si, sj) of bm to the pixel (i, j)
+    virtual void copyPixel(int i, int j, const BackgroundModel& bm, int si, int sj) {
+        std::copy(bm.pixelColors(si, sj), bm.pixelColors(si, sj) + nSamples * 3, pixelColors(i, j));
     }
 
-    void swap(BackgroundModel& bm) {
-        samples.swap(bm.samples);
+public:
+    BackgroundModel(Size sz, int S) : size(sz), nSamples(S) {
+        colors.resize((size_t)sz.area() * S * 3);
     }
 
+    virtual ~BackgroundModel() {}
+
     void motionCompensation(const BackgroundModel& bm, const std::vector<Point2f>& points) {
         for (int i = 0; i < size.height; ++i)
                 for (int j = 0; j < size.width; ++j) {
@@ -237,42 +328,82 @@ public:
                     if (p.y >= size.height)
                         p.y = size.height - 1;
 
-                    for (int k = 0; k < nSamples; k++)
-                        samples[i * stride + j * nSamples + k] = bm.samples[p.y * stride + p.x * nSamples + k];
+                    copyPixel(i, j, bm, p.y, p.x);
                 }
     }
 
-    const BackgroundSampleType& operator()(int k) const {
-        return samples[k];
-    }
-
-    BackgroundSampleType& operator()(int k) {
-        return samples[k];
+    Size getSize() const {
+        return size;
     }
+};
 
-    const BackgroundSampleType& operator()(int i, int j, int k) const {
-        return samples[i * stride + j * nSamples + k];
+class BackgroundModelGSOC : public BackgroundModel {
+private:
+    std::vector<unsigned> times;
+    std::vector<ushort> hits;
+
+    void copyPixel(int i, int j, const BackgroundModel& _bm, int si, int sj) CV_OVERRIDE {
+        const BackgroundModelGSOC& bm = static_cast<const BackgroundModelGSOC&>(_bm);
+        BackgroundModel::copyPixel(i, j, bm, si, sj);
+        const size_t dst = sampleIndex(i, j, 0), src = bm.sampleIndex(si, sj, 0);
+        std::copy(bm.times.begin() + src, bm.times.begin() + src + nSamples, times.begin() + dst);
+        std::copy(bm.hits.begin() + src, bm.hits.begin() + src + nSamples, hits.begin() + dst);
     }
 
-    BackgroundSampleType& operator()(int i, int j, int k) {
-        return samples[i * stride + j * nSamples + k];
+public:
+    BackgroundModelGSOC(Size sz, int S) : BackgroundModel(sz, S) {
+        times.resize((size_t)sz.area() * S);
+        hits.resize((size_t)sz.area() * S);
     }
 
-    Size getSize() const {
-        return size;
+    void swap(BackgroundModelGSOC& bm) {
+        swapColors(bm);
+        times.swap(bm.times);
+        hits.swap(bm.hits);
     }
-};
 
-class BackgroundModelGSOC : public BackgroundModel<BackgroundSampleGSOC> {
-public:
-    BackgroundModelGSOC(Size sz, int S) : BackgroundModel(sz, S) {};
-
-    float findClosest(int i, int j, const Point3f& color, int& indOut) const {
-        const int end = i * stride + (j + 1) * nSamples;
-        int minInd = i * stride + j * nSamples;
-        float minDist = L2sqdist(color - samples[minInd].color);
-        for (int k = minInd + 1; k < end; ++k) {
-            const float dist = L2sqdist(color - samples[k].color);
+    // Returns the squared L2 distance (in 8-bit units) to the closest sample
+    int findClosest(int i, int j, const Vec3b& color, int& indOut) const {
+        const uchar* b = pixelColors(i, j);
+        const uchar* g = b + nSamples;
+        const uchar* r = g + nSamples;
+        int minInd = 0, minDist = INT_MAX, k = 0;
+#if CV_SIMD128
+        const v_uint8x16 vb = v_setall_u8(color[0]), vg = v_setall_u8(color[1]), vr = v_setall_u8(color[2]);
+        for (; k <= nSamples - v_uint8x16::nlanes; k += v_uint8x16::nlanes) {
+            v_uint16x8 b0, b1, g0, g1, r0, r1;
+            v_expand(v_absdiff(v_load(b + k), vb), b0, b1);
+            v_expand(v_absdiff(v_load(g + k), vg), g0, g1);
+            v_expand(v_absdiff(v_load(r + k), vr), r0, r1);
+
+            v_uint32x4 d[4], t0, t1;
+            v_mul_expand(b0, b0, d[0], d[1]);
+            v_mul_expand(g0, g0, t0, t1);
+            d[0] += t0; d[1] += t1;
+            v_mul_expand(r0, r0, t0, t1);
+            d[0] += t0; d[1] += t1;
+            v_mul_expand(b1, b1, d[2], d[3]);
+            v_mul_expand(g1, g1, t0, t1);
+            d[2] += t0; d[3] += t1;
+            v_mul_expand(r1, r1, t0, t1);
+            d[2] += t0; d[3] += t1;
+
+            const int blockMin = (int)v_reduce_min(v_min(v_min(d[0], d[1]), v_min(d[2], d[3])));
+            if (blockMin < minDist) {
+                unsigned buf[v_uint8x16::nlanes];
+                for (int l = 0; l < 4; ++l)
+                    v_store(buf + l * v_uint32x4::nlanes, d[l]);
+                int l = 0;
+                while ((int)buf[l] != blockMin)
+                    ++l;
+                minInd = k + l;
+                minDist = blockMin;
+            }
+        }
+#endif
+        for (; k < nSamples; ++k) {
+            const int db = b[k] - color[0], dg = g[k] - color[1], dr = r[k] - color[2];
+            const int dist = db * db + dg * dg + dr * dr;
             if (dist < minDist) {
                 minInd = k;
                 minDist = dist;
@@ -282,49 +413,137 @@ public:
         return minDist;
     }
 
-    void replaceOldest(int i, int j, const BackgroundSampleGSOC& sample) {
-        const int end = i * stride + (j + 1) * nSamples;
-        int minInd = i * stride + j * nSamples;
-        for (int k = minInd + 1; k < end; ++k) {
-            if (samples[k].time < samples[minInd].time)
-                minInd = k;
+    BackgroundSampleGSOC getSample(int i, int j, int k) const {
+        const size_t idx = sampleIndex(i, j, k);
+        return BackgroundSampleGSOC(getColor(i, j, k), times[idx], hits[idx]);
+    }
+
+    void setSample(int i, int j, int k, const BackgroundSampleGSOC& sample) {
+        const size_t idx = sampleIndex(i, j, k);
+        setColor(i, j, k, sample.color);
+        times[idx] = sample.time;
+        hits[idx] = sample.hits;
+    }
+
+    // Blends the sample with the color, marks it as used at the given time and returns the updated sample
+    BackgroundSampleGSOC updateSample(int i, int j, int k, const Vec3b& color, float rate, unsigned time) {
+        BackgroundSampleGSOC sample = getSample(i, j, k);
+        for (int c = 0; c < 3; ++c)
+            sample.color[c] = blendColor(sample.color[c], color[c], rate);
+        sample.time = time;
+        if (sample.hits < USHRT_MAX)
+            ++sample.hits;
+        setSample(i, j, k, sample);
+        return sample;
+    }
+
+    // Replaces the sample which was not used for the longest time
+    void replaceOldest(int i, int j, const BackgroundSampleGSOC& sample, unsigned currentTime) {
+        const unsigned* t = &times[sampleIndex(i, j, 0)];
+        int maxInd = 0;
+        unsigned maxAge = currentTime - t[0];
+        for (int k = 1; k < nSamples; ++k) {
+            const unsigned age = currentTime - t[k];
+            if (age > maxAge) {
+                maxInd = k;
+                maxAge = age;
+            }
         }
-        samples[minInd] = sample;
+        setSample(i, j, maxInd, sample);
     }
 
-    Point3f getMean(int i, int j, uint64 threshold) const {
-        const int end = i * stride + (j + 1) * nSamples;
-        Point3f acc(0, 0, 0);
+    Vec3b getMean(int i, int j, unsigned threshold) const {
+        const ushort* h = &hits[sampleIndex(i, j, 0)];
+        int acc[3] = { 0, 0, 0 };
         int cnt = 0;
-        for (int k = i * stride + j * nSamples; k < end; ++k) {
-            if (samples[k].hits > threshold) {
-                acc += samples[k].color;
+        for (int k = 0; k < nSamples; ++k) {
+            if (h[k] > threshold) {
+                const Vec3b c = getColor(i, j, k);
+                acc[0] += c[0];
+                acc[1] += c[1];
+                acc[2] += c[2];
                 ++cnt;
             }
         }
         if (cnt == 0) {
             cnt = nSamples;
-            for (int k = i * stride + j * nSamples; k < end; ++k)
-                acc += samples[k].color;
+            for (int k = 0; k < nSamples; ++k) {
+                const Vec3b c = getColor(i, j, k);
+                acc[0] += c[0];
+                acc[1] += c[1];
+                acc[2] += c[2];
+            }
         }
-        acc.x /= cnt;
-        acc.y /= cnt;
-        acc.z /= cnt;
-        return acc;
+        return Vec3b(saturate_cast<uchar>(float(acc[0]) / cnt),
+                     saturate_cast<uchar>(float(acc[1]) / cnt),
+                     saturate_cast<uchar>(float(acc[2]) / cnt));
     }
 };
 
-class BackgroundModelLSBP : public BackgroundModel<BackgroundSampleLSBP> {
+class BackgroundModelLSBP : public BackgroundModel {
+private:
+    std::vector<int> descs;
+    std::vector<float> minDecisionDists;
+
+    void copyPixel(int i, int j, const BackgroundModel& _bm, int si, int sj) CV_OVERRIDE {
+        const BackgroundModelLSBP& bm = static_cast<const BackgroundModelLSBP&>(_bm);
+        BackgroundModel::copyPixel(i, j, bm, si, sj);
+        const size_t dst = sampleIndex(i, j, 0), src = bm.sampleIndex(si, sj, 0);
+        std::copy(bm.descs.begin() + src, bm.descs.begin() + src + nSamples, descs.begin() + dst);
+        std::copy(bm.minDecisionDists.begin() + src, bm.minDecisionDists.begin() + src + nSamples, minDecisionDists.begin() + dst);
+    }
+
 public:
-    BackgroundModelLSBP(Size sz, int S) : BackgroundModel(sz, S) {};
-
-    int countMatches(int i, int j, const Point3f& color, int desc, float threshold, int descThreshold, float& minDist) const {
-        const int end = i * stride + (j + 1) * nSamples;
-        int count = 0;
-        minDist = 1e9;
-        for (int k = i * stride + j * nSamples; k < end; ++k) {
-            const float dist = L1dist(color - samples[k].color);
-            if (dist < threshold && LSBPDist32(static_cast<unsigned>(desc ^ samples[k].desc)) < descThreshold)
+    BackgroundModelLSBP(Size sz, int S) : BackgroundModel(sz, S) {
+        descs.resize((size_t)sz.area() * S);
+        minDecisionDists.resize((size_t)sz.area() * S);
+    }
+
+    void swap(BackgroundModelLSBP& bm) {
+        swapColors(bm);
+        descs.swap(bm.descs);
+        minDecisionDists.swap(bm.minDecisionDists);
+    }
+
+    void setSample(int i, int j, int k, const BackgroundSampleLSBP& sample) {
+        const size_t idx = sampleIndex(i, j, k);
+        setColor(i, j, k, sample.color);
+        descs[idx] = sample.desc;
+        minDecisionDists[idx] = sample.minDecisionDist;
+    }
+
+    // Distances are L1 distances in 8-bit units
+    int countMatches(int i, int j, const Vec3b& color, int desc, int threshold, int descThreshold, int& minDist) const {
+        const uchar* b = pixelColors(i, j);
+        const uchar* g = b + nSamples;
+        const uchar* r = g + nSamples;
+        const int* d = &descs[sampleIndex(i, j, 0)];
+        int count = 0, k = 0;
+        minDist = INT_MAX;
+#if CV_SIMD128
+        const v_uint8x16 vb = v_setall_u8(color[0]), vg = v_setall_u8(color[1]), vr = v_setall_u8(color[2]);
+        const v_uint16x8 vthreshold = v_setall_u16((ushort)std::min(std::max(threshold, 0), 255 * 3 + 1));
+        for (; k <= nSamples - v_uint8x16::nlanes; k += v_uint8x16::nlanes) {
+            v_uint16x8 s0, s1, t0, t1;
+            v_expand(v_absdiff(v_load(b + k), vb), s0, s1);
+            v_expand(v_absdiff(v_load(g + k), vg), t0, t1);
+            s0 += t0; s1 += t1;
+            v_expand(v_absdiff(v_load(r + k), vr), t0, t1);
+            s0 += t0; s1 += t1;
+
+            minDist = std::min(minDist, (int)v_reduce_min(v_min(s0, s1)));
+            int mask = v_signmask(v_pack(s0 < vthreshold, s1 < vthreshold));
+            while (mask) {
+                const int l = trailingZeros32((unsigned)mask);
+                mask &= mask - 1;
+                if (LSBPDist32(static_cast<unsigned>(desc ^ d[k + l])) < descThreshold)
+                    ++count;
+            }
+        }
+#endif
+        for (; k < nSamples; ++k) {
+            const int dist = std::abs(b[k] - color[0]) + std::abs(g[k] - color[1]) + std::abs(r[k] - color[2]);
+            if (dist < threshold && LSBPDist32(static_cast<unsigned>(desc ^ d[k])) < descThreshold)
                 ++count;
             if (dist < minDist)
                 minDist = dist;
@@ -332,50 +551,29 @@ public:
         return count;
     }
 
-    Point3f getMean(int i, int j) const {
-        const int end = i * stride + (j + 1) * nSamples;
-        Point3f acc(0, 0, 0);
-        for (int k = i * stride + j * nSamples; k < end; ++k) {
-            acc += samples[k].color;
+    Vec3b getMean(int i, int j) const {
+        int acc[3] = { 0, 0, 0 };
+        for (int k = 0; k < nSamples; ++k) {
+            const Vec3b c = getColor(i, j, k);
+            acc[0] += c[0];
+            acc[1] += c[1];
+            acc[2] += c[2];
         }
-        acc.x /= nSamples;
-        acc.y /= nSamples;
-        acc.z /= nSamples;
-        return acc;
+        return Vec3b(saturate_cast<uchar>(float(acc[0]) / nSamples),
+                     saturate_cast<uchar>(float(acc[1]) / nSamples),
+                     saturate_cast<uchar>(float(acc[2]) / nSamples));
     }
 
     float getDMean(int i, int j) const {
-        const int end = i * stride + (j + 1) * nSamples;
+        const float* mdd = &minDecisionDists[sampleIndex(i, j, 0)];
         float d = 0;
-        for (int k = i * stride + j * nSamples; k < end; ++k)
-            d += samples[k].minDecisionDist;
+        for (int k = 0; k < nSamples; ++k)
+            d += mdd[k];
 
         return d / nSamples;
     }
 };
 
-class ParallelLocalSVDValues : public ParallelLoopBody {
-private:
-    const Size sz;
-    Mat& localSVDValues;
-    const Mat& frameGray;
-
-    ParallelLocalSVDValues &operator=(const ParallelLocalSVDValues&);
-
-public:
-    ParallelLocalSVDValues(const Size& _sz, Mat& _localSVDValues, const Mat& _frameGray) : sz(_sz), localSVDValues(_localSVDValues), frameGray(_frameGray) {};
-
-    void operator()(const Range &range) const CV_OVERRIDE {
-        for (int i = range.start; i < range.end; ++i)
-            for (int j = 1; j < sz.width - 1; ++j) {
-                localSVDValues.at<float>(i, j) = localSVD(
-                    frameGray.at<float>(i - 1, j - 1), frameGray.at<float>(i - 1, j), frameGray.at<float>(i - 1, j + 1),
-                    frameGray.at<float>(i, j - 1), frameGray.at<float>(i, j), frameGray.at<float>(i, j + 1),
-                    frameGray.at<float>(i + 1, j - 1), frameGray.at<float>(i + 1, j), frameGray.at<float>(i + 1, j + 1));
-            }
-    }
-};
-
 class ParallelFromLocalSVDValues : public ParallelLoopBody {
 private:
     const Size sz;
@@ -412,34 +610,24 @@ void BackgroundSubtractorLSBPDesc::calcLocalSVDValues(OutputArray _localSVDValue
     const Size sz = frame.size();
     _localSVDValues.create(sz, CV_32F);
     Mat localSVDValues = _localSVDValues.getMat();
-    localSVDValues = 0.0f;
 
     cvtColor(frame, frameGray, COLOR_BGR2GRAY);
 
-    parallel_for_(Range(1, sz.height - 1), ParallelLocalSVDValues(sz, localSVDValues, frameGray));
-
-    for (int i = 1; i < sz.height - 1; ++i) {
-        localSVDValues.at<float>(i, 0) = localSVD(
-            frameGray.at<float>(i - 1, 0), frameGray.at<float>(i - 1, 0), frameGray.at<float>(i - 1, 1),
-            frameGray.at<float>(i, 0), frameGray.at<float>(i, 0), frameGray.at<float>(i, 1),
-            frameGray.at<float>(i + 1, 0), frameGray.at<float>(i + 1, 0), frameGray.at<float>(i + 1, 1));
+    // The pixels on the image border use the replicated neighbours, the corners are left at zero
+    Mat framePadded;
+    copyMakeBorder(frameGray, framePadded, 1, 1, 1, 1, BORDER_REPLICATE);
 
-        localSVDValues.at<float>(i, sz.width - 1) = localSVD(
-            frameGray.at<float>(i - 1, sz.width - 2), frameGray.at<float>(i - 1, sz.width - 1), frameGray.at<float>(i - 1, sz.width - 1),
-            frameGray.at<float>(i, sz.width - 2), frameGray.at<float>(i, sz.width - 1), frameGray.at<float>(i, sz.width - 1),
-            frameGray.at<float>(i + 1, sz.width - 2), frameGray.at<float>(i + 1, sz.width - 1), frameGray.at<float>(i + 1, sz.width - 1));
-    }
-
-    for (int j = 1; j < sz.width - 1; ++j) {
-        localSVDValues.at<float>(0, j) = localSVD(
-            frameGray.at<float>(0, j - 1), frameGray.at<float>(0, j), frameGray.at<float>(0, j + 1),
-            frameGray.at<float>(0, j - 1), frameGray.at<float>(0, j), frameGray.at<float>(0, j + 1),
-            frameGray.at<float>(1, j - 1), frameGray.at<float>(1, j), frameGray.at<float>(1, j + 1));
-        localSVDValues.at<float>(sz.height - 1, j) = localSVD(
-            frameGray.at<float>(sz.height - 2, j - 1), frameGray.at<float>(sz.height - 2, j), frameGray.at<float>(sz.height - 2, j + 1),
-            frameGray.at<float>(sz.height - 1, j - 1), frameGray.at<float>(sz.height - 1, j), frameGray.at<float>(sz.height - 1, j + 1),
-            frameGray.at<float>(sz.height - 1, j - 1), frameGray.at<float>(sz.height - 1, j), frameGray.at<float>(sz.height - 1, j + 1));
-    }
+    parallel_for_(Range(0, sz.height), [&](const Range& range) {
+        AutoBuffer<float> buf(sz.width * 3);
+        for (int i = range.start; i < range.end; ++i)
+            localSVDRow(framePadded.ptr<float>(i) + 1, framePadded.ptr<float>(i + 1) + 1, framePadded.ptr<float>(i + 2) + 1,
+                        sz.width, localSVDValues.ptr<float>(i), buf.data());
+    });
+
+    localSVDValues.at<float>(0, 0) = 0;
+    localSVDValues.at<float>(0, sz.width - 1) = 0;
+    localSVDValues.at<float>(sz.height - 1, 0) = 0;
+    localSVDValues.at<float>(sz.height - 1, sz.width - 1) = 0;
 }
 
 void BackgroundSubtractorLSBPDesc::computeFromLocalSVDValues(OutputArray _desc, const Mat& localSVDValues, const Point2i* LSBPSamplePoints) {
@@ -465,7 +653,7 @@ private:
     const int nSamples;
     const float replaceRate;
     const float propagationRate;
-    const uint64 hitsThreshold;
+    const unsigned hitsThreshold;
     const float alpha;
     const float beta;
     const float blinkingSupressionDecay;
@@ -566,39 +754,39 @@ public:
         BackgroundModelGSOC* backgroundModel = bgs->backgroundModel.get();
         Mat& distMovingAvg = bgs->distMovingAvg;
 
+        const unsigned currentTime = (unsigned)bgs->currentTime;
+        const float distScale = 1.0f / (255 * 255);
+
         for (int index = range.start; index < range.end; ++index) {
             const int i = index / sz.width, j = index % sz.width;
+            const Vec3b color = frame.at<Vec3b>(i, j);
             int k;
-            const float minDist = backgroundModel->findClosest(i, j, frame.at<Point3f>(i, j), k);
+            const float minDist = backgroundModel->findClosest(i, j, color, k) * distScale;
 
             distMovingAvg.at<float>(i, j) *= 1 - float(learningRate);
             distMovingAvg.at<float>(i, j) += float(learningRate) * minDist;
 
             const float threshold = bgs->alpha * distMovingAvg.at<float>(i, j) + bgs->beta;
-            BackgroundSampleGSOC& sample = (* backgroundModel)(k);
 
             if (minDist > threshold) {
                 fgMask.at<uchar>(i, j) = 255;
 
                 if (bgs->rng.uniform(0.0f, 1.0f) < bgs->replaceRate)
-                    backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame.at<Point3f>(i, j), 0, bgs->currentTime));
+                    backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(color, currentTime), currentTime);
             }
             else {
-                sample.color *= 1 - learningRate;
-                sample.color += learningRate * frame.at<Point3f>(i, j);
-                sample.time = bgs->currentTime;
-                ++sample.hits;
+                const BackgroundSampleGSOC sample = backgroundModel->updateSample(i, j, k, color, float(learningRate), currentTime);
 
                 // Propagation to neighbors
                 if (sample.hits > bgs->hitsThreshold && bgs->rng.uniform(0.0f, 1.0f) < bgs->propagationRate) {
                     if (i + 1 < sz.height)
-                        backgroundModel->replaceOldest(i + 1, j, sample);
+                        backgroundModel->replaceOldest(i + 1, j, sample, currentTime);
                     if (j + 1 < sz.width)
-                        backgroundModel->replaceOldest(i, j + 1, sample);
+                        backgroundModel->replaceOldest(i, j + 1, sample, currentTime);
                     if (i > 0)
-                        backgroundModel->replaceOldest(i - 1, j, sample);
+                        backgroundModel->replaceOldest(i - 1, j, sample, currentTime);
                     if (j > 0)
-                        backgroundModel->replaceOldest(i, j - 1, sample);
+                        backgroundModel->replaceOldest(i, j - 1, sample, currentTime);
                 }
 
                 fgMask.at<uchar>(i, j) = 0;
@@ -630,7 +818,7 @@ public:
         for (int index = range.start; index < range.end; ++index) {
             const int i = index / sz.width, j = index % sz.width;
 
-            float minDist = 1e9f;
+            int minDist = INT_MAX;
             const float DMean = backgroundModel->getDMean(i, j);
 
             if (R.at<float>(i, j) > DMean * bgs->Rscale)
@@ -638,7 +826,9 @@ public:
             else
                 R.at<float>(i, j) *= 1 + bgs->Rincdec;
 
-            if (backgroundModel->countMatches(i, j, frame.at<Point3f>(i, j), LSBPDesc.at<int>(i, j), R.at<float>(i, j), bgs->LSBPthreshold, minDist) < bgs->minCount) {
+            // the color distances are measured in 8-bit units
+            const int threshold = cvCeil(std::min(R.at<float>(i, j) * 255, 255.f * 3 + 1));
+            if (backgroundModel->countMatches(i, j, frame.at<Vec3b>(i, j), LSBPDesc.at<int>(i, j), threshold, bgs->LSBPthreshold, minDist) < bgs->minCount) {
                 fgMask.at<uchar>(i, j) = 255;
 
                 T.at<float>(i, j) += bgs->Tinc / DMean;
@@ -649,14 +839,14 @@ public:
                 T.at<float>(i, j) -= bgs->Tdec / DMean;
 
                 if (bgs->rng.uniform(0.0f, 1.0f) < 1 / T.at<float>(i, j))
-                    (* backgroundModel)(i, j, bgs->rng.uniform(0, bgs->nSamples)) = BackgroundSampleLSBP(frame.at<Point3f>(i, j), LSBPDesc.at<int>(i, j), minDist);
+                    backgroundModel->setSample(i, j, bgs->rng.uniform(0, bgs->nSamples), BackgroundSampleLSBP(frame.at<Vec3b>(i, j), LSBPDesc.at<int>(i, j), minDist / 255.f));
 
                 if (bgs->rng.uniform(0.0f, 1.0f) < 1 / T.at<float>(i, j)) {
                     const int oi = i + bgs->rng.uniform(-1, 2);
                     const int oj = j + bgs->rng.uniform(-1, 2);
 
                     if (oi >= 0 && oi < sz.height && oj >= 0 && oj < sz.width)
-                        (* backgroundModel)(oi, oj, bgs->rng.uniform(0, bgs->nSamples)) = BackgroundSampleLSBP(frame.at<Point3f>(oi, oj), LSBPDesc.at<int>(oi, oj), minDist);
+                        backgroundModel->setSample(oi, oj, bgs->rng.uniform(0, bgs->nSamples), BackgroundSampleLSBP(frame.at<Vec3b>(oi, oj), LSBPDesc.at<int>(oi, oj), minDist / 255.f));
                 }
             }
 
@@ -682,7 +872,7 @@ BackgroundSubtractorGSOCImpl::BackgroundSubtractorGSOCImpl(int _mc,
   nSamples(_nSamples),
   replaceRate(_replaceRate),
   propagationRate(_propagationRate),
-  hitsThreshold(_hitsThreshold),
+  hitsThreshold(std::min(_hitsThreshold, USHRT_MAX - 1)),
   alpha(_alpha),
   beta(_beta),
   blinkingSupressionDecay(_blinkingSupressionDecay),
@@ -720,27 +910,26 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
     if (frame.channels() != 3)
         cvtColor(frame, frame, COLOR_GRAY2BGR);
 
-    if (frame.depth() != CV_32F) {
-        frame.convertTo(frame, CV_32F);
-        frame /= 255;
-    }
-
     CV_Assert(frame.channels() == 3);
 
+    // The model keeps 8-bit colors, floating-point frames are expected to be in [0, 1]
+    Mat frame8u;
+    if (frame.depth() == CV_8U)
+        frame8u = frame;
+    else
+        frame.convertTo(frame8u, CV_8U, 255);
+
     if (backgroundModel.empty()) {
         backgroundModel = makePtr<BackgroundModelGSOC>(sz, nSamples);
-        backgroundModelPrev = makePtr<BackgroundModelGSOC>(sz, nSamples);
         distMovingAvg = Mat(sz, CV_32F, Scalar::all(0.005f));
         prevFgMask = Mat(sz, CV_8U, Scalar::all(0));
         blinkingSupression = Mat(sz, CV_32F, Scalar::all(0.0f));
 
         for (int i = 0; i < sz.height; ++i)
             for (int j = 0; j < sz.width; ++j) {
-                BackgroundSampleGSOC sample(frame.at<Point3f>(i, j), 0);
-                for (int k = 0; k < nSamples; ++k) {
-                    (* backgroundModel)(i, j, k) = sample;
-                    (* backgroundModelPrev)(i, j, k) = sample;
-                }
+                BackgroundSampleGSOC sample(frame8u.at<Vec3b>(i, j));
+                for (int k = 0; k < nSamples; ++k)
+                    backgroundModel->setSample(i, j, k, sample);
             }
     }
 
@@ -750,6 +939,9 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
         std::vector<Point2f> srcPoints;
         std::vector<Point2f> dstPoints;
 
+        if (frame.depth() != CV_32F)
+            frame.convertTo(frame, CV_32F, 1.0/255);
+
         if (prevFrame.empty())
             frame.copyTo(prevFrame);
 
@@ -766,6 +958,9 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
             dstPoints.resize(srcPoints.size());
             perspectiveTransform(srcPoints, dstPoints, H);
 
+            // every pixel of the model is overwritten, so the previous model needs no initialization
+            if (backgroundModelPrev.empty())
+                backgroundModelPrev = makePtr<BackgroundModelGSOC>(sz, nSamples);
             backgroundModel->swap(* backgroundModelPrev);
             backgroundModel->motionCompensation(* backgroundModelPrev, dstPoints);
         }
@@ -776,7 +971,7 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
     if (learningRate > 1 || learningRate < 0)
         learningRate = 0.1;
 
-    parallel_for_(Range(0, sz.area()), ParallelGSOC(sz, this, frame, learningRate, fgMask));
+    parallel_for_(Range(0, sz.area()), ParallelGSOC(sz, this, frame8u, learningRate, fgMask));
 
     ++currentTime;
 
@@ -788,7 +983,7 @@ void BackgroundSubtractorGSOCImpl::apply(InputArray _image, OutputArray _fgmask,
     for (int i = 0; i < sz.height; ++i)
         for (int j = 0; j < sz.width; ++j)
             if (rng.uniform(0.0f, 1.0f) < prob.at<float>(i, j))
-                backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame.at<Point3f>(i, j), 0, currentTime));
+                backgroundModel->replaceOldest(i, j, BackgroundSampleGSOC(frame8u.at<Vec3b>(i, j), (unsigned)currentTime), (unsigned)currentTime);
 
     this->postprocessing(fgMask);
 }
@@ -800,7 +995,7 @@ void BackgroundSubtractorGSOCImpl::getBackgroundImage(OutputArray _backgroundIma
     Mat backgroundImage = _backgroundImage.getMat();
     for (int i = 0; i < sz.height; ++i)
         for (int j = 0; j < sz.width; ++j)
-            backgroundImage.at< Point3_<uchar> >(i, j) = backgroundModel->getMean(i, j, hitsThreshold) * 255;
+            backgroundImage.at<Vec3b>(i, j) = backgroundModel->getMean(i, j, hitsThreshold);
 }
 
 BackgroundSubtractorLSBPImpl::BackgroundSubtractorLSBPImpl(int _mc,
@@ -864,9 +1059,14 @@ void BackgroundSubtractorLSBPImpl::apply(InputArray _image, OutputArray _fgmask,
     if (frame.channels() != 3)
         cvtColor(frame, frame, COLOR_GRAY2BGR);
 
+    // The model keeps 8-bit colors, floating-point frames are expected to be in [0, 1]
+    Mat frame8u;
     if (frame.depth() != CV_32F) {
+        frame8u = frame;
         frame.convertTo(frame, CV_32F, 1.0/255);
     }
+    else
+        frame.convertTo(frame8u, CV_8U, 255);
 
     CV_Assert(frame.channels() == 3);
     Mat LSBPDesc(sz, CV_32S, Scalar::all(0));
@@ -875,7 +1075,6 @@ void BackgroundSubtractorLSBPImpl::apply(InputArray _image, OutputArray _fgmask,
 
     if (backgroundModel.empty()) {
         backgroundModel = makePtr<BackgroundModelLSBP>(sz, nSamples);
-        backgroundModelPrev = makePtr<BackgroundModelLSBP>(sz, nSamples);
         T = Mat(sz, CV_32F);
         T = (Tlower + Tupper) * 0.5f;
         R = Mat(sz, CV_32F);
@@ -883,11 +1082,9 @@ void BackgroundSubtractorLSBPImpl::apply(InputArray _image, OutputArray _fgmask,
 
         for (int i = 0; i < sz.height; ++i)
             for (int j = 0; j < sz.width; ++j) {
-                BackgroundSampleLSBP sample(frame.at<Point3f>(i, j), LSBPDesc.at<int>(i, j));
-                for (int k = 0; k < nSamples; ++k) {
-                    (* backgroundModel)(i, j, k) = sample;
-                    (* backgroundModelPrev)(i, j, k) = sample;
-                }
+                BackgroundSampleLSBP sample(frame8u.at<Vec3b>(i, j), LSBPDesc.at<int>(i, j));
+                for (int k = 0; k < nSamples; ++k)
+                    backgroundModel->setSample(i, j, k, sample);
             }
     }
 
@@ -913,6 +1110,9 @@ void BackgroundSubtractorLSBPImpl::apply(InputArray _image, OutputArray _fgmask,
             dstPoints.resize(srcPoints.size());
             perspectiveTransform(srcPoints, dstPoints, H);
 
+            // every pixel of the model is overwritten, so the previous model needs no initialization
+            if (backgroundModelPrev.empty())
+                backgroundModelPrev = makePtr<BackgroundModelLSBP>(sz, nSamples);
             backgroundModel->swap(* backgroundModelPrev);
             backgroundModel->motionCompensation(* backgroundModelPrev, dstPoints);
         }
@@ -923,7 +1123,7 @@ void BackgroundSubtractorLSBPImpl::apply(InputArray _image, OutputArray _fgmask,
     if (learningRate > 1 || learningRate < 0)
         learningRate = 0.1;
 
-    parallel_for_(Range(0, sz.area()), ParallelLSBP(sz, this, frame, learningRate, LSBPDesc, fgMask));
+    parallel_for_(Range(0, sz.area()), ParallelLSBP(sz, this, frame8u, learningRate, LSBPDesc, fgMask));
 
     this->postprocessing(fgMask);
 }
@@ -935,7 +1135,7 @@ void BackgroundSubtractorLSBPImpl::getBackgroundImage(OutputArray _backgroundIma
     Mat backgroundImage = _backgroundImage.getMat();
     for (int i = 0; i < sz.height; ++i)
         for (int j = 0; j < sz.width; ++j)
-            backgroundImage.at< Point3_<uchar> >(i, j) = backgroundModel->getMean(i, j) * 255;
+            backgroundImage.at<Vec3b>(i, j) = backgroundModel->getMean(i, j);
 }
 
 Ptr<BackgroundSubtractorGSOC> createBackgroundSubtractorGSOC(int mc,
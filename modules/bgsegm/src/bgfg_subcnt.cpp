@@ -173,13 +173,9 @@ public:
 
 struct BGSubtractPixel : public CNTFunctor
 {
-    BGSubtractPixel(int _minPixelStability, int _threshold,
-                    const Mat &_frame, const Mat &_prevFrame, Mat &_fgMask)
+    BGSubtractPixel(int _minPixelStability, int _threshold)
         : minPixelStability(_minPixelStability),
-          threshold(_threshold),
-          frame(_frame),
-          prevFrame(_prevFrame),
-          fgMask(_fgMask)
+          threshold(_threshold)
     {}
 
     //! the destructor
@@ -211,22 +207,15 @@ struct BGSubtractPixel : public CNTFunctor
 
     int minPixelStability;
     int threshold;
-    const Mat &frame;
-    const Mat &prevFrame;
-    Mat &fgMask;
 };
 
 struct BGSubtractPixelWithHistory : public CNTFunctor
 {
-    BGSubtractPixelWithHistory(int _minPixelStability, int _maxPixelStability, int _threshold,
-                               const Mat &_frame, const Mat &_prevFrame, Mat &_fgMask)
+    BGSubtractPixelWithHistory(int _minPixelStability, int _maxPixelStability, int _threshold)
         : minPixelStability(_minPixelStability),
           maxPixelStability(_maxPixelStability),
           threshold(_threshold),
-          thresholdHistory(30),
-          frame(_frame),
-          prevFrame(_prevFrame),
-          fgMask(_fgMask)
+          thresholdHistory(30)
     {}
 
     //! the destructor
@@ -302,11 +291,33 @@ struct BGSubtractPixelWithHistory : public CNTFunctor
     int maxPixelStability;
     int threshold;
     int thresholdHistory;
-    const Mat &frame;
-    const Mat &prevFrame;
-    Mat &fgMask;
 };
 
+static Ptr<CNTFunctor> createCNTFunctor(int minPixelStability, int maxPixelStability, int threshold,
+                                        bool useHistory, double learningRate)
+{
+    if (useHistory && learningRate)
+    {
+        double scaleMaxStability = 1.0;
+        if (learningRate > 0 && learningRate < 1.0)
+        {
+            scaleMaxStability = learningRate;
+        }
+        return makePtr<BGSubtractPixelWithHistory>(minPixelStability, int(maxPixelStability * scaleMaxStability),
+                                                   threshold);
+    }
+    return makePtr<BGSubtractPixel>(minPixelStability, threshold*3);
+}
+
+static void processCNTRow(CNTFunctor &functor, Vec4i* row, const uchar* frameRow, const uchar* prevFrameRow,
+                          uchar* fgMaskRow, int cols)
+{
+    for (int c = 0; c < cols; ++c)
+    {
+        functor(row[c], frameRow[c], prevFrameRow[c], fgMaskRow[c]);
+    }
+}
+
 class CNTInvoker : public ParallelLoopBody
 {
 public:
@@ -320,14 +331,8 @@ public:
     {
         for (int r = range.start; r < range.end; ++r)
         {
-            Vec4i* row = data.ptr<Vec4i>(r);
-            uchar* frameRow = img.ptr<uchar>(r);
-            uchar* prevFrameRow = prevFrame.ptr<uchar>(r);
-            uchar* fgMaskRow = fgMask.ptr<uchar>(r);
-            for (int c = 0; c < data.cols; ++c)
-            {
-                functor(row[c], frameRow[c], prevFrameRow[c], fgMaskRow[c]);
-            }
+            processCNTRow(functor, data.ptr<Vec4i>(r), img.ptr<uchar>(r), prevFrame.ptr<uchar>(r),
+                          fgMask.ptr<uchar>(r), data.cols);
         }
     }
 
@@ -368,21 +373,8 @@ void BackgroundSubtractorCNTImpl::apply(InputArray image, OutputArray _fgmask, d
     }
 
     fgMask = Scalar(0);
-    CNTFunctor *functor;
-    if (useHistory && learningRate)
-    {
-        double scaleMaxStability = 1.0;
-        if (learningRate > 0 && learningRate < 1.0)
-        {
-            scaleMaxStability = learningRate;
-        }
-        functor = new BGSubtractPixelWithHistory(minPixelStability, int(maxPixelStability * scaleMaxStability),
-                                                 threshold, frame, prevFrame, fgMask);
-    }
-    else
-    {
-        functor = new BGSubtractPixel(minPixelStability, threshold*3, frame, prevFrame, fgMask);
-    }
+    Ptr<CNTFunctor> functor = createCNTFunctor(minPixelStability, maxPixelStability, threshold,
+                                               useHistory, learningRate);
 
     if (isParallel)
     {
@@ -393,19 +385,11 @@ void BackgroundSubtractorCNTImpl::apply(InputArray image, OutputArray _fgmask, d
     {
         for (int r = 0; r < data.rows; ++r)
         {
-            Vec4i* row = data.ptr<Vec4i>(r);
-            uchar* frameRow = frame.ptr<uchar>(r);
-            uchar* prevFrameRow = prevFrame.ptr<uchar>(r);
-            uchar* fgMaskRow = fgMask.ptr<uchar>(r);
-            for (int c = 0; c < data.cols; ++c)
-            {
-                (*functor)(row[c], frameRow[c], prevFrameRow[c], fgMaskRow[c]);
-            }
+            processCNTRow(*functor, data.ptr<Vec4i>(r), frame.ptr<uchar>(r), prevFrame.ptr<uchar>(r),
+                          fgMask.ptr<uchar>(r), data.cols);
         }
     }
 
-    delete functor;
-
     prevFrame = frame;
 }
 
@@ -415,6 +399,171 @@ Ptr<BackgroundSubtractorCNT> createBackgroundSubtractorCNT(int minPixelStability
     return makePtr<BackgroundSubtractorCNTImpl>(minPixelStability, useHistory, maxStability, isParallel);
 }
 
+// Number of image rows processed by one task of the batched subtractor
+static const int CNT_BATCH_BAND_ROWS = 16;
+
+class BackgroundSubtractorCNTBatchImpl CV_FINAL : public BackgroundSubtractorBatch
+{
+public:
+    BackgroundSubtractorCNTBatchImpl(int nstreams, int minStability, bool _useHistory, int maxStability)
+        : streams(nstreams),
+          minPixelStability(minStability),
+          maxPixelStability(maxStability),
+          threshold(5),
+          useHistory(_useHistory)
+    {
+        CV_Assert(nstreams > 0);
+    }
+
+    virtual void apply(InputArrayOfArrays images, OutputArrayOfArrays fgmasks, double learningRate) CV_OVERRIDE;
+    virtual void getBackgroundImage(int stream, OutputArray backgroundImage) const CV_OVERRIDE;
+
+    virtual int getNumStreams() const CV_OVERRIDE
+    {
+        return (int)streams.size();
+    }
+
+private:
+    struct Stream
+    {
+        Stream() : initialized(false), offset(0) {}
+
+        Size frameSize;
+        bool initialized;
+        size_t offset; // offset of the stream in the pools
+    };
+
+    std::vector<Stream> streams;
+    // Same per-pixel model as BackgroundSubtractorCNTImpl::data and the previous frames of all the streams
+    std::vector<Vec4i> dataPool;
+    std::vector<uchar> prevFramePool;
+    int minPixelStability;
+    int maxPixelStability;
+    int threshold;
+    bool useHistory;
+};
+
+void BackgroundSubtractorCNTBatchImpl::getBackgroundImage(int stream, OutputArray _backgroundImage) const
+{
+    CV_Assert(stream >= 0 && stream < (int)streams.size());
+    const Stream& s = streams[stream];
+    CV_Assert(s.initialized);
+
+    _backgroundImage.create(s.frameSize, CV_8U);
+    Mat backgroundImage = _backgroundImage.getMat();
+    const Vec4i* data = dataPool.data() + s.offset;
+    for (int r = 0; r < s.frameSize.height; ++r)
+    {
+        uchar* dst = backgroundImage.ptr<uchar>(r);
+        for (int c = 0; c < s.frameSize.width; ++c, ++data)
+            dst[c] = saturate_cast<uchar>((*data)[3]);
+    }
+}
+
+void BackgroundSubtractorCNTBatchImpl::apply(InputArrayOfArrays _images, OutputArrayOfArrays _fgmasks, double learningRate)
+{
+    std::vector<Mat> frames;
+    _images.getMatVector(frames);
+    const int n = (int)streams.size();
+    CV_Assert((int)frames.size() == n);
+
+    bool reallocate = dataPool.empty();
+    for (int i = 0; i < n; ++i)
+    {
+        CV_Assert(frames[i].depth() == CV_8U);
+        if (frames[i].channels() != 1)
+            cvtColor(frames[i], frames[i], COLOR_BGR2GRAY);
+        if (frames[i].size() != streams[i].frameSize)
+            reallocate = true;
+    }
+
+    if (reallocate)
+    {   // Moves the models to new pools, the streams which changed their size are reinitialized
+        size_t total = 0;
+        for (int i = 0; i < n; ++i)
+            total += frames[i].total();
+        std::vector<Vec4i> newDataPool(total);
+        std::vector<uchar> newPrevFramePool(total);
+        size_t offset = 0;
+        for (int i = 0; i < n; ++i)
+        {
+            Stream& s = streams[i];
+            const size_t size = frames[i].total();
+            if (s.initialized && frames[i].size() == s.frameSize)
+            {
+                std::copy(dataPool.begin() + s.offset, dataPool.begin() + s.offset + size, newDataPool.begin() + offset);
+                std::copy(prevFramePool.begin() + s.offset, prevFramePool.begin() + s.offset + size, newPrevFramePool.begin() + offset);
+            }
+            else
+            {
+                s.initialized = false;
+            }
+            s.frameSize = frames[i].size();
+            s.offset = offset;
+            offset += size;
+        }
+        dataPool.swap(newDataPool);
+        prevFramePool.swap(newPrevFramePool);
+    }
+
+    _fgmasks.create(n, 1, CV_8U);
+    std::vector<Mat> fgMasks(n);
+    std::vector<Vec2i> tasks; // (stream, first row)
+    for (int i = 0; i < n; ++i)
+    {
+        Stream& s = streams[i];
+        if (!s.initialized || learningRate >= 1)
+        {   // the history color is the current frame
+            Vec4i* data = dataPool.data() + s.offset;
+            uchar* prevFrame = prevFramePool.data() + s.offset;
+            for (int r = 0; r < s.frameSize.height; ++r)
+            {
+                const uchar* frameRow = frames[i].ptr<uchar>(r);
+                for (int c = 0; c < s.frameSize.width; ++c, ++data, ++prevFrame)
+                {
+                    *data = Vec4i(0, frameRow[c], 0, 0);
+                    *prevFrame = frameRow[c];
+                }
+            }
+            s.initialized = true;
+        }
+
+        _fgmasks.create(s.frameSize, CV_8U, i);
+        fgMasks[i] = _fgmasks.getMat(i);
+
+        for (int r = 0; r < s.frameSize.height; r += CNT_BATCH_BAND_ROWS)
+            tasks.push_back(Vec2i(i, r));
+    }
+
+    Ptr<CNTFunctor> functor = createCNTFunctor(minPixelStability, maxPixelStability, threshold,
+                                               useHistory, learningRate);
+
+    parallel_for_(Range(0, (int)tasks.size()), [&](const Range& range)
+    {
+        for (int t = range.start; t < range.end; ++t)
+        {
+            const int i = tasks[t][0];
+            const Stream& s = streams[i];
+            const int cols = s.frameSize.width;
+            const int rEnd = std::min(tasks[t][1] + CNT_BATCH_BAND_ROWS, s.frameSize.height);
+            for (int r = tasks[t][1]; r < rEnd; ++r)
+            {
+                const uchar* frameRow = frames[i].ptr<uchar>(r);
+                uchar* prevFrameRow = &prevFramePool[s.offset + (size_t)r * cols];
+                uchar* fgMaskRow = fgMasks[i].ptr<uchar>(r);
+                std::fill(fgMaskRow, fgMaskRow + cols, (uchar)0);
+                processCNTRow(*functor, &dataPool[s.offset + (size_t)r * cols], frameRow, prevFrameRow, fgMaskRow, cols);
+                std::copy(frameRow, frameRow + cols, prevFrameRow);
+            }
+        }
+    });
+}
+
+Ptr<BackgroundSubtractorBatch> createBackgroundSubtractorCNTBatch(int nstreams, int minPixelStability, bool useHistory, int maxStability)
+{
+    return makePtr<BackgroundSubtractorCNTBatchImpl>(nstreams, minPixelStability, useHistory, maxStability);
+}
+
 }
 }
 
@@ -0,0 +1,136 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// Streams of different sizes and types, the static background of every stream is disturbed
+// by noise and a moving rectangle
+static void generateStreamFrames(RNG& rng, const vector<Mat>& backgrounds, int frameNum, vector<Mat>& frames)
+{
+    frames.resize(backgrounds.size());
+    for (size_t i = 0; i < backgrounds.size(); i++)
+    {
+        const Mat& bg = backgrounds[i];
+        Mat noise(bg.size(), bg.type());
+        rng.fill(noise, RNG::UNIFORM, 0, 8);
+        add(bg, noise, frames[i]);
+        Rect object((frameNum * 3) % (bg.cols / 2), bg.rows / 4, bg.cols / 3, bg.rows / 3);
+        rectangle(frames[i], object, Scalar::all(255), FILLED);
+    }
+}
+
+static void testBatch(Ptr<BackgroundSubtractorBatch> batch, vector< Ptr<BackgroundSubtractor> >& single,
+                      const vector<Mat>& backgrounds, double learningRate)
+{
+    ASSERT_EQ((int)single.size(), batch->getNumStreams());
+    RNG rng(0);
+    int nthreads = getNumThreads();
+    for (int frameNum = 0; frameNum < 20; frameNum++)
+    {
+        vector<Mat> frames, masks;
+        generateStreamFrames(rng, backgrounds, frameNum, frames);
+        batch->apply(frames, masks, learningRate);
+        ASSERT_EQ(frames.size(), masks.size());
+
+        for (size_t i = 0; i < frames.size(); i++)
+        {
+            // the reference does not depend on the scheduling of its own parallel loops
+            Mat expected;
+            setNumThreads(1);
+            single[i]->apply(frames[i], expected, learningRate);
+            setNumThreads(nthreads);
+            ASSERT_EQ(CV_8UC1, masks[i].type());
+            ASSERT_EQ(expected.size(), masks[i].size());
+            EXPECT_EQ(0, cvtest::norm(expected, masks[i], NORM_INF)) << "stream " << i << ", frame " << frameNum;
+        }
+    }
+}
+
+static vector<Mat> makeBackgrounds()
+{
+    RNG rng(1);
+    const Size sizes[] = { Size(64, 48), Size(97, 31), Size(160, 120), Size(33, 65) };
+    const int types[] = { CV_8UC1, CV_8UC3, CV_8UC3, CV_8UC1 };
+    vector<Mat> backgrounds;
+    for (int i = 0; i < 4; i++)
+    {
+        Mat bg(sizes[i], types[i]);
+        rng.fill(bg, RNG::UNIFORM, 0, 200);
+        backgrounds.push_back(bg);
+    }
+    return backgrounds;
+}
+
+TEST(BackgroundSubtractor_Batch, MOG)
+{
+    vector<Mat> backgrounds = makeBackgrounds();
+    vector< Ptr<BackgroundSubtractor> > single;
+    for (size_t i = 0; i < backgrounds.size(); i++)
+        single.push_back(createBackgroundSubtractorMOG());
+    testBatch(createBackgroundSubtractorMOGBatch((int)backgrounds.size()), single, backgrounds, -1);
+}
+
+TEST(BackgroundSubtractor_Batch, CNT)
+{
+    vector<Mat> backgrounds = makeBackgrounds();
+    vector< Ptr<BackgroundSubtractor> > single;
+    for (size_t i = 0; i < backgrounds.size(); i++)
+        single.push_back(createBackgroundSubtractorCNT(5, true, 100));
+    testBatch(createBackgroundSubtractorCNTBatch((int)backgrounds.size(), 5, true, 100), single, backgrounds, 0.5);
+}
+
+// The subtractors the generic batch is meant for: their per-object random generators and
+// whole-mask post-processing must stay isolated per stream
+static Ptr<BackgroundSubtractor> createGenericSubtractor(const string& name)
+{
+    if (name == "GMG")
+        return createBackgroundSubtractorGMG(5);
+    if (name == "GSOC")
+        return createBackgroundSubtractorGSOC();
+    if (name == "LSBP")
+        return createBackgroundSubtractorLSBP();
+    CV_Error(Error::StsBadArg, "unknown background subtractor " + name);
+}
+
+typedef testing::TestWithParam<string> BackgroundSubtractor_BatchGeneric;
+
+TEST_P(BackgroundSubtractor_BatchGeneric, matches_single_streams)
+{
+    vector<Mat> backgrounds = makeBackgrounds();
+    vector< Ptr<BackgroundSubtractor> > streams, single;
+    for (size_t i = 0; i < backgrounds.size(); i++)
+    {
+        streams.push_back(createGenericSubtractor(GetParam()));
+        single.push_back(createGenericSubtractor(GetParam()));
+    }
+
+    // GSOC and LSBP draw from their generator inside their pixel loops, so the draws follow the
+    // scheduling whenever these loops nest in parallel (e.g. with TBB). Their streams are then only
+    // comparable on a single thread, which still checks that every stream keeps its own state.
+    int nthreads = getNumThreads();
+    if (GetParam() != "GMG")
+        setNumThreads(1);
+    testBatch(createBackgroundSubtractorBatch(streams), single, backgrounds, -1);
+    setNumThreads(nthreads);
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, BackgroundSubtractor_BatchGeneric, testing::Values("GMG", "GSOC", "LSBP"));
+
+TEST(BackgroundSubtractor_Batch, FrameSizeChange)
+{
+    vector<Mat> backgrounds = makeBackgrounds();
+    Ptr<BackgroundSubtractorBatch> batch = createBackgroundSubtractorMOGBatch((int)backgrounds.size());
+    vector< Ptr<BackgroundSubtractor> > single;
+    for (size_t i = 0; i < backgrounds.size(); i++)
+        single.push_back(createBackgroundSubtractorMOG());
+    testBatch(batch, single, backgrounds, -1);
+
+    // only the stream which changed its size is reinitialized
+    resize(backgrounds[1], backgrounds[1], Size(50, 40));
+    single[1] = createBackgroundSubtractorMOG();
+    testBatch(batch, single, backgrounds, -1);
+}
+
+}} // namespace
@@ -48,6 +48,36 @@ TEST(BackgroundSubtractor_LSBP, Correctness)
     EXPECT_LE(std::abs(lsv.at<float>(1, 1) - 0.0f), 0.001f);
 }
 
+// The closed-form local SVD values match a general SVD of the neighbourhood
+TEST(BackgroundSubtractor_LSBP, LocalSVDValuesReference)
+{
+    RNG rng(0);
+    Mat input(23, 37, CV_32FC3);
+    rng.fill(input, RNG::UNIFORM, 0.0f, 1.0f);
+
+    Mat lsv, gray, padded;
+    bgsegm::BackgroundSubtractorLSBPDesc::calcLocalSVDValues(lsv, input);
+    cvtColor(input, gray, COLOR_BGR2GRAY);
+    // the border pixels use the replicated neighbours
+    copyMakeBorder(gray, padded, 1, 1, 1, 1, BORDER_REPLICATE);
+
+    for (int i = 0; i < input.rows; ++i)
+        for (int j = 0; j < input.cols; ++j)
+        {
+            const bool corner = (i == 0 || i == input.rows - 1) && (j == 0 || j == input.cols - 1);
+            if (corner)
+            {
+                EXPECT_EQ(0.0f, lsv.at<float>(i, j)) << "at (" << i << ", " << j << ")";
+                continue;
+            }
+
+            Mat w;
+            SVD::compute(padded(Rect(j, i, 3, 3)), w, SVD::NO_UV);
+            const float expected = (w.at<float>(1) + w.at<float>(2)) / w.at<float>(0);
+            EXPECT_NEAR(expected, lsv.at<float>(i, j), 5e-3f) << "at (" << i << ", " << j << ")";
+        }
+}
+
 TEST(BackgroundSubtractor_LSBP, Discrimination)
 {
     Point2i LSBPSamplePoints[32];
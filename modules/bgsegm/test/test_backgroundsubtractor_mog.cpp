@@ -0,0 +1,60 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef testing::TestWithParam<int> BackgroundSubtractor_MOG;
+
+TEST_P(BackgroundSubtractor_MOG, DetectsMovingObject)
+{
+    const int type = GetParam();
+    const Size sz(97, 61);
+    RNG rng(0);
+    Mat background(sz, type);
+    rng.fill(background, RNG::UNIFORM, 0, 200);
+
+    Ptr<BackgroundSubtractorMOG> mog = createBackgroundSubtractorMOG();
+    Mat frame, fgmask;
+    for (int i = 0; i < 40; i++)
+    {
+        Mat noise(sz, type);
+        rng.fill(noise, RNG::NORMAL, 0, 2);
+        add(background, noise, frame);
+        mog->apply(frame, fgmask);
+    }
+    EXPECT_LE(countNonZero(fgmask), (int)(sz.area() / 100));
+
+    Rect object(30, 20, 25, 17);
+    rectangle(frame, object, Scalar::all(255), FILLED);
+    mog->apply(frame, fgmask);
+    EXPECT_EQ(object.area(), countNonZero(fgmask(object)));
+
+    // the result does not depend on the number of threads
+    Ptr<BackgroundSubtractorMOG> mogSingle = createBackgroundSubtractorMOG();
+    Ptr<BackgroundSubtractorMOG> mogParallel = createBackgroundSubtractorMOG();
+    Mat maskSingle, maskParallel;
+    int nthreads = getNumThreads();
+    for (int i = 0; i < 10; i++)
+    {
+        rng.fill(frame, RNG::UNIFORM, 0, 256);
+        setNumThreads(1);
+        mogSingle->apply(frame, maskSingle);
+        setNumThreads(nthreads);
+        mogParallel->apply(frame, maskParallel);
+        EXPECT_EQ(0, cvtest::norm(maskSingle, maskParallel, NORM_INF));
+    }
+    for (int i = 0; i < 5; i++)
+    {
+        setNumThreads(1);
+        mogSingle->apply(frame, maskSingle, 0);
+        setNumThreads(nthreads);
+        mogParallel->apply(frame, maskParallel, 0);
+        EXPECT_EQ(0, cvtest::norm(maskSingle, maskParallel, NORM_INF));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, BackgroundSubtractor_MOG, Values(CV_8UC1, CV_8UC3));
+
+}} // namespace
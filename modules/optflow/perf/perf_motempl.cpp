@@ -0,0 +1,89 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+// Builds the motion history of a few blobs moving to the right, the last update is at timestamp 10
+static Mat generateMHI(Size sz, Mat& silhouette)
+{
+    Mat mhi = Mat::zeros(sz, CV_32F);
+    silhouette.create(sz, CV_8U);
+    RNG rng(0x2d7e);
+    Point centers[8];
+    for (int k = 0; k < 8; k++)
+        centers[k] = Point(rng.uniform(0, sz.width / 2), rng.uniform(0, sz.height));
+
+    for (int t = 1; t <= 10; t++)
+    {
+        silhouette = Scalar::all(0);
+        for (int k = 0; k < 8; k++)
+            circle(silhouette, centers[k] + Point(t * sz.width / 40, 0), sz.height / 10, Scalar::all(255), -1);
+        cv::motempl::updateMotionHistory(silhouette, mhi, t, 5);
+    }
+    return mhi;
+}
+
+typedef TestBaseWithParam<Size> MotionTemplates;
+
+PERF_TEST_P(MotionTemplates, updateMotionHistory, Values(szVGA, sz720p))
+{
+    Size sz = GetParam();
+    Mat silhouette;
+    Mat mhi = generateMHI(sz, silhouette);
+
+    TEST_CYCLE()
+    {
+        cv::motempl::updateMotionHistory(silhouette, mhi, 11, 5);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, calcMotionGradient, Values(szVGA, sz720p))
+{
+    Size sz = GetParam();
+    Mat silhouette, mask, orientation;
+    Mat mhi = generateMHI(sz, silhouette);
+
+    TEST_CYCLE()
+    {
+        cv::motempl::calcMotionGradient(mhi, mask, orientation, 0.5, 3, 3);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, calcGlobalOrientation, Values(szVGA, sz720p))
+{
+    Size sz = GetParam();
+    Mat silhouette, mask, orientation;
+    Mat mhi = generateMHI(sz, silhouette);
+    cv::motempl::calcMotionGradient(mhi, mask, orientation, 0.5, 3, 3);
+
+    TEST_CYCLE()
+    {
+        cv::motempl::calcGlobalOrientation(orientation, mask, mhi, 10, 5);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+PERF_TEST_P(MotionTemplates, segmentMotion, Values(szVGA, sz720p))
+{
+    Size sz = GetParam();
+    Mat silhouette, segmask;
+    Mat mhi = generateMHI(sz, silhouette);
+    std::vector<Rect> rects;
+
+    TEST_CYCLE()
+    {
+        rects.clear();
+        cv::motempl::segmentMotion(mhi, segmask, rects, 10, 1.5);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
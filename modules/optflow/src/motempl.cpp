@@ -42,6 +42,7 @@
 #include "precomp.hpp"
 #include "opencv2/core/utility.hpp"
 #include "opencv2/core/hal/hal.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include "opencv2/core/private.hpp"
 #include "opencl_kernels_optflow.hpp"
 
@@ -70,6 +71,37 @@ static bool ocl_updateMotionHistory( InputArray _silhouette, InputOutputArray _m
 
 #endif
 
+static void updateMotionHistoryRow( const uchar* silhData, float* mhiData, int width, float ts, float delbound )
+{
+    int x = 0;
+#if CV_SIMD128
+    const v_float32x4 ts4 = v_setall_f32(ts), db4 = v_setall_f32(delbound);
+    const v_uint32x4 z = v_setzero_u32();
+    for( ; x <= width - v_uint8x16::nlanes; x += v_uint8x16::nlanes )
+    {
+        v_uint16x8 s0, s1;
+        v_expand(v_load(silhData + x), s0, s1);
+        v_uint32x4 s[4];
+        v_expand(s0, s[0], s[1]);
+        v_expand(s1, s[2], s[3]);
+
+        for( int k = 0; k < 4; k++ )
+        {
+            float* ptr = mhiData + x + k*v_float32x4::nlanes;
+            v_float32x4 v = v_load(ptr);
+            v = v & (v >= db4);
+            v_store(ptr, v_select(v_reinterpret_as_f32(s[k] != z), ts4, v));
+        }
+    }
+#endif
+    for( ; x < width; x++ )
+    {
+        float val = mhiData[x];
+        val = silhData[x] ? ts : val < delbound ? 0 : val;
+        mhiData[x] = val;
+    }
+}
+
 void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
                               double timestamp, double duration )
 {
@@ -84,74 +116,74 @@ void updateMotionHistory( InputArray _silhouette, InputOutputArray _mhi,
 
     Mat silh = _silhouette.getMat(), mhi = _mhi.getMat();
     Size size = silh.size();
-#if defined(HAVE_IPP)
-    int silhstep = (int)silh.step, mhistep = (int)mhi.step;
-#endif
 
-    if( silh.isContinuous() && mhi.isContinuous() )
-    {
-        size.width *= size.height;
-        size.height = 1;
 #if defined(HAVE_IPP)
-        silhstep = (int)silh.total();
-        mhistep = (int)mhi.total() * sizeof(Ipp32f);
-#endif
-    }
-
-#if defined(HAVE_IPP)
-    IppStatus status = ippiUpdateMotionHistory_8u32f_C1IR((const Ipp8u *)silh.data, silhstep, (Ipp32f *)mhi.data, mhistep,
-                                                          ippiSize(size.width, size.height), (Ipp32f)timestamp, (Ipp32f)duration);
-    if (status >= 0)
-        return;
-#endif
-
-#if CV_SSE2
-    volatile bool useSIMD = checkHardwareSupport(CV_CPU_SSE2);
-#endif
-
-    for(int y = 0; y < size.height; y++ )
     {
-        const uchar* silhData = silh.ptr<uchar>(y);
-        float* mhiData = mhi.ptr<float>(y);
-        int x = 0;
+        Size ippsize = size;
+        int silhstep = (int)silh.step, mhistep = (int)mhi.step;
 
-#if CV_SSE2
-        if( useSIMD )
+        if( silh.isContinuous() && mhi.isContinuous() )
         {
-            __m128 ts4 = _mm_set1_ps(ts), db4 = _mm_set1_ps(delbound);
-            for( ; x <= size.width - 8; x += 8 )
-            {
-                __m128i z = _mm_setzero_si128();
-                __m128i s = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(silhData + x)), z);
-                __m128 s0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(s, z)), s1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(s, z));
-                __m128 v0 = _mm_loadu_ps(mhiData + x), v1 = _mm_loadu_ps(mhiData + x + 4);
-                __m128 fz = _mm_setzero_ps();
+            ippsize.width *= ippsize.height;
+            ippsize.height = 1;
+            silhstep = (int)silh.total();
+            mhistep = (int)mhi.total() * sizeof(Ipp32f);
+        }
 
-                v0 = _mm_and_ps(v0, _mm_cmpge_ps(v0, db4));
-                v1 = _mm_and_ps(v1, _mm_cmpge_ps(v1, db4));
+        IppStatus status = ippiUpdateMotionHistory_8u32f_C1IR((const Ipp8u *)silh.data, silhstep, (Ipp32f *)mhi.data, mhistep,
+                                                              ippiSize(ippsize.width, ippsize.height), (Ipp32f)timestamp, (Ipp32f)duration);
+        if (status >= 0)
+            return;
+    }
+#endif
 
-                __m128 m0 = _mm_and_ps(_mm_xor_ps(v0, ts4), _mm_cmpneq_ps(s0, fz));
-                __m128 m1 = _mm_and_ps(_mm_xor_ps(v1, ts4), _mm_cmpneq_ps(s1, fz));
+    parallel_for_(Range(0, size.height), [&](const Range& range)
+    {
+        for( int y = range.start; y < range.end; y++ )
+            updateMotionHistoryRow(silh.ptr<uchar>(y), mhi.ptr<float>(y), size.width, ts, delbound);
+    }, size.area()/(double)(1<<16));
+}
 
-                v0 = _mm_xor_ps(v0, m0);
-                v1 = _mm_xor_ps(v1, m1);
 
-                _mm_storeu_ps(mhiData + x, v0);
-                _mm_storeu_ps(mhiData + x + 4, v1);
-            }
+static void motionGradientMaskRow( const float* dX, const float* dY, const float* mhiMin, const float* mhiMax,
+                                   float* orient, uchar* mask, int width,
+                                   float gradient_epsilon, float min_delta, float max_delta )
+{
+    int x = 0;
+#if CV_SIMD128
+    const v_float32x4 eps4 = v_setall_f32(gradient_epsilon);
+    const v_float32x4 min4 = v_setall_f32(min_delta), max4 = v_setall_f32(max_delta);
+    const v_uint32x4 one = v_setall_u32(1);
+    for( ; x <= width - v_uint8x16::nlanes; x += v_uint8x16::nlanes )
+    {
+        v_uint32x4 m[4];
+        for( int k = 0; k < 4; k++ )
+        {
+            const int i = x + k*v_float32x4::nlanes;
+            v_float32x4 d0 = v_load(mhiMax + i) - v_load(mhiMin + i);
+            v_float32x4 keep = ((v_abs(v_load(dX + i)) >= eps4) | (v_abs(v_load(dY + i)) >= eps4)) &
+                               (d0 >= min4) & (d0 <= max4);
+            v_store(orient + i, v_load(orient + i) & keep);
+            m[k] = v_reinterpret_as_u32(keep) & one;
         }
+        v_store(mask + x, v_pack(v_pack(m[0], m[1]), v_pack(m[2], m[3])));
+    }
 #endif
+    for( ; x < width; x++ )
+    {
+        float d0 = mhiMax[x] - mhiMin[x];
 
-        for( ; x < size.width; x++ )
+        if( (std::abs(dX[x]) < gradient_epsilon && std::abs(dY[x]) < gradient_epsilon) ||
+            d0 < min_delta || max_delta < d0 )
         {
-            float val = mhiData[x];
-            val = silhData[x] ? ts : val < delbound ? 0 : val;
-            mhiData[x] = val;
+            mask[x] = (uchar)0;
+            orient[x] = 0.f;
         }
+        else
+            mask[x] = (uchar)1;
     }
 }
 
-
 void calcMotionGradient( InputArray _mhi, OutputArray _mask,
                              OutputArray _orientation,
                              double delta1, double delta2,
@@ -192,65 +224,86 @@ void calcMotionGradient( InputArray _mhi, OutputArray _mask,
     float min_delta = (float)delta1;
     float max_delta = (float)delta2;
 
-    Mat dX_min, dY_max;
+    Mat dX, dY, mhiMin, mhiMax;
 
     // calc Dx and Dy
-    Sobel( mhi, dX_min, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
-    Sobel( mhi, dY_max, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dX, CV_32F, 1, 0, aperture_size, 1, 0, BORDER_REPLICATE );
+    Sobel( mhi, dY, CV_32F, 0, 1, aperture_size, 1, 0, BORDER_REPLICATE );
 
-    int x, y;
+    erode( mhi, mhiMin, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
+    dilate( mhi, mhiMax, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
 
-    if( mhi.isContinuous() && orient.isContinuous() && mask.isContinuous() )
+    // calc gradient orientation and mask off the pixels where the gradient is very small
+    // or which have little motion difference in their neighborhood
+    parallel_for_(Range(0, size.height), [&](const Range& range)
     {
-        size.width *= size.height;
-        size.height = 1;
-    }
+        for( int y = range.start; y < range.end; y++ )
+        {
+            float* orient_row = orient.ptr<float>(y);
+            cv::hal::fastAtan2(dY.ptr<float>(y), dX.ptr<float>(y), orient_row, size.width, true);
+            motionGradientMaskRow(dX.ptr<float>(y), dY.ptr<float>(y), mhiMin.ptr<float>(y), mhiMax.ptr<float>(y),
+                                  orient_row, mask.ptr<uchar>(y), size.width, gradient_epsilon, min_delta, max_delta);
+        }
+    }, size.area()/(double)(1<<16));
+}
 
-    // calc gradient
-    for( y = 0; y < size.height; y++ )
+// Accumulates the weighted angles, relative to the dominant orientation,
+// of the recently updated pixels of a row
+static void accumulateOrientationShift( const float* mhiptr, const float* oriptr, const uchar* maskptr, int width,
+                                        float a, float b, float delbound, float fbaseOrient,
+                                        float& shiftOrient, float& shiftWeight )
+{
+    int x = 0;
+#if CV_SIMD128
+    const v_float32x4 a4 = v_setall_f32(a), b4 = v_setall_f32(b), db4 = v_setall_f32(delbound);
+    const v_float32x4 base4 = v_setall_f32(fbaseOrient);
+    const v_float32x4 v180 = v_setall_f32(180.f), v360 = v_setall_f32(360.f), v45 = v_setall_f32(45.f);
+    const v_uint32x4 z = v_setzero_u32();
+    v_float32x4 sumOrient = v_setzero_f32(), sumWeight = v_setzero_f32();
+    for( ; x <= width - v_uint8x16::nlanes; x += v_uint8x16::nlanes )
     {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
+        v_uint16x8 m0, m1;
+        v_expand(v_load(maskptr + x), m0, m1);
+        v_uint32x4 m[4];
+        v_expand(m0, m[0], m[1]);
+        v_expand(m1, m[2], m[3]);
 
-        cv::hal::fastAtan2(dY_max_row, dX_min_row, orient_row, size.width, true);
-
-        // make orientation zero where the gradient is very small
-        for( x = 0; x < size.width; x++ )
+        for( int k = 0; k < 4; k++ )
         {
-            float dY = dY_max_row[x];
-            float dX = dX_min_row[x];
-
-            if( std::abs(dX) < gradient_epsilon && std::abs(dY) < gradient_epsilon )
-            {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
-            }
-            else
-                mask_row[x] = (uchar)1;
+            const int i = x + k*v_float32x4::nlanes;
+            v_float32x4 h = v_load(mhiptr + i);
+            v_float32x4 relAngle = v_load(oriptr + i) - base4;
+            relAngle += v360 & (relAngle < -v180);
+            relAngle -= v360 & (relAngle > v180);
+
+            v_float32x4 sel = v_reinterpret_as_f32(m[k] != z) & (h > db4) & (v_abs(relAngle) < v45);
+            v_float32x4 weight = (h*a4 + b4) & sel;
+            sumOrient += weight*relAngle;
+            sumWeight += weight;
         }
     }
-
-    erode( mhi, dX_min, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-    dilate( mhi, dY_max, noArray(), Point(-1,-1), (aperture_size-1)/2, BORDER_REPLICATE );
-
-    // mask off pixels which have little motion difference in their neighborhood
-    for( y = 0; y < size.height; y++ )
+    shiftOrient += v_reduce_sum(sumOrient);
+    shiftWeight += v_reduce_sum(sumWeight);
+#endif
+    for( ; x < width; x++ )
     {
-        const float* dX_min_row = dX_min.ptr<float>(y);
-        const float* dY_max_row = dY_max.ptr<float>(y);
-        float* orient_row = orient.ptr<float>(y);
-        uchar* mask_row = mask.ptr<uchar>(y);
-
-        for( x = 0; x < size.width; x++ )
+        if( maskptr[x] != 0 && mhiptr[x] > delbound )
         {
-            float d0 = dY_max_row[x] - dX_min_row[x];
-
-            if( mask_row[x] == 0 || d0 < min_delta || max_delta < d0 )
+            /*
+             orient in 0..360, base_orient in 0..360
+             -> (rel_angle = orient - base_orient) in -360..360.
+             rel_angle is translated to -180..180
+             */
+            float weight = mhiptr[x] * a + b;
+            float relAngle = oriptr[x] - fbaseOrient;
+
+            relAngle += (relAngle < -180 ? 360 : 0);
+            relAngle += (relAngle > 180 ? -360 : 0);
+
+            if( fabs(relAngle) < 45 )
             {
-                mask_row[x] = (uchar)0;
-                orient_row[x] = 0.f;
+                shiftOrient += weight * relAngle;
+                shiftWeight += weight;
             }
         }
     }
@@ -307,34 +360,8 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
      */
     float shiftOrient = 0, shiftWeight = 0;
     for( int y = 0; y < size.height; y++ )
-    {
-        const float* mhiptr = mhi.ptr<float>(y);
-        const float* oriptr = orient.ptr<float>(y);
-        const uchar* maskptr = mask.ptr<uchar>(y);
-
-        for( int x = 0; x < size.width; x++ )
-        {
-            if( maskptr[x] != 0 && mhiptr[x] > delbound )
-            {
-                /*
-                 orient in 0..360, base_orient in 0..360
-                 -> (rel_angle = orient - base_orient) in -360..360.
-                 rel_angle is translated to -180..180
-                 */
-                float weight = mhiptr[x] * a + b;
-                float relAngle = oriptr[x] - fbaseOrient;
-
-                relAngle += (relAngle < -180 ? 360 : 0);
-                relAngle += (relAngle > 180 ? -360 : 0);
-
-                if( fabs(relAngle) < 45 )
-                {
-                    shiftOrient += weight * relAngle;
-                    shiftWeight += weight;
-                }
-            }
-        }
-    }
+        accumulateOrientationShift(mhi.ptr<float>(y), orient.ptr<float>(y), mask.ptr<uchar>(y), size.width,
+                                   a, b, delbound, fbaseOrient, shiftOrient, shiftWeight);
 
     // add the dominant orientation and the relative shift
     if( shiftWeight == 0 )
@@ -348,6 +375,77 @@ double calcGlobalOrientation( InputArray _orientation, InputArray _mask,
 }
 
 
+// Number of MHI rows linked by one task of segmentMotion
+static const int SEGMENT_BAND_ROWS = 32;
+
+static inline bool motionConnected( float a, float b, float thresh )
+{
+    float d = a - b;
+    return -thresh <= d && d <= thresh;
+}
+
+// Roots are the smallest index of their component, so every parent index
+// is less or equal to its child's index
+static inline int findMotionRoot( std::vector<int>& parent, int p )
+{
+    while( parent[p] != p )
+    {
+        parent[p] = parent[parent[p]];
+        p = parent[p];
+    }
+    return p;
+}
+
+static inline void uniteMotion( std::vector<int>& parent, int p, int q )
+{
+    p = findMotionRoot(parent, p);
+    q = findMotionRoot(parent, q);
+    if( p < q )
+        parent[q] = p;
+    else if( q < p )
+        parent[p] = q;
+}
+
+// Initializes the parents of row y, linking each pixel to its left neighbor and,
+// if linkUp is set, to its upper neighbor. Zero MHI pixels get no parent (-1).
+static void linkMotionRow( const Mat& mhi, std::vector<int>& parent, int y, float thresh, bool linkUp )
+{
+    const int cols = mhi.cols;
+    const float* mhiptr = mhi.ptr<float>(y);
+    const float* upptr = linkUp ? mhi.ptr<float>(y - 1) : 0;
+    int* pptr = &parent[(size_t)y * cols];
+
+    for( int x = 0; x < cols; x++ )
+    {
+        const float v = mhiptr[x];
+        if( v == 0 )
+        {
+            pptr[x] = -1;
+            continue;
+        }
+        const int idx = y * cols + x;
+        pptr[x] = idx;
+        if( x > 0 && mhiptr[x - 1] != 0 && motionConnected(v, mhiptr[x - 1], thresh) )
+            uniteMotion(parent, idx, idx - 1);
+        if( upptr && upptr[x] != 0 && motionConnected(v, upptr[x], thresh) )
+            uniteMotion(parent, idx, idx - cols);
+    }
+}
+
+// Links row y to the row above it, once both rows have been initialized
+static void linkMotionRowUp( const Mat& mhi, std::vector<int>& parent, int y, float thresh )
+{
+    const int cols = mhi.cols;
+    const float* mhiptr = mhi.ptr<float>(y);
+    const float* upptr = mhi.ptr<float>(y - 1);
+
+    for( int x = 0; x < cols; x++ )
+    {
+        if( mhiptr[x] != 0 && upptr[x] != 0 && motionConnected(mhiptr[x], upptr[x], thresh) )
+            uniteMotion(parent, y * cols + x, (y - 1) * cols + x);
+    }
+}
+
 void segmentMotion(InputArray _mhi, OutputArray _segmask,
                    vector<Rect>& boundingRects,
                    double timestamp, double segThresh)
@@ -361,58 +459,121 @@ void segmentMotion(InputArray _mhi, OutputArray _segmask,
     CV_Assert( mhi.type() == CV_32F );
     CV_Assert( segThresh >= 0 );
 
-    Mat mask = Mat::zeros( mhi.rows + 2, mhi.cols + 2, CV_8UC1 );
-
-    int x, y;
+    const int rows = mhi.rows, cols = mhi.cols;
+    const int nbands = (rows + SEGMENT_BAND_ROWS - 1) / SEGMENT_BAND_ROWS;
+    const float ts = (float)timestamp;
+    const float thresh = (float)segThresh;
 
-    // protect zero mhi pixels from floodfill.
-    for( y = 0; y < mhi.rows; y++ )
+    // Link the 4-connected non-zero pixels whose MHI values differ by at most segThresh.
+    // The bands are linked independently, then joined along their first rows.
+    std::vector<int> parent((size_t)rows * cols);
+    parallel_for_(Range(0, nbands), [&](const Range& range)
+    {
+        for( int band = range.start; band < range.end; band++ )
+        {
+            const int y0 = band * SEGMENT_BAND_ROWS, y1 = std::min(y0 + SEGMENT_BAND_ROWS, rows);
+            for( int y = y0; y < y1; y++ )
+                linkMotionRow(mhi, parent, y, thresh, y > y0);
+        }
+    });
+    for( int band = 1; band < nbands; band++ )
+        linkMotionRowUp(mhi, parent, band * SEGMENT_BAND_ROWS, thresh);
+
+    // Resolve every pixel to its root and number the components in the order of
+    // their first pixel updated at timestamp. The label of a component is kept at its root.
+    int ncomps = 0;
+    for( int y = 0; y < rows; y++ )
     {
         const float* mhiptr = mhi.ptr<float>(y);
-        uchar* maskptr = mask.ptr<uchar>(y+1) + 1;
+        int* pptr = &parent[(size_t)y * cols];
 
-        for( x = 0; x < mhi.cols; x++ )
+        for( int x = 0; x < cols; x++ )
         {
-            if( mhiptr[x] == 0 )
-                maskptr[x] = 1;
+            if( pptr[x] < 0 )
+                continue;
+            int root = pptr[x] = parent[pptr[x]];
+            if( mhiptr[x] == ts )
+            {
+                float& label = segmask.ptr<float>(root / cols)[root % cols];
+                if( label == 0 )
+                    label = (float)++ncomps;
+            }
         }
     }
 
-    float ts = (float)timestamp;
-    float comp_idx = 1.f;
+    if( ncomps == 0 )
+        return;
 
-    for( y = 0; y < mhi.rows; y++ )
+    // Label the pixels and collect the bounding boxes of the components touched by each band.
+    // A band only lists the components it touches, slot maps a label to its entry in the list.
+    std::vector<std::vector<std::pair<int, Vec4i> > > bandBoxes(nbands);
+    TLSData<std::vector<int> > slots;
+    parallel_for_(Range(0, nbands), [&](const Range& range)
     {
-        float* mhiptr = mhi.ptr<float>(y);
-        uchar* maskptr = mask.ptr<uchar>(y+1) + 1;
+        std::vector<int>& slot = *slots.get();
+        if( slot.empty() )
+            slot.assign(ncomps, -1);
 
-        for( x = 0; x < mhi.cols; x++ )
+        for( int band = range.start; band < range.end; band++ )
         {
-            if( mhiptr[x] == ts && maskptr[x] == 0 )
+            std::vector<std::pair<int, Vec4i> >& boxes = bandBoxes[band];
+            const int y0 = band * SEGMENT_BAND_ROWS, y1 = std::min(y0 + SEGMENT_BAND_ROWS, rows);
+            for( int y = y0; y < y1; y++ )
             {
-                Rect cc;
-                floodFill( mhi, mask, Point(x,y), Scalar::all(0),
-                           &cc, Scalar::all(segThresh), Scalar::all(segThresh),
-                           FLOODFILL_MASK_ONLY + 2*256 + 4 );
+                const int* pptr = &parent[(size_t)y * cols];
+                float* segmaskptr = segmask.ptr<float>(y);
 
-                for( int y1 = 0; y1 < cc.height; y1++ )
+                for( int x = 0; x < cols; x++ )
                 {
-                    float* segmaskptr = segmask.ptr<float>(cc.y + y1) + cc.x;
-                    uchar* maskptr1 = mask.ptr<uchar>(cc.y + y1 + 1) + cc.x + 1;
-
-                    for( int x1 = 0; x1 < cc.width; x1++ )
+                    const int root = pptr[x];
+                    if( root < 0 )
+                        continue;
+                    const int idx = y * cols + x;
+                    const float label = root == idx ? segmaskptr[x] : segmask.ptr<float>(root / cols)[root % cols];
+                    if( label == 0 )
+                        continue;
+                    if( root != idx )
+                        segmaskptr[x] = label;
+
+                    const int comp = (int)label - 1;
+                    if( slot[comp] < 0 )
                     {
-                        if( maskptr1[x1] > 1 )
-                        {
-                            maskptr1[x1] = 1;
-                            segmaskptr[x1] = comp_idx;
-                        }
+                        slot[comp] = (int)boxes.size();
+                        boxes.push_back(std::make_pair(comp, Vec4i(x, y, x, y)));
+                        continue;
                     }
+                    Vec4i& box = boxes[slot[comp]].second;
+                    box[0] = std::min(box[0], x);
+                    box[1] = std::min(box[1], y);
+                    box[2] = std::max(box[2], x);
+                    box[3] = std::max(box[3], y);
                 }
-                comp_idx += 1.f;
-                boundingRects.push_back(cc);
             }
+
+            for( size_t k = 0; k < boxes.size(); k++ )
+                slot[boxes[k].first] = -1;
         }
+    });
+
+    std::vector<Vec4i> compBoxes(ncomps, Vec4i(cols, rows, -1, -1));
+    for( int band = 0; band < nbands; band++ )
+    {
+        const std::vector<std::pair<int, Vec4i> >& boxes = bandBoxes[band];
+        for( size_t k = 0; k < boxes.size(); k++ )
+        {
+            Vec4i& box = compBoxes[boxes[k].first];
+            const Vec4i& b = boxes[k].second;
+            box[0] = std::min(box[0], b[0]);
+            box[1] = std::min(box[1], b[1]);
+            box[2] = std::max(box[2], b[2]);
+            box[3] = std::max(box[3], b[3]);
+        }
+    }
+
+    for( int comp = 0; comp < ncomps; comp++ )
+    {
+        const Vec4i& box = compBoxes[comp];
+        boundingRects.push_back(Rect(box[0], box[1], box[2] - box[0] + 1, box[3] - box[1] + 1));
     }
 }
 
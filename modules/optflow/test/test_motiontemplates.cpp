@@ -494,6 +494,69 @@ int CV_MHIGlobalOrientTest::validate_test_results( int test_case_idx )
 }
 
 
+///////////////////// segmentMotion //////////////////////
+
+// floodFill-based reference: components are grown from the pixels updated at timestamp, in raster order
+static void test_segmentMotion( const Mat& mhi, Mat& segmask, vector<Rect>& boundingRects,
+                                double timestamp, double segThresh )
+{
+    segmask = Mat::zeros(mhi.size(), CV_32F);
+    Mat mask = Mat::zeros(mhi.rows + 2, mhi.cols + 2, CV_8UC1);
+    Mat mhiCopy = mhi.clone();
+    mask(Rect(1, 1, mhi.cols, mhi.rows)).setTo(1, mhi == 0);
+
+    float ts = (float)timestamp;
+    float comp_idx = 1.f;
+    for( int y = 0; y < mhi.rows; y++ )
+    {
+        for( int x = 0; x < mhi.cols; x++ )
+        {
+            if( mhi.at<float>(y, x) != ts || mask.at<uchar>(y + 1, x + 1) != 0 )
+                continue;
+            Rect cc;
+            floodFill(mhiCopy, mask, Point(x, y), Scalar::all(0), &cc,
+                      Scalar::all(segThresh), Scalar::all(segThresh), FLOODFILL_MASK_ONLY + 2*256 + 4);
+            Mat filled = mask(cc + Point(1, 1)) == 2;
+            segmask(cc).setTo(comp_idx, filled);
+            mask(cc + Point(1, 1)).setTo(1, filled);
+            comp_idx += 1.f;
+            boundingRects.push_back(cc);
+        }
+    }
+}
+
+TEST(Video_MHISegment, accuracy)
+{
+    RNG& rng = cvtest::TS::ptr()->get_rng();
+    for( int iter = 0; iter < 10; iter++ )
+    {
+        Size sz(rng.uniform(1, 200), rng.uniform(1, 200));
+        const double ts = 10.0, duration = 5.0;
+
+        // random blobs of motion updated at successive timestamps
+        Mat mhi = Mat::zeros(sz, CV_32F);
+        for( int t = 0; t <= 5; t++ )
+        {
+            for( int k = 0; k < 8; k++ )
+            {
+                Point c(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+                Size axes(rng.uniform(1, 30), rng.uniform(1, 30));
+                ellipse(mhi, c, axes, rng.uniform(0., 360.), 0, 360, Scalar::all(ts - duration + t), -1);
+            }
+        }
+
+        Mat segmask, ref_segmask;
+        vector<Rect> rects(1, Rect(1, 2, 3, 4)), ref_rects(1, Rect(1, 2, 3, 4));
+        cv::motempl::segmentMotion(mhi, segmask, rects, ts, 1.5);
+        test_segmentMotion(mhi, ref_segmask, ref_rects, ts, 1.5);
+
+        EXPECT_MAT_NEAR(ref_segmask, segmask, 0);
+        ASSERT_EQ(ref_rects.size(), rects.size());
+        for( size_t i = 0; i < rects.size(); i++ )
+            EXPECT_EQ(ref_rects[i], rects[i]);
+    }
+}
+
 TEST(Video_MHIUpdate, accuracy) { CV_UpdateMHITest test; test.safe_run(); }
 TEST(Video_MHIGradient, accuracy) { CV_MHIGradientTest test; test.safe_run(); }
 TEST(Video_MHIGlobalOrient, accuracy) { CV_MHIGlobalOrientTest test; test.safe_run(); }
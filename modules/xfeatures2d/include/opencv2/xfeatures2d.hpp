@@ -377,6 +377,13 @@ public:
 
     CV_WRAP virtual void setUseNormalizeDescriptor(const bool dsc_normalize) = 0;
     CV_WRAP virtual bool getUseNormalizeDescriptor() const = 0;
+
+    /** @brief Use an int16 quantized projection matrix (disabled by default).
+    Pooled features and projection rows are quantized and projected with integer dot products,
+    descriptors differ from the float path by a small relative error.
+     */
+    CV_WRAP virtual void setUseQuantizedProjection(const bool use_quantized_projection) = 0;
+    CV_WRAP virtual bool getUseQuantizedProjection() const = 0;
 };
 
 /** @brief Class implementing BoostDesc (Learning Image Descriptors with Boosting), described in
@@ -897,6 +904,21 @@ public:
         const std::vector<Mat>& imageSignatures,
         std::vector<float>& distances) const = 0;
 
+    /**
+    * @brief Computes Signature Quadratic Form Distance between each pair of query
+    *       and database signatures.
+    * @param querySignatures Vector of query signatures.
+    * @param databaseSignatures Vector of database signatures.
+    * @param distances Output matrix of measured distances of type CV_32FC1,
+    *       one row per query signature and one column per database signature.
+    * @note The self-similarity term of every signature is computed only once
+    *       and the database is processed in cache-sized tiles in parallel.
+    */
+    CV_WRAP virtual void computeQuadraticFormDistances(
+        const std::vector<Mat>& querySignatures,
+        const std::vector<Mat>& databaseSignatures,
+        OutputArray distances) const = 0;
+
 };
 
 /**
@@ -988,6 +1010,24 @@ public:
         CV_OUT std::vector<Elliptic_KeyPoint>& keypoints,
         OutputArray descriptors,
         bool useProvidedKeypoints=false ) = 0;
+
+    /**
+     * @brief Enables the simulation of affine views of the input image, as in ASIFT (see also cv::AffineFeature).
+     *
+     * Every (tilt, roll) pair defines a view: the image is rotated by roll degrees and
+     * then compressed by the tilt factor along the x axis. The views are warped concurrently,
+     * then the wrapped detector and extractor run on one view at a time, so they do not need
+     * to be reentrant. Keypoints are mapped back to the input image as elliptic regions.
+     * Empty vectors (the default) disable the view synthesis.
+     *
+     * @param tilts tilt factors of the views, each one must be >= 1
+     * @param rolls roll angles of the views in degrees, same length as tilts
+     * @note The default implementation throws StsNotImplemented.
+     */
+    CV_WRAP virtual void setViewParams(const std::vector<float>& tilts, const std::vector<float>& rolls);
+    /** @brief Returns the simulated affine views, see setViewParams. The default implementation returns no view.
+     */
+    CV_WRAP virtual void getViewParams(CV_OUT std::vector<float>& tilts, CV_OUT std::vector<float>& rolls) const;
 };
 
 /**
@@ -1069,6 +1109,38 @@ CV_EXPORTS_W void matchGMS(const Size& size1, const Size& size2, const std::vect
                            const std::vector<DMatch>& matches1to2, CV_OUT std::vector<DMatch>& matchesGMS, const bool withRotation = false,
                            const bool withScale = false, const double thresholdFactor = 6.0);
 
+/** @brief Class implementing the GMS matching strategy, see matchGMS.
+
+The object keeps the grid statistics and the per-match cell indices allocated between calls, so
+it should be preferred over matchGMS when matching is done repeatedly, e.g. once per video frame.
+The rotation and scale hypotheses are evaluated concurrently.
+ */
+class CV_EXPORTS_W GMSMatcher : public Algorithm
+{
+public:
+    /** @brief Creates the GMS matcher.
+    @param withRotation Take rotation transformation into account.
+    @param withScale Take scale transformation into account.
+    @param thresholdFactor The higher, the less matches.
+     */
+    CV_WRAP static Ptr<GMSMatcher> create(bool withRotation = false, bool withScale = false, double thresholdFactor = 6.0);
+
+    /** @brief Filters the nearest neighbor matches, see matchGMS for the description of the parameters.
+     */
+    CV_WRAP virtual void match(const Size& size1, const Size& size2, const std::vector<KeyPoint>& keypoints1,
+                               const std::vector<KeyPoint>& keypoints2, const std::vector<DMatch>& matches1to2,
+                               CV_OUT std::vector<DMatch>& matchesGMS) = 0;
+
+    CV_WRAP virtual void setWithRotation(bool withRotation) = 0;
+    CV_WRAP virtual bool getWithRotation() const = 0;
+
+    CV_WRAP virtual void setWithScale(bool withScale) = 0;
+    CV_WRAP virtual bool getWithScale() const = 0;
+
+    CV_WRAP virtual void setThresholdFactor(double thresholdFactor) = 0;
+    CV_WRAP virtual double getThresholdFactor() const = 0;
+};
+
 /** @brief LOGOS (Local geometric support for high-outlier spatial verification) feature matching strategy described in @cite Lowry2018LOGOSLG .
     @param keypoints1 Input keypoints of image1.
     @param keypoints2 Input keypoints of image2.
@@ -0,0 +1,39 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+typedef tuple<bool, bool> GMS_Params_t;
+typedef perf::TestBaseWithParam<GMS_Params_t> gms;
+
+PERF_TEST_P(gms, match, testing::Combine(testing::Bool(), testing::Bool()))
+{
+    const bool withRotation = get<0>(GetParam());
+    const bool withScale = get<1>(GetParam());
+
+    string filename1 = getDataPath("cv/detectors_descriptors_evaluation/images_datasets/graf/img1.png");
+    string filename2 = getDataPath("cv/detectors_descriptors_evaluation/images_datasets/graf/img2.png");
+    Mat img1 = imread(filename1, IMREAD_GRAYSCALE);
+    Mat img2 = imread(filename2, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(img1.empty()) << "Unable to load source image " << filename1;
+    ASSERT_FALSE(img2.empty()) << "Unable to load source image " << filename2;
+
+    Ptr<ORB> orb = ORB::create(10000);
+    orb->setFastThreshold(0);
+    vector<KeyPoint> keypoints1, keypoints2;
+    Mat descriptors1, descriptors2;
+    orb->detectAndCompute(img1, noArray(), keypoints1, descriptors1);
+    orb->detectAndCompute(img2, noArray(), keypoints2, descriptors2);
+
+    vector<DMatch> matchesAll, matchesGMS;
+    BFMatcher(NORM_HAMMING).match(descriptors1, descriptors2, matchesAll);
+
+    Ptr<GMSMatcher> matcher = GMSMatcher::create(withRotation, withScale);
+    TEST_CYCLE() matcher->match(img1.size(), img2.size(), keypoints1, keypoints2, matchesAll, matchesGMS);
+
+    SANITY_CHECK_NOTHING();
+}
+
+}} // namespace
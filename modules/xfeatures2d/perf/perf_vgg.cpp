@@ -32,4 +32,26 @@ PERF_TEST_P(vgg, extract, testing::Values(VGG_IMAGES))
     SANITY_CHECK_NOTHING();
 }
 
+PERF_TEST_P(vgg, extract_quantized, testing::Values(VGG_IMAGES))
+{
+    string filename = getDataPath(GetParam());
+    Mat frame = imread(filename, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(frame.empty()) << "Unable to load source image " << filename;
+
+    Mat mask;
+    declare.in(frame).time(90);
+
+    Ptr<KAZE> detector = KAZE::create();
+    vector<KeyPoint> points;
+    detector->detect(frame, points, mask);
+
+    Ptr<VGG> descriptor = VGG::create();
+    descriptor->setUseQuantizedProjection(true);
+    Mat_<float> descriptors;
+    // compute keypoints descriptor
+    TEST_CYCLE() descriptor->compute(frame, points, descriptors);
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
@@ -453,14 +453,23 @@ float selDifferentiationScale(const Mat & img, Mat & Lxm2smooth, Mat & Lxmysmoot
 void calcAffineCovariantRegions(const Mat & image, const std::vector<KeyPoint> & keypoints,
         std::vector<Elliptic_KeyPoint> & affRegions)
 {
-    for (size_t i = 0; i < keypoints.size(); ++i)
+    //Adaptation of every keypoint is independent, keep the converged ones in input order
+    std::vector<Elliptic_KeyPoint> candidates(keypoints.size());
+    std::vector<uchar> converged(keypoints.size(), 0);
+    parallel_for_(Range(0, (int) keypoints.size()), [&](const Range& range)
     {
-        KeyPoint kp = keypoints[i];
-        Elliptic_KeyPoint ex(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
-                kp.size / 6);
-
-        if (calcAffineAdaptation(image, ex))
-            affRegions.push_back(ex);
+        for (int i = range.start; i < range.end; ++i)
+        {
+            const KeyPoint& kp = keypoints[i];
+            candidates[i] = Elliptic_KeyPoint(kp.pt, 0, Size_<float> (kp.size / 2, kp.size / 2), kp.size,
+                    kp.size / 6);
+            converged[i] = calcAffineAdaptation(image, candidates[i]);
+        }
+    });
+    for (size_t i = 0; i < candidates.size(); ++i)
+    {
+        if (converged[i])
+            affRegions.push_back(candidates[i]);
     }
     //Erase similar keypoint
     float maxDiff = 4;
@@ -491,96 +500,205 @@ void calcAffineCovariantRegions(const Mat & image, const std::vector<KeyPoint> &
     }
 }
 
-void calcAffineCovariantDescriptors(const Ptr<DescriptorExtractor>& dextractor, const Mat& img,
-        std::vector<Elliptic_KeyPoint>& affRegions, Mat& descriptors)
+/*
+ * Computes the descriptor of a single elliptic region after warping it into a circle
+ */
+void calcAffineCovariantDescriptor(const Ptr<DescriptorExtractor>& dextractor, const Mat& img,
+        const Elliptic_KeyPoint& region, Mat descriptor)
 {
+    Point p = region.pt;
 
-    assert(!affRegions.empty());
-    int descriptorSize = dextractor->descriptorSize();
-    int descriptorType = dextractor->descriptorType();
-    descriptors.create(Size(descriptorSize, int(affRegions.size())), descriptorType);
-    descriptors.setTo(0);
+    Matx21f size;
+    size(0, 0) = size(1, 0) = region.size;
 
-    int i = 0;
+    //U matrix
+    Matx23f transf = region.transf;
+    Matx22f U(
+        transf(0,0), transf(0,1),
+        transf(1,0), transf(1,1)
+    );
 
-    for (std::vector<Elliptic_KeyPoint>::iterator it = affRegions.begin(); it < affRegions.end(); ++it)
-    {
-        Point p = it->pt;
+    float radius = region.size / 2;
+    float si = region.si;
 
-        Matx21f size;
-        size(0, 0) = size(1, 0) = it->size;
+    Size_<float> boundingBox;
 
-        //U matrix
-        Matx23f transf = it->transf;
-        Matx22f U(
-            transf(0,0), transf(0,1),
-            transf(1,0), transf(1,1)
-        );
+    float ac_b2 = float(determinant(U));
+    boundingBox.width  = ceil(U(1, 1)/ac_b2 * 3 * si );
+    boundingBox.height = ceil(U(0, 0)/ac_b2 * 3 * si );
 
-        float radius = it->size / 2;
-        float si = it->si;
+    //Create window around interest point
+    float half_width = std::min((float) std::min(img.cols - p.x-1, p.x), boundingBox.width);
+    float half_height = std::min((float) std::min(img.rows - p.y-1, p.y), boundingBox.height);
+    int roix = max(p.x - (int) boundingBox.width, 0);
+    int roiy = max(p.y - (int) boundingBox.height, 0);
+    Rect roi = Rect(roix, roiy, p.x - roix + int(half_width)+1, p.y - roiy + int(half_height)+1);
 
-        Size_<float> boundingBox;
+    Mat img_roi = img(roi);
 
-        float ac_b2 = float(determinant(U));
-        boundingBox.width  = ceil(U(1, 1)/ac_b2 * 3 * si );
-        boundingBox.height = ceil(U(0, 0)/ac_b2 * 3 * si );
+    size(0, 0) = float(img_roi.cols);
+    size(1, 0) = float(img_roi.rows);
 
-        //Create window around interest point
-        float half_width = std::min((float) std::min(img.cols - p.x-1, p.x), boundingBox.width);
-        float half_height = std::min((float) std::min(img.rows - p.y-1, p.y), boundingBox.height);
-        int roix = max(p.x - (int) boundingBox.width, 0);
-        int roiy = max(p.y - (int) boundingBox.height, 0);
-        Rect roi = Rect(roix, roiy, p.x - roix + int(half_width)+1, p.y - roiy + int(half_height)+1);
+    size = U * size;
+
+    Mat transfImgRoi, transfImg;
+    warpAffine(img_roi, transfImgRoi, transf, Size(int(ceil(size(0, 0))), int(ceil(size(1, 0)))),
+            INTER_AREA, BORDER_DEFAULT);
+
+    Matx21f c; //Transformed point
+    Matx21f pt; //Image point
+    //Point within the Roi
+    pt(0, 0) = float(p.x - roix);
+    pt(1, 0) = float(p.y - roiy);
 
-        Mat img_roi = img(roi);
+    //Point in U-Normalized coordinates
+    c = U * pt;
+    float cx = c(0, 0);
+    float cy = c(1, 0);
 
-        size(0, 0) = float(img_roi.cols);
-        size(1, 0) = float(img_roi.rows);
+    //Cut around point to have patch of 2*keypoint->size
 
-        size = U * size;
+    roix = std::max(int(ceil(cx - radius)), 0);
+    roiy = std::max(int(ceil(cy - radius)), 0);
 
-        Mat transfImgRoi, transfImg;
-        warpAffine(img_roi, transfImgRoi, transf, Size(int(ceil(size(0, 0))), int(ceil(size(1, 0)))),
-                INTER_AREA, BORDER_DEFAULT);
+    roi = Rect(roix, roiy, int(ceil(std::min(cx - roix + radius, size(0, 0)))),
+            int(ceil(std::min(cy - roiy + radius, size(1, 0)))));
+    transfImg = transfImgRoi(roi);
 
-        Matx21f c; //Transformed point
-        Matx21f pt; //Image point
-        //Point within the Roi
-        pt(0, 0) = float(p.x - roix);
-        pt(1, 0) = float(p.y - roiy);
+    cx = c(0, 0) - roix;
+    cy = c(1, 0) - roiy;
 
-        //Point in U-Normalized coordinates
-        c = U * pt;
-        float cx = c(0, 0);
-        float cy = c(1, 0);
+    Mat tmpDesc;
+    KeyPoint kp(Point(int(cx), int(cy)), region.size);
 
-        //Cut around point to have patch of 2*keypoint->size
+    std::vector<KeyPoint> k(1, kp);
 
-        roix = std::max(int(ceil(cx - radius)), 0);
-        roiy = std::max(int(ceil(cy - radius)), 0);
+    transfImg.convertTo(transfImg, CV_8U);
+    dextractor->compute(transfImg, k, tmpDesc);
+
+    tmpDesc.row(0).copyTo(descriptor);
+}
 
-        roi = Rect(roix, roiy, int(ceil(std::min(cx - roix + radius, size(0, 0)))),
-                int(ceil(std::min(cy - roiy + radius, size(1, 0)))));
-        transfImg = transfImgRoi(roi);
+void calcAffineCovariantDescriptors(const Ptr<DescriptorExtractor>& dextractor, const Mat& img,
+        std::vector<Elliptic_KeyPoint>& affRegions, Mat& descriptors)
+{
 
-        cx = c(0, 0) - roix;
-        cy = c(1, 0) - roiy;
+    assert(!affRegions.empty());
+    int descriptorSize = dextractor->descriptorSize();
+    int descriptorType = dextractor->descriptorType();
+    descriptors.create(Size(descriptorSize, int(affRegions.size())), descriptorType);
+    descriptors.setTo(0);
 
-        Mat tmpDesc;
-        KeyPoint kp(Point(int(cx), int(cy)), it->size);
+    //Every region is warped and described independently
+    parallel_for_(Range(0, (int) affRegions.size()), [&](const Range& range)
+    {
+        for (int i = range.start; i < range.end; ++i)
+            calcAffineCovariantDescriptor(dextractor, img, affRegions[i], descriptors.row(i));
+    });
+}
 
-        std::vector<KeyPoint> k(1, kp);
+/*
+ * Simulates the affine view given by tilt and roll (in degrees) of image and mask,
+ * Ai receives the transformation from the view back to the image. Same sampling as ASIFT.
+ */
+void affineSkew(float tilt, float phi, const Mat& image, const Mat& mask,
+        Mat& warpedImage, Mat& warpedMask, Matx23f& Ai)
+{
+    int h = image.rows;
+    int w = image.cols;
+    Mat rotated;
+    Matx23f A(1.f, 0.f, 0.f,
+              0.f, 1.f, 0.f);
 
-        transfImg.convertTo(transfImg, CV_8U);
-        dextractor->compute(transfImg, k, tmpDesc);
+    if (mask.empty())
+    {
+        warpedMask.create(h, w, CV_8UC1);
+        warpedMask.setTo(255);
+    }
+    else
+        mask.copyTo(warpedMask);
 
-        tmpDesc.row(0).copyTo(descriptors.row(i));
+    if (phi != 0)
+    {
+        phi = float(phi * CV_PI / 180);
+        float s = std::sin(phi);
+        float c = std::cos(phi);
+        A = Matx23f(c, -s, 0.f,
+                    s,  c, 0.f);
+
+        std::vector<Point2f> corners(4);
+        corners[0] = Point2f(0.f, 0.f);
+        corners[1] = Point2f((float) w, 0.f);
+        corners[2] = Point2f((float) w, (float) h);
+        corners[3] = Point2f(0.f, (float) h);
+        std::vector<Point2f> tcorners;
+        transform(corners, tcorners, A);
+        Rect rect = boundingRect(tcorners);
+        A(0, 2) = float(-rect.x);
+        A(1, 2) = float(-rect.y);
+        warpAffine(image, rotated, A, rect.size(), INTER_LINEAR, BORDER_REPLICATE);
+    }
+    else
+        rotated = image;
 
-        i++;
+    if (tilt != 1)
+    {
+        Mat blurred;
+        double s = 0.8 * std::sqrt(tilt * tilt - 1);
+        GaussianBlur(rotated, blurred, Size(0, 0), s, 0.01);
+        resize(blurred, warpedImage, Size(0, 0), 1.0 / tilt, 1.0, INTER_NEAREST);
+        A(0, 0) /= tilt;
+        A(0, 1) /= tilt;
+        A(0, 2) /= tilt;
+    }
+    else
+        rotated.copyTo(warpedImage);
 
+    if (tilt != 1 || phi != 0)
+    {
+        Mat maskView;
+        warpAffine(warpedMask, maskView, A, warpedImage.size(), INTER_NEAREST);
+        warpedMask = maskView;
     }
 
+    invertAffineTransform(A, Ai);
+}
+
+/*
+ * Maps a keypoint detected in a simulated view back to the image. The circular region
+ * of the view becomes an ellipse, the linear part of the view transformation normalizes it.
+ */
+Elliptic_KeyPoint mapViewKeyPoint(const KeyPoint& kp, const Matx23f& Ai)
+{
+    Matx22f M(Ai(0, 0), Ai(0, 1),
+              Ai(1, 0), Ai(1, 1));
+    Point2f pt(Ai(0, 0) * kp.pt.x + Ai(0, 1) * kp.pt.y + Ai(0, 2),
+               Ai(1, 0) * kp.pt.x + Ai(1, 1) * kp.pt.y + Ai(1, 2));
+
+    //Semi-axes of the image of a circle of radius r are r times the singular values of M
+    Matx22f C = M * M.t();
+    float tr = C(0, 0) + C(1, 1);
+    float det = C(0, 0) * C(1, 1) - C(0, 1) * C(1, 0);
+    float disc = std::sqrt(std::max(tr * tr / 4 - det, 0.f));
+    float l1 = tr / 2 + disc;
+    float l2 = std::max(tr / 2 - disc, 0.f);
+    float r = kp.size / 2;
+    float phi = float(std::atan2(l1 - C(0, 0), C(0, 1)) * 180 / CV_PI);
+    if (C(0, 1) == 0)
+        phi = C(0, 0) >= C(1, 1) ? 0.f : 90.f;
+
+    Elliptic_KeyPoint ekp(pt, phi, Size(), kp.size, kp.size / 6);
+    ekp.axes = Size_<float>(r * std::sqrt(l1), r * std::sqrt(l2));
+    ekp.response = kp.response;
+    ekp.octave = kp.octave;
+    ekp.class_id = kp.class_id;
+
+    Matx22f U = M.inv();
+    ekp.transf = Matx23f(
+        U(0,0), U(0,1), 0.f,
+        U(1,0), U(1,1), 0.f
+    );
+    return ekp;
 }
 
 } // anonymous namespace
@@ -605,9 +723,23 @@ protected:
     int descriptorSize() const CV_OVERRIDE;
     int descriptorType() const CV_OVERRIDE;
     int defaultNorm() const CV_OVERRIDE;
+    void setViewParams(const std::vector<float>& tilts, const std::vector<float>& rolls) CV_OVERRIDE;
+    void getViewParams(std::vector<float>& tilts, std::vector<float>& rolls) const CV_OVERRIDE;
 private:
+    //Detects (and describes) keypoints on every simulated view
+    void detectAndComputeViews(const Mat& image, const Mat& mask, std::vector<Elliptic_KeyPoint>& keypoints,
+            OutputArray descriptors);
+
     Ptr<FeatureDetector> m_keypoint_detector;
     Ptr<DescriptorExtractor> m_descriptor_extractor;
+
+    //Simulated views, disabled when empty
+    std::vector<float> m_tilts;
+    std::vector<float> m_rolls;
+
+    //Warp buffers of every view, kept between calls
+    std::vector<Mat> m_view_images;
+    std::vector<Mat> m_view_masks;
 };
 
 Ptr<AffineFeature2D> AffineFeature2D::create(
@@ -617,11 +749,106 @@ Ptr<AffineFeature2D> AffineFeature2D::create(
     return makePtr<AffineFeature2D_Impl>(keypoint_detector, descriptor_extractor);
 }
 
+void AffineFeature2D::setViewParams(const std::vector<float>& tilts, const std::vector<float>& rolls)
+{
+    CV_UNUSED(tilts); CV_UNUSED(rolls);
+    CV_Error(Error::StsNotImplemented, "The simulation of affine views is not supported by this AffineFeature2D implementation");
+}
+
+void AffineFeature2D::getViewParams(std::vector<float>& tilts, std::vector<float>& rolls) const
+{
+    tilts.clear();
+    rolls.clear();
+}
+
+void AffineFeature2D_Impl::setViewParams(const std::vector<float>& tilts, const std::vector<float>& rolls)
+{
+    CV_Assert(tilts.size() == rolls.size());
+    for (size_t i = 0; i < tilts.size(); i++)
+        CV_Assert(tilts[i] >= 1);
+    m_tilts = tilts;
+    m_rolls = rolls;
+}
+
+void AffineFeature2D_Impl::getViewParams(std::vector<float>& tilts, std::vector<float>& rolls) const
+{
+    tilts = m_tilts;
+    rolls = m_rolls;
+}
+
+void AffineFeature2D_Impl::detectAndComputeViews(
+        const Mat& image,
+        const Mat& mask,
+        std::vector<Elliptic_KeyPoint>& keypoints,
+        OutputArray descriptors)
+{
+    const int numViews = (int) m_tilts.size();
+    const bool withDescriptors = descriptors.needed();
+
+    m_view_images.resize(numViews);
+    m_view_masks.resize(numViews);
+    std::vector<std::vector<Elliptic_KeyPoint> > viewKeypoints(numViews);
+    std::vector<Mat> viewDescriptors(numViews);
+
+    std::vector<Matx23f> viewInverses(numViews);
+    std::vector<std::vector<KeyPoint> > viewKps(numViews);
+
+    // the warps are independent
+    parallel_for_(Range(0, numViews), [&](const Range& range)
+    {
+        for (int v = range.start; v < range.end; v++)
+            affineSkew(m_tilts[v], m_rolls[v], image, mask, m_view_images[v], m_view_masks[v], viewInverses[v]);
+    });
+
+    // the wrapped detector and extractor are not required to be reentrant,
+    // they process one view at a time and may parallelize internally
+    for (int v = 0; v < numViews; v++)
+    {
+        m_keypoint_detector->detect(m_view_images[v], viewKps[v], m_view_masks[v]);
+        if (withDescriptors && !viewKps[v].empty())
+            m_descriptor_extractor->compute(m_view_images[v], viewKps[v], viewDescriptors[v]);
+    }
+
+    parallel_for_(Range(0, numViews), [&](const Range& range)
+    {
+        for (int v = range.start; v < range.end; v++)
+        {
+            const std::vector<KeyPoint>& kps = viewKps[v];
+            viewKeypoints[v].reserve(kps.size());
+            for (size_t i = 0; i < kps.size(); i++)
+                viewKeypoints[v].push_back(mapViewKeyPoint(kps[i], viewInverses[v]));
+        }
+    });
+
+    keypoints.clear();
+    for (int v = 0; v < numViews; v++)
+        keypoints.insert(keypoints.end(), viewKeypoints[v].begin(), viewKeypoints[v].end());
+
+    if (withDescriptors)
+    {
+        std::vector<Mat> nonEmpty;
+        for (int v = 0; v < numViews; v++)
+        {
+            if (!viewDescriptors[v].empty())
+                nonEmpty.push_back(viewDescriptors[v]);
+        }
+        if (nonEmpty.empty())
+            descriptors.release();
+        else
+            vconcat(nonEmpty, descriptors);
+    }
+}
+
 void AffineFeature2D_Impl::detect(
     InputArray image,
     std::vector<Elliptic_KeyPoint>& keypoints,
     InputArray mask)
 {
+    if (!m_tilts.empty())
+    {
+        detectAndComputeViews(image.getMat(), mask.getMat(), keypoints, noArray());
+        return;
+    }
     std::vector<KeyPoint> non_elliptic_keypoints;
     m_keypoint_detector->detect(image, non_elliptic_keypoints, mask);
     Mat fimage;
@@ -636,6 +863,11 @@ void AffineFeature2D_Impl::detectAndCompute(
         OutputArray descriptors,
         bool useProvidedKeypoints)
 {
+    if(!m_tilts.empty() && !useProvidedKeypoints)
+    {
+        detectAndComputeViews(image.getMat(), mask.getMat(), keypoints, descriptors);
+        return;
+    }
     if(!useProvidedKeypoints)
     {
         std::vector<KeyPoint> non_elliptic_keypoints;
@@ -654,6 +886,13 @@ void AffineFeature2D_Impl::detectAndCompute(
         OutputArray descriptors,
         bool useProvidedKeypoints)
 {
+    if(!m_tilts.empty() && !useProvidedKeypoints)
+    {
+        std::vector<Elliptic_KeyPoint> elliptic_keypoints;
+        detectAndComputeViews(image.getMat(), mask.getMat(), elliptic_keypoints, descriptors);
+        keypoints.assign(elliptic_keypoints.begin(), elliptic_keypoints.end());
+        return;
+    }
     if(!useProvidedKeypoints)
     {
         m_keypoint_detector->detect(image, keypoints, mask);
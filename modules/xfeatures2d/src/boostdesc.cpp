@@ -51,8 +51,8 @@
 
  */
 
-#include <bitset>
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 
 
@@ -207,8 +207,13 @@ static void computeGradientMaps( const Mat& im,
     Sobel( im, derivx, derivx.depth(), 1, 0 );
     Sobel( im, derivy, derivy.depth(), 0, 1 );
 
+    // reuse the maps of the previous patch when possible
+    gradMap.resize( orientQuant );
     for ( int i = 0; i < orientQuant; i++ )
-      gradMap.push_back( Mat::zeros( im.size(), CV_8UC1 ) );
+    {
+      gradMap[i].create( im.size(), CV_8UC1 );
+      gradMap[i].setTo( Scalar::all(0) );
+    }
 
     int index, index2;
     double binCenter, weight;
@@ -288,8 +293,7 @@ static void computeIntegrals( const vector<Mat>& gradMap,
     int rows = gradMap[0].rows;
     int cols = gradMap[0].cols;
 
-    for ( int i = 0; i < orientQuant+1; i++ )
-      integralMap.push_back( Mat::zeros( rows+1, cols+1, CV_8UC1 ) );
+    integralMap.resize( orientQuant+1 );
 
     // generate corresponding integral images
     for( int i = 0; i < orientQuant; i++ )
@@ -298,20 +302,37 @@ static void computeIntegrals( const vector<Mat>& gradMap,
     // copy the values from the first quantization bin
     integralMap[0].copyTo( integralMap[orientQuant] );
 
-    int* ptrSum, *ptr;
+    const int total = (rows+1)*(cols+1);
+    int* ptrSum = integralMap[orientQuant].ptr<int>();
     for ( int k = 1; k < orientQuant; k++ )
     {
-      ptr    = (int*) integralMap[k].ptr<int>();
-      ptrSum = (int*) integralMap[orientQuant].ptr<int>();
-      for (int i=0; i<(rows+1)*(cols+1); ++i)
-      {
-        *ptrSum += *ptr;
-        ++ptrSum;
-        ++ptr;
-      }
+      const int* ptr = integralMap[k].ptr<int>();
+      int i = 0;
+#if CV_SIMD128
+      for ( ; i <= total - 4; i += 4 )
+        v_store( ptrSum + i, v_load( ptrSum + i ) + v_load( ptr + i ) );
+#endif
+      for ( ; i < total; ++i )
+        ptrSum[i] += ptr[i];
     }
 }
 
+// signed sum of weights, +w[i] where the weak learner fired and -w[i] otherwise
+static float signedSum( const float* weights, const float* signs, const int len )
+{
+    int i = 0;
+    float sum = 0.f;
+#if CV_SIMD128
+    v_float32x4 v_sum = v_setzero_f32();
+    for ( ; i <= len - 4; i += 4 )
+      v_sum = v_muladd( v_load( weights + i ), v_load( signs + i ), v_sum );
+    sum = v_reduce_sum( v_sum );
+#endif
+    for ( ; i < len; i++ )
+      sum += weights[i] * signs[i];
+    return sum;
+}
+
 static float computeWLResponse( const int x_min,  const int x_max,
                                 const int y_min,  const int y_max,
                                 const int orient, const float thresh,
@@ -418,8 +439,12 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
 
     void operator ()( const cv::Range& range ) const CV_OVERRIDE
     {
-      // maps
+      // maps, reused for every keypoint of the range
       vector<Mat> gradMap, integralMap;
+      Mat patch;
+
+      // weak learner responses as +1 / -1
+      vector<float> wlSigns( nWLs );
 
       // small binary map
       uchar binLookUp[8];
@@ -429,7 +454,6 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
       for ( int i = range.start; i < range.end; i++ )
       {
 
-        Mat patch;
         // rectify the patch around a given keypoint
         rectifyPatch( image, keypoints[i], patch_size,
                       patch, use_scale_orientation, scale_factor );
@@ -448,13 +472,18 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
              ( desc_type == BGM_BILINEAR )
            )
         {
+          const int* x_min = wl_x_min.ptr<int>(0);
+          const int* x_max = wl_x_max.ptr<int>(0);
+          const int* y_min = wl_y_min.ptr<int>(0);
+          const int* y_max = wl_y_max.ptr<int>(0);
+          const int* orient = wl_orient.ptr<int>(0);
+          const float* thresh = wl_thresh.ptr<float>(0);
+
           uchar* desc = descriptors->ptr<uchar>(i);
           for ( int j = 0; j < nWLs; j++ )
           {
-            WLR = computeWLResponse( wl_x_min.at<int>(0,j), wl_x_max.at<int>(0,j),
-                                     wl_y_min.at<int>(0,j), wl_y_max.at<int>(0,j),
-                                     wl_orient.at<int>(0,j), wl_thresh.at<float>(0,j),
-                                     orient_q, integralMap );
+            WLR = computeWLResponse( x_min[j], x_max[j], y_min[j], y_max[j],
+                                     orient[j], thresh[j], orient_q, integralMap );
             desc[j/8] |=  ( WLR >= 0 ) ? binLookUp[ j % 8 ] : 0;
           }
         } // end BGM
@@ -464,24 +493,29 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
          */
         if ( desc_type == LBGM )
         {
-          std::bitset<512> wlResponses;
-
-          for ( int j = 0; j < nWLs; j++ )
-          {
-            WLR = computeWLResponse( wl_x_min.at<int>(0,j), wl_x_max.at<int>(0,j),
-                                     wl_y_min.at<int>(0,j), wl_y_max.at<int>(0,j),
-                                     wl_orient.at<int>(0,j), wl_thresh.at<float>(0,j),
-                                     orient_q, integralMap );
-            wlResponses[j] = ( WLR >= 0 ) ? 1 : 0;
-        }
+          const int* x_min = wl_x_min.ptr<int>(0);
+          const int* x_max = wl_x_max.ptr<int>(0);
+          const int* y_min = wl_y_min.ptr<int>(0);
+          const int* y_max = wl_y_max.ptr<int>(0);
+          const int* orient = wl_orient.ptr<int>(0);
+          const float* thresh = wl_thresh.ptr<float>(0);
 
           float* desc = descriptors->ptr<float>(i);
-          for ( int d = 0; d < Dims; d++ )
+          for ( int wl = 0; wl < nWLs; wl++ )
           {
-            for ( int wl = 0; wl < nWLs; wl++ )
-            {
-              desc[d] += ( wlResponses[wl] ) ? wl_beta.at<float>(wl,d) : -wl_beta.at<float>(wl,d);
-            }
+            WLR = computeWLResponse( x_min[wl], x_max[wl], y_min[wl], y_max[wl],
+                                     orient[wl], thresh[wl], orient_q, integralMap );
+            // accumulate the whole row of projection weights at once
+            const float sign = ( WLR >= 0 ) ? 1.f : -1.f;
+            const float* beta = wl_beta.ptr<float>(wl);
+            int d = 0;
+#if CV_SIMD128
+            const v_float32x4 v_sign = v_setall_f32( sign );
+            for ( ; d <= Dims - 4; d += 4 )
+              v_store( desc + d, v_muladd( v_load( beta + d ), v_sign, v_load( desc + d ) ) );
+#endif
+            for ( ; d < Dims; d++ )
+              desc[d] += sign * beta[d];
           }
         } // end LBGM
 
@@ -493,28 +527,27 @@ struct ComputeBoostDescInvoker : ParallelLoopBody
              ( desc_type == BINBOOST_256 )
            )
         {
-          float resp;
+          uchar* desc = descriptors->ptr<uchar>(i);
           for ( int d = 0; d < Dims; d++ )
           {
-            resp = 0;
-            uchar* desc = descriptors->ptr<uchar>(i);
+            const int* x_min = wl_x_min.ptr<int>(d);
+            const int* x_max = wl_x_max.ptr<int>(d);
+            const int* y_min = wl_y_min.ptr<int>(d);
+            const int* y_max = wl_y_max.ptr<int>(d);
+            const int* orient = wl_orient.ptr<int>(d);
+            const float* thresh = wl_thresh.ptr<float>(d);
+
             for ( int wl = 0; wl < nWLs; wl++ )
             {
-              WLR = computeWLResponse( wl_x_min.at<int>(d,wl), wl_x_max.at<int>(d,wl),
-                                       wl_y_min.at<int>(d,wl), wl_y_max.at<int>(d,wl),
-                                       wl_orient.at<int>(d,wl), wl_thresh.at<float>(d,wl),
-                                       orient_q, integralMap );
-              resp += ( WLR >= 0 ) ? wl_beta.at<float>(d,wl) : -wl_beta.at<float>(d,wl);
+              WLR = computeWLResponse( x_min[wl], x_max[wl], y_min[wl], y_max[wl],
+                                       orient[wl], thresh[wl], orient_q, integralMap );
+              wlSigns[wl] = ( WLR >= 0 ) ? 1.f : -1.f;
             }
+            const float resp = signedSum( wl_beta.ptr<float>(d), &wlSigns[0], nWLs );
             desc[d/8] |= ( resp >= 0 ) ? binLookUp[d%8] : 0;
           }
         } // end BINBOOST
 
-        // clean-up
-        patch.release();
-        gradMap.clear();
-        integralMap.clear();
-
       } // end for loop
     } // end operator
 
@@ -65,136 +65,157 @@ const int mRotationPatterns[8][9] = {
 // 5 level scales
 const double mScaleRatios[5] = { 1.0, 1.0 / 2, 1.0 / std::sqrt(2.0), std::sqrt(2.0), 2.0 };
 
-class GMSMatcher
+// Left grid is fixed, right grid is scaled by mScaleRatios
+const Size mGridSizeLeft(20, 20);
+const int mNumberScales = 5;
+const int mNumberRotations = 8;
+const int mNumberGridTypes = 4;
+
+// Working memory of a single (scale, rotation, grid type) evaluation
+struct GMSWorkspace
+{
+    // x      : left grid idx
+    // y      : right grid idx
+    // value  : how many matches from idx_left to idx_right
+    // Only the touched entries are reset after each use.
+    Mat motionStatistics;
+
+    //
+    vector<int> numberPointsInPerCellLeft;
+
+    // Largest motion statistics value of each left cell
+    vector<int> maxNumberInPerCellLeft;
+
+    // Inldex  : grid_idx_left
+    // Value   : grid_idx_right
+    vector<int> cellPairs;
+};
+
+class GMSMatcher_Impl CV_FINAL : public GMSMatcher
 {
 public:
-    // OpenCV Keypoints & Correspond Image Size & Nearest Neighbor Matches
-    GMSMatcher(const vector<KeyPoint>& vkp1, const Size& size1, const vector<KeyPoint>& vkp2, const Size& size2,
-               const vector<DMatch>& vDMatches, const double thresholdFactor) : mThresholdFactor(thresholdFactor)
-    {
-        // Input initialize
-        normalizePoints(vkp1, size1, mvP1);
-        normalizePoints(vkp2, size2, mvP2);
-        mNumberMatches = vDMatches.size();
-        convertMatches(vDMatches, mvMatches);
-
-        // Grid initialize
-        mGridSizeLeft = Size(20, 20);
-        mGridNumberLeft = mGridSizeLeft.width * mGridSizeLeft.height;
-
-        // Initialize the neighbor of left grid
-        mGridNeighborLeft = Mat::zeros(mGridNumberLeft, 9, CV_32SC1);
-        initalizeNeighbors(mGridNeighborLeft, mGridSizeLeft);
-    }
+    GMSMatcher_Impl(bool withRotation, bool withScale, double thresholdFactor);
 
-    ~GMSMatcher() {}
+    void match(const Size& size1, const Size& size2, const vector<KeyPoint>& keypoints1,
+               const vector<KeyPoint>& keypoints2, const vector<DMatch>& matches1to2,
+               vector<DMatch>& matchesGMS) CV_OVERRIDE;
 
-    // Get Inlier Mask
-    // Return number of inliers
-    int getInlierMask(vector<bool> &vbInliers, const bool withRotation = false, const bool withScale = false);
+    void setWithRotation(bool withRotation) CV_OVERRIDE { mWithRotation = withRotation; }
+    bool getWithRotation() const CV_OVERRIDE { return mWithRotation; }
 
+    void setWithScale(bool withScale) CV_OVERRIDE { mWithScale = withScale; }
+    bool getWithScale() const CV_OVERRIDE { return mWithScale; }
+
+    void setThresholdFactor(double thresholdFactor) CV_OVERRIDE { mThresholdFactor = thresholdFactor; }
+    double getThresholdFactor() const CV_OVERRIDE { return mThresholdFactor; }
 
 private:
+    bool mWithRotation;
+    bool mWithScale;
+    double mThresholdFactor;
+
     // Normalized Points
     vector<Point2f> mvP1, mvP2;
 
-    // Matches
-    vector<pair<int, int> > mvMatches;
-
     // Number of Matches
     size_t mNumberMatches;
 
     // Grid Size
-    Size mGridSizeLeft, mGridSizeRight;
+    Size mGridSizeRight[mNumberScales];
     int mGridNumberLeft;
-    int mGridNumberRight;
+    int mGridNumberRight[mNumberScales];
+    int mMaxGridNumberRight;
 
-    // x      : left grid idx
-    // y      : right grid idx
-    // value  : how many matches from idx_left to idx_right
-    Mat mMotionStatistics;
-
-    //
-    vector<int> mNumberPointsInPerCellLeft;
-
-    // Inldex  : grid_idx_left
-    // Value   : grid_idx_right
-    vector<int> mCellPairs;
-
-    // Every Matches has a cell-pair
-    // first  : grid_idx_left
-    // second : grid_idx_right
-    vector<pair<int, int> > mvMatchPairs;
-
-    // Inlier Mask for output
-    vector<bool> mvbInlierMask;
+    // Every match has a left cell for each grid type and a right cell for each scale
+    vector<int> mMatchCellsLeft[mNumberGridTypes];
+    vector<int> mMatchCellsRight[mNumberScales];
 
     //
     Mat mGridNeighborLeft;
-    Mat mGridNeighborRight;
+    Mat mGridNeighborRight[mNumberScales];
 
-    double mThresholdFactor;
+    // One inlier mask per (hypothesis, grid type), reused between calls
+    vector<uchar> mGridInlierMasks;
+    vector<int> mNumberInliers;
 
+    TLSData<GMSWorkspace> mWorkspaces;
 
     // Assign Matches to Cell Pairs
-    void assignMatchPairs(const int GridType);
+    void assignMatchPairs(GMSWorkspace& ws, const int gridType, const int scale) const;
 
-    void convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches);
+    int getGridIndexLeft(const Point2f &pt, const int type) const;
 
-    int getGridIndexLeft(const Point2f &pt, const int type);
+    int getGridIndexRight(const Point2f &pt, const int scale) const;
 
-    int getGridIndexRight(const Point2f &pt);
+    vector<int> getNB9(const int idx, const Size& GridSize) const;
 
-    vector<int> getNB9(const int idx, const Size& GridSize);
+    void initalizeNeighbors(Mat &neighbor, const Size& GridSize) const;
 
-    void initalizeNeighbors(Mat &neighbor, const Size& GridSize);
+    void normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts) const;
 
-    void normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts);
-
-    // Run
-    int run(const int rotationType);
+    // Get Inlier Mask
+    // Return number of inliers
+    int getInlierMask(vector<bool> &vbInliers);
 
-    void setScale(const int scale);
+    // Run a single grid type of a (scale, rotation) hypothesis
+    void run(const int scale, const int rotationType, const int gridType, uchar* inlierMask) const;
 
     // Verify Cell Pairs
-    void verifyCellPairs(const int rotationType);
+    void verifyCellPairs(GMSWorkspace& ws, const int rotationType, const int scale) const;
 };
 
-void GMSMatcher::assignMatchPairs(const int gridType)
+GMSMatcher_Impl::GMSMatcher_Impl(bool withRotation, bool withScale, double thresholdFactor) :
+    mWithRotation(withRotation), mWithScale(withScale), mThresholdFactor(thresholdFactor), mNumberMatches(0)
 {
-    for (size_t i = 0; i < mNumberMatches; i++)
-    {
-        Point2f &lp = mvP1[mvMatches[i].first];
-        Point2f &rp = mvP2[mvMatches[i].second];
-
-        int lgidx = mvMatchPairs[i].first = getGridIndexLeft(lp, gridType);
-        int rgidx = -1;
+    // Grid initialize
+    mGridNumberLeft = mGridSizeLeft.width * mGridSizeLeft.height;
 
-        if (gridType == 1)
-        {
-            rgidx = mvMatchPairs[i].second = getGridIndexRight(rp);
-        }
-        else
-        {
-            rgidx = mvMatchPairs[i].second;
-        }
+    // Initialize the neighbor of left grid
+    mGridNeighborLeft = Mat::zeros(mGridNumberLeft, 9, CV_32SC1);
+    initalizeNeighbors(mGridNeighborLeft, mGridSizeLeft);
 
-        if (lgidx < 0 || rgidx < 0) continue;
+    // Initialize the right grids of every scale
+    mMaxGridNumberRight = 0;
+    for (int scale = 0; scale < mNumberScales; scale++)
+    {
+        mGridSizeRight[scale].width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
+        mGridSizeRight[scale].height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
+        mGridNumberRight[scale] = mGridSizeRight[scale].width * mGridSizeRight[scale].height;
+        mMaxGridNumberRight = std::max(mMaxGridNumberRight, mGridNumberRight[scale]);
 
-        mMotionStatistics.at<int>(lgidx, rgidx)++;
-        mNumberPointsInPerCellLeft[lgidx]++;
+        mGridNeighborRight[scale] = Mat::zeros(mGridNumberRight[scale], 9, CV_32SC1);
+        initalizeNeighbors(mGridNeighborRight[scale], mGridSizeRight[scale]);
     }
 }
 
-// Convert OpenCV DMatch to Match (pair<int, int>)
-void GMSMatcher::convertMatches(const vector<DMatch> &vDMatches, vector<pair<int, int> > &vMatches)
+void GMSMatcher_Impl::assignMatchPairs(GMSWorkspace& ws, const int gridType, const int scale) const
 {
-    vMatches.resize(mNumberMatches);
+    const int *cellsLeft = mMatchCellsLeft[gridType - 1].data();
+    const int *cellsRight = mMatchCellsRight[scale].data();
+    int *numberPoints = ws.numberPointsInPerCellLeft.data();
+    int *maxNumber = ws.maxNumberInPerCellLeft.data();
+    int *cellPairs = ws.cellPairs.data();
+
     for (size_t i = 0; i < mNumberMatches; i++)
-        vMatches[i] = pair<int, int>(vDMatches[i].queryIdx, vDMatches[i].trainIdx);
+    {
+        int lgidx = cellsLeft[i];
+        int rgidx = cellsRight[i];
+
+        if (lgidx < 0 || rgidx < 0 || rgidx >= mGridNumberRight[scale]) continue;
+
+        int number = ++ws.motionStatistics.ptr<int>(lgidx)[rgidx];
+        numberPoints[lgidx]++;
+
+        // Track the first right cell with the most matches, as a full row scan would
+        if (number > maxNumber[lgidx] || (number == maxNumber[lgidx] && rgidx < cellPairs[lgidx]))
+        {
+            maxNumber[lgidx] = number;
+            cellPairs[lgidx] = rgidx;
+        }
+    }
 }
 
-int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
+int GMSMatcher_Impl::getGridIndexLeft(const Point2f &pt, const int type) const
 {
     int x = 0, y = 0;
 
@@ -225,83 +246,78 @@ int GMSMatcher::getGridIndexLeft(const Point2f &pt, const int type)
     return x + y * mGridSizeLeft.width;
 }
 
-int GMSMatcher::getGridIndexRight(const Point2f &pt)
+int GMSMatcher_Impl::getGridIndexRight(const Point2f &pt, const int scale) const
 {
-    int x = cvFloor(pt.x * mGridSizeRight.width);
-    int y = cvFloor(pt.y * mGridSizeRight.height);
+    int x = cvFloor(pt.x * mGridSizeRight[scale].width);
+    int y = cvFloor(pt.y * mGridSizeRight[scale].height);
 
-    return x + y * mGridSizeRight.width;
+    return x + y * mGridSizeRight[scale].width;
 }
 
-int GMSMatcher::getInlierMask(vector<bool> &vbInliers, const bool withRotation, const bool withScale)
+int GMSMatcher_Impl::getInlierMask(vector<bool> &vbInliers)
 {
-    int max_inlier = 0;
+    const int numberScales = mWithScale ? mNumberScales : 1;
+    const int numberRotations = mWithRotation ? mNumberRotations : 1;
+    const int numberHypotheses = numberScales * numberRotations;
+    const int numberRuns = numberHypotheses * mNumberGridTypes;
 
-    if (!withScale && !withRotation)
-    {
-        setScale(0);
-        max_inlier = run(1);
-        vbInliers = mvbInlierMask;
-        return max_inlier;
-    }
+    if (mNumberMatches == 0)
+        return 0;
 
-    if (withRotation && withScale)
+    mGridInlierMasks.assign(numberRuns * mNumberMatches, 0);
+    mNumberInliers.assign(numberHypotheses, 0);
+
+    // Every (scale, rotation, grid type) run is independent
+    parallel_for_(Range(0, numberRuns), [&](const Range& range)
     {
-        for (int scale = 0; scale < 5; scale++)
+        for (int i = range.start; i < range.end; i++)
         {
-            setScale(scale);
-            for (int rotationType = 1; rotationType <= 8; rotationType++)
-            {
-                int num_inlier = run(rotationType);
-
-                if (num_inlier > max_inlier)
-                {
-                    vbInliers = mvbInlierMask;
-                    max_inlier = num_inlier;
-                }
-            }
+            int hypothesis = i / mNumberGridTypes;
+            int gridType = i % mNumberGridTypes + 1;
+            int scale = hypothesis / numberRotations;
+            int rotationType = hypothesis % numberRotations + 1;
+            run(scale, rotationType, gridType, &mGridInlierMasks[i * mNumberMatches]);
         }
-        return max_inlier;
-    }
+    });
 
-    if (withRotation && !withScale)
+    // Merge the grid types of each hypothesis
+    parallel_for_(Range(0, numberHypotheses), [&](const Range& range)
     {
-        setScale(0);
-        for (int rotationType = 1; rotationType <= 8; rotationType++)
+        for (int hypothesis = range.start; hypothesis < range.end; hypothesis++)
         {
-            int num_inlier = run(rotationType);
-
-            if (num_inlier > max_inlier)
+            uchar *mask = &mGridInlierMasks[hypothesis * mNumberGridTypes * mNumberMatches];
+            for (int gridType = 1; gridType < mNumberGridTypes; gridType++)
             {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
+                const uchar *gridMask = mask + gridType * mNumberMatches;
+                for (size_t i = 0; i < mNumberMatches; i++)
+                    mask[i] |= gridMask[i];
             }
+            mNumberInliers[hypothesis] = (int) count(mask, mask + mNumberMatches, (uchar) 1); //number of inliers
         }
-        return max_inlier;
-    }
+    });
 
-    if (!withRotation && withScale)
+    // Keep the first hypothesis with the most inliers, in the serial (scale, rotation) order
+    int max_inlier = 0;
+    int best = (numberHypotheses == 1) ? 0 : -1;
+    for (int hypothesis = 0; hypothesis < numberHypotheses; hypothesis++)
     {
-        for (int scale = 0; scale < 5; scale++)
+        if (mNumberInliers[hypothesis] > max_inlier)
         {
-            setScale(scale);
-            int num_inlier = run(1);
-
-            if (num_inlier > max_inlier)
-            {
-                vbInliers = mvbInlierMask;
-                max_inlier = num_inlier;
-            }
-
+            max_inlier = mNumberInliers[hypothesis];
+            best = hypothesis;
         }
-        return max_inlier;
     }
 
+    if (best >= 0)
+    {
+        const uchar *mask = &mGridInlierMasks[best * mNumberGridTypes * mNumberMatches];
+        vbInliers.assign(mask, mask + mNumberMatches);
+    }
     return max_inlier;
 }
 
 // Get Neighbor 9
-vector<int> GMSMatcher::getNB9(const int idx, const Size& gridSize)
+vector<int> GMSMatcher_Impl::getNB9(const int idx, const Size& gridSize) const
 {
     vector<int> NB9(9, -1);
 
@@ -324,7 +340,7 @@ vector<int> GMSMatcher::getNB9(const int idx, const Size& gridSize)
     return NB9;
 }
 
-void GMSMatcher::initalizeNeighbors(Mat &neighbor, const Size& gridSize)
+void GMSMatcher_Impl::initalizeNeighbors(Mat &neighbor, const Size& gridSize) const
 {
     for (int i = 0; i < neighbor.rows; i++)
     {
@@ -335,7 +351,7 @@ void GMSMatcher::initalizeNeighbors(Mat &neighbor, const Size& gridSize)
 }
 
 // Normalize Key Points to Range(0 - 1)
-void GMSMatcher::normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts)
+void GMSMatcher_Impl::normalizePoints(const vector<KeyPoint> &kp, const Size &size, vector<Point2f> &npts) const
 {
     const size_t numP = kp.size();
     const int width   = size.width;
@@ -349,74 +365,49 @@ void GMSMatcher::normalizePoints(const vector<KeyPoint> &kp, const Size &size, v
     }
 }
 
-int GMSMatcher::run(const int rotationType)
+void GMSMatcher_Impl::run(const int scale, const int rotationType, const int gridType, uchar* inlierMask) const
 {
-    mvbInlierMask.assign(mNumberMatches, false);
+    GMSWorkspace& ws = *mWorkspaces.get();
 
-    // Initialize Motion Statisctics
-    mMotionStatistics = Mat::zeros(mGridNumberLeft, mGridNumberRight, CV_32SC1);
-    mvMatchPairs.assign(mNumberMatches, pair<int, int>(0, 0));
+    // Initialize Motion Statisctics, zeroed once and then only reset where touched
+    if (ws.motionStatistics.rows != mGridNumberLeft || ws.motionStatistics.cols != mMaxGridNumberRight)
+        ws.motionStatistics = Mat::zeros(mGridNumberLeft, mMaxGridNumberRight, CV_32SC1);
+    ws.cellPairs.assign(mGridNumberLeft, -1);
+    ws.numberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
+    ws.maxNumberInPerCellLeft.assign(mGridNumberLeft, 0);
 
-    for (int gridType = 1; gridType <= 4; gridType++)
-    {
-        // initialize
-        mMotionStatistics.setTo(0);
-        mCellPairs.assign(mGridNumberLeft, -1);
-        mNumberPointsInPerCellLeft.assign(mGridNumberLeft, 0);
+    assignMatchPairs(ws, gridType, scale);
+    verifyCellPairs(ws, rotationType, scale);
 
-        assignMatchPairs(gridType);
-        verifyCellPairs(rotationType);
+    // Mark inliers
+    const int *cellsLeft = mMatchCellsLeft[gridType - 1].data();
+    const int *cellsRight = mMatchCellsRight[scale].data();
+    for (size_t i = 0; i < mNumberMatches; i++)
+    {
+        int lgidx = cellsLeft[i];
+        int rgidx = cellsRight[i];
+        if (lgidx >= 0 && ws.cellPairs[lgidx] == rgidx)
+            inlierMask[i] = 1;
 
-        // Mark inliers
-        for (size_t i = 0; i < mNumberMatches; i++)
-        {
-            if (mvMatchPairs[i].first >= 0 && mCellPairs[mvMatchPairs[i].first] == mvMatchPairs[i].second)
-                mvbInlierMask[i] = true;
-        }
+        if (lgidx >= 0 && rgidx >= 0 && rgidx < mGridNumberRight[scale])
+            ws.motionStatistics.ptr<int>(lgidx)[rgidx] = 0;
     }
-
-    return (int) count(mvbInlierMask.begin(), mvbInlierMask.end(), true); //number of inliers
 }
 
-void GMSMatcher::setScale(const int scale)
-{
-    // Set Scale
-    mGridSizeRight.width = cvRound(mGridSizeLeft.width  * mScaleRatios[scale]);
-    mGridSizeRight.height = cvRound(mGridSizeLeft.height * mScaleRatios[scale]);
-    mGridNumberRight = mGridSizeRight.width * mGridSizeRight.height;
-
-    // Initialize the neighbor of right grid
-    mGridNeighborRight = Mat::zeros(mGridNumberRight, 9, CV_32SC1);
-    initalizeNeighbors(mGridNeighborRight, mGridSizeRight);
-}
-
-void GMSMatcher::verifyCellPairs(const int rotationType)
+void GMSMatcher_Impl::verifyCellPairs(GMSWorkspace& ws, const int rotationType, const int scale) const
 {
     const int *CurrentRP = mRotationPatterns[rotationType - 1];
+    const Mat& gridNeighborRight = mGridNeighborRight[scale];
 
     for (int i = 0; i < mGridNumberLeft; i++)
     {
-        if (sum(mMotionStatistics.row(i))[0] == 0)
-        {
-            mCellPairs[i] = -1;
+        // Cells without any match keep -1, the best right cell was found in assignMatchPairs
+        int idx_grid_rt = ws.cellPairs[i];
+        if (idx_grid_rt < 0)
             continue;
-        }
-
-        int max_number = 0;
-        for (int j = 0; j < mGridNumberRight; j++)
-        {
-            int *value = mMotionStatistics.ptr<int>(i);
-            if (value[j] > max_number)
-            {
-                mCellPairs[i] = j;
-                max_number = value[j];
-            }
-        }
-
-        int idx_grid_rt = mCellPairs[i];
 
         const int *NB9_lt = mGridNeighborLeft.ptr<int>(i);
-        const int *NB9_rt = mGridNeighborRight.ptr<int>(idx_grid_rt);
+        const int *NB9_rt = gridNeighborRight.ptr<int>(idx_grid_rt);
 
         int score = 0;
         double thresh = 0;
@@ -429,25 +420,47 @@ void GMSMatcher::verifyCellPairs(const int rotationType)
             if (ll == -1 || rr == -1)
                 continue;
 
-            score += mMotionStatistics.at<int>(ll, rr);
-            thresh += mNumberPointsInPerCellLeft[ll];
+            score += ws.motionStatistics.ptr<int>(ll)[rr];
+            thresh += ws.numberPointsInPerCellLeft[ll];
             numpair++;
         }
 
         thresh = mThresholdFactor * std::sqrt(thresh / numpair);
 
         if (score < thresh)
-            mCellPairs[i] = -2;
+            ws.cellPairs[i] = -2;
     }
 }
 
-void matchGMS( const Size& size1, const Size& size2, const vector<KeyPoint>& keypoints1, const vector<KeyPoint>& keypoints2,
-               const vector<DMatch>& matches1to2, vector<DMatch>& matchesGMS, const bool withRotation, const bool withScale,
-               const double thresholdFactor )
+void GMSMatcher_Impl::match(const Size& size1, const Size& size2, const vector<KeyPoint>& keypoints1,
+                            const vector<KeyPoint>& keypoints2, const vector<DMatch>& matches1to2,
+                            vector<DMatch>& matchesGMS)
 {
-    GMSMatcher gms(keypoints1, size1, keypoints2, size2, matches1to2, thresholdFactor);
+    // Input initialize
+    normalizePoints(keypoints1, size1, mvP1);
+    normalizePoints(keypoints2, size2, mvP2);
+    mNumberMatches = matches1to2.size();
+
+    // Cell indices only depend on the grid type (left) or on the scale (right)
+    for (int gridType = 1; gridType <= mNumberGridTypes; gridType++)
+    {
+        vector<int>& cells = mMatchCellsLeft[gridType - 1];
+        cells.resize(mNumberMatches);
+        for (size_t i = 0; i < mNumberMatches; i++)
+            cells[i] = getGridIndexLeft(mvP1[matches1to2[i].queryIdx], gridType);
+    }
+    for (int scale = 0; scale < mNumberScales; scale++)
+    {
+        vector<int>& cells = mMatchCellsRight[scale];
+        cells.resize(mNumberMatches);
+        if (scale > 0 && !mWithScale)
+            continue;
+        for (size_t i = 0; i < mNumberMatches; i++)
+            cells[i] = getGridIndexRight(mvP2[matches1to2[i].trainIdx], scale);
+    }
+
     vector<bool> inlierMask;
-    gms.getInlierMask(inlierMask, withRotation, withScale);
+    getInlierMask(inlierMask);
 
     matchesGMS.clear();
     for (size_t i = 0; i < inlierMask.size(); i++) {
@@ -456,5 +469,18 @@ void matchGMS( const Size& size1, const Size& size2, const vector<KeyPoint>& key
     }
 }
 
+Ptr<GMSMatcher> GMSMatcher::create(bool withRotation, bool withScale, double thresholdFactor)
+{
+    return makePtr<GMSMatcher_Impl>(withRotation, withScale, thresholdFactor);
+}
+
+void matchGMS( const Size& size1, const Size& size2, const vector<KeyPoint>& keypoints1, const vector<KeyPoint>& keypoints2,
+               const vector<DMatch>& matches1to2, vector<DMatch>& matchesGMS, const bool withRotation, const bool withScale,
+               const double thresholdFactor )
+{
+    GMSMatcher_Impl gms(withRotation, withScale, thresholdFactor);
+    gms.match(size1, size2, keypoints1, keypoints2, matches1to2, matchesGMS);
+}
+
 } //namespace xfeatures2d
 } //namespace cv
@@ -3,6 +3,7 @@
 // of this distribution and at http://opencv.org/license.html
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace {
 
@@ -40,6 +41,8 @@ private:
     std::vector<Octave> octaves;
     std::vector<DOGOctave> DOG_octaves;
     void build(const Mat& img, bool DOG);
+    void buildUpsampledOctave(const Mat& img, std::vector<Mat>& layers);
+    void buildOctaves(const Mat& img, int omin, std::vector<std::vector<Mat> >& octave_layers);
 public:
     class Params
     {
@@ -87,124 +90,143 @@ Pyramid::Pyramid(const Mat & img, int octavesN_, int layersN_, float sigma0_, in
 /**
  * Build gaussian pyramid with layersN_ + 3 layers and 2^(1/layersN_) step between layers
  * each octave is downsampled of a factor of 2
+ *
+ * The optional upsampled octave (omin < 0) and the chain of regular octaves only share the
+ * input image, so both chains are built concurrently. DOG layers are computed afterwards
+ * in one parallel pass over every (octave, layer) pair.
  */
 
 void Pyramid::build(const Mat& img, bool DOG)
 {
+    int omin = params.omin;
+    if (omin < 0)
+        omin = -1;
 
-    Size ksize(0, 0);
-    int gsize;
+    std::vector<Mat> up_layers;
+    std::vector<std::vector<Mat> > base_layers(params.octavesN);
 
-    float sigma0 = params.sigma0;
-    float sigma = sigma0;
-    int layersN = params.layersN + 3;
-    int omin = params.omin;
-    float k = params.step;
+    parallel_for_(Range(0, omin < 0 ? 2 : 1), [&](const Range& range)
+    {
+        for (int chain = range.start; chain < range.end; chain++)
+        {
+            if (chain == 0)
+                buildOctaves(img, omin, base_layers);
+            else
+                buildUpsampledOctave(img, up_layers);
+        }
+    });
 
-    /*layer to downsample*/
-    int down_lay = int(1 / log(k));
+    if (omin < 0)
+        octaves.push_back(Octave(up_layers));
+    for (size_t i = 0; i < base_layers.size(); i++)
+        octaves.push_back(Octave(base_layers[i]));
 
-    int octave, layer;
-    double sigmaN = 0.5;
+    if (!DOG)
+        return;
 
-    std::vector<Mat> layers, DOG_layers;
-    /* standard deviation of current layer*/
-    float sigma_curr = sigma;
-    /* standard deviation of previous layer*/
-    float sigma_prev = sigma;
+    /* every DOG layer only depends on two adjacent gaussian layers */
+    std::vector<Point> dog_index;
+    std::vector<std::vector<Mat> > dog_layers(octaves.size());
+    for (size_t octave = 0; octave < octaves.size(); octave++)
+    {
+        int n = (int) octaves[octave].layers.size() - 1;
+        dog_layers[octave].resize(n);
+        for (int layer = 0; layer < n; layer++)
+            dog_index.push_back(Point(layer, (int) octave));
+    }
 
-    if (omin < 0)
+    parallel_for_(Range(0, (int) dog_index.size()), [&](const Range& range)
     {
-        omin = -1;
-        Mat tmp_img;
-        Mat blurred_img;
-        gsize = int(ceil(sigmaN * 3)) * 2 + 1;
-        GaussianBlur(img, blurred_img, Size(gsize,gsize), sigmaN);
-        resize(blurred_img, tmp_img, ksize, 2, 2, INTER_AREA);
-        layers.push_back(tmp_img);
-
-        for (layer = 1; layer < layersN; layer++)
+        for (int i = range.start; i < range.end; i++)
         {
-            sigma_curr = getSigma(layer);
-            sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
-            Mat prev_lay = layers[layer - 1], curr_lay, DOG_lay;
-            /* smoothing is applied on previous layer so sigma_curr^2 = sigma^2 + sigma_prev^2 */
-            gsize = int(ceil(sigma * 3)) * 2 + 1;
-            GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
-            layers.push_back(curr_lay);
-            if (DOG)
-            {
-                absdiff(curr_lay, prev_lay, DOG_lay);
-                DOG_layers.push_back(DOG_lay);
-            }
-            sigma_prev = sigma_curr;
-
+            const Point& idx = dog_index[i];
+            const std::vector<Mat>& layers = octaves[idx.y].layers;
+            absdiff(layers[idx.x + 1], layers[idx.x], dog_layers[idx.y][idx.x]);
         }
-        Octave tmp_oct(layers);
-        octaves.push_back(tmp_oct);
-        layers.clear();
+    });
 
-        if (DOG)
-        {
-            DOGOctave tmp_DOG_Oct(DOG_layers);
-            DOG_octaves.push_back(tmp_DOG_Oct);
-            DOG_layers.clear();
-        }
+    for (size_t octave = 0; octave < dog_layers.size(); octave++)
+        DOG_octaves.push_back(DOGOctave(dog_layers[octave]));
+}
 
+/**
+ * Build the octave preceding the first one, where the image size is doubled
+ */
+void Pyramid::buildUpsampledOctave(const Mat& img, std::vector<Mat>& layers)
+{
+    const double sigmaN = 0.5;
+    const int layersN = params.layersN + 3;
+    float sigma_prev = params.sigma0;
+
+    Mat tmp_img;
+    Mat blurred_img;
+    int gsize = int(ceil(sigmaN * 3)) * 2 + 1;
+    GaussianBlur(img, blurred_img, Size(gsize,gsize), sigmaN);
+    resize(blurred_img, tmp_img, Size(0, 0), 2, 2, INTER_AREA);
+    layers.push_back(tmp_img);
+
+    for (int layer = 1; layer < layersN; layer++)
+    {
+        float sigma_curr = getSigma(layer);
+        float sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
+        Mat curr_lay;
+        /* smoothing is applied on previous layer so sigma_curr^2 = sigma^2 + sigma_prev^2 */
+        gsize = int(ceil(sigma * 3)) * 2 + 1;
+        GaussianBlur(layers[layer - 1], curr_lay, Size(gsize,gsize), sigma);
+        layers.push_back(curr_lay);
+        sigma_prev = sigma_curr;
     }
+}
+
+/**
+ * Build params.octavesN octaves starting from the input image,
+ * each octave starts from the downsampled layer of the previous one
+ */
+void Pyramid::buildOctaves(const Mat& img, int omin, std::vector<std::vector<Mat> >& octave_layers)
+{
+    const double sigmaN = 0.5;
+    const int layersN = params.layersN + 3;
+    const float sigma0 = params.sigma0;
+
+    /*layer to downsample*/
+    int down_lay = int(1 / log(params.step));
 
     /* Presmoothing on first layer */
     float sb = float(sigmaN) / powf(2.0f, (float) omin);
-    sigma = sigma0;
+    float sigma = sigma0;
     if (sigma0 > sb)
         sigma = sqrt(sigma0 * sigma0 - sb * sb);
 
     /*1° step on image*/
     Mat tmpImg;
-    gsize = int(ceil(sigma * 3)) * 2 + 1;
+    int gsize = int(ceil(sigma * 3)) * 2 + 1;
     GaussianBlur(img, tmpImg, Size(gsize,gsize), sigma);
-    layers.push_back(tmpImg);
 
     /*for every octave build layers*/
-    sigma_prev = sigma;
+    float sigma_prev = sigma;
 
-    for (octave = 0; octave < params.octavesN; octave++)
+    for (int octave = 0; octave < params.octavesN; octave++)
     {
-        for (layer = 1; layer < layersN; layer++)
+        std::vector<Mat>& layers = octave_layers[octave];
+        layers.reserve(layersN);
+        layers.push_back(tmpImg);
+
+        for (int layer = 1; layer < layersN; layer++)
         {
-            sigma_curr = getSigma(layer);
+            float sigma_curr = getSigma(layer);
             sigma = sqrt(powf(sigma_curr, 2) - powf(sigma_prev, 2));
 
-            Mat prev_lay = layers[layer - 1], curr_lay, DOG_lay;
+            Mat curr_lay;
             gsize = int(ceil(sigma * 3)) * 2 + 1;
-            GaussianBlur(prev_lay, curr_lay, Size(gsize,gsize), sigma);
+            GaussianBlur(layers[layer - 1], curr_lay, Size(gsize,gsize), sigma);
             layers.push_back(curr_lay);
-
-            if (DOG)
-            {
-                absdiff(curr_lay, prev_lay, DOG_lay);
-                DOG_layers.push_back(DOG_lay);
-            }
             sigma_prev = sigma_curr;
         }
 
-        Mat resized_lay;
-        resize(layers[down_lay], resized_lay, ksize, 1.0f / 2, 1.0f / 2, INTER_AREA);
-
-        Octave tmp_oct(layers);
-        octaves.push_back(tmp_oct);
-        if (DOG)
-        {
-            DOGOctave tmp_DOG_Oct(DOG_layers);
-            DOG_octaves.push_back(tmp_DOG_Oct);
-            DOG_layers.clear();
-        }
-        sigma_curr = sigma_prev = sigma0;
-        layers.clear();
-        layers.push_back(resized_lay);
-
+        tmpImg = Mat();
+        resize(layers[down_lay], tmpImg, Size(0, 0), 1.0f / 2, 1.0f / 2, INTER_AREA);
+        sigma_prev = sigma0;
     }
-
 }
 
 /**
@@ -330,6 +352,8 @@ public:
 
 protected:
     void detect( InputArray image, std::vector<KeyPoint>& keypoints, InputArray mask=noArray() ) CV_OVERRIDE;
+    void detectInLayer( Pyramid& pyr, int octave, int layer, Size image_size,
+                        const Mat& mask, std::vector<KeyPoint>& keypoints ) const;
 
     int numOctaves;
     float corn_thresh;
@@ -382,6 +406,160 @@ void HarrisLaplaceFeatureDetector_Impl::write (FileStorage& fs) const
     fs << "num_layers" << num_layers;
 }
 
+/*
+ * Cornerness of the second moment matrix, det(M) - 0.04 * tr(M)^2
+ */
+static void computeCornerness(const Mat& dx2, const Mat& dy2, const Mat& dxy, Mat& cornerness)
+{
+    cornerness.create(dx2.size(), CV_32F);
+    for (int row = 0; row < dx2.rows; row++)
+    {
+        const float* dx2_row = dx2.ptr<float>(row);
+        const float* dy2_row = dy2.ptr<float>(row);
+        const float* dxy_row = dxy.ptr<float>(row);
+        float* dst = cornerness.ptr<float>(row);
+        int col = 0;
+#if CV_SIMD128
+        const v_float32x4 v_k = v_setall_f32(0.04f);
+        for (; col <= dx2.cols - 4; col += 4)
+        {
+            v_float32x4 a = v_load(dx2_row + col);
+            v_float32x4 b = v_load(dy2_row + col);
+            v_float32x4 c = v_load(dxy_row + col);
+            v_float32x4 det = a * b - c * c;
+            v_float32x4 tr = a + b;
+            v_store(dst + col, det - (v_k * tr * tr));
+        }
+#endif
+        for (; col < dx2.cols; col++)
+        {
+            float dx2f = dx2_row[col];
+            float dy2f = dy2_row[col];
+            float dxyf = dxy_row[col];
+            float det = dx2f * dy2f - dxyf * dxyf;
+            float tr = dx2f + dy2f;
+            dst[col] = det - (0.04f * tr * tr);
+        }
+    }
+}
+
+/*
+ * Find Harris corners on a single pyramid layer which are also DOG maxima across scales
+ */
+void HarrisLaplaceFeatureDetector_Impl::detectInLayer(Pyramid& pyr, int octave, int layer, Size image_size,
+                                                      const Mat& mask, std::vector<KeyPoint>& keypoints) const
+{
+    Mat Lx, Ly;
+    Mat Lxm2smooth, Lxmysmooth, Lym2smooth;
+
+    float si = powf(2.f, layer / (float) num_layers);
+    float sd = si * 0.7f;
+
+    Mat curr_layer;
+    if (num_layers == 4)
+    {
+        if (layer == 1)
+        {
+            Mat tmp = pyr.getLayer(octave - 1, num_layers - 1);
+            resize(tmp, curr_layer, Size(0, 0), 0.5, 0.5, INTER_AREA);
+
+        } else
+            curr_layer = pyr.getLayer(octave, layer - 2);
+    } else /*if num_layer==2*/
+    {
+
+        curr_layer = pyr.getLayer(octave, layer - 1);
+    }
+
+    /*Calculates second moment matrix*/
+
+    /*Derivatives*/
+    Sobel(curr_layer, Lx, CV_32F, 1, 0, 1);
+    Sobel(curr_layer, Ly, CV_32F, 0, 1, 1);
+
+    /*Normalization*/
+    Lx = Lx * sd;
+    Ly = Ly * sd;
+
+    Mat Lxm2 = Lx.mul(Lx);
+    Mat Lym2 = Ly.mul(Ly);
+    Mat Lxmy = Lx.mul(Ly);
+
+    int gsize = int(ceil(si * 3)) * 2 + 1;
+
+    /*Convolution*/
+    GaussianBlur(Lxm2, Lxm2smooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
+    GaussianBlur(Lym2, Lym2smooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
+    GaussianBlur(Lxmy, Lxmysmooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
+
+    /*Calculates cornerness in each pixel of the image*/
+    Mat cornern_mat;
+    computeCornerness(Lxm2smooth, Lym2smooth, Lxmysmooth, cornern_mat);
+
+    double maxVal = 0;
+    Mat corn_dilate;
+
+    /*Find max cornerness value and rejects all corners that are lower than a threshold*/
+    minMaxLoc(cornern_mat, 0, &maxVal, 0, 0);
+    threshold(cornern_mat, cornern_mat, maxVal * corn_thresh, 0, THRESH_TOZERO);
+    dilate(cornern_mat, corn_dilate, Mat());
+
+    Size imgsize = curr_layer.size();
+
+    /*Verify for each of the initial points whether the DoG attains a maximum at the scale of the point*/
+    Mat prevDOG, curDOG, succDOG;
+    prevDOG = pyr.getDOGLayer(octave, layer - 1);
+    curDOG = pyr.getDOGLayer(octave, layer);
+    succDOG = pyr.getDOGLayer(octave, layer + 1);
+
+    const float octave_scale = powf(2.0f, (float) octave - 1);
+    const float kp_size = 3 * octave_scale * si * 2;
+
+    for (int y = 1; y < imgsize.height - 1; y++)
+    {
+        const float* corn_row = cornern_mat.ptr<float>(y);
+        const float* dilate_row = corn_dilate.ptr<float>(y);
+        const float* cur_row = curDOG.ptr<float>(y);
+        const float* prev_row = prevDOG.ptr<float>(y);
+        const float* succ_row = succDOG.ptr<float>(y);
+
+        for (int x = 1; x < imgsize.width - 1; x++)
+        {
+            float val = corn_row[x];
+            if (val != 0 && val == dilate_row[x])
+            {
+
+                float curVal = cur_row[x];
+                float prevVal = prev_row[x];
+                float succVal = succ_row[x];
+
+                KeyPoint kp(
+                        Point2f(x * octave_scale + octave_scale / 2,
+                                y * octave_scale + octave_scale / 2),
+                        kp_size, 0, val, octave);
+
+                if(!mask.empty() && mask.at<unsigned char>(int(kp.pt.y), int(kp.pt.x)) == 0)
+                {
+                    // ignore keypoints where mask is zero
+                    continue;
+                }
+
+                /*Check whether keypoint size is inside the image*/
+                float start_kp_x = kp.pt.x - kp.size / 2;
+                float start_kp_y = kp.pt.y - kp.size / 2;
+                float end_kp_x = start_kp_x + kp.size;
+                float end_kp_y = start_kp_y + kp.size;
+
+                if (curVal > prevVal && curVal > succVal && curVal >= DOG_thresh
+                        && start_kp_x > 0 && start_kp_y > 0 && end_kp_x < image_size.width
+                        && end_kp_y < image_size.height)
+                    keypoints.push_back(kp);
+
+            }
+        }
+    }
+}
+
 /*
  * Detect method
  * The method detect Harris corners on scale space as described in
@@ -403,142 +581,36 @@ void HarrisLaplaceFeatureDetector_Impl::detect(InputArray img, std::vector<KeyPo
         CV_Assert(mask.type() == CV_8UC1);
         CV_Assert(mask.size == image.size);
     }
-    Mat_<float> dx2, dy2, dxy;
-    Mat Lx, Ly;
-    float si, sd;
-    int gsize;
     Mat fimage;
     image.convertTo(fimage, CV_32F, 1.f/255);
     /*Build gaussian pyramid*/
     Pyramid pyr(fimage, numOctaves, num_layers, 1, -1, true);
-    keypoints = std::vector<KeyPoint> (0);
 
     /*Find Harris corners on each layer*/
     //Use pyr.params.octavesN instead of numOctaves. See issue #1513
+    std::vector<Point> tasks;
     for (int octave = 0; octave <= pyr.params.octavesN; octave++)
     {
         for (int layer = 1; layer <= num_layers; layer++)
         {
             if (octave == 0)
                 layer = num_layers;
-
-            Mat Lxm2smooth, Lxmysmooth, Lym2smooth;
-
-            si = powf(2.f, layer / (float) num_layers);
-            sd = si * 0.7f;
-
-            Mat curr_layer;
-            if (num_layers == 4)
-            {
-                if (layer == 1)
-                {
-                    Mat tmp = pyr.getLayer(octave - 1, num_layers - 1);
-                    resize(tmp, curr_layer, Size(0, 0), 0.5, 0.5, INTER_AREA);
-
-                } else
-                    curr_layer = pyr.getLayer(octave, layer - 2);
-            } else /*if num_layer==2*/
-            {
-
-                curr_layer = pyr.getLayer(octave, layer - 1);
-            }
-
-            /*Calculates second moment matrix*/
-
-            /*Derivatives*/
-            Sobel(curr_layer, Lx, CV_32F, 1, 0, 1);
-            Sobel(curr_layer, Ly, CV_32F, 0, 1, 1);
-
-            /*Normalization*/
-            Lx = Lx * sd;
-            Ly = Ly * sd;
-
-            Mat Lxm2 = Lx.mul(Lx);
-            Mat Lym2 = Ly.mul(Ly);
-            Mat Lxmy = Lx.mul(Ly);
-
-            gsize = int(ceil(si * 3)) * 2 + 1;
-
-            /*Convolution*/
-            GaussianBlur(Lxm2, Lxm2smooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
-            GaussianBlur(Lym2, Lym2smooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
-            GaussianBlur(Lxmy, Lxmysmooth, Size(gsize, gsize), si, si, BORDER_REPLICATE);
-
-            Mat cornern_mat(curr_layer.size(), CV_32F);
-
-            /*Calculates cornerness in each pixel of the image*/
-            for (int row = 0; row < curr_layer.rows; row++)
-            {
-                for (int col = 0; col < curr_layer.cols; col++)
-                {
-                    float dx2f = Lxm2smooth.at<float> (row, col);
-                    float dy2f = Lym2smooth.at<float> (row, col);
-                    float dxyf = Lxmysmooth.at<float> (row, col);
-                    float det = dx2f * dy2f - dxyf * dxyf;
-                    float tr = dx2f + dy2f;
-                    float cornerness = det - (0.04f * tr * tr);
-                    cornern_mat.at<float> (row, col) = cornerness;
-                }
-            }
-
-            double maxVal = 0;
-            Mat corn_dilate;
-
-            /*Find max cornerness value and rejects all corners that are lower than a threshold*/
-            minMaxLoc(cornern_mat, 0, &maxVal, 0, 0);
-            threshold(cornern_mat, cornern_mat, maxVal * corn_thresh, 0, THRESH_TOZERO);
-            dilate(cornern_mat, corn_dilate, Mat());
-
-            Size imgsize = curr_layer.size();
-
-            /*Verify for each of the initial points whether the DoG attains a maximum at the scale of the point*/
-            Mat prevDOG, curDOG, succDOG;
-            prevDOG = pyr.getDOGLayer(octave, layer - 1);
-            curDOG = pyr.getDOGLayer(octave, layer);
-            succDOG = pyr.getDOGLayer(octave, layer + 1);
-
-            for (int y = 1; y < imgsize.height - 1; y++)
-            {
-                for (int x = 1; x < imgsize.width - 1; x++)
-                {
-                    float val = cornern_mat.at<float> (y, x);
-                    if (val != 0 && val == corn_dilate.at<float> (y, x))
-                    {
-
-                        float curVal = curDOG.at<float> (y, x);
-                        float prevVal =  prevDOG.at<float> (y, x);
-                        float succVal = succDOG.at<float> (y, x);
-
-                        KeyPoint kp(
-                                Point2f(x * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2,
-                                        y * powf(2.0f, (float) octave - 1) + powf(2.0f, (float) octave - 1) / 2),
-                                3 * powf(2.0f, (float) octave - 1) * si * 2, 0, val, octave);
-
-                        if(!mask.empty() && mask.at<unsigned char>(int(kp.pt.y), int(kp.pt.x)) == 0)
-                        {
-                            // ignore keypoints where mask is zero
-                            continue;
-                        }
-
-                        /*Check whether keypoint size is inside the image*/
-                        float start_kp_x = kp.pt.x - kp.size / 2;
-                        float start_kp_y = kp.pt.y - kp.size / 2;
-                        float end_kp_x = start_kp_x + kp.size;
-                        float end_kp_y = start_kp_y + kp.size;
-
-                        if (curVal > prevVal && curVal > succVal && curVal >= DOG_thresh
-                                && start_kp_x > 0 && start_kp_y > 0 && end_kp_x < image.cols
-                                && end_kp_y < image.rows)
-                            keypoints.push_back(kp);
-
-                    }
-                }
-            }
-
+            tasks.push_back(Point(layer, octave));
         }
-
     }
 
+    /*Layers are independent once the pyramid is built, results are merged in the serial order*/
+    std::vector<std::vector<KeyPoint> > layer_keypoints(tasks.size());
+    parallel_for_(Range(0, (int) tasks.size()), [&](const Range& range)
+    {
+        for (int i = range.start; i < range.end; i++)
+            detectInLayer(pyr, tasks[i].y, tasks[i].x, image.size(), mask, layer_keypoints[i]);
+    });
+
+    keypoints.clear();
+    for (size_t i = 0; i < layer_keypoints.size(); i++)
+        keypoints.insert(keypoints.end(), layer_keypoints[i].begin(), layer_keypoints[i].end());
+
     /*Sort keypoints in decreasing cornerness order*/
     sort(keypoints.begin(), keypoints.end(), sort_func);
     for (size_t i = 1; i < keypoints.size(); i++)
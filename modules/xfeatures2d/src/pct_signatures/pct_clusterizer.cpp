@@ -142,6 +142,7 @@ namespace cv
 
 
                     // Main iterations cycle. Our implementation has fixed number of iterations.
+                    std::vector<int> labels(samples.rows);
                     for (int iteration = 0; iteration < mIterationCount; iteration++)
                     {
                         // Prepare space for new centroid values.
@@ -151,10 +152,19 @@ namespace cv
                         // Clear weights for new iteration.
                         clusters(Rect(WEIGHT_IDX, 0, 1, clusters.rows)) = 0;
 
-                        // Compute affiliation of points and sum new coordinates for centroids.
+                        // Compute affiliation of points in parallel.
+                        parallel_for_(Range(0, samples.rows), [&](const Range& range)
+                        {
+                            for (int iSample = range.start; iSample < range.end; iSample++)
+                            {
+                                labels[iSample] = findClosestCluster(clusters, samples, iSample);
+                            }
+                        });
+
+                        // Sum new coordinates for centroids (sequentially, so the sums do not depend on threading).
                         for (int iSample = 0; iSample < samples.rows; iSample++)
                         {
-                            int iClosest = findClosestCluster(clusters, samples, iSample);
+                            int iClosest = labels[iSample];
                             for (int iDimension = 1; iDimension < SIGNATURE_DIMENSION; iDimension++)
                             {
                                 tmpCentroids.at<float>(iClosest, iDimension) += samples.at<float>(iSample, iDimension);
@@ -217,22 +227,36 @@ namespace cv
                 */
                 void joinCloseClusters(Mat& clusters)
                 {
-                    for (int i = 0; i < clusters.rows - 1; i++)
+                    // Cluster i is only compared with clusters j > i whose weights are not changed
+                    // before i is visited, so all the decisions can be made in parallel.
+                    std::vector<uchar> joined(clusters.rows, 0);
+                    parallel_for_(Range(0, std::max(clusters.rows - 1, 0)), [&](const Range& range)
                     {
-                        if (clusters.at<float>(i, WEIGHT_IDX) == 0)
+                        for (int i = range.start; i < range.end; i++)
                         {
-                            continue;
-                        }
+                            if (clusters.at<float>(i, WEIGHT_IDX) == 0)
+                            {
+                                continue;
+                            }
 
-                        for (int j = i + 1; j < clusters.rows; j++)
-                        {
-                            if (clusters.at<float>(j, WEIGHT_IDX) > 0
-                                && computeDistance(mDistanceFunction, clusters, i, clusters, j) <= mJoiningDistance)
+                            for (int j = i + 1; j < clusters.rows; j++)
                             {
-                                clusters.at<float>(i, WEIGHT_IDX) = 0;
-                                break;
+                                if (clusters.at<float>(j, WEIGHT_IDX) > 0
+                                    && computeDistance(mDistanceFunction, clusters, i, clusters, j) <= mJoiningDistance)
+                                {
+                                    joined[i] = 1;
+                                    break;
+                                }
                             }
                         }
+                    });
+
+                    for (int i = 0; i < clusters.rows; i++)
+                    {
+                        if (joined[i])
+                        {
+                            clusters.at<float>(i, WEIGHT_IDX) = 0;
+                        }
                     }
                 }
 
@@ -58,8 +58,10 @@ References:
 */
 #include "precomp.hpp"
 
+#include "opencv2/core/hal/hal.hpp"
+#include "opencv2/core/hal/intrin.hpp"
+
 #include "pct_signatures/constants.hpp"
-#include "pct_signatures/similarity.hpp"
 
 namespace cv
 {
@@ -67,6 +69,34 @@ namespace cv
     {
         namespace pct_signatures
         {
+            /**
+            * @brief Signature stored plane by plane (weights, then each coordinate)
+            *       with the centroid count padded to the SIMD width.
+            *       Padding centroids have zero weight, so they do not contribute to the SQFD.
+            */
+            struct PackedSignature
+            {
+                int count;
+                int stride;
+                std::vector<float> data;
+
+                PackedSignature() : count(0), stride(0) {}
+
+                const float* plane(int d) const { return &data[d * stride]; }
+            };
+
+
+            /**
+            * @brief Working set of one parallel task of the batched distance computation.
+            */
+            struct SQFDWorkspace
+            {
+                std::vector<PackedSignature> signatures;
+                std::vector<float> selfTerms;
+                std::vector<float> row;
+            };
+
+
             class PCTSignaturesSQFD_Impl : public PCTSignaturesSQFD
             {
             public:
@@ -91,63 +121,352 @@ namespace cv
                     const std::vector<Mat>& imageSignatures,
                     std::vector<float>& distances) const CV_OVERRIDE;
 
+                void computeQuadraticFormDistances(
+                    const std::vector<Mat>& querySignatures,
+                    const std::vector<Mat>& databaseSignatures,
+                    OutputArray distances) const CV_OVERRIDE;
+
 
             private:
+                /**
+                * @brief Number of database signatures processed by one parallel task.
+                */
+                enum { DATABASE_TILE = 16 };
+
+                /**
+                * @brief Number of query signatures kept hot while sweeping a database tile.
+                */
+                enum { QUERY_TILE = 8 };
+
                 int mDistanceFunction;
                 int mSimilarityFunction;
                 float mSimilarityParameter;
 
+                void checkFunctions() const;
+
                 float computePartialSQFD(
-                    const Mat& signature0,
-                    const Mat& signature1) const;
+                    const PackedSignature& signature0,
+                    const PackedSignature& signature1,
+                    float* row) const;
+
+                void computeRowSimilarities(
+                    const float* point,
+                    const PackedSignature& signature,
+                    float* row) const;
+
+                void computeDistanceMatrix(
+                    const std::vector<PackedSignature>& queries,
+                    const std::vector<float>& querySelfTerms,
+                    const std::vector<Mat>& databaseSignatures,
+                    Mat& distances) const;
 
             };
 
 
+            static void packSignature(const Mat& signature, PackedSignature& packed)
+            {
+                if (signature.cols != SIGNATURE_DIMENSION)
+                {
+                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
+                }
+                if (signature.rows <= 0)
+                {
+                    CV_Error(Error::StsBadArg, "Signature count must be greater than 0!");
+                }
+                CV_Assert(signature.type() == CV_32FC1);
+
+                packed.count = signature.rows;
+                packed.stride = alignSize(signature.rows, 4);
+                packed.data.resize(SIGNATURE_DIMENSION * packed.stride);
+
+                for (int i = 0; i < packed.stride; i++)
+                {
+                    // padding repeats the first centroid, so its similarity stays finite
+                    const float* point = signature.ptr<float>(i < packed.count ? i : 0);
+                    for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        packed.data[d * packed.stride + i] = point[d];
+                    }
+                    if (i >= packed.count)
+                    {
+                        packed.data[WEIGHT_IDX * packed.stride + i] = 0;
+                    }
+                }
+            }
+
+
+            static inline float rowDot(const float* a, const float* b, int n)
+            {
+                int j = 0;
+                float result = 0;
+#if CV_SIMD128
+                v_float32x4 sum = v_setzero_f32();
+                for (; j <= n - v_float32x4::nlanes; j += v_float32x4::nlanes)
+                {
+                    sum = v_muladd(v_load(a + j), v_load(b + j), sum);
+                }
+                result = v_reduce_sum(sum);
+#endif
+                for (; j < n; j++)
+                {
+                    result += a[j] * b[j];
+                }
+                return result;
+            }
+
+
+            void PCTSignaturesSQFD_Impl::checkFunctions() const
+            {
+                if (mDistanceFunction < PCTSignatures::L0_25 || mDistanceFunction > PCTSignatures::L_INFINITY)
+                {
+                    CV_Error(Error::StsBadArg, "Distance function not implemented!");
+                }
+                if (mSimilarityFunction < PCTSignatures::MINUS || mSimilarityFunction > PCTSignatures::HEURISTIC)
+                {
+                    CV_Error(Error::StsNotImplemented, "Similarity function not implemented!");
+                }
+            }
+
+
             /**
-            * @brief Class implementing parallel computing of SQFD distance for multiple images.
+            * @brief Similarities of one centroid to all (padded) centroids of a signature.
+            * @param point Centroid coordinates, indexed the same way as the signature columns.
+            * @param signature Packed signature.
+            * @param row Output similarities, signature.stride values.
             */
-            class Parallel_computeSQFDs : public ParallelLoopBody
+            void PCTSignaturesSQFD_Impl::computeRowSimilarities(
+                      const float* point,
+                      const PackedSignature& signature,
+                      float* row) const
             {
-            private:
-                const PCTSignaturesSQFD* mPctSignaturesSQFDAlgorithm;
-                const Mat* mSourceSignature;
-                const std::vector<Mat>* mImageSignatures;
-                std::vector<float>* mDistances;
+                const int n = signature.stride;
+                int j = 0;
 
-            public:
-                Parallel_computeSQFDs(
-                    const PCTSignaturesSQFD* pctSignaturesSQFDAlgorithm,
-                    const Mat* sourceSignature,
-                    const std::vector<Mat>* imageSignatures,
-                    std::vector<float>* distances)
-                    : mPctSignaturesSQFDAlgorithm(pctSignaturesSQFDAlgorithm),
-                    mSourceSignature(sourceSignature),
-                    mImageSignatures(imageSignatures),
-                    mDistances(distances)
+#if CV_SIMD128
+                for (; j < n; j += v_float32x4::nlanes)
                 {
-                    mDistances->resize(imageSignatures->size());
+                    v_float32x4 result = v_setzero_f32();
+                    for (int d = 1; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        v_float32x4 difference = v_setall_f32(point[d]) - v_load(signature.plane(d) + j);
+                        switch (mDistanceFunction)
+                        {
+                        case PCTSignatures::L0_25:
+                            result += v_sqrt(v_sqrt(v_abs(difference)));
+                            break;
+                        case PCTSignatures::L0_5:
+                            result += v_sqrt(v_abs(difference));
+                            break;
+                        case PCTSignatures::L1:
+                            result += v_abs(difference);
+                            break;
+                        case PCTSignatures::L2:
+                        case PCTSignatures::L2SQUARED:
+                            result = v_muladd(difference, difference, result);
+                            break;
+                        case PCTSignatures::L5:
+                        {
+                            v_float32x4 squared = difference * difference;
+                            result += v_abs(difference) * squared * squared;
+                            break;
+                        }
+                        case PCTSignatures::L_INFINITY:
+                            result = v_max(result, difference);
+                            break;
+                        }
+                    }
+                    switch (mDistanceFunction)
+                    {
+                    case PCTSignatures::L0_25:
+                        result = result * result;
+                        result = result * result;
+                        break;
+                    case PCTSignatures::L0_5:
+                        result = result * result;
+                        break;
+                    case PCTSignatures::L2:
+                        result = v_sqrt(result);
+                        break;
+                    }
+                    v_store(row + j, result);
+                }
+#endif
+                for (; j < n; j++)
+                {
+                    float result = 0;
+                    for (int d = 1; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        float difference = point[d] - signature.plane(d)[j];
+                        switch (mDistanceFunction)
+                        {
+                        case PCTSignatures::L0_25:
+                            result += std::sqrt(std::sqrt(std::abs(difference)));
+                            break;
+                        case PCTSignatures::L0_5:
+                            result += std::sqrt(std::abs(difference));
+                            break;
+                        case PCTSignatures::L1:
+                            result += std::abs(difference);
+                            break;
+                        case PCTSignatures::L2:
+                        case PCTSignatures::L2SQUARED:
+                            result += difference * difference;
+                            break;
+                        case PCTSignatures::L5:
+                            result += std::abs(difference) * difference * difference * difference * difference;
+                            break;
+                        case PCTSignatures::L_INFINITY:
+                            result = std::max(result, difference);
+                            break;
+                        }
+                    }
+                    switch (mDistanceFunction)
+                    {
+                    case PCTSignatures::L0_25:
+                        result *= result;
+                        result *= result;
+                        break;
+                    case PCTSignatures::L0_5:
+                        result *= result;
+                        break;
+                    case PCTSignatures::L2:
+                        result = std::sqrt(result);
+                        break;
+                    }
+                    row[j] = result;
+                }
+
+                if (mDistanceFunction == PCTSignatures::L5)
+                {
+                    for (j = 0; j < n; j++)
+                    {
+                        row[j] = std::pow(row[j], (float)0.2);
+                    }
                 }
 
-                void operator()(const Range& range) const CV_OVERRIDE
+                // turn distances into similarities
+                j = 0;
+                switch (mSimilarityFunction)
                 {
-                    if (mSourceSignature->empty())
+                case PCTSignatures::MINUS:
+                    for (; j < n; j++)
+                    {
+                        row[j] = -row[j];
+                    }
+                    break;
+                case PCTSignatures::GAUSSIAN:
+                    for (; j < n; j++)
                     {
-                        CV_Error(Error::StsBadArg, "Source signature is empty!");
+                        row[j] = -mSimilarityParameter * row[j] * row[j];
                     }
+                    hal::exp32f(row, row, n);
+                    break;
+                case PCTSignatures::HEURISTIC:
+                {
+#if CV_SIMD128
+                    v_float32x4 one = v_setall_f32(1.f), alpha = v_setall_f32(mSimilarityParameter);
+                    for (; j < n; j += v_float32x4::nlanes)
+                    {
+                        v_store(row + j, one / (alpha + v_load(row + j)));
+                    }
+#endif
+                    for (; j < n; j++)
+                    {
+                        row[j] = 1 / (mSimilarityParameter + row[j]);
+                    }
+                    break;
+                }
+                }
+            }
+
+
+            float PCTSignaturesSQFD_Impl::computePartialSQFD(
+                      const PackedSignature& signature0,
+                      const PackedSignature& signature1,
+                      float* row) const
+            {
+                float point[SIGNATURE_DIMENSION];
+                double result = 0;
+                for (int i = 0; i < signature0.count; i++)
+                {
+                    for (int d = 0; d < SIGNATURE_DIMENSION; d++)
+                    {
+                        point[d] = signature0.plane(d)[i];
+                    }
+                    computeRowSimilarities(point, signature1, row);
+                    result += point[WEIGHT_IDX] * rowDot(signature1.plane(WEIGHT_IDX), row, signature1.stride);
+                }
+                return (float)result;
+            }
+
+
+            /**
+            * @brief Fills distances(q, d) for packed queries and raw database signatures.
+            *       Each task packs a tile of the database, computes its self terms once and
+            *       sweeps the queries in small blocks, so both stay in cache.
+            */
+            void PCTSignaturesSQFD_Impl::computeDistanceMatrix(
+                      const std::vector<PackedSignature>& queries,
+                      const std::vector<float>& querySelfTerms,
+                      const std::vector<Mat>& databaseSignatures,
+                      Mat& distances) const
+            {
+                const int queryCount = (int)queries.size();
+                const int databaseCount = (int)databaseSignatures.size();
+                const int tileCount = (databaseCount + DATABASE_TILE - 1) / DATABASE_TILE;
+
+                int queryStride = 0;
+                for (int q = 0; q < queryCount; q++)
+                {
+                    queryStride = std::max(queryStride, queries[q].stride);
+                }
 
-                    for (int i = range.start; i < range.end; i++)
+                TLSData<SQFDWorkspace> workspaces;
+                parallel_for_(Range(0, tileCount), [&](const Range& range)
+                {
+                    SQFDWorkspace& ws = *workspaces.get();
+                    ws.signatures.resize(DATABASE_TILE);
+                    ws.selfTerms.resize(DATABASE_TILE);
+
+                    for (int tile = range.start; tile < range.end; tile++)
                     {
-                        if (mImageSignatures[i].empty())
+                        const int dbStart = tile * DATABASE_TILE;
+                        const int dbEnd = std::min(dbStart + DATABASE_TILE, databaseCount);
+
+                        int stride = queryStride;
+                        for (int d = dbStart; d < dbEnd; d++)
                         {
-                            CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", i));
+                            if (databaseSignatures[d].empty())
+                            {
+                                CV_Error_(Error::StsBadArg, ("Signature ID: %d is empty!", d));
+                            }
+                            packSignature(databaseSignatures[d], ws.signatures[d - dbStart]);
+                            stride = std::max(stride, ws.signatures[d - dbStart].stride);
                         }
+                        ws.row.resize(stride);
 
-                        (*mDistances)[i] = mPctSignaturesSQFDAlgorithm->computeQuadraticFormDistance(
-                            *mSourceSignature, (*mImageSignatures)[i]);
+                        for (int d = dbStart; d < dbEnd; d++)
+                        {
+                            const PackedSignature& signature = ws.signatures[d - dbStart];
+                            ws.selfTerms[d - dbStart] = computePartialSQFD(signature, signature, &ws.row[0]);
+                        }
+
+                        for (int qStart = 0; qStart < queryCount; qStart += QUERY_TILE)
+                        {
+                            const int qEnd = std::min(qStart + QUERY_TILE, queryCount);
+                            for (int d = dbStart; d < dbEnd; d++)
+                            {
+                                for (int q = qStart; q < qEnd; q++)
+                                {
+                                    float result = querySelfTerms[q] + ws.selfTerms[d - dbStart]
+                                        - computePartialSQFD(queries[q], ws.signatures[d - dbStart], &ws.row[0]) * 2;
+                                    distances.at<float>(q, d) = sqrt(result);
+                                }
+                            }
+                        }
                     }
-                }
-            };
+                });
+            }
 
 
             float PCTSignaturesSQFD_Impl::computeQuadraticFormDistance(
@@ -159,25 +478,19 @@ namespace cv
                 {
                     CV_Error(Error::StsBadArg, "Empty signature!");
                 }
+                checkFunctions();
 
-                Mat signature0 = _signature0.getMat();
-                Mat signature1 = _signature1.getMat();
+                PackedSignature signature0, signature1;
+                packSignature(_signature0.getMat(), signature0);
+                packSignature(_signature1.getMat(), signature1);
 
-                if (signature0.cols != SIGNATURE_DIMENSION || signature1.cols != SIGNATURE_DIMENSION)
-                {
-                    CV_Error_(Error::StsBadArg, ("Signature dimension must be %d!", SIGNATURE_DIMENSION));
-                }
-
-                if (signature0.rows <= 0 || signature1.rows <= 0)
-                {
-                    CV_Error(Error::StsBadArg, "Signature count must be greater than 0!");
-                }
+                std::vector<float> row(std::max(signature0.stride, signature1.stride));
 
                 // compute sqfd
                 float result = 0;
-                result += computePartialSQFD(signature0, signature0);
-                result += computePartialSQFD(signature1, signature1);
-                result -= computePartialSQFD(signature0, signature1) * 2;
+                result += computePartialSQFD(signature0, signature0, &row[0]);
+                result += computePartialSQFD(signature1, signature1, &row[0]);
+                result -= computePartialSQFD(signature0, signature1, &row[0]) * 2;
 
                 return sqrt(result);
             }
@@ -187,24 +500,58 @@ namespace cv
                       const std::vector<Mat>& imageSignatures,
                       std::vector<float>& distances) const
             {
-                parallel_for_(Range(0, (int)imageSignatures.size()),
-                    Parallel_computeSQFDs(this, &sourceSignature, &imageSignatures, &distances));
+                if (sourceSignature.empty())
+                {
+                    CV_Error(Error::StsBadArg, "Source signature is empty!");
+                }
+                checkFunctions();
+
+                std::vector<PackedSignature> queries(1);
+                packSignature(sourceSignature, queries[0]);
+                std::vector<float> row(queries[0].stride);
+                std::vector<float> querySelfTerms(1, computePartialSQFD(queries[0], queries[0], &row[0]));
+
+                distances.resize(imageSignatures.size());
+                if (imageSignatures.empty())
+                {
+                    return;
+                }
+                Mat distanceRow(1, (int)distances.size(), CV_32FC1, &distances[0]);
+                computeDistanceMatrix(queries, querySelfTerms, imageSignatures, distanceRow);
             }
 
-            float PCTSignaturesSQFD_Impl::computePartialSQFD(
-                      const Mat& signature0,
-                      const Mat& signature1) const
+            void PCTSignaturesSQFD_Impl::computeQuadraticFormDistances(
+                      const std::vector<Mat>& querySignatures,
+                      const std::vector<Mat>& databaseSignatures,
+                      OutputArray _distances) const
             {
-                float result = 0;
-                for (int i = 0; i < signature0.rows; i++)
+                checkFunctions();
+
+                const int queryCount = (int)querySignatures.size();
+                std::vector<PackedSignature> queries(queryCount);
+                std::vector<float> querySelfTerms(queryCount);
+                parallel_for_(Range(0, queryCount), [&](const Range& range)
                 {
-                    for (int j = 0; j < signature1.rows; j++)
+                    std::vector<float> row;
+                    for (int q = range.start; q < range.end; q++)
                     {
-                        result += signature0.at<float>(i, WEIGHT_IDX) * signature1.at<float>(j, WEIGHT_IDX)
-                            * computeSimilarity(mDistanceFunction, mSimilarityFunction, mSimilarityParameter, signature0, i, signature1, j);
+                        if (querySignatures[q].empty())
+                        {
+                            CV_Error_(Error::StsBadArg, ("Query signature ID: %d is empty!", q));
+                        }
+                        packSignature(querySignatures[q], queries[q]);
+                        row.resize(queries[q].stride);
+                        querySelfTerms[q] = computePartialSQFD(queries[q], queries[q], &row[0]);
                     }
+                });
+
+                _distances.create(queryCount, (int)databaseSignatures.size(), CV_32FC1);
+                Mat distances = _distances.getMat();
+                if (distances.empty())
+                {
+                    return;
                 }
-                return result;
+                computeDistanceMatrix(queries, querySelfTerms, databaseSignatures, distances);
             }
 
 
@@ -78,7 +78,37 @@ class TBMR_Impl CV_FINAL : public TBMR
                      OutputArray descriptors,
                      bool useProvidedKeypoints = false) CV_OVERRIDE;
 
-    CV_INLINE uint zfindroot(uint *parent, uint p)
+    // The affine views are simulated by detectAndCompute, which runs
+    // the detector through AffineFeature2D
+    virtual void setViewParams(const std::vector<float>& tilts,
+                               const std::vector<float>& rolls) CV_OVERRIDE
+    {
+        CV_Assert(tilts.size() == rolls.size());
+        for (size_t i = 0; i < tilts.size(); i++)
+            CV_Assert(tilts[i] >= 1);
+        viewTilts = tilts;
+        viewRolls = rolls;
+    }
+    virtual void getViewParams(std::vector<float>& tilts,
+                               std::vector<float>& rolls) const CV_OVERRIDE
+    {
+        tilts = viewTilts;
+        rolls = viewRolls;
+    }
+
+    // Per (scale, polarity) working memory of the component trees of a call
+    struct TreeBuffers
+    {
+        // component tree representation (parent,S): see
+        // https://ieeexplore.ieee.org/document/6850018
+        Mat parent;
+        // moments: compound type of: (area, x, y, xy, xx, yy)
+        Mat imaAttributes;
+        // S in descending order, used for the min tree
+        Mat reversedS;
+    };
+
+    CV_INLINE uint zfindroot(uint *parent, uint p) const
     {
         if (parent[p] == p)
             return p;
@@ -88,7 +118,7 @@ class TBMR_Impl CV_FINAL : public TBMR
 
     // Calculate the Component tree. Based on the order of S, it will be a
     // min or max tree.
-    void calcMinMaxTree(Mat ima)
+    void calcMinMaxTree(const Mat &ima, const uint *S_ptr, TreeBuffers &buf) const
     {
         int rs = ima.rows;
         int cs = ima.cols;
@@ -106,14 +136,12 @@ class TBMR_Impl CV_FINAL : public TBMR
         uint* zpar = zparb.data();
         uint *root = rootb.data();
         uint *rank = rankb.data();
-        parent = Mat(rs, cs, CV_32S); // unsigned
         AutoBuffer<bool> dejaVub(imSize);
         memset(dejaVub.data(), 0, imSize * sizeof(bool));
         bool* dejaVu = dejaVub.data();
 
-        const uint *S_ptr = S.ptr<const uint>();
-        uint *parent_ptr = parent.ptr<uint>();
-        Vec<uint, 6> *imaAttribute = imaAttributes.ptr<Vec<uint, 6>>();
+        uint *parent_ptr = buf.parent.ptr<uint>();
+        Vec<uint, 6> *imaAttribute = buf.imaAttributes.ptr<Vec<uint, 6>>();
 
         for (int i = imSize - 1; i >= 0; --i)
         {
@@ -186,27 +214,25 @@ class TBMR_Impl CV_FINAL : public TBMR
         }
     }
 
-    void calculateTBMRs(const Mat &image, std::vector<Elliptic_KeyPoint> &tbmrs,
-                        const Mat &mask, float scale, int octave)
+    void calculateTBMRs(const Mat &image, const uint *S_ptr,
+                        std::vector<Elliptic_KeyPoint> &tbmrs,
+                        const Mat &mask, float scale, int octave,
+                        TreeBuffers &buf) const
     {
         uint imSize = image.cols * image.rows;
         uint maxArea =
             static_cast<uint>(params.maxAreaRelative * imSize * scale);
         uint minArea = static_cast<uint>(params.minArea * scale);
 
-        if (parent.empty() || parent.size != image.size)
-            parent = Mat(image.rows, image.cols, CV_32S);
+        buf.parent.create(image.rows, image.cols, CV_32S); // unsigned
+        buf.imaAttributes.create(image.rows, image.cols, CV_32SC(6));
 
-        if (imaAttributes.empty() || imaAttributes.size != image.size)
-            imaAttributes = Mat(image.rows, image.cols, CV_32SC(6));
-
-        calcMinMaxTree(image);
+        calcMinMaxTree(image, S_ptr, buf);
 
         const Vec<uint, 6> *imaAttribute =
-            imaAttributes.ptr<const Vec<uint, 6>>();
+            buf.imaAttributes.ptr<const Vec<uint, 6>>();
         const uint8_t *ima_ptr = image.ptr<const uint8_t>();
-        const uint *S_ptr = S.ptr<const uint>();
-        uint *parent_ptr = parent.ptr<uint>();
+        uint *parent_ptr = buf.parent.ptr<uint>();
 
         // canonization
         for (uint i = 0; i < imSize; ++i)
@@ -451,18 +477,66 @@ class TBMR_Impl CV_FINAL : public TBMR
         //---------------------------------------------
     }
 
-    Mat tempsrc;
-
-    // component tree representation (parent,S): see
-    // https://ieeexplore.ieee.org/document/6850018
-    Mat parent;
-    Mat S;
-    // moments: compound type of: (area, x, y, xy, xx, yy)
-    Mat imaAttributes;
-
     Params params;
+
+    // simulated affine views of detectAndCompute, disabled when empty
+    std::vector<float> viewTilts;
+    std::vector<float> viewRolls;
 };
 
+// Stable counting sort of the pixel indices of an 8-bit continuous image by
+// ascending intensity. Stripes of the image are histogrammed and scattered
+// concurrently; the exclusive prefix sum over (value, stripe) keeps the
+// result identical to a serial stable sort.
+static void sortPixelsByIntensity(const Mat &ima, Mat &S)
+{
+    CV_Assert(ima.type() == CV_8UC1 && ima.isContinuous());
+
+    const int total = (int)ima.total();
+    S.create(1, total, CV_32S);
+
+    const int minStripeSize = 1 << 16;
+    const int nstripes =
+        std::max(1, std::min(getNumThreads(), total / minStripeSize));
+    std::vector<int> offsets(nstripes * 256, 0);
+
+    const uchar *ima_ptr = ima.ptr<uchar>();
+    uint *S_ptr = S.ptr<uint>();
+
+    parallel_for_(Range(0, nstripes), [&](const Range &range) {
+        for (int stripe = range.start; stripe < range.end; ++stripe)
+        {
+            int *hist = &offsets[stripe * 256];
+            int begin = (int)((int64)total * stripe / nstripes);
+            int end = (int)((int64)total * (stripe + 1) / nstripes);
+            for (int i = begin; i < end; ++i)
+                hist[ima_ptr[i]]++;
+        }
+    });
+
+    int offset = 0;
+    for (int v = 0; v < 256; ++v)
+    {
+        for (int stripe = 0; stripe < nstripes; ++stripe)
+        {
+            int count = offsets[stripe * 256 + v];
+            offsets[stripe * 256 + v] = offset;
+            offset += count;
+        }
+    }
+
+    parallel_for_(Range(0, nstripes), [&](const Range &range) {
+        for (int stripe = range.start; stripe < range.end; ++stripe)
+        {
+            int *pos = &offsets[stripe * 256];
+            int begin = (int)((int64)total * stripe / nstripes);
+            int end = (int)((int64)total * (stripe + 1) / nstripes);
+            for (int i = begin; i < end; ++i)
+                S_ptr[pos[ima_ptr[i]]++] = (uint)i;
+        }
+    });
+}
+
 void TBMR_Impl::detect(InputArray _image, std::vector<KeyPoint> &keypoints,
                        InputArray _mask)
 {
@@ -491,11 +565,9 @@ void TBMR_Impl::detect(InputArray _image,
         CV_Assert(mask.size == src.size);
     }
 
+    // the working memory is local so that detect can be called concurrently
     if (!src.isContinuous())
-    {
-        src.copyTo(tempsrc);
-        src = tempsrc;
-    }
+        src = src.clone();
 
     CV_Assert(src.depth() == CV_8U);
 
@@ -517,20 +589,43 @@ void TBMR_Impl::detect(InputArray _image,
     MSDImagePyramid scaleSpacer(src, m_cur_n_scales, m_scale_factor);
     pyr = scaleSpacer.getImPyr();
 
-    int oct = 0;
-    for (auto &s : pyr)
-    {
-        float scale = ((float)s.cols) / pyr.begin()->cols;
-        std::vector<Elliptic_KeyPoint> kpts;
+    const int nlevels = (int)pyr.size();
+    // pixel indices of every pyramid level sorted by ascending intensity
+    std::vector<Mat> sortedPixels(nlevels);
+    for (int oct = 0; oct < nlevels; oct++)
+        sortPixelsByIntensity(pyr[oct], sortedPixels[oct]);
 
-        // append max tree tbmrs
-        sortIdx(s.reshape(1, 1), S,
-                SortFlags::SORT_ASCENDING | SortFlags::SORT_EVERY_ROW);
-        calculateTBMRs(s, kpts, mask, scale, oct);
+    // the max tree and the min tree of every level are independent, build
+    // all of them concurrently and merge the results in the serial order
+    const int ntrees = nlevels * 2;
+    std::vector<TreeBuffers> treeBuffers(ntrees);
+    std::vector<std::vector<Elliptic_KeyPoint>> treeKpts(ntrees);
 
-        // reverse instead of sort
-        flip(S, S, -1);
-        calculateTBMRs(s, kpts, mask, scale, oct);
+    parallel_for_(Range(0, ntrees), [&](const Range &range) {
+        for (int t = range.start; t < range.end; ++t)
+        {
+            int oct = t / 2;
+            const Mat &s = pyr[oct];
+            float scale = ((float)s.cols) / pyr.begin()->cols;
+            TreeBuffers &buf = treeBuffers[t];
+
+            // append max tree tbmrs
+            const uint *S_ptr = sortedPixels[oct].ptr<const uint>();
+            if (t % 2 == 1)
+            {
+                // reverse instead of sort for the min tree
+                flip(sortedPixels[oct], buf.reversedS, -1);
+                S_ptr = buf.reversedS.ptr<const uint>();
+            }
+            calculateTBMRs(s, S_ptr, treeKpts[t], mask, scale, oct, buf);
+        }
+    });
+
+    for (int oct = 0; oct < nlevels; oct++)
+    {
+        std::vector<Elliptic_KeyPoint> &kpts = treeKpts[oct * 2];
+        kpts.insert(kpts.end(), treeKpts[oct * 2 + 1].begin(),
+                    treeKpts[oct * 2 + 1].end());
 
         if (oct == 0)
         {
@@ -556,8 +651,6 @@ void TBMR_Impl::detect(InputArray _image,
                 }
             }
         }
-
-        oct++;
     }
 }
 
@@ -569,6 +662,7 @@ void TBMR_Impl::detectAndCompute(
     // We can use SIFT to compute descriptors for the extracted keypoints...
     auto sift = SIFT::create();
     auto dac = AffineFeature2D::create(this, sift);
+    dac->setViewParams(viewTilts, viewRolls);
     dac->detectAndCompute(image, mask, keypoints, descriptors,
                           useProvidedKeypoints);
 }
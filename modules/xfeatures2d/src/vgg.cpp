@@ -54,6 +54,7 @@
  */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 
 
@@ -110,6 +111,9 @@ public:
     virtual void setUseNormalizeDescriptor(const bool dsc_normalize) CV_OVERRIDE { m_dsc_normalize = dsc_normalize; }
     virtual bool getUseNormalizeDescriptor() const CV_OVERRIDE { return m_dsc_normalize; }
 
+    virtual void setUseQuantizedProjection(const bool use_quantized_projection) CV_OVERRIDE { m_use_quantized_projection = use_quantized_projection; }
+    virtual bool getUseQuantizedProjection() const CV_OVERRIDE { return m_use_quantized_projection; }
+
 protected:
 
     /*
@@ -150,6 +154,13 @@ protected:
     // pool regions & proj
     Mat m_PRFilters, m_Proj;
 
+    // switch to enable the int16 projection
+    bool m_use_quantized_projection;
+
+    // int16 proj & per row scale
+    Mat m_ProjQ;
+    vector<float> m_ProjQScale;
+
 private:
 
     /*
@@ -162,6 +173,9 @@ private:
                              const int PJrows, const int PJcols,
                              const unsigned int PJidx[], const unsigned int PJidxSize, const unsigned int PJ[] );
 
+     // initialize int16 projection
+     void ini_quantized_projection();
+
 }; // END VGG_Impl CLASS
 
 // -------------------------------------------------
@@ -220,8 +234,9 @@ static inline void get_patch( const KeyPoint kp, Mat& Patch, const Mat& image,
   }
 }
 
-// get descriptor given 64x64 image patch
-static void get_desc( const Mat Patch, Mat& PatchTrans, int anglebins, bool img_normalize )
+// get descriptor given 64x64 image patch, PatchTrans must be preallocated
+// with Patch.total() rows and anglebins columns (it may be a block column)
+static void get_desc( const Mat Patch, Mat PatchTrans, int anglebins, bool img_normalize )
 {
     Mat Ix, Iy;
     // % compute gradient
@@ -314,7 +329,8 @@ static void get_desc( const Mat Patch, Mat& PatchTrans, int anglebins, bool img_
     Mat GMagT = GMag.t();
 
     // % feature channels
-    PatchTrans = Mat( (int)Patch.total(), anglebins, CV_32F, Scalar::all(0) );
+    CV_DbgAssert( PatchTrans.rows == (int)Patch.total() && PatchTrans.cols == anglebins );
+    PatchTrans.setTo( Scalar::all(0) );
 
     for ( int i = 0; i < anglebins; i++ )
     {
@@ -328,6 +344,102 @@ static void get_desc( const Mat Patch, Mat& PatchTrans, int anglebins, bool img_
     }
 }
 
+// quantization scale of the pooled features, they are cropped to [0, 1]
+static const float VGG_FEATURE_SCALE = 1023.0f;
+// int16 products summed in int32 before flushing to float. A block of 128 products
+// puts 32 products in each of the 4 SIMD lanes, below the 2^31 / (1023 * 32767) = 64
+// products an int32 lane can hold; the scalar path accumulates in int64 instead.
+static const int VGG_QUANT_BLOCK = 128;
+
+// quantize pooled features to int16
+static void quantize_features( const float* src, short* dst, int len, int len_padded )
+{
+    int i = 0;
+    for ( ; i < len; i++ )
+    {
+      float v = std::max( std::min( src[i], 1.0f ), -1.0f );
+      dst[i] = (short) cvRound( v * VGG_FEATURE_SCALE );
+    }
+    for ( ; i < len_padded; i++ )
+      dst[i] = 0;
+}
+
+// int16 dot product with integer accumulation, len must be a multiple of 8
+static float dot_quantized( const short* a, const short* b, int len )
+{
+    int i = 0;
+    float sum = 0.0f;
+#if CV_SIMD128
+    v_float32x4 v_sum = v_setzero_f32();
+    for ( ; i < len; )
+    {
+      int block_end = std::min( i + VGG_QUANT_BLOCK, len );
+      v_int32x4 v_acc = v_setzero_s32();
+      for ( ; i < block_end; i += 8 )
+        v_acc += v_dotprod( v_load( a + i ), v_load( b + i ) );
+      v_sum += v_cvt_f32( v_acc );
+    }
+    sum = v_reduce_sum( v_sum );
+#endif
+    int64 acc = 0;
+    for ( ; i < len; i++ )
+      acc += a[i] * b[i];
+    return sum + (float) acc;
+}
+
+// projects a block of quantized features, dst(b, d) = scale[d] * <features(b), proj(d)>.
+// Four feature rows share every load of a projection row, each result equals dot_quantized
+static void project_quantized( const Mat& features, int nblock, const Mat& proj,
+                               const vector<float>& scale, Mat& dst )
+{
+    const int len = proj.cols;
+    int b = 0;
+#if CV_SIMD128
+    for ( ; b + 4 <= nblock; b += 4 )
+    {
+      const short* f0 = features.ptr<short>( b );
+      const short* f1 = features.ptr<short>( b + 1 );
+      const short* f2 = features.ptr<short>( b + 2 );
+      const short* f3 = features.ptr<short>( b + 3 );
+      for ( int d = 0; d < proj.rows; d++ )
+      {
+        const short* p = proj.ptr<short>( d );
+        v_float32x4 v_sum0 = v_setzero_f32(), v_sum1 = v_setzero_f32();
+        v_float32x4 v_sum2 = v_setzero_f32(), v_sum3 = v_setzero_f32();
+        for ( int i = 0; i < len; )
+        {
+          int block_end = std::min( i + VGG_QUANT_BLOCK, len );
+          v_int32x4 v_acc0 = v_setzero_s32(), v_acc1 = v_setzero_s32();
+          v_int32x4 v_acc2 = v_setzero_s32(), v_acc3 = v_setzero_s32();
+          for ( ; i < block_end; i += 8 )
+          {
+            v_int16x8 v_p = v_load( p + i );
+            v_acc0 += v_dotprod( v_load( f0 + i ), v_p );
+            v_acc1 += v_dotprod( v_load( f1 + i ), v_p );
+            v_acc2 += v_dotprod( v_load( f2 + i ), v_p );
+            v_acc3 += v_dotprod( v_load( f3 + i ), v_p );
+          }
+          v_sum0 += v_cvt_f32( v_acc0 );
+          v_sum1 += v_cvt_f32( v_acc1 );
+          v_sum2 += v_cvt_f32( v_acc2 );
+          v_sum3 += v_cvt_f32( v_acc3 );
+        }
+        dst.at<float>( b, d )     = v_reduce_sum( v_sum0 ) * scale[d];
+        dst.at<float>( b + 1, d ) = v_reduce_sum( v_sum1 ) * scale[d];
+        dst.at<float>( b + 2, d ) = v_reduce_sum( v_sum2 ) * scale[d];
+        dst.at<float>( b + 3, d ) = v_reduce_sum( v_sum3 ) * scale[d];
+      }
+    }
+#endif
+    for ( ; b < nblock; b++ )
+    {
+      const short* f = features.ptr<short>( b );
+      float* desc = dst.ptr<float>( b );
+      for ( int d = 0; d < proj.rows; d++ )
+        desc[d] = dot_quantized( f, proj.ptr<short>( d ), len ) * scale[d];
+    }
+}
+
 // -------------------------------------------------
 /* VGG interface implementation */
 
@@ -336,14 +448,16 @@ struct ComputeVGGInvoker : ParallelLoopBody
     ComputeVGGInvoker( const Mat& _image, Mat* _descriptors,
                         const vector<KeyPoint>& _keypoints,
                         const Mat& _PRFilters, const Mat& _Proj,
+                        const Mat& _ProjQ, const vector<float>& _ProjQScale,
                         const int _anglebins, const bool _img_normalize,
                         const bool _use_scale_orientation, const float _scale_factor )
+      : keypoints( _keypoints ), ProjQScale( _ProjQScale )
     {
       image = _image;
-      keypoints = _keypoints;
       descriptors = _descriptors;
 
       Proj = _Proj;
+      ProjQ = _ProjQ;
       PRFilters = _PRFilters;
 
       anglebins = _anglebins;
@@ -354,30 +468,72 @@ struct ComputeVGGInvoker : ParallelLoopBody
 
     void operator ()(const cv::Range& range) const CV_OVERRIDE
     {
-      Mat Desc, PatchTrans;
+      const int npatch = 64 * 64;
+      const int nregions = PRFilters.rows;
+      const int nfeatures = nregions * anglebins;
+      const bool quantized = !ProjQ.empty();
+
       Mat Patch( 64, 64, CV_32F );
-      for (int k = range.start; k < range.end; k++)
+      Mat PatchTrans( npatch, anglebins * BLOCK_SIZE, CV_32F );
+      Mat Desc, Features( BLOCK_SIZE, nfeatures, CV_32F );
+      Mat FeaturesQ;
+      if ( quantized )
+        FeaturesQ.create( BLOCK_SIZE, ProjQ.cols, CV_16S );
+
+      // keypoints are processed in blocks so that pooling and
+      // projection are done with a few large matrix products
+      for (int k0 = range.start; k0 < range.end; k0 += BLOCK_SIZE)
       {
-        // sample patch from image
-        get_patch( keypoints[k], Patch, image, use_scale_orientation, scale_factor );
-        // compute transform
-        get_desc( Patch, PatchTrans, anglebins, img_normalize );
+        const int nblock = std::min( BLOCK_SIZE, range.end - k0 );
+        for (int b = 0; b < nblock; b++)
+        {
+          // sample patch from image
+          get_patch( keypoints[k0 + b], Patch, image, use_scale_orientation, scale_factor );
+          // compute transform
+          get_desc( Patch, PatchTrans.colRange( b * anglebins, (b + 1) * anglebins ),
+                    anglebins, img_normalize );
+        }
         // pool features
-        Desc = PRFilters * PatchTrans;
+        Desc = PRFilters * PatchTrans.colRange( 0, nblock * anglebins );
         // crop
         min( Desc, 1.0f, Desc );
-        // reshape
-        Desc = Desc.reshape( 1, (int)Desc.total() );
+        // reshape, one row of (region, angle) features per keypoint
+        for (int b = 0; b < nblock; b++)
+        {
+          float* dst = Features.ptr<float>( b );
+          for (int r = 0; r < nregions; r++)
+          {
+            const float* src = Desc.ptr<float>( r ) + b * anglebins;
+            for (int a = 0; a < anglebins; a++)
+              dst[r * anglebins + a] = src[a];
+          }
+        }
         // project
-        descriptors->row( k ) = Desc.t() * Proj.t();
+        if ( quantized )
+        {
+          for (int b = 0; b < nblock; b++)
+            quantize_features( Features.ptr<float>( b ), FeaturesQ.ptr<short>( b ),
+                               nfeatures, FeaturesQ.cols );
+          Mat dst = descriptors->rowRange( k0, k0 + nblock );
+          project_quantized( FeaturesQ, nblock, ProjQ, ProjQScale, dst );
+        }
+        else
+        {
+          Mat dst = descriptors->rowRange( k0, k0 + nblock );
+          gemm( Features.rowRange( 0, nblock ), Proj, 1.0, noArray(), 0.0, dst, GEMM_2_T );
+        }
       }
     }
 
+    enum { BLOCK_SIZE = 16 };
+
     Mat image;
     Mat *descriptors;
-    vector<KeyPoint> keypoints;
+    const vector<KeyPoint>& keypoints;
 
     Mat Proj;
+    Mat ProjQ;
+    const vector<float>& ProjQScale;
     Mat PRFilters;
 
     int anglebins;
@@ -418,10 +574,18 @@ void VGG_Impl::compute( InputArray _image, vector<KeyPoint>& keypoints, OutputAr
     Mat descriptors = _descriptors.getMat();
     descriptors.setTo( Scalar(0) );
 
+    if ( m_use_quantized_projection && m_ProjQ.empty() )
+      ini_quantized_projection();
+
+    const Mat ProjQ = m_use_quantized_projection ? m_ProjQ : Mat();
+    const int nstripes = ( (int) keypoints.size() + ComputeVGGInvoker::BLOCK_SIZE - 1 )
+                       / ComputeVGGInvoker::BLOCK_SIZE;
     parallel_for_( Range( 0, (int) keypoints.size() ),
         ComputeVGGInvoker( m_image, &descriptors, keypoints, m_PRFilters, m_Proj,
+                            ProjQ, m_ProjQScale,
                             m_anglebins, m_img_normalize, m_use_scale_orientation,
-                            m_scale_factor )
+                            m_scale_factor ),
+        nstripes
     );
 
     // normalize desc
@@ -471,13 +635,38 @@ void VGG_Impl::ini_params( const int PRrows, const int PRcols,
     }
 }
 
+// quantize projection matrix rows to int16, one scale per output dimension
+void VGG_Impl::ini_quantized_projection()
+{
+    const int cols_padded = alignSize( m_Proj.cols, 8 );
+    m_ProjQ = Mat::zeros( m_Proj.rows, cols_padded, CV_16S );
+    m_ProjQScale.resize( m_Proj.rows );
+
+    for ( int d = 0; d < m_Proj.rows; d++ )
+    {
+      const float* src = m_Proj.ptr<float>( d );
+      short* dst = m_ProjQ.ptr<short>( d );
+
+      float maxval = 0.0f;
+      for ( int i = 0; i < m_Proj.cols; i++ )
+        maxval = std::max( maxval, std::abs( src[i] ) );
+
+      const float scale = ( maxval > 0.0f ) ? 32767.0f / maxval : 1.0f;
+      for ( int i = 0; i < m_Proj.cols; i++ )
+        dst[i] = saturate_cast<short>( src[i] * scale );
+
+      m_ProjQScale[d] = 1.0f / ( scale * VGG_FEATURE_SCALE );
+    }
+}
+
 // constructor
 VGG_Impl::VGG_Impl( int _desc, float _isigma, bool _img_normalize,
                     bool _use_scale_orientation, float _scale_factor, bool _dsc_normalize )
              : m_isigma( _isigma ), m_scale_factor( _scale_factor ),
                m_img_normalize( _img_normalize ),
                m_use_scale_orientation( _use_scale_orientation ),
-               m_dsc_normalize( _dsc_normalize )
+               m_dsc_normalize( _dsc_normalize ),
+               m_use_quantized_projection( false )
 {
     // constant
     m_anglebins = 8;
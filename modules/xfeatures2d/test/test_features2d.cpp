@@ -91,6 +91,65 @@ TEST(Features2d_Detector_TBMR_Affine, regression)
     test.safe_run();
 }
 
+TEST(Features2d_AffineFeature2D_Views, keypoints_and_descriptors)
+{
+    string path = cvtest::TS::ptr()->get_data_path() + FEATURES2D_DIR + "/" + IMAGE_FILENAME;
+    Mat image = imread(path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image.empty());
+
+    Ptr<AffineFeature2D> affine = AffineFeature2D::create(StarDetector::create(), BriefDescriptorExtractor::create());
+
+    std::vector<float> tilts, rolls;
+    tilts.push_back(1.f);             rolls.push_back(0.f);
+    tilts.push_back((float)CV_SQRT2); rolls.push_back(0.f);
+    tilts.push_back((float)CV_SQRT2); rolls.push_back(45.f);
+    tilts.push_back(2.f);             rolls.push_back(90.f);
+    affine->setViewParams(tilts, rolls);
+
+    std::vector<float> tilts2, rolls2;
+    affine->getViewParams(tilts2, rolls2);
+    EXPECT_EQ(tilts, tilts2);
+    EXPECT_EQ(rolls, rolls2);
+
+    std::vector<Elliptic_KeyPoint> keypoints;
+    Mat descriptors;
+    affine->detectAndCompute(image, noArray(), keypoints, descriptors);
+    ASSERT_FALSE(keypoints.empty());
+    EXPECT_EQ((int)keypoints.size(), descriptors.rows);
+
+    // the first view is the identity, it reproduces the wrapped detector and extractor
+    std::vector<KeyPoint> plain;
+    Mat plainDescriptors;
+    StarDetector::create()->detect(image, plain);
+    BriefDescriptorExtractor::create()->compute(image, plain, plainDescriptors);
+    ASSERT_FALSE(plain.empty());
+    ASSERT_LT(plain.size(), keypoints.size());
+    for (size_t i = 0; i < plain.size(); i++)
+    {
+        EXPECT_EQ(plain[i].pt, keypoints[i].pt) << i;
+        EXPECT_EQ(plain[i].size, keypoints[i].size) << i;
+        EXPECT_EQ(plain[i].response, keypoints[i].response) << i;
+        EXPECT_FLOAT_EQ(plain[i].size / 2, keypoints[i].axes.width) << i;
+        EXPECT_FLOAT_EQ(plain[i].size / 2, keypoints[i].axes.height) << i;
+    }
+    EXPECT_EQ(0, cv::norm(plainDescriptors, descriptors.rowRange(0, (int)plain.size()), NORM_HAMMING));
+
+    // the keypoints of the other views map back inside the image, up to the rounding of the warps
+    Rect bounds(-1, -1, image.cols + 2, image.rows + 2);
+    for (size_t i = 0; i < keypoints.size(); i++)
+    {
+        EXPECT_TRUE(bounds.contains(keypoints[i].pt)) << keypoints[i].pt;
+        EXPECT_GE(keypoints[i].axes.width, keypoints[i].axes.height);
+    }
+
+    // results do not depend on the reuse of the view buffers
+    std::vector<Elliptic_KeyPoint> keypoints2;
+    Mat descriptors2;
+    affine->detectAndCompute(image, noArray(), keypoints2, descriptors2);
+    ASSERT_EQ(keypoints.size(), keypoints2.size());
+    EXPECT_EQ(0, cv::norm(descriptors, descriptors2, NORM_HAMMING));
+}
+
 /*
  * Descriptors
  */
@@ -199,6 +258,39 @@ TEST( Features2d_DescriptorExtractor_VGG, regression )
     test.safe_run();
 }
 
+TEST( Features2d_DescriptorExtractor_VGG, quantized_projection )
+{
+    string path = cvtest::TS::ptr()->get_data_path() + FEATURES2D_DIR + "/" + IMAGE_FILENAME;
+    Mat image = imread(path, IMREAD_GRAYSCALE);
+    ASSERT_FALSE(image.empty());
+
+    std::vector<KeyPoint> keypoints;
+    ORB::create(500)->detect(image, keypoints);
+    ASSERT_FALSE(keypoints.empty());
+
+    const int types[] = { VGG::VGG_120, VGG::VGG_80, VGG::VGG_64, VGG::VGG_48 };
+    for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++)
+    {
+        Ptr<VGG> vgg = VGG::create(types[t], 1.4f, true, true, 0.75f);
+        EXPECT_FALSE(vgg->getUseQuantizedProjection());
+
+        Mat reference, quantized;
+        vgg->compute(image, keypoints, reference);
+        vgg->setUseQuantizedProjection(true);
+        EXPECT_TRUE(vgg->getUseQuantizedProjection());
+        vgg->compute(image, keypoints, quantized);
+
+        ASSERT_EQ(reference.size(), quantized.size());
+        ASSERT_EQ(reference.type(), quantized.type());
+        for (int i = 0; i < reference.rows; i++)
+        {
+            double ref_norm = cvtest::norm(reference.row(i), NORM_L2);
+            double diff = cvtest::norm(reference.row(i), quantized.row(i), NORM_L2);
+            EXPECT_LE(diff, 0.01 * ref_norm + 1e-3) << "type=" << types[t] << " keypoint=" << i;
+        }
+    }
+}
+
 TEST( Features2d_DescriptorExtractor_BGM, regression )
 {
     CV_DescriptorExtractorTest<Hamming> test( "descriptor-boostdesc-bgm",
@@ -113,4 +113,176 @@ void CV_GMSMatcherTest::run( int )
 
 TEST(XFeatures2d_GMSMatcher, gms_matcher_regression) { CV_GMSMatcherTest test; test.safe_run(); }
 
+// Straightforward scalar implementation of the grid-based motion statistics,
+// independent of the matcher implementation
+static const int gmsRotationPatterns[8][9] = {
+    { 1,2,3, 4,5,6, 7,8,9 }, { 4,1,2, 7,5,3, 8,9,6 }, { 7,4,1, 8,5,2, 9,6,3 }, { 8,7,4, 9,5,1, 6,3,2 },
+    { 9,8,7, 6,5,4, 3,2,1 }, { 6,9,8, 3,5,7, 2,1,4 }, { 3,6,9, 2,5,8, 1,4,7 }, { 2,3,6, 1,5,9, 4,7,8 }
+};
+
+static vector<int> gmsNeighbors(int idx, Size gridSize)
+{
+    vector<int> nb(9, -1);
+    int cx = idx % gridSize.width, cy = idx / gridSize.width;
+    for (int dy = -1; dy <= 1; dy++)
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            int x = cx + dx, y = cy + dy;
+            if (x >= 0 && x < gridSize.width && y >= 0 && y < gridSize.height)
+                nb[dx + 4 + dy * 3] = x + y * gridSize.width;
+        }
+    return nb;
+}
+
+static int gmsReferenceRun(const vector<Point2f>& p1, const vector<Point2f>& p2, const vector<DMatch>& matches,
+                           Size gridRight, int rotationType, double thresholdFactor, vector<bool>& inliers)
+{
+    const Size gridLeft(20, 20);
+    const int nLeft = gridLeft.area(), nRight = gridRight.area();
+    const size_t n = matches.size();
+    const int* pattern = gmsRotationPatterns[rotationType - 1];
+    inliers.assign(n, false);
+    vector<int> leftIdx(n, 0), rightIdx(n, 0);
+
+    for (int gridType = 1; gridType <= 4; gridType++)
+    {
+        const double ox = (gridType == 2 || gridType == 4) ? 0.5 : 0.0;
+        const double oy = (gridType == 3 || gridType == 4) ? 0.5 : 0.0;
+        vector<vector<int> > stats(nLeft, vector<int>(nRight, 0));
+        vector<int> pointsLeft(nLeft, 0), cellPairs(nLeft, -1);
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const Point2f& lp = p1[matches[i].queryIdx];
+            const Point2f& rp = p2[matches[i].trainIdx];
+            int x = cvFloor(lp.x * gridLeft.width + ox), y = cvFloor(lp.y * gridLeft.height + oy);
+            leftIdx[i] = (x >= gridLeft.width || y >= gridLeft.height) ? -1 : x + y * gridLeft.width;
+            if (gridType == 1)
+                rightIdx[i] = cvFloor(rp.x * gridRight.width) + cvFloor(rp.y * gridRight.height) * gridRight.width;
+            if (leftIdx[i] < 0 || rightIdx[i] < 0)
+                continue;
+            stats[leftIdx[i]][rightIdx[i]]++;
+            pointsLeft[leftIdx[i]]++;
+        }
+
+        for (int i = 0; i < nLeft; i++)
+        {
+            int best = 0;
+            for (int j = 0; j < nRight; j++)
+            {
+                if (stats[i][j] > best)
+                {
+                    best = stats[i][j];
+                    cellPairs[i] = j;
+                }
+            }
+            if (cellPairs[i] < 0)
+                continue;
+
+            vector<int> nbLeft = gmsNeighbors(i, gridLeft), nbRight = gmsNeighbors(cellPairs[i], gridRight);
+            int score = 0, numpair = 0;
+            double thresh = 0;
+            for (int k = 0; k < 9; k++)
+            {
+                int ll = nbLeft[k], rr = nbRight[pattern[k] - 1];
+                if (ll == -1 || rr == -1)
+                    continue;
+                score += stats[ll][rr];
+                thresh += pointsLeft[ll];
+                numpair++;
+            }
+            if (score < thresholdFactor * std::sqrt(thresh / numpair))
+                cellPairs[i] = -2;
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            if (leftIdx[i] >= 0 && cellPairs[leftIdx[i]] == rightIdx[i])
+                inliers[i] = true;
+        }
+    }
+    return (int)std::count(inliers.begin(), inliers.end(), true);
+}
+
+static void gmsReference(Size size1, Size size2, const vector<KeyPoint>& kp1, const vector<KeyPoint>& kp2,
+                         const vector<DMatch>& matches, vector<DMatch>& result,
+                         bool withRotation, bool withScale, double thresholdFactor = 6.0)
+{
+    static const double scaleRatios[5] = { 1.0, 1.0 / 2, 1.0 / std::sqrt(2.0), std::sqrt(2.0), 2.0 };
+    vector<Point2f> p1(kp1.size()), p2(kp2.size());
+    for (size_t i = 0; i < kp1.size(); i++)
+        p1[i] = Point2f(kp1[i].pt.x / size1.width, kp1[i].pt.y / size1.height);
+    for (size_t i = 0; i < kp2.size(); i++)
+        p2[i] = Point2f(kp2[i].pt.x / size2.width, kp2[i].pt.y / size2.height);
+
+    vector<bool> best, inliers;
+    int maxInliers = 0;
+    for (int scale = 0; scale < (withScale ? 5 : 1); scale++)
+    {
+        Size gridRight(cvRound(20 * scaleRatios[scale]), cvRound(20 * scaleRatios[scale]));
+        for (int rotationType = 1; rotationType <= (withRotation ? 8 : 1); rotationType++)
+        {
+            int num = gmsReferenceRun(p1, p2, matches, gridRight, rotationType, thresholdFactor, inliers);
+            if (num > maxInliers || (!withRotation && !withScale))
+            {
+                best = inliers;
+                maxInliers = num;
+            }
+        }
+    }
+
+    result.clear();
+    for (size_t i = 0; i < best.size(); i++)
+    {
+        if (best[i])
+            result.push_back(matches[i]);
+    }
+}
+
+TEST(XFeatures2d_GMSMatcher, object_api_matches_reference)
+{
+    string path = cvtest::TS::ptr()->get_data_path() + "detectors_descriptors_evaluation/images_datasets/graf/";
+    Mat imgRef = imread(path + "img1.png");
+    Mat imgCur = imread(path + "img3.png");
+    ASSERT_FALSE(imgRef.empty());
+    ASSERT_FALSE(imgCur.empty());
+
+    Ptr<Feature2D> orb = ORB::create(10000);
+    vector<KeyPoint> keypointsRef, keypointsCur;
+    Mat descriptorsRef, descriptorsCur;
+    orb->detectAndCompute(imgRef, noArray(), keypointsRef, descriptorsRef);
+    orb->detectAndCompute(imgCur, noArray(), keypointsCur, descriptorsCur);
+
+    vector<DMatch> matchesAll;
+    BFMatcher(NORM_HAMMING).match(descriptorsCur, descriptorsRef, matchesAll);
+
+    // the same matcher object is reused for every combination and call
+    Ptr<GMSMatcher> gms = GMSMatcher::create();
+    for (int comb = 0; comb < 4; comb++)
+    {
+        bool withRotation = (comb & 1) != 0;
+        bool withScale = (comb & 2) != 0;
+        gms->setWithRotation(withRotation);
+        gms->setWithScale(withScale);
+        EXPECT_EQ(withRotation, gms->getWithRotation());
+        EXPECT_EQ(withScale, gms->getWithScale());
+
+        vector<DMatch> expected;
+        gmsReference(imgCur.size(), imgRef.size(), keypointsCur, keypointsRef, matchesAll, expected, withRotation, withScale);
+        ASSERT_FALSE(expected.empty());
+
+        for (int iter = 0; iter < 2; iter++)
+        {
+            vector<DMatch> actual;
+            gms->match(imgCur.size(), imgRef.size(), keypointsCur, keypointsRef, matchesAll, actual);
+            ASSERT_EQ(expected.size(), actual.size()) << "withRotation=" << withRotation << " withScale=" << withScale;
+            for (size_t i = 0; i < expected.size(); i++)
+            {
+                EXPECT_EQ(expected[i].queryIdx, actual[i].queryIdx);
+                EXPECT_EQ(expected[i].trainIdx, actual[i].trainIdx);
+            }
+        }
+    }
+}
+
 }} // namespace
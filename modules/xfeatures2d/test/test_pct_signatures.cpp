@@ -0,0 +1,126 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat randomSignature(RNG& rng, int count)
+{
+    Mat signature(count, 8, CV_32FC1);
+    rng.fill(signature, RNG::UNIFORM, 0.f, 1.f);
+    return signature;
+}
+
+// Scalar similarity of two signature rows, following pct_signatures/similarity.hpp.
+// Column 0 holds the weight, the other columns the point coordinates.
+static double referenceSimilarity(int distanceFunction, int similarityFunction, double alpha,
+                                  const float* p0, const float* p1)
+{
+    double distance = 0;
+    for (int d = 1; d < 8; d++)
+    {
+        double diff = std::abs((double)p0[d] - p1[d]);
+        switch (distanceFunction)
+        {
+        case PCTSignatures::L0_5: distance += std::sqrt(diff); break;
+        case PCTSignatures::L1: distance += diff; break;
+        case PCTSignatures::L2: distance += diff * diff; break;
+        case PCTSignatures::L5: distance += std::pow(diff, 5.0); break;
+        default: CV_Error(Error::StsNotImplemented, "distance function is not covered by the reference");
+        }
+    }
+    switch (distanceFunction)
+    {
+    case PCTSignatures::L0_5: distance = distance * distance; break;
+    case PCTSignatures::L2: distance = std::sqrt(distance); break;
+    case PCTSignatures::L5: distance = std::pow(distance, 0.2); break;
+    }
+
+    switch (similarityFunction)
+    {
+    case PCTSignatures::MINUS: return -distance;
+    case PCTSignatures::GAUSSIAN: return std::exp(-alpha * distance * distance);
+    case PCTSignatures::HEURISTIC: return 1 / (alpha + distance);
+    }
+    CV_Error(Error::StsNotImplemented, "similarity function is not covered by the reference");
+}
+
+static double referencePartialSQFD(int distanceFunction, int similarityFunction, double alpha,
+                                   const Mat& s0, const Mat& s1)
+{
+    double result = 0;
+    for (int i = 0; i < s0.rows; i++)
+        for (int j = 0; j < s1.rows; j++)
+            result += (double)s0.at<float>(i, 0) * s1.at<float>(j, 0) *
+                referenceSimilarity(distanceFunction, similarityFunction, alpha, s0.ptr<float>(i), s1.ptr<float>(j));
+    return result;
+}
+
+static double referenceSQFD(int distanceFunction, int similarityFunction, double alpha,
+                            const Mat& s0, const Mat& s1)
+{
+    double result = referencePartialSQFD(distanceFunction, similarityFunction, alpha, s0, s0)
+                  + referencePartialSQFD(distanceFunction, similarityFunction, alpha, s1, s1)
+                  - 2 * referencePartialSQFD(distanceFunction, similarityFunction, alpha, s0, s1);
+    return std::sqrt(std::max(result, 0.0));
+}
+
+typedef tuple<int, int> PCTSignaturesSQFD_Params_t;
+typedef testing::TestWithParam<PCTSignaturesSQFD_Params_t> Features2d_PCTSignaturesSQFD;
+
+TEST_P(Features2d_PCTSignaturesSQFD, distance_matrix)
+{
+    const int distanceFunction = get<0>(GetParam());
+    const int similarityFunction = get<1>(GetParam());
+    Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create(distanceFunction, similarityFunction, 1.0f);
+
+    RNG& rng = theRNG();
+    vector<Mat> queries, database;
+    for (int i = 0; i < 5; i++)
+        queries.push_back(randomSignature(rng, rng.uniform(1, 40)));
+    for (int i = 0; i < 37; i++)
+        database.push_back(randomSignature(rng, rng.uniform(1, 40)));
+
+    Mat distances;
+    sqfd->computeQuadraticFormDistances(queries, database, distances);
+    ASSERT_EQ(CV_32FC1, distances.type());
+    ASSERT_EQ(Size((int)database.size(), (int)queries.size()), distances.size());
+
+    for (size_t q = 0; q < queries.size(); q++)
+    {
+        vector<float> row;
+        sqfd->computeQuadraticFormDistances(queries[q], database, row);
+        ASSERT_EQ(database.size(), row.size());
+        for (size_t d = 0; d < database.size(); d++)
+        {
+            double expected = referenceSQFD(distanceFunction, similarityFunction, 1.0, queries[q], database[d]);
+            double eps = 5e-3 * (1 + expected);
+            EXPECT_NEAR(expected, distances.at<float>((int)q, (int)d), eps);
+            EXPECT_NEAR(expected, row[d], eps);
+            EXPECT_NEAR(expected, sqfd->computeQuadraticFormDistance(queries[q], database[d]), eps);
+        }
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, Features2d_PCTSignaturesSQFD, testing::Values(
+    make_tuple((int)PCTSignatures::L2, (int)PCTSignatures::HEURISTIC),
+    make_tuple((int)PCTSignatures::L1, (int)PCTSignatures::GAUSSIAN),
+    make_tuple((int)PCTSignatures::L5, (int)PCTSignatures::HEURISTIC),
+    make_tuple((int)PCTSignatures::L0_5, (int)PCTSignatures::GAUSSIAN)
+));
+
+TEST(Features2d_PCTSignaturesSQFD, identical_signatures)
+{
+    RNG& rng = theRNG();
+    Mat signature = randomSignature(rng, 25);
+    Ptr<PCTSignaturesSQFD> sqfd = PCTSignaturesSQFD::create();
+
+    vector<Mat> signatures(1, signature);
+    Mat distances;
+    sqfd->computeQuadraticFormDistances(signatures, signatures, distances);
+    EXPECT_LE(distances.at<float>(0, 0), 1e-2f);
+}
+
+}} // namespace
@@ -139,7 +139,8 @@ The threshold value \f$T(x, y)\f$ is determined based on the binarization method
 classic Niblack, it is the mean minus \f$ k \f$ times standard deviation of
 \f$\texttt{blockSize} \times\texttt{blockSize}\f$ neighborhood of \f$(x, y)\f$.
 
-The function can't process the image in-place.
+The function can't process the image in-place. 8-bit images are processed in bands of rows with a
+sliding window, so the memory used only depends on the image width.
 
 @param _src Source 8-bit single-channel image.
 @param _dst Destination image of the same size and the same type as src.
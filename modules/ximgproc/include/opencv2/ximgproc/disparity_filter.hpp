@@ -120,6 +120,23 @@ public:
     /** @brief Get the ROI used in the last filter call
      */
     CV_WRAP virtual Rect getROI() = 0;
+
+    /** video-related parameters */
+
+    /** @brief VideoMode makes the filter keep the guide, disparity, confidence and result of the previous filter
+    call. When the image size and filter parameters stay the same, the next call only re-solves the tiles whose
+    guide, disparity or confidence changed, together with a margin around them, while the other tiles keep the
+    previously filtered disparity. This is meant for video streams where most of the scene is static.
+     */
+    CV_WRAP virtual bool getVideoMode() = 0;
+    /** @see getVideoMode */
+    CV_WRAP virtual void setVideoMode(bool _video_mode) = 0;
+    /** @brief ChangeThreshold is the largest difference of guide image values that is not considered as a change in
+    video mode. The default value of 0 re-solves every tile where the guide changed at all.
+     */
+    CV_WRAP virtual int getChangeThreshold() = 0;
+    /** @see getChangeThreshold */
+    CV_WRAP virtual void setChangeThreshold(int _change_thresh) = 0;
 };
 
 /** @brief Convenience factory method that creates an instance of DisparityWLSFilter and sets up all the relevant
@@ -393,6 +393,24 @@ public:
     @note Confidence images with CV_8U depth are expected to in [0, 255] and CV_32F in [0, 1] range.
     */
     CV_WRAP virtual void filter(InputArray src, InputArray confidence, OutputArray dst) = 0;
+
+    /** @brief Rebuilds the bilateral grid for a new guide image, e.g. the next frame of a video.
+
+    @param guide image serving as guide for filtering. It should have 8-bit depth and either 1 or 3 channels.
+
+    The grid buffers are reused when the guide keeps the same size, the other parameters are unchanged.
+    */
+    CV_WRAP virtual void setGuide(InputArray guide) = 0;
+
+    /** @brief Enables starting the solver from the solution of the previous filter() call.
+
+    On consecutive video frames the previous solution, splatted into the current grid, is usually much closer
+    to the result than the average of the source image, so the solver needs fewer iterations. The previous
+    solution is only used when the size and the number of channels of the source image are unchanged.
+    */
+    CV_WRAP virtual void setWarmStart(bool warmStart) = 0;
+    /** @see setWarmStart */
+    CV_WRAP virtual bool getWarmStart() const = 0;
 };
 
 /** @brief Factory method, create instance of FastBilateralSolverFilter and execute the initialization routines.
@@ -464,6 +482,14 @@ public:
     @param dst destination image.
     */
     CV_WRAP virtual void filter(InputArray src, OutputArray dst) = 0;
+
+    /** @brief Recomputes the smoothness weights for a new guide image, e.g. the next frame of a video.
+
+    @param guide image serving as guide for filtering. It should have 8-bit depth and either 1 or 3 channels.
+
+    The weight lookup table and, when the guide keeps the same size, the weight buffers are reused.
+    */
+    CV_WRAP virtual void setGuide(InputArray guide) = 0;
 };
 
 /** @brief Factory method, create instance of FastGlobalSmootherFilter and execute the initialization routines.
@@ -78,6 +78,25 @@ public:
     */
     CV_WRAP virtual void getBoundingBoxes(InputArray edge_map, InputArray orientation_map, CV_OUT std::vector<Rect> &boxes, OutputArray scores = noArray()) = 0;
 
+    /** @brief Groups the edges of an image and computes the affinities between the groups.
+
+    The result is kept and used by the following getBoundingBoxes(boxes, scores) calls, so several
+    box search settings (alpha, beta, eta, minScore, maxBoxes, maxAspectRatio, minBoxArea, kappa)
+    can be evaluated on the same image without grouping its edges again. Changes of edgeMinMag,
+    edgeMergeThr, clusterMinMag and gamma take effect at the next call of this method.
+
+    @param edge_map edge image.
+    @param orientation_map orientation map.
+    */
+    CV_WRAP virtual void computeEdgeGroups(InputArray edge_map, InputArray orientation_map) = 0;
+
+    /** @brief Returns array containing proposal boxes for the edge groups of the last computeEdgeGroups() call.
+
+    @param boxes proposal boxes.
+    @param scores of the proposal boxes, provided a vector of float types.
+    */
+    CV_WRAP virtual void getBoundingBoxes(CV_OUT std::vector<Rect> &boxes, OutputArray scores = noArray()) = 0;
+
     /** @brief Returns the step size of sliding window search.
     */
     CV_WRAP virtual float getAlpha() const = 0;
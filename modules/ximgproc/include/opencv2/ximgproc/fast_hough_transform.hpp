@@ -137,6 +137,35 @@ CV_EXPORTS_W void FastHoughTransform( InputArray  src,
                                       int         op = FHT_ADD,
                                       int         makeSkew = HDO_DESKEW );
 
+/**
+* @brief   Calculates 2D Fast Hough transform of a sequence of images.
+* @details The class computes the same transform as cv::ximgproc::FastHoughTransform
+* but keeps its intermediate buffers between calls, so transforming a sequence of
+* images of the same size and type (e.g. video frames) does not reallocate them.
+*/
+class CV_EXPORTS_W FastHoughTransformer : public Algorithm
+{
+public:
+    /**
+    * @brief   Calculates 2D Fast Hough transform of an image.
+    * @param   src         The source (input) image.
+    * @param   dst         The destination image, result of transformation.
+    */
+    CV_WRAP virtual void apply(InputArray src, OutputArray dst) = 0;
+};
+
+/**
+* @brief   Creates a FastHoughTransformer.
+* @param   dstMatDepth The depth of destination image
+* @param   angleRange  The part of Hough space to calculate, see cv::AngleRangeOption
+* @param   op          The operation to be applied, see cv::HoughOp
+* @param   makeSkew    Specifies to do or not to do image skewing, see cv::HoughDeskewOption
+*/
+CV_EXPORTS_W Ptr<FastHoughTransformer> createFastHoughTransformer( int dstMatDepth,
+                                                                   int angleRange = ARO_315_135,
+                                                                   int op = FHT_ADD,
+                                                                   int makeSkew = HDO_DESKEW );
+
 /**
 * @brief   Calculates coordinates of line segment corresponded by point in Hough space.
 * @param   houghPoint  Point in Hough space.
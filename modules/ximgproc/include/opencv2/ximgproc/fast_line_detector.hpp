@@ -43,6 +43,17 @@ public:
       */
     CV_WRAP virtual void detect(InputArray _image, OutputArray _lines) = 0;
 
+    /** @brief Finds lines in a batch of images.
+
+      The images are processed in parallel, for example the current frames of
+      several cameras. The internal buffers are kept between calls, so calling
+      this method for every frame of a video does not reallocate them.
+
+      @param _images A vector of grayscale (CV_8UC1) input images.
+      @param _lines A vector holding, for each image, the lines as returned by detect().
+      */
+    CV_WRAP virtual void detectBatch(InputArrayOfArrays _images, OutputArrayOfArrays _lines) = 0;
+
     /** @brief Draws the line segments on a given image.
       @param _image The image, where the lines will be drawn. Should be bigger
       or equal to the image, where the lines were found.
@@ -113,6 +113,25 @@ CV_EXPORTS void createRLEImage(std::vector<cv::Point3i>& runs, OutputArray res,
 CV_EXPORTS void morphologyEx(InputArray rlSrc, OutputArray rlDest, int op, InputArray rlKernel,
     bool bBoundaryOnForErosion = true, Point anchor = Point(0,0));
 
+/**
+* @brief   Computes the connected components of a run-length encoded binary image and their statistics,
+*          without painting the image.
+*
+* The components are labeled 0, 1, ... in the raster order of their first pixel. There is no background
+* label, as the background is not part of the encoding.
+*
+* @param   rlSrc       input image, the runs must be sorted by row and column and must not overlap
+*                      (as produced by the other functions of this module)
+* @param   labels      output column of CV_32S labels, one for every run of rlSrc
+* @param   stats       output statistics of every label as a CV_32S matrix with one row per label,
+*                      columns are indexed by cv::ConnectedComponentsTypes (bounding box and area)
+* @param   connectivity 8 or 4 for 8-way or 4-way connectivity respectively
+* @return  the number of components
+*
+*/
+CV_EXPORTS int connectedComponentsWithStats(InputArray rlSrc, OutputArray labels, OutputArray stats,
+    int connectivity = 8);
+
 }
 }
 }
@@ -59,6 +59,14 @@ namespace cv {
 
                             CV_WRAP virtual void setMinSize(int min_size) = 0;
                             CV_WRAP virtual int getMinSize() = 0;
+
+                            /** @brief Set the size of the square tiles segmented independently, in parallel.
+                                Tiles are merged along their seams afterwards, so the result may slightly differ from
+                                the segmentation of the whole image. 0 (the default) disables tiling.
+                                @param tile_size The tile size in pixels
+                            */
+                            CV_WRAP virtual void setTileSize(int tile_size) = 0;
+                            CV_WRAP virtual int getTileSize() = 0;
                     };
 
                     /** @brief Creates a graph based segmentor
@@ -129,6 +129,22 @@ public:
     CV_WRAP virtual void  setFGSSigma(float _sigma) = 0;
     /** @see setFGSLambda */
     CV_WRAP virtual float getFGSSigma() = 0;
+
+    /** @brief Sets whether the geodesic structures (match graph and geodesic nearest neighbors of every match)
+    are kept between interpolate() calls. They are reused when the next call has the same cost map (edge map),
+    the same match positions in the reference image and the same K and Lambda, e.g. when several match sets
+    sharing their reference positions are interpolated. It is turned off by default.
+     */
+    CV_WRAP virtual void setUseGeodesicCache(bool _use_cache) = 0;
+    /** @see setUseGeodesicCache */
+    CV_WRAP virtual bool getUseGeodesicCache() = 0;
+
+    /** @brief Returns the geodesic K nearest neighbors of every match found by the last interpolate() call,
+    nearest first. Rows follow the matches sorted in raster order of their reference positions.
+    @param labels CV_32S matrix with the indices of the neighbors, -1 where there is none.
+    @param distances CV_32F matrix with the geodesic distances to the neighbors.
+     */
+    CV_WRAP virtual void getGeodesicNeighbors(OutputArray labels, OutputArray distances) = 0;
 };
 
 /** @brief Factory method that creates an instance of the
@@ -256,6 +272,22 @@ public:
      *  @see setFGSSigma
      */
     CV_WRAP virtual float getFGSSigma() const = 0;
+    /** @brief Sets whether the geodesic structures (match graph and geodesic nearest neighbors of every match)
+     *  and the superpixel segmentation are kept between interpolate() calls. The geodesic structures are reused
+     *  when the next call has the same cost map (edge map), match positions, K and lambda, the superpixels when
+     *  it has the same reference image and superpixel parameters. It is turned off by default.
+     */
+    CV_WRAP virtual void setUseGeodesicCache(bool use_cache = false) = 0;
+    /** @copybrief setUseGeodesicCache
+     *  @see setUseGeodesicCache
+     */
+    CV_WRAP virtual bool getUseGeodesicCache() const = 0;
+    /** @brief Returns the geodesic K nearest neighbors of every match found by the last interpolate() call,
+     *  nearest first, one row per match in the input order.
+     *  @param labels CV_32S matrix with the indices of the neighbors, -1 where there is none.
+     *  @param distances CV_32F matrix with the geodesic distances to the neighbors.
+     */
+    CV_WRAP virtual void getGeodesicNeighbors(OutputArray labels, OutputArray distances) const = 0;
 };
 
 /** @brief Factory method that creates an instance of the
@@ -50,6 +50,37 @@ PERF_TEST_P( DisparityWLSFilterPerfTest, perf, Combine(GuideTypes::all(), SrcTyp
     SANITY_CHECK_NOTHING();
 }
 
+typedef TestBaseWithParam<bool> DisparityWLSFilterVideoPerfTest;
+
+PERF_TEST_P( DisparityWLSFilterVideoPerfTest, perf, Values(true,false) )
+{
+    RNG rng(0);
+    bool use_conf = GetParam();
+    Size sz = sz720p;
+
+    Mat guide(sz, CV_8UC3);
+    Mat disp_left(sz, CV_16S);
+    Mat disp_right(sz, CV_16S);
+    Mat dst(sz, CV_16S);
+    Rect ROI;
+    MakeArtificialExample(rng,guide,disp_left,disp_right,ROI);
+
+    // static scene with a small moving object
+    Ptr<DisparityWLSFilter> wls_filter = createDisparityWLSFilterGeneric(use_conf);
+    wls_filter->setVideoMode(true);
+    wls_filter->filter(disp_left,guide,dst,disp_right,ROI);
+    int frame = 0;
+
+    TEST_CYCLE_N(10)
+    {
+        Rect object(ROI.x + 16*(frame++ % 8), ROI.y + 16, 48, 48);
+        guide(object).setTo(Scalar::all(frame*20 % 256));
+        wls_filter->filter(disp_left,guide,dst,disp_right,ROI);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 void MakeArtificialExample(RNG rng, Mat& dst_left_view, Mat& dst_left_disparity_map, Mat& dst_right_disparity_map, Rect& dst_ROI)
 {
     int w = dst_left_view.cols;
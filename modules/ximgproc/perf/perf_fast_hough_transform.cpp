@@ -78,4 +78,37 @@ PERF_TEST_P(srcSize_srcType_dstDepth, FastHoughTransform,
 
 #undef ALL_MAT_DEPHTS
 
+typedef tuple<Size, MatDepth, int, int> srcSize_dstDepth_op_angleRange_t;
+typedef perf::TestBaseWithParam<srcSize_dstDepth_op_angleRange_t>
+        srcSize_dstDepth_op_angleRange;
+
+PERF_TEST_P(srcSize_dstDepth_op_angleRange, FastHoughTransformer,
+            testing::Combine(
+                testing::Values(szVGA, sz1080p),
+                testing::Values(CV_8U, CV_16U, CV_32F),
+                testing::Values((int)FHT_ADD, (int)FHT_MAX, (int)FHT_AVE),
+                testing::Values((int)ARO_315_135, (int)ARO_0_45)
+                )
+            )
+{
+    Size srcSize    = get<0>(GetParam());
+    int  dstDepth   = get<1>(GetParam());
+    int  op         = get<2>(GetParam());
+    int  angleRange = get<3>(GetParam());
+
+    Mat src(srcSize, CV_8UC1);
+    Mat fht;
+
+    declare.in(src, WARMUP_RNG);
+
+    Ptr<FastHoughTransformer> transformer = createFastHoughTransformer(dstDepth, angleRange, op);
+
+    TEST_CYCLE_N(3)
+    {
+        transformer->apply(src, fht);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }} // namespace
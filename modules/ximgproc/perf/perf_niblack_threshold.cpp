@@ -0,0 +1,44 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test {
+namespace {
+
+typedef tuple<Size, int, int> NiblackThresholdParams;
+typedef TestBaseWithParam<NiblackThresholdParams> NiblackThresholdPerfTest;
+
+PERF_TEST_P(NiblackThresholdPerfTest, perf, Combine(Values(sz1080p, Size(4960, 7016)),
+    Values((int)BINARIZATION_NIBLACK, (int)BINARIZATION_SAUVOLA, (int)BINARIZATION_WOLF, (int)BINARIZATION_NICK),
+    Values(15, 51)))
+{
+    NiblackThresholdParams params = GetParam();
+    Size sz = get<0>(params);
+    int method = get<1>(params);
+    int blockSize = get<2>(params);
+
+    // page-like image: dark text strokes over an unevenly lit background
+    Mat src(sz, CV_8UC1);
+    RNG rng(0x0b1a);
+    rng.fill(src, RNG::UNIFORM, 180, 230);
+    for (int i = 0; i < sz.area() / 4000; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(p1.x + rng.uniform(-20, 20), p1.y + rng.uniform(-20, 20));
+        line(src, p1, p2, Scalar(rng.uniform(0, 80)), rng.uniform(1, 4));
+    }
+    Mat dst(sz, CV_8UC1);
+
+    declare.in(src).out(dst);
+
+    TEST_CYCLE_N(3)
+    {
+        niBlackThreshold(src, dst, 255, THRESH_BINARY, blockSize, 0.2, method, 128);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
+} // namespace
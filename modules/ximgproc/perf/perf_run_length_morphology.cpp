@@ -33,5 +33,28 @@ PERF_TEST_P(RLMorphologyPerfTest, perf, Combine(Values(1,7, 21), Values(sz720p,
     SANITY_CHECK_NOTHING();
 }
 
+typedef TestBaseWithParam<tuple<Size, int> > RLConnectedComponentsPerfTest;
+
+PERF_TEST_P(RLConnectedComponentsPerfTest, perf, Combine(Values(sz2160p, Size(16384, 1024)), Values(4, 8)))
+{
+    Size sz = get<0>(GetParam());
+    int connectivity = get<1>(GetParam());
+
+    Mat src(sz, CV_8U), blurred;
+    Mat thresholded, labels, stats;
+    randu(src, Scalar::all(0), Scalar::all(256));
+    GaussianBlur(src, blurred, Size(7, 7), 2.0);
+    rl::threshold(blurred, thresholded, 135.0, THRESH_BINARY);
+
+    declare.in(thresholded);
+
+    TEST_CYCLE_N(4)
+    {
+        rl::connectedComponentsWithStats(thresholded, labels, stats, connectivity);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 }
-} // namespace
\ No newline at end of file
+} // namespace
@@ -0,0 +1,41 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "perf_precomp.hpp"
+
+namespace opencv_test {
+namespace {
+
+typedef tuple<Size, int> ThinningParams;
+typedef TestBaseWithParam<ThinningParams> ThinningPerfTest;
+
+PERF_TEST_P(ThinningPerfTest, perf, Combine(Values(sz720p, sz2160p),
+    Values((int)THINNING_ZHANGSUEN, (int)THINNING_GUOHALL)))
+{
+    ThinningParams params = GetParam();
+    Size sz = get<0>(params);
+    int thinningType = get<1>(params);
+
+    // document-like image: many thick strokes on a blank page
+    Mat src = Mat::zeros(sz, CV_8UC1);
+    RNG rng(0x7417);
+    for (int i = 0; i < sz.area() / 2000; i++)
+    {
+        Point p1(rng.uniform(0, sz.width), rng.uniform(0, sz.height));
+        Point p2(p1.x + rng.uniform(-40, 40), p1.y + rng.uniform(-40, 40));
+        line(src, p1, p2, Scalar(255), rng.uniform(3, 9));
+    }
+    Mat dst;
+
+    declare.in(src);
+
+    TEST_CYCLE_N(3)
+    {
+        thinning(src, dst, thinningType);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
+}
+} // namespace
@@ -44,5 +44,34 @@ PERF_TEST_P(WeightedMedianFilterTest, perf,
     SANITY_CHECK_NOTHING();
 }
 
+typedef tuple<Size, MatType, int> WMFDisparityParam;
+typedef TestBaseWithParam<WMFDisparityParam> WeightedMedianFilterDisparityTest;
+
+PERF_TEST_P(WeightedMedianFilterDisparityTest, perf,
+    Combine(
+    Values(szVGA, sz720p),
+    Values(CV_8U, CV_32F),
+    Values(7, 15))
+)
+{
+    WMFDisparityParam params = GetParam();
+    Size sz  = get<0>(params);
+    int srcDepth = get<1>(params);
+    int r    = get<2>(params);
+
+    Mat joint(sz, CV_8UC3);
+    Mat src(sz, CV_MAKE_TYPE(srcDepth, 1));
+    Mat dst(sz, src.type());
+
+    declare.in(joint, src, WARMUP_RNG).out(dst);
+
+    TEST_CYCLE_N(1)
+    {
+        weightedMedianFilter(joint, src, dst, r, 25.5, WMF_EXP);
+    }
+
+    SANITY_CHECK_NOTHING();
+}
+
 
 }} // namespace
@@ -39,16 +39,27 @@
 
 #include "precomp.hpp"
 #include <opencv2/ximgproc.hpp>
+#include "opencv2/core/hal/hal.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <vector>
 
 namespace cv
 {
 namespace ximgproc
 {
-  void compute_mRTV(const Mat& L, Mat& mRTV, int fr);
-  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr);
-  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg);
-  void joint_bilateral_filter3(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg);
+  // Buffers of one filtering, reused by all its iterations
+  struct BTFWorkspace
+  {
+    Mat B, mRTV, G, minmRTV, Gtilde;
+    Mat Gx, Gy, grad, maxL, minL, maxG, sumG; // compute_mRTV
+    Mat rowMin, rowArg; // compute_G
+    Mat padG, padImg; // joint_bilateral_filter
+  };
+
+  void compute_mRTV(const Mat& L, Mat& mRTV, int fr, BTFWorkspace& ws);
+  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr, BTFWorkspace& ws);
+  void blend_G(const Mat& G, const Mat& B, const Mat& mRTV, const Mat& minmRTV, double sigmaAlpha, Mat& Gtilde);
+  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg, BTFWorkspace& ws);
 
   void bilateralTextureFilter(InputArray src_, OutputArray dst_, int fr,
                               int numIter, double sigmaAlpha, double sigmaAvg)
@@ -74,52 +85,22 @@ namespace ximgproc
       I.convertTo(I, CV_32FC3, 1.0 / 255.0);
     }
 
+    BTFWorkspace ws;
+    Mat J;
     for (int iter = 0; iter < numIter; iter++)
     {
-      Mat B;
-      blur(I, B, Size(2 * fr + 1, 2 * fr + 1), Point(-1, -1), BORDER_REFLECT);
+      blur(I, ws.B, Size(2 * fr + 1, 2 * fr + 1), Point(-1, -1), BORDER_REFLECT);
 
-      Mat mRTV;
-      compute_mRTV(I, mRTV, fr);
+      compute_mRTV(I, ws.mRTV, fr, ws);
 
-      Mat G, minmRTV;
-      compute_G(B, mRTV, G, minmRTV, fr);
+      compute_G(ws.B, ws.mRTV, ws.G, ws.minmRTV, fr, ws);
 
       // alpha blending
-      Mat Gtilde;
-      Mat diff = mRTV - minmRTV;
-      Mat alpha = -diff.mul(sigmaAlpha);
-      exp(alpha, alpha);
-      alpha = alpha + 1.;
-      pow(alpha, -1, alpha);
-      alpha = (alpha - 0.5) * 2;
-      Mat alphainv = -(alpha - 1);
-
-      std::vector<Mat> Gi, Bi;
-      Gi.resize(I.channels());
-      Bi.resize(I.channels());
-      if (I.channels() == 3) {
-        split(G, &Gi[0]);
-        split(B, &Bi[0]);
-      }
-      else {
-        G.copyTo(Gi[0]);
-        B.copyTo(Bi[0]);
-      }
+      blend_G(ws.G, ws.B, ws.mRTV, ws.minmRTV, sigmaAlpha, ws.Gtilde);
 
-      std::vector<Mat> Gtildei;
-      Gtildei.resize(I.channels());
-      for (int i = 0; i < B.channels(); i++)
-        Gtildei[i] = Gi[i].mul(alpha) + Bi[i].mul(alphainv);
-      merge(&Gtildei[0], B.channels(), Gtilde);
-
-      // joint bilateral filter
-      cv::Mat J;
-      if (I.channels() == 1)
-        joint_bilateral_filter(I, Gtilde, J, fr * 2, sigmaAvg);
-      else if (I.channels() == 3)
-        joint_bilateral_filter3(I, Gtilde, J, fr * 2, sigmaAvg);
-      I = J;
+      // joint bilateral filter, the previous image buffer receives the next one
+      joint_bilateral_filter(I, ws.Gtilde, J, fr * 2, sigmaAvg, ws);
+      std::swap(I, J);
     }
     if (src.type() == CV_8UC1) {
       I.convertTo(I, CV_8UC1, 255.0);
@@ -131,226 +112,278 @@ namespace ximgproc
     I.copyTo(dst_);
   }
 
-  void compute_mRTV(const Mat& L, Mat& mRTV, int fr)
+  void compute_mRTV(const Mat& L, Mat& mRTV, int fr, BTFWorkspace& ws)
   {
-    mRTV = Mat::zeros(L.size(), CV_32FC1);
-
     const float eps = 0.00001f;
+    const int cn = L.channels();
 
     // Calculate image derivative(gradient)
-    Mat G;
-    Mat Gx, Gy, kernelx, kernely;
-    kernelx = Mat::zeros(1, 3, CV_32F);
+    Mat kernelx = Mat::zeros(1, 3, CV_32F);
     kernelx.at<float>(0, 1) = -1.0;
     kernelx.at<float>(0, 2) = 1.0;
-    filter2D(L, Gx, -1, kernelx, Point(-1, -1), 0, BORDER_REFLECT);
-    kernely = Mat::zeros(3, 1, CV_32F);
+    filter2D(L, ws.Gx, -1, kernelx, Point(-1, -1), 0, BORDER_REFLECT);
+    Mat kernely = Mat::zeros(3, 1, CV_32F);
     kernely.at<float>(1, 0) = -1.0;
     kernely.at<float>(2, 0) = 1.0;
-    filter2D(L, Gy, -1, kernely, Point(-1, -1), 0, BORDER_REFLECT);
-
-    Gx = Gx.mul(Gx);
-    Gy = Gy.mul(Gy);
-    sqrt(Gx + Gy, G);
-
-    // Pad image L and G
-    Mat padL;
-    Mat padG;
-    copyMakeBorder(L, padL, fr, fr, fr, fr, BORDER_REFLECT);
-    copyMakeBorder(G, padG, fr, fr, fr, fr, BORDER_REFLECT);
-
-    // Calculate maxL, minL, maxG, sumG
-    int pu = fr;
-    int pb = pu + L.rows;
-    int pl = fr;
-    int pr = pl + L.cols;
-
-    std::vector<Mat> Li, Gi;
-    Li.resize(L.channels());
-    Gi.resize(L.channels());
-    if (L.channels() == 3) {
-      split(padL, &Li[0]);
-      split(padG, &Gi[0]);
-    }
-    else {
-      padL.copyTo(Li[0]);
-      padG.copyTo(Gi[0]);
-    }
-
-    for (int i = 0; i < L.channels(); i++)
+    filter2D(L, ws.Gy, -1, kernely, Point(-1, -1), 0, BORDER_REFLECT);
+    magnitude(ws.Gx, ws.Gy, ws.grad);
+
+    // Calculate maxL, minL, maxG, sumG over the (2*fr+1)x(2*fr+1) windows, all channels at once
+    Size ksize(2 * fr + 1, 2 * fr + 1);
+    Mat window = getStructuringElement(MORPH_RECT, ksize);
+    dilate(L, ws.maxL, window, Point(-1, -1), 1, BORDER_REFLECT);
+    erode(L, ws.minL, window, Point(-1, -1), 1, BORDER_REFLECT);
+    dilate(ws.grad, ws.maxG, window, Point(-1, -1), 1, BORDER_REFLECT);
+    boxFilter(ws.grad, ws.sumG, -1, ksize, Point(-1, -1), false, BORDER_REFLECT);
+
+    // mRTV = mean over the channels of maxG / sumG * (2*fr+1) * (maxL - minL),
+    // the extrema of L being taken together with 0 and 1
+    mRTV.create(L.size(), CV_32FC1);
+    const float scale = (float)(2 * fr + 1);
+    parallel_for_(Range(0, L.rows), [&](const Range& range)
     {
-      Mat maxL = Mat::zeros(L.size(), CV_32FC1);
-      Mat minL = Mat::ones(L.size(), CV_32FC1);
-      Mat maxG = Mat::zeros(L.size(), CV_32FC1);
-      Mat sumG = Mat::zeros(L.size(), CV_32FC1);
-      for (int y = -fr; y <= fr; y++)
+      for (int y = range.start; y < range.end; y++)
       {
-        for (int x = -fr; x <= fr; x++)
+        const float* maxL = ws.maxL.ptr<float>(y);
+        const float* minL = ws.minL.ptr<float>(y);
+        const float* maxG = ws.maxG.ptr<float>(y);
+        const float* sumG = ws.sumG.ptr<float>(y);
+        float* dst = mRTV.ptr<float>(y);
+        for (int x = 0; x < L.cols; x++)
         {
-          Mat temp = Li[i](
-            Range(pu + y, pb + y),
-            Range(pl + x, pr + x)
-          );
-          maxL = max(maxL, temp);
-          minL = min(minL, temp);
-
-          temp = Gi[i](
-            Range(pu + y, pb + y),
-            Range(pl + x, pr + x)
-          );
-          maxG = max(maxG, temp);
-          sumG = sumG + temp;
+          float v = 0.f;
+          for (int c = 0; c < cn; c++)
+          {
+            int k = x * cn + c;
+            float deltai = std::max(maxL[k], 0.f) - std::min(minL[k], 1.f);
+            v += maxG[k] / std::max(sumG[k], eps) * scale * deltai;
+          }
+          dst[x] = (cn == 3) ? v / 3 : v;
         }
       }
-      Mat deltai = maxL - minL;
-      sumG = max(sumG, eps);
-      Mat mRTVi = maxG / sumG * (2 * fr + 1);
-      mRTV = mRTV + mRTVi.mul(deltai);
-    }
-    if (L.channels() == 3)
-      mRTV = mRTV / 3;
+    });
   }
 
-  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr)
+  void compute_G(const Mat& B, const Mat& mRTV, Mat& G, Mat& alpha, int fr, BTFWorkspace& ws)
   {
-    B.copyTo(G);
-    alpha = Mat::ones(B.size(), CV_32FC1);
-    for (int y = -fr; y <= fr; y++)
+    // For every pixel, G takes the value of B at the position of the smallest mRTV of its window
+    // (coordinates clamped to the image), and alpha that mRTV, provided it is below 1. The first
+    // position in raster order of the window wins on ties: it is the first one of the row minima
+    // along the window rows, in the first window row holding the smallest of them.
+    const int rows = B.rows, cols = B.cols, cn = B.channels();
+
+    ws.rowMin.create(B.size(), CV_32FC1);
+    ws.rowArg.create(B.size(), CV_32SC1);
+    parallel_for_(Range(0, rows), [&](const Range& range)
     {
-      for (int x = -fr; x <= fr; x++)
+      for (int y = range.start; y < range.end; y++)
       {
-        Point pb;
-        Point pt;
-        for (pb.y = 0; pb.y < B.rows; pb.y++)
+        const float* m = mRTV.ptr<float>(y);
+        float* rmin = ws.rowMin.ptr<float>(y);
+        int* rarg = ws.rowArg.ptr<int>(y);
+        for (int x = 0; x < cols; x++)
         {
-          for (pb.x = 0; pb.x < B.cols; pb.x++)
+          int arg = std::max(x - fr, 0);
+          float best = m[arg];
+          for (int dx = -fr + 1; dx <= fr; dx++)
           {
-            pt.x = min(max(pb.x + x, 0), B.cols - 1);
-            pt.y = min(max(pb.y + y, 0), B.rows - 1);
-            if (alpha.at<float>(pb) > mRTV.at<float>(pt))
+            int xx = std::min(std::max(x + dx, 0), cols - 1);
+            if (m[xx] < best)
             {
-              alpha.at<float>(pb) = mRTV.at<float>(pt);
-              if (B.channels() == 3)
-                G.at<Vec3f>(pb) = B.at<Vec3f>(pt);
-              else if (B.channels() == 1)
-                G.at<float>(pb) = B.at<float>(pt);
+              best = m[xx];
+              arg = xx;
             }
           }
+          rmin[x] = best;
+          rarg[x] = arg;
         }
       }
-    }
+    });
+
+    G.create(B.size(), B.type());
+    alpha.create(B.size(), CV_32FC1);
+    parallel_for_(Range(0, rows), [&](const Range& range)
+    {
+      for (int y = range.start; y < range.end; y++)
+      {
+        float* a = alpha.ptr<float>(y);
+        float* g = G.ptr<float>(y);
+        for (int x = 0; x < cols; x++)
+        {
+          float best = 1.f;
+          const float* b = B.ptr<float>(y) + x * cn;
+          for (int dy = -fr; dy <= fr; dy++)
+          {
+            int yy = std::min(std::max(y + dy, 0), rows - 1);
+            float v = ws.rowMin.ptr<float>(yy)[x];
+            if (v < best)
+            {
+              best = v;
+              b = B.ptr<float>(yy) + ws.rowArg.ptr<int>(yy)[x] * cn;
+            }
+          }
+          a[x] = best;
+          for (int c = 0; c < cn; c++)
+            g[x * cn + c] = b[c];
+        }
+      }
+    });
   }
 
-  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg)
+  void blend_G(const Mat& G, const Mat& B, const Mat& mRTV, const Mat& minmRTV, double sigmaAlpha, Mat& Gtilde)
   {
-    Mat p_G;
-    copyMakeBorder(G, p_G, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat p_img;
-    copyMakeBorder(img, p_img, fr2, fr2, fr2, fr2, BORDER_REFLECT);
-
-    Mat SW;
-    if (SW.empty()) {
-      SW = Mat(2*fr2+1, 2*fr2+1, CV_32FC1);
-      int r, c;
-      float y, x;
-      for (r = 0, y = (float)-fr2; r < SW.rows; r++, y += 1.0) {
-        for(c = 0, x = (float)-fr2; c < SW.cols; c++, x += 1.0) {
-          SW.at<float>(r,c) = exp(-(x*x + y*y) / (2*fr2*fr2));
+    // Gtilde = alpha * G + (1 - alpha) * B with alpha = 2 / (1 + exp(-sigmaAlpha * (mRTV - minmRTV))) - 1
+    const int cols = G.cols, cn = G.channels();
+    const float sa = (float)sigmaAlpha;
+    Gtilde.create(G.size(), G.type());
+    parallel_for_(Range(0, G.rows), [&](const Range& range)
+    {
+      std::vector<float> alphaBuf(cols);
+      float* alpha = &alphaBuf[0];
+      for (int y = range.start; y < range.end; y++)
+      {
+        const float* m = mRTV.ptr<float>(y);
+        const float* mm = minmRTV.ptr<float>(y);
+        for (int x = 0; x < cols; x++)
+          alpha[x] = -((m[x] - mm[x]) * sa);
+        hal::exp32f(alpha, alpha, cols);
+
+        const float* g = G.ptr<float>(y);
+        const float* b = B.ptr<float>(y);
+        float* dst = Gtilde.ptr<float>(y);
+        for (int x = 0; x < cols; x++)
+        {
+          float a = (1.f / (alpha[x] + 1.f) - 0.5f) * 2;
+          float ainv = -(a - 1);
+          for (int c = 0; c < cn; c++)
+            dst[x * cn + c] = g[x * cn + c] * a + b[x * cn + c] * ainv;
         }
       }
-    }
+    });
+  }
 
-    r_img = Mat::zeros(img.size(), CV_32FC1);
+  // One window offset of the joint bilateral filter over a row:
+  // w = exp(colorCoeff * |pG - G|^2) * sw, sum += w, acc += w * pImg
+  template<int cn>
+  static void jbfAccumulateRow(const float* g, const float* pg, const float* pimg, int cols,
+                               float colorCoeff, float sw, float* wbuf, float* sum, float* acc)
+  {
+    int x = 0;
+#if CV_SIMD128
+    const v_float32x4 v_coeff = v_setall_f32(colorCoeff);
+    for (; x <= cols - v_float32x4::nlanes; x += v_float32x4::nlanes)
     {
-      Mat sum_d_W = Mat::zeros(img.size(), CV_32FC1);
-      Mat d_W = Mat::zeros(G.size(), CV_32FC1);
-
-      for (int x = -fr2; x <= fr2; x++) {
-        for (int y = -fr2; y <= fr2; y++) {
-          d_W = p_G(Rect(fr2+x, fr2+y, img.cols, img.rows)) - G;
-          multiply(d_W, d_W, d_W);
-          exp(-0.5 * d_W / (sigma_avg*sigma_avg), d_W);
+      v_float32x4 d = v_setzero_f32();
+      if (cn == 1)
+      {
+        v_float32x4 t = v_load(pg + x) - v_load(g + x);
+        d += t * t;
+      }
+      else
+      {
+        v_float32x4 g0, g1, g2, p0, p1, p2;
+        v_load_deinterleave(g + x * cn, g0, g1, g2);
+        v_load_deinterleave(pg + x * cn, p0, p1, p2);
+        d += (p0 - g0) * (p0 - g0);
+        d += (p1 - g1) * (p1 - g1);
+        d += (p2 - g2) * (p2 - g2);
+      }
+      v_store(wbuf + x, d * v_coeff);
+    }
+#endif
+    for (; x < cols; x++)
+    {
+      float d = 0.f;
+      for (int c = 0; c < cn; c++)
+      {
+        float t = pg[x * cn + c] - g[x * cn + c];
+        d += t * t;
+      }
+      wbuf[x] = d * colorCoeff;
+    }
 
-          d_W = d_W * SW.at<float>(fr2+y, fr2+x); //Gaussian weight
+    hal::exp32f(wbuf, wbuf, cols);
 
-          sum_d_W = sum_d_W + d_W;
-          multiply(d_W, p_img(Rect(fr2+x, fr2+y, img.cols, img.rows)), d_W);
-          r_img = r_img + d_W;
-        }
+    x = 0;
+#if CV_SIMD128
+    const v_float32x4 v_sw = v_setall_f32(sw);
+    for (; x <= cols - v_float32x4::nlanes; x += v_float32x4::nlanes)
+    {
+      v_float32x4 w = v_load(wbuf + x) * v_sw;
+      v_store(sum + x, v_load(sum + x) + w);
+      if (cn == 1)
+      {
+        v_store(acc + x, v_load(acc + x) + w * v_load(pimg + x));
+      }
+      else
+      {
+        v_float32x4 a0, a1, a2, p0, p1, p2;
+        v_load_deinterleave(acc + x * cn, a0, a1, a2);
+        v_load_deinterleave(pimg + x * cn, p0, p1, p2);
+        v_store_interleave(acc + x * cn, a0 + w * p0, a1 + w * p1, a2 + w * p2);
       }
-      max(1e-5f, sum_d_W, sum_d_W);
-      divide(r_img, sum_d_W, r_img);
+    }
+#endif
+    for (; x < cols; x++)
+    {
+      float w = wbuf[x] * sw;
+      sum[x] += w;
+      for (int c = 0; c < cn; c++)
+        acc[x * cn + c] += w * pimg[x * cn + c];
     }
   }
 
-  void joint_bilateral_filter3(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg)
+  void joint_bilateral_filter(const Mat& img, const Mat& G, Mat& r_img, int fr2, double sigma_avg, BTFWorkspace& ws)
   {
-    Mat p_G;
-    copyMakeBorder(G, p_G, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+    CV_Assert(img.channels() == 1 || img.channels() == 3);
+    const int cn = img.channels(), cols = img.cols;
 
-    Mat p_img;
-    copyMakeBorder(img, p_img, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+    copyMakeBorder(G, ws.padG, fr2, fr2, fr2, fr2, BORDER_REFLECT);
+    copyMakeBorder(img, ws.padImg, fr2, fr2, fr2, fr2, BORDER_REFLECT);
 
-    Mat SW;
-    if (SW.empty()) {
-      SW = Mat(2*fr2+1, 2*fr2+1, CV_32FC1);
+    const int wsize = 2 * fr2 + 1;
+    std::vector<float> SW(wsize * wsize);
+    {
       int r, c;
       float y, x;
-      for (r = 0, y = (float)-fr2; r < SW.rows; r++, y += 1.0) {
-        for(c = 0, x = (float)-fr2; c < SW.cols; c++, x += 1.0) {
-          SW.at<float>(r,c) = exp(-(x*x + y*y) / (2*fr2*fr2));
+      for (r = 0, y = (float)-fr2; r < wsize; r++, y += 1.0) {
+        for(c = 0, x = (float)-fr2; c < wsize; c++, x += 1.0) {
+          SW[r * wsize + c] = exp(-(x*x + y*y) / (2*fr2*fr2));
         }
       }
     }
+    const float colorCoeff = (float)(-0.5 / (sigma_avg*sigma_avg));
 
-    std::vector<Mat> G_channels(3);
-    split(G, G_channels);
-    std::vector<Mat> p_G_channels(3);
-    split(p_G, p_G_channels);
-    std::vector<Mat> p_img_channels(3);
-    split(p_img, p_img_channels);
-
-    Mat sum_d_W = Mat::zeros(img.size(), CV_32FC1);
-    std::vector<Mat> d_W_channels(3);
-    for (int ch = 0; ch < 3; ch++) {
-      d_W_channels[ch] = Mat::zeros(G.size(), CV_32FC1);
-    }
-    Mat d_W = Mat::zeros(G.size(), CV_32FC1);
-
-    std::vector<Mat> r_img_channels(3);
-    for (int ch = 0; ch < 3; ch++) {
-      r_img_channels[ch] = Mat::zeros(G.size(), CV_32FC1);
-    }
-
-    for (int x = -fr2; x <= fr2; x++) {
-      for (int y = -fr2; y <= fr2; y++) {
-        d_W.setTo(0);
-        for (int ch = 0; ch < 3; ch++) {
-          subtract(p_G_channels[ch](Rect(fr2+x, fr2+y, img.cols, img.rows)), G_channels[ch], d_W_channels[ch]);
-          multiply(d_W_channels[ch], d_W_channels[ch], d_W_channels[ch]);
-        }
-        for (int ch = 0; ch < 3; ch++) {
-          add(d_W, d_W_channels[ch], d_W);
+    r_img.create(img.size(), img.type());
+    parallel_for_(Range(0, img.rows), [&](const Range& range)
+    {
+      std::vector<float> wbuf(cols), sum(cols), acc(cols * cn);
+      for (int i = range.start; i < range.end; i++)
+      {
+        std::fill(sum.begin(), sum.end(), 0.f);
+        std::fill(acc.begin(), acc.end(), 0.f);
+        const float* g = G.ptr<float>(i);
+        for (int x = -fr2; x <= fr2; x++) {
+          for (int y = -fr2; y <= fr2; y++) {
+            const float* pg = ws.padG.ptr<float>(i + fr2 + y) + (fr2 + x) * cn;
+            const float* pimg = ws.padImg.ptr<float>(i + fr2 + y) + (fr2 + x) * cn;
+            const float sw = SW[(fr2 + y) * wsize + fr2 + x]; //Gaussian weight
+            if (cn == 1)
+              jbfAccumulateRow<1>(g, pg, pimg, cols, colorCoeff, sw, &wbuf[0], &sum[0], &acc[0]);
+            else
+              jbfAccumulateRow<3>(g, pg, pimg, cols, colorCoeff, sw, &wbuf[0], &sum[0], &acc[0]);
+          }
         }
-        exp(-0.5 * d_W / (sigma_avg*sigma_avg), d_W);
-
-        d_W = d_W * SW.at<float>(fr2+y, fr2+x); //Gaussian weight
-
-        add(sum_d_W, d_W, sum_d_W);
 
-        for (int ch = 0; ch < 3; ch++) {
-          Mat n_p_img = p_img_channels[ch](Rect(fr2+x, fr2+y, img.cols, img.rows));
-          accumulateProduct(d_W, n_p_img, r_img_channels[ch]);
+        float* dst = r_img.ptr<float>(i);
+        for (int j = 0; j < cols; j++)
+        {
+          float s = std::max(sum[j], 1e-5f);
+          for (int c = 0; c < cn; c++)
+            dst[j * cn + c] = acc[j * cn + c] / s;
         }
       }
-    }
-
-    max(1e-5f, sum_d_W, sum_d_W);
-    for (int ch = 0; ch < 3; ch++) {
-      divide(r_img_channels[ch], sum_d_W, r_img_channels[ch]);
-    }
-    merge(r_img_channels, r_img);
+    });
   }
 
 }
@@ -62,9 +62,19 @@ protected:
     float resize_factor;
     int num_stripes;
 
+    // video mode: tiles of the last solved frame, the result is reused where the inputs did not change
+    enum { VIDEO_TILE_SIZE = 32, VIDEO_MARGIN_TILES = 2 };
+    bool video_mode;
+    int change_thresh;
+    Mat prev_guide, prev_disp, prev_conf, prev_result;
+    double prev_lambda, prev_sigma_color;
+
     void init(double _lambda, double _sigma_color, bool _use_confidence, int l_offs, int r_offs, int t_offs, int b_offs, int _min_disp);
     void computeDepthDiscontinuityMaps(Mat& left_disp, Mat& right_disp, Mat& left_dst, Mat& right_dst);
     void computeConfidenceMap(InputArray left_disp, InputArray right_disp);
+    void solveRegion(const Mat& src, const Mat& disp, const Mat& conf, Mat& dst);
+    void solve(const Mat& src, const Mat& disp, const Mat& conf, Mat& dst);
+    void storeFrame(const Mat& src, const Mat& disp, const Mat& conf, const Mat& result);
 
 protected:
     struct ComputeDiscontinuityAwareLRC_ParBody : public ParallelLoopBody
@@ -138,6 +148,12 @@ public:
 
     Mat getConfidenceMap() CV_OVERRIDE { return confidence_map; }
     Rect getROI() CV_OVERRIDE { return valid_disp_ROI; }
+
+    bool getVideoMode() CV_OVERRIDE { return video_mode; }
+    void setVideoMode(bool _video_mode) CV_OVERRIDE { video_mode = _video_mode; if (!video_mode) prev_result.release(); }
+
+    int getChangeThreshold() CV_OVERRIDE { return change_thresh; }
+    void setChangeThreshold(int _change_thresh) CV_OVERRIDE { CV_Assert(_change_thresh >= 0); change_thresh = _change_thresh; }
 };
 
 void DisparityWLSFilterImpl::init(double _lambda, double _sigma_color, bool _use_confidence,  int l_offs, int r_offs, int t_offs, int b_offs, int _min_disp)
@@ -157,6 +173,9 @@ void DisparityWLSFilterImpl::init(double _lambda, double _sigma_color, bool _use
     depth_discontinuity_roll_off_factor = 0.001f;
     resize_factor = 1.0;
     num_stripes = getNumThreads();
+    video_mode = false;
+    change_thresh = 0;
+    prev_lambda = prev_sigma_color = 0.0;
 }
 
 void DisparityWLSFilterImpl::computeDepthDiscontinuityMaps(Mat& left_disp, Mat& right_disp, Mat& left_dst, Mat& right_dst)
@@ -292,9 +311,7 @@ void DisparityWLSFilterImpl::filter_(InputArray disparity_map_left, InputArray l
         Mat& dst_full_size = filtered_disparity_map.getMatRef();
         dst_full_size = Scalar(16*(min_disp-1));
         dst = Mat(dst_full_size,ROI);
-        Mat filtered_disp;
-        fastGlobalSmootherFilter(src,disp,filtered_disp,lambda,sigma_color);
-        filtered_disp.copyTo(dst);
+        solve(src,disp,Mat(),dst);
     }
     else
     {
@@ -324,15 +341,115 @@ void DisparityWLSFilterImpl::filter_(InputArray disparity_map_left, InputArray l
         dst_full_size = Scalar(16*(min_disp-1));
         dst = Mat(dst_full_size,ROI);
         Mat conf(confidence_map,ROI);
+        solve(src,disp,conf,dst);
+    }
+}
 
+void DisparityWLSFilterImpl::solveRegion(const Mat& src, const Mat& disp, const Mat& conf, Mat& dst)
+{
+    if(conf.empty())
+    {
+        Mat filtered_disp;
+        fastGlobalSmootherFilter(src,disp,filtered_disp,lambda,sigma_color);
+        filtered_disp.copyTo(dst);
+    }
+    else
+    {
         Mat disp_mul_conf;
         disp_mul_conf = conf.mul(disp);
         Mat conf_filtered;
         Ptr<FastGlobalSmootherFilter> wls = createFastGlobalSmootherFilter(src,lambda,sigma_color);
         wls->filter(disp_mul_conf,disp_mul_conf);
         wls->filter(conf,conf_filtered);
-        dst = disp_mul_conf.mul(1/(conf_filtered+EPS));
+        Mat filtered_disp = disp_mul_conf.mul(1/(conf_filtered+EPS));
+        filtered_disp.copyTo(dst);
+    }
+}
+
+void DisparityWLSFilterImpl::storeFrame(const Mat& src, const Mat& disp, const Mat& conf, const Mat& result)
+{
+    src.copyTo(prev_guide);
+    disp.copyTo(prev_disp);
+    if(conf.empty())
+        prev_conf.release();
+    else
+        conf.copyTo(prev_conf);
+    result.copyTo(prev_result);
+    prev_lambda = lambda;
+    prev_sigma_color = sigma_color;
+}
+
+void DisparityWLSFilterImpl::solve(const Mat& src, const Mat& disp, const Mat& conf, Mat& dst)
+{
+    bool can_reuse = video_mode && !prev_result.empty() &&
+                     prev_guide.size() == src.size() && prev_guide.type() == src.type() &&
+                     prev_disp.size() == disp.size() && prev_conf.empty() == conf.empty() &&
+                     prev_lambda == lambda && prev_sigma_color == sigma_color;
+    if(!can_reuse)
+    {
+        solveRegion(src,disp,conf,dst);
+        if(video_mode)
+            storeFrame(src,disp,conf,dst);
+        return;
+    }
+
+    // find the tiles where the guide, the disparity or the confidence changed since they were last solved
+    const int tile = VIDEO_TILE_SIZE;
+    const int tiles_x = (src.cols+tile-1)/tile;
+    const int tiles_y = (src.rows+tile-1)/tile;
+    const Rect frame(0,0,src.cols,src.rows);
+    Mat changed(tiles_y,tiles_x,CV_8U);
+    parallel_for_(Range(0,tiles_x*tiles_y),[&](const Range& range)
+    {
+        for(int t=range.start;t<range.end;t++)
+        {
+            int tx = t%tiles_x, ty = t/tiles_x;
+            Rect r = Rect(tx*tile,ty*tile,tile,tile) & frame;
+            bool c = norm(Mat(src,r),Mat(prev_guide,r),NORM_INF) > change_thresh ||
+                     norm(Mat(disp,r),Mat(prev_disp,r),NORM_INF) > 0 ||
+                     (!conf.empty() && norm(Mat(conf,r),Mat(prev_conf,r),NORM_INF) > 0);
+            changed.at<uchar>(ty,tx) = c ? 255 : 0;
+        }
+    });
+
+    int n_changed = countNonZero(changed);
+    if(2*n_changed > tiles_x*tiles_y)
+    {
+        solveRegion(src,disp,conf,dst);
+        storeFrame(src,disp,conf,dst);
+        return;
+    }
+
+    // every group of changed tiles is re-solved with a margin of unchanged tiles around it,
+    // only the changed tiles of the group are updated
+    if(n_changed > 0)
+    {
+        Mat grown, labels, stats, centroids;
+        dilate(changed,grown,Mat(),Point(-1,-1),VIDEO_MARGIN_TILES);
+        int n_groups = connectedComponentsWithStats(grown,labels,stats,centroids,8,CV_32S);
+        for(int l=1;l<n_groups;l++)
+        {
+            Rect group(stats.at<int>(l,CC_STAT_LEFT),stats.at<int>(l,CC_STAT_TOP),
+                       stats.at<int>(l,CC_STAT_WIDTH),stats.at<int>(l,CC_STAT_HEIGHT));
+            Rect region = Rect(group.x*tile,group.y*tile,group.width*tile,group.height*tile) & frame;
+            Mat region_result;
+            solveRegion(Mat(src,region),Mat(disp,region),conf.empty() ? Mat() : Mat(conf,region),region_result);
+
+            for(int ty=group.y;ty<group.y+group.height;ty++)
+                for(int tx=group.x;tx<group.x+group.width;tx++)
+                {
+                    if(!changed.at<uchar>(ty,tx) || labels.at<int>(ty,tx)!=l)
+                        continue;
+                    Rect r = Rect(tx*tile,ty*tile,tile,tile) & frame;
+                    Mat(region_result,r-region.tl()).copyTo(Mat(prev_result,r));
+                    Mat(src,r).copyTo(Mat(prev_guide,r));
+                    Mat(disp,r).copyTo(Mat(prev_disp,r));
+                    if(!conf.empty())
+                        Mat(conf,r).copyTo(Mat(prev_conf,r));
+                }
+        }
     }
+    prev_result.copyTo(dst);
 }
 
 DisparityWLSFilterImpl::ComputeDiscontinuityAwareLRC_ParBody::ComputeDiscontinuityAwareLRC_ParBody(DisparityWLSFilterImpl& _wls, Mat& _left_disp, Mat& _right_disp, Mat& _left_disc, Mat& _right_disc, Mat& _dst, Rect _left_ROI, Rect _right_ROI, int _nstripes):
@@ -88,6 +88,14 @@ protected: /*Typedefs declarations*/
 
     typedef float                   WorkType;
 
+    enum
+    {
+        /*rows of the NC/IC passes buffered before their transposed write*/
+        TRANSPOSE_TILE = 8,
+        /*rows (columns) handled by one parallel stripe of the horizontal (vertical) RF pass*/
+        RF_STRIPE = 16
+    };
+
 public: /*Members declarations*/
 
     int h, w, mode;
@@ -147,7 +155,7 @@ protected: /*Wrappers for parallelization*/
     template <typename WorkVec>
     struct FilterIC_horPass : public ParallelLoopBody
     {
-        Mat &src, &idist, &dist, &dst, isrcBuf;
+        Mat &src, &idist, &dist, &dst;
         float radius;
 
         FilterIC_horPass(Mat& src_, Mat& idist_, Mat& dist_, Mat& dst_);
@@ -163,6 +171,7 @@ protected: /*Wrappers for parallelization*/
         FilterRF_horPass(Mat& res_, Mat& alphaD_, int iteration_);
         void operator() (const Range& range) const CV_OVERRIDE;
         Range getRange() const { return Range(0, res.rows); }
+        double getNStripes() const { return res.rows / (double)RF_STRIPE; }
     };
 
     template <typename WorkVec>
@@ -175,8 +184,10 @@ protected: /*Wrappers for parallelization*/
         void operator() (const Range& range) const CV_OVERRIDE;
         #ifdef CV_GET_NUM_THREAD_WORKS_PROPERLY
         Range getRange() const { return Range(0, cv::getNumThreads()); }
+        double getNStripes() const { return -1.0; }
         #else
         Range getRange() const { return Range(0, res.cols); }
+        double getNStripes() const { return res.cols / (double)RF_STRIPE; }
         #endif
     };
 
@@ -239,6 +250,10 @@ protected: /*Auxiliary implementation functions*/
 
     static Mat getWExtendedMat(int h, int w, int type, int brdleft = 0, int brdRight = 0, int cacheAlign = 0);
 
+    /*writes the rows [i0, i1) of a pass output, buffered in tile, to the columns [i0, i1) of dst*/
+    template<typename WorkVec>
+    static void writeTransposedTile(const std::vector<WorkVec>& tile, int cols, int i0, int i1, Mat& dst);
+
     template<typename SrcVec, typename SrcWorkVec>
     static void integrateSparseRow(const SrcVec *src, const float *dist, SrcWorkVec *dst, int cols);
 
@@ -158,8 +158,8 @@ void DTFilterCPU::filter_(const Mat& src, Mat& dst, int dDepth)
         {
             horParBody.radius = vertParBody.radius = getIterRadius(iter);
 
-            parallel_for_(Range(0, res.rows), horParBody);
-            parallel_for_(Range(0, resT.rows), vertParBody);
+            parallel_for_(Range(0, res.rows), horParBody, res.rows / (double)TRANSPOSE_TILE);
+            parallel_for_(Range(0, resT.rows), vertParBody, resT.rows / (double)TRANSPOSE_TILE);
         }
     }
     else if (mode == DTF_IC)
@@ -174,8 +174,8 @@ void DTFilterCPU::filter_(const Mat& src, Mat& dst, int dDepth)
         {
             horParBody.radius = vertParBody.radius = getIterRadius(iter);
 
-            parallel_for_(Range(0, res.rows), horParBody);
-            parallel_for_(Range(0, resT.rows), vertParBody);
+            parallel_for_(Range(0, res.rows), horParBody, res.rows / (double)TRANSPOSE_TILE);
+            parallel_for_(Range(0, resT.rows), vertParBody, resT.rows / (double)TRANSPOSE_TILE);
         }
     }
     else if (mode == DTF_RF)
@@ -196,8 +196,8 @@ void DTFilterCPU::filter_(const Mat& src, Mat& dst, int dDepth)
 
             FilterRF_horPass<WorkVec> horParBody(res, a0dHor, iter);
             FilterRF_vertPass<WorkVec> vertParBody(res, a0dVert, iter);
-            parallel_for_(horParBody.getRange(), horParBody);
-            parallel_for_(vertParBody.getRange(), vertParBody);
+            parallel_for_(horParBody.getRange(), horParBody, horParBody.getNStripes());
+            parallel_for_(vertParBody.getRange(), vertParBody, vertParBody.getNStripes());
         }
     }
 
@@ -266,6 +266,17 @@ void DTFilterCPU::prepareSrcImg_IC(const Mat& src, Mat& dst, Mat& dstT)
 }
 
 
+template<typename WorkVec>
+void DTFilterCPU::writeTransposedTile(const std::vector<WorkVec>& tile, int cols, int i0, int i1, Mat& dst)
+{
+    for (int j = 0; j < cols; j++)
+    {
+        WorkVec *dstLine = dst.ptr<WorkVec>(j) + i0;
+        for (int i = i0; i < i1; i++)
+            dstLine[i - i0] = tile[(i - i0) * cols + j];
+    }
+}
+
 template <typename WorkVec>
 DTFilterCPU::FilterNC_horPass<WorkVec>::FilterNC_horPass(Mat& src_, Mat& idist_, Mat& dst_)
 : src(src_), idist(idist_), dst(dst_), radius(1.0f)
@@ -281,42 +292,51 @@ void DTFilterCPU::FilterNC_horPass<WorkVec>::operator()(const Range& range) cons
     WorkVec *isrcLine = &isrcBuf[0];
     #endif
 
-    for (int i = range.start; i < range.end; i++)
+    //results of TRANSPOSE_TILE rows, written to dst as contiguous pieces of its rows
+    std::vector<WorkVec> tileBuf(TRANSPOSE_TILE * src.cols);
+
+    for (int i0 = range.start; i0 < range.end; i0 += TRANSPOSE_TILE)
     {
-        const WorkVec   *srcLine    = src.ptr<WorkVec>(i);
-        IDistType       *idistLine  = idist.ptr<IDistType>(i);
-        int leftBound = 0, rightBound = 0;
-        WorkVec sum;
-
-        #ifdef NC_USE_INTEGRAL_SRC
-        integrateRow(srcLine, isrcLine, src.cols);
-        #else
-        sum = srcLine[0];
-        #endif
-
-        for (int j = 0; j < src.cols; j++)
+        int i1 = std::min(i0 + (int)TRANSPOSE_TILE, range.end);
+        for (int i = i0; i < i1; i++)
         {
-            IDistType curVal = idistLine[j];
+            const WorkVec   *srcLine    = src.ptr<WorkVec>(i);
+            IDistType       *idistLine  = idist.ptr<IDistType>(i);
+            WorkVec         *tileLine   = &tileBuf[(i - i0) * src.cols];
+            int leftBound = 0, rightBound = 0;
+            WorkVec sum;
+
             #ifdef NC_USE_INTEGRAL_SRC
-            leftBound  = getLeftBound(idistLine, leftBound, curVal - radius);
-            rightBound = getRightBound(idistLine, rightBound, curVal + radius);
-            sum = (isrcLine[rightBound + 1] - isrcLine[leftBound]);
+            integrateRow(srcLine, isrcLine, src.cols);
             #else
-            while (idistLine[leftBound] < curVal - radius)
-            {
-                sum -= srcLine[leftBound];
-                leftBound++;
-            }
+            sum = srcLine[0];
+            #endif
 
-            while (idistLine[rightBound + 1] < curVal + radius)
+            for (int j = 0; j < src.cols; j++)
             {
-                rightBound++;
-                sum += srcLine[rightBound];
+                IDistType curVal = idistLine[j];
+                #ifdef NC_USE_INTEGRAL_SRC
+                leftBound  = getLeftBound(idistLine, leftBound, curVal - radius);
+                rightBound = getRightBound(idistLine, rightBound, curVal + radius);
+                sum = (isrcLine[rightBound + 1] - isrcLine[leftBound]);
+                #else
+                while (idistLine[leftBound] < curVal - radius)
+                {
+                    sum -= srcLine[leftBound];
+                    leftBound++;
+                }
+
+                while (idistLine[rightBound + 1] < curVal + radius)
+                {
+                    rightBound++;
+                    sum += srcLine[rightBound];
+                }
+                #endif
+
+                tileLine[j] = sum / (float)(rightBound + 1 - leftBound);
             }
-            #endif
-
-            dst.at<WorkVec>(j, i) = sum / (float)(rightBound + 1 - leftBound);
         }
+        writeTransposedTile(tileBuf, src.cols, i0, i1, dst);
     }
 }
 
@@ -325,57 +345,57 @@ DTFilterCPU::FilterIC_horPass<WorkVec>::FilterIC_horPass(Mat& src_, Mat& idist_,
 : src(src_), idist(idist_), dist(dist_), dst(dst_), radius(1.0f)
 {
     CV_DbgAssert(src.type() == traits::Type<WorkVec>::value && dst.type() == traits::Type<WorkVec>::value && dst.rows == src.cols && dst.cols == src.rows);
-
-    #ifdef CV_GET_NUM_THREAD_WORKS_PROPERLY
-    isrcBuf.create(cv::getNumThreads(), src.cols + 1, traits::Type<WorkVec>::value);
-    #else
-    isrcBuf.create(src.rows, src.cols + 1, traits::Type<WorkVec>::value);
-    #endif
 }
 
 template <typename WorkVec>
 void DTFilterCPU::FilterIC_horPass<WorkVec>::operator()(const Range& range) const
 {
-    #ifdef CV_GET_NUM_THREAD_WORKS_PROPERLY
-    WorkVec *isrcLine = const_cast<WorkVec*>( isrcBuf.ptr<WorkVec>(cv::getThreadNum()) );
-    #else
-    WorkVec *isrcLine = const_cast<WorkVec*>( isrcBuf.ptr<WorkVec>(range.start) );
-    #endif
+    std::vector<WorkVec> isrcBuf(src.cols + 1);
+    WorkVec *isrcLine = &isrcBuf[0];
 
-    for (int i = range.start; i < range.end; i++)
+    //results of TRANSPOSE_TILE rows, written to dst as contiguous pieces of its rows
+    std::vector<WorkVec> tileBuf(TRANSPOSE_TILE * src.cols);
+
+    for (int i0 = range.start; i0 < range.end; i0 += TRANSPOSE_TILE)
     {
-        WorkVec   *srcLine      = src.ptr<WorkVec>(i);
-        DistType  *distLine     = dist.ptr<DistType>(i);
-        IDistType *idistLine    = idist.ptr<IDistType>(i);
+        int i1 = std::min(i0 + (int)TRANSPOSE_TILE, range.end);
+        for (int i = i0; i < i1; i++)
+        {
+            WorkVec   *srcLine      = src.ptr<WorkVec>(i);
+            DistType  *distLine     = dist.ptr<DistType>(i);
+            IDistType *idistLine    = idist.ptr<IDistType>(i);
+            WorkVec   *tileLine     = &tileBuf[(i - i0) * src.cols];
 
-        integrateSparseRow(srcLine, distLine, isrcLine, src.cols);
+            integrateSparseRow(srcLine, distLine, isrcLine, src.cols);
 
-        int leftBound = 0, rightBound = 0;
-        WorkVec sumL, sumR, sumC;
+            int leftBound = 0, rightBound = 0;
+            WorkVec sumL, sumR, sumC;
 
-        srcLine[-1] = srcLine[0];
-        srcLine[src.cols] = srcLine[src.cols - 1];
+            srcLine[-1] = srcLine[0];
+            srcLine[src.cols] = srcLine[src.cols - 1];
 
-        for (int j = 0; j < src.cols; j++)
-        {
-            IDistType curVal = idistLine[j];
-            IDistType valueLeft = curVal - radius;
-            IDistType valueRight = curVal + radius;
+            for (int j = 0; j < src.cols; j++)
+            {
+                IDistType curVal = idistLine[j];
+                IDistType valueLeft = curVal - radius;
+                IDistType valueRight = curVal + radius;
 
-            leftBound = getLeftBound(idistLine, leftBound, valueLeft);
-            rightBound = getRightBound(idistLine, rightBound, valueRight);
+                leftBound = getLeftBound(idistLine, leftBound, valueLeft);
+                rightBound = getRightBound(idistLine, rightBound, valueRight);
 
-            float areaL = idistLine[leftBound] - valueLeft;
-            float areaR = valueRight - idistLine[rightBound];
-            float dl = areaL / distLine[leftBound - 1];
-            float dr = areaR / distLine[rightBound];
+                float areaL = idistLine[leftBound] - valueLeft;
+                float areaR = valueRight - idistLine[rightBound];
+                float dl = areaL / distLine[leftBound - 1];
+                float dr = areaR / distLine[rightBound];
 
-            sumL = 0.5f*areaL*(dl*srcLine[leftBound - 1] + (2.0f - dl)*srcLine[leftBound]);
-            sumR = 0.5f*areaR*((2.0f - dr)*srcLine[rightBound] + dr*srcLine[rightBound + 1]);
-            sumC = isrcLine[rightBound] - isrcLine[leftBound];
+                sumL = 0.5f*areaL*(dl*srcLine[leftBound - 1] + (2.0f - dl)*srcLine[leftBound]);
+                sumR = 0.5f*areaR*((2.0f - dr)*srcLine[rightBound] + dr*srcLine[rightBound + 1]);
+                sumC = isrcLine[rightBound] - isrcLine[leftBound];
 
-            dst.at<WorkVec>(j, i) = (sumL + sumC + sumR) / (2.0f * radius);
+                tileLine[j] = (sumL + sumC + sumR) / (2.0f * radius);
+            }
         }
+        writeTransposedTile(tileBuf, src.cols, i0, i1, dst);
     }
 }
 
@@ -392,7 +412,34 @@ DTFilterCPU::FilterRF_horPass<WorkVec>::FilterRF_horPass(Mat& res_, Mat& alphaD_
 template <typename WorkVec>
 void DTFilterCPU::FilterRF_horPass<WorkVec>::operator()(const Range& range) const
 {
-    for (int i = range.start; i < range.end; i++)
+    const int cn = WorkVec::channels;
+    int i = range.start;
+
+    if (range.end - i >= 4)
+    {
+        //groups of 4 rows are filtered in lockstep, interleaved so that every recursion step is one vector operation
+        std::vector<float> buf(4 * res.cols * cn), abuf(4 * std::max(res.cols - 1, 1));
+        for (; i <= range.end - 4; i += 4)
+        {
+            float *rows[4], *arows[4];
+            for (int r = 0; r < 4; r++)
+            {
+                rows[r] = res.ptr<float>(i + r);
+                arows[r] = alphaD.ptr<DistType>(i + r);
+                if (iteration > 1)
+                {
+                    for (int j = res.cols - 2; j >= 0; j--)
+                        arows[r][j] *= arows[r][j];
+                }
+            }
+            interleave_rows4(rows, &buf[0], res.cols * cn);
+            interleave_rows4(arows, &abuf[0], res.cols - 1);
+            rf_hor_rows4_pass(&buf[0], &abuf[0], res.cols, cn);
+            deinterleave_rows4(&buf[0], rows, res.cols * cn);
+        }
+    }
+
+    for (; i < range.end; i++)
     {
         WorkVec     *dstLine = res.ptr<WorkVec>(i);
         DistType    *adLine  = alphaD.ptr<DistType>(i);
@@ -447,10 +494,8 @@ void DTFilterCPU::FilterRF_vertPass<WorkVec>::operator()(const Range& range) con
                 adRow[j] *= adRow[j];
         }
 
-        for (int j = rcols.start; j < rcols.end; j++)
-        {
-            curRow[j] += adRow[j] * (prevRow[j] - curRow[j]);
-        }
+        rf_vert_row_pass((float*)(curRow + rcols.start), (float*)(prevRow + rcols.start), adRow + rcols.start,
+                         rcols.size(), WorkVec::channels);
     }
 
     for (int i = res.rows - 2; i >= 0; i--)
@@ -459,10 +504,8 @@ void DTFilterCPU::FilterRF_vertPass<WorkVec>::operator()(const Range& range) con
         WorkVec     *curRow  = res.ptr<WorkVec>(i);
         DistType    *adRow   = alphaD.ptr<DistType>(i);
 
-        for (int j = rcols.start; j < rcols.end; j++)
-        {
-            curRow[j] += adRow[j] * (prevRow[j] - curRow[j]);
-        }
+        rf_vert_row_pass((float*)(curRow + rcols.start), (float*)(prevRow + rcols.start), adRow + rcols.start,
+                         rcols.size(), WorkVec::channels);
     }
 }
 
@@ -40,6 +40,7 @@
 
 #include <opencv2/core/cvdef.h>
 #include <opencv2/core/utility.hpp>
+#include <opencv2/core/hal/intrin.hpp>
 #include <cmath>
 using namespace std;
 
@@ -550,6 +551,127 @@ void rf_vert_row_pass(float *curRow, float *prevRow, float alphaVal, int w)
         curRow[j] += alphaVal*(prevRow[j] - curRow[j]);
 }
 
+void rf_vert_row_pass(float *curRow, float *prevRow, float *alpha, int w, int cn)
+{
+    int j = 0;
+#if CV_SIMD128
+    if (cn == 1)
+    {
+        for (; j <= w - v_float32x4::nlanes; j += v_float32x4::nlanes)
+        {
+            v_float32x4 cur = v_load(curRow + j);
+            v_float32x4 prev = v_load(prevRow + j);
+            v_store(curRow + j, cur + v_load(alpha + j) * (prev - cur));
+        }
+    }
+    else if (cn == 4)
+    {
+        for (; j < w; j++)
+        {
+            v_float32x4 cur = v_load(curRow + 4*j);
+            v_float32x4 prev = v_load(prevRow + 4*j);
+            v_store(curRow + 4*j, cur + v_setall_f32(alpha[j]) * (prev - cur));
+        }
+    }
+#endif
+    for (; j < w; j++)
+    {
+        for (int c = 0; c < cn; c++)
+            curRow[j*cn + c] += alpha[j]*(prevRow[j*cn + c] - curRow[j*cn + c]);
+    }
+}
+
+void interleave_rows4(float * const *rows, float *buf, int n)
+{
+    int k = 0;
+#if CV_SIMD128
+    for (; k <= n - 4; k += 4)
+    {
+        v_float32x4 a0 = v_load(rows[0] + k), a1 = v_load(rows[1] + k);
+        v_float32x4 a2 = v_load(rows[2] + k), a3 = v_load(rows[3] + k);
+        v_float32x4 b0, b1, b2, b3;
+        v_transpose4x4(a0, a1, a2, a3, b0, b1, b2, b3);
+        v_store(buf + 4*k, b0);
+        v_store(buf + 4*k + 4, b1);
+        v_store(buf + 4*k + 8, b2);
+        v_store(buf + 4*k + 12, b3);
+    }
+#endif
+    for (; k < n; k++)
+    {
+        for (int r = 0; r < 4; r++)
+            buf[4*k + r] = rows[r][k];
+    }
+}
+
+void deinterleave_rows4(float *buf, float * const *rows, int n)
+{
+    int k = 0;
+#if CV_SIMD128
+    for (; k <= n - 4; k += 4)
+    {
+        v_float32x4 b0 = v_load(buf + 4*k), b1 = v_load(buf + 4*k + 4);
+        v_float32x4 b2 = v_load(buf + 4*k + 8), b3 = v_load(buf + 4*k + 12);
+        v_float32x4 a0, a1, a2, a3;
+        v_transpose4x4(b0, b1, b2, b3, a0, a1, a2, a3);
+        v_store(rows[0] + k, a0);
+        v_store(rows[1] + k, a1);
+        v_store(rows[2] + k, a2);
+        v_store(rows[3] + k, a3);
+    }
+#endif
+    for (; k < n; k++)
+    {
+        for (int r = 0; r < 4; r++)
+            rows[r][k] = buf[4*k + r];
+    }
+}
+
+void rf_hor_rows4_pass(float *buf, float *alpha, int w, int cn)
+{
+#if CV_SIMD128
+    for (int j = 1; j < w; j++)
+    {
+        v_float32x4 a = v_load(alpha + 4*(j - 1));
+        for (int c = 0; c < cn; c++)
+        {
+            float *cur = buf + 4*(j*cn + c);
+            v_float32x4 x = v_load(cur);
+            v_store(cur, x + a * (v_load(cur - 4*cn) - x));
+        }
+    }
+    for (int j = w - 2; j >= 0; j--)
+    {
+        v_float32x4 a = v_load(alpha + 4*j);
+        for (int c = 0; c < cn; c++)
+        {
+            float *cur = buf + 4*(j*cn + c);
+            v_float32x4 x = v_load(cur);
+            v_store(cur, x + a * (v_load(cur + 4*cn) - x));
+        }
+    }
+#else
+    for (int j = 1; j < w; j++)
+    {
+        for (int c = 0; c < cn; c++)
+        {
+            float *cur = buf + 4*(j*cn + c);
+            for (int r = 0; r < 4; r++)
+                cur[r] += alpha[4*(j - 1) + r] * (cur[r - 4*cn] - cur[r]);
+        }
+    }
+    for (int j = w - 2; j >= 0; j--)
+    {
+        for (int c = 0; c < cn; c++)
+        {
+            float *cur = buf + 4*(j*cn + c);
+            for (int r = 0; r < 4; r++)
+                cur[r] += alpha[4*j + r] * (cur[r + 4*cn] - cur[r]);
+        }
+    }
+#endif
+}
+
 } //end of cv::ximgproc::intrinsics
 
 } //end of cv::ximgproc
@@ -88,6 +88,17 @@ namespace intrinsics
     void min_(float *dst, float *src1, float *src2, int w);
 
     void rf_vert_row_pass(float *curRow, float *prevRow, float alphaVal, int w);
+
+    //curRow[j] += alpha[j] * (prevRow[j] - curRow[j]) for w pixels of cn channels
+    void rf_vert_row_pass(float *curRow, float *prevRow, float *alpha, int w, int cn);
+
+    //buf[4*k + r] = rows[r][k] for k < n, and back
+    void interleave_rows4(float * const *rows, float *buf, int n);
+    void deinterleave_rows4(float *buf, float * const *rows, int n);
+
+    //forward and backward recursive filtering of 4 interleaved rows of w pixels of cn channels,
+    //alpha holds the w-1 interleaved coefficients between neighbouring pixels
+    void rf_hor_rows4_pass(float *buf, float *alpha, int w, int cn);
 }
 
 }
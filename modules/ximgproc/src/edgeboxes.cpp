@@ -80,6 +80,10 @@ public:
 
     virtual void getBoundingBoxes(InputArray edge_map, InputArray orientation_map, std::vector<Rect> &boxes, OutputArray scores = noArray()) CV_OVERRIDE;
 
+    virtual void computeEdgeGroups(InputArray edge_map, InputArray orientation_map) CV_OVERRIDE;
+
+    virtual void getBoundingBoxes(std::vector<Rect> &boxes, OutputArray scores = noArray()) CV_OVERRIDE;
+
     float getAlpha() const CV_OVERRIDE { return _alpha; }
     void setAlpha(float value) CV_OVERRIDE
     {
@@ -160,20 +164,25 @@ private:
     vector<float> _scaleNorm;
     float _sxStep, _ayStep, _xyStepRatio;
 
-    // data structures for efficiency (see scoreBox)
-    Mat _sWts;
-    Mat _sDone, _sMap, _sIds;
-    int _sId;
+    // data structures for efficiency (see scoreBox), one set per thread
+    struct ScoreWorkspace
+    {
+        vector<float> sWts;
+        vector<int> sDone, sMap, sIds;
+        int sId;
+
+        ScoreWorkspace() : sId(0) {}
+    };
 
     // helper routines
     static bool boxesCompare(const Box &a, const Box &b) { return a.score < b.score; }
     void clusterEdges(Mat &edgeMap, Mat &orientationMap);
     void prepDataStructs(Mat &edgeMap);
-    void scoreAllBoxes(Boxes &boxes);
-    void scoreBox(Box &box);
-    void refineBox(Box &box);
-    float boxesOverlap(Box &a, Box &b);
-    void boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes);
+    void scoreAllBoxes(Boxes &boxes) const;
+    void scoreBox(Box &box, ScoreWorkspace &ws) const;
+    void refineBox(Box &box, ScoreWorkspace &ws) const;
+    static float boxesOverlap(const Box &a, const Box &b);
+    void boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes) const;
 };
 
 
@@ -526,7 +535,7 @@ void EdgeBoxesImpl::prepDataStructs(Mat &edgeMap)
     int s = 0;
     int s1;
 
-    _hIdxs.resize(h);
+    _hIdxs.assign(h, vector<int>());
     _hIdxImg = Mat::zeros(w, h, DataType<int>::type);
     for (y = 0; y < h; y++)
     {
@@ -544,7 +553,7 @@ void EdgeBoxesImpl::prepDataStructs(Mat &edgeMap)
         }
     }
 
-    _vIdxs.resize(w);
+    _vIdxs.assign(w, vector<int>());
     _vIdxImg = Mat::zeros(w, h, DataType<int>::type);
     for (x = 0; x < w; x++)
     {
@@ -561,25 +570,28 @@ void EdgeBoxesImpl::prepDataStructs(Mat &edgeMap)
             _vIdxImg.at<int>(x, y) = (int)_vIdxs[x].size() - 1;
         }
     }
-
-    // initialize scoreBox() data structures
-    int n = _segCnt + 1;
-    _sWts = Mat::zeros(n, 1, DataType<float>::type);
-    _sDone = Mat(n, 1, DataType<int>::type,Scalar(-1));
-    _sMap = Mat::zeros(n, 1, DataType<int>::type);
-    _sIds = Mat::zeros(n, 1, DataType<int>::type);
-    _sId = 0;
 }
 
 
-void EdgeBoxesImpl::scoreBox(Box &box)
+void EdgeBoxesImpl::scoreBox(Box &box, ScoreWorkspace &ws) const
 {
     int i, j, k, q, bh, bw, y0, x0, y1, x1, y0m, y1m, x0m, x1m;
-    float *sWts = (float *)_sWts.data;
-    int *sDone = (int *)_sDone.data;
-    int *sMap = (int *)_sMap.data;
-    int *sIds = (int *)_sIds.data;
-    int sId = _sId++;
+
+    // initialize scoreBox() data structures
+    int nSegs = _segCnt + 1;
+    if ((int)ws.sDone.size() != nSegs)
+    {
+        ws.sWts.assign(nSegs, 0);
+        ws.sDone.assign(nSegs, -1);
+        ws.sMap.assign(nSegs, 0);
+        ws.sIds.assign(nSegs, 0);
+        ws.sId = 0;
+    }
+    float *sWts = &ws.sWts[0];
+    int *sDone = &ws.sDone[0];
+    int *sMap = &ws.sMap[0];
+    int *sIds = &ws.sIds[0];
+    int sId = ws.sId++;
 
     // add edge count inside box
     y1 = clamp(box.y + box.h, 0, h - 1);
@@ -708,7 +720,7 @@ void EdgeBoxesImpl::scoreBox(Box &box)
 }
 
 
-void EdgeBoxesImpl::refineBox(Box &box)
+void EdgeBoxesImpl::refineBox(Box &box, ScoreWorkspace &ws) const
 {
     int yStep = (int)(box.h * _xyStepRatio);
     int xStep = (int)(box.w * _xyStepRatio);
@@ -725,59 +737,59 @@ void EdgeBoxesImpl::refineBox(Box &box)
         B = box;
         B.y = box.y - yStep;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, ws);
 
         if (B.score <= box.score)
         {
             B = box;
             B.y = box.y + yStep;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, ws);
         }
         if (B.score > box.score) box = B;
         // search over y end
         B = box;
         B.h = B.h + yStep;
-        scoreBox(B);
+        scoreBox(B, ws);
 
         if (B.score <= box.score)
         {
             B = box;
             B.h = B.h - yStep;
-            scoreBox(B);
+            scoreBox(B, ws);
         }
         if (B.score > box.score) box = B;
         // search over x start
         B = box;
         B.x = box.x - xStep;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, ws);
 
         if (B.score <= box.score)
         {
             B = box;
             B.x = box.x + xStep;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, ws);
         }
 
         if (B.score > box.score) box = B;
         // search over x end
         B = box;
         B.w = B.w + xStep;
-        scoreBox(B);
+        scoreBox(B, ws);
 
         if (B.score <= box.score)
         {
             B = box;
             B.w = B.w - xStep;
-            scoreBox(B);
+            scoreBox(B, ws);
         }
         if (B.score > box.score) box = B;
     }
 }
 
-void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes)
+void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes) const
 {
     // get list of all boxes roughly distributed in grid
     boxes.resize(0);
@@ -815,19 +827,27 @@ void EdgeBoxesImpl::scoreAllBoxes(Boxes &boxes)
 
     // score all boxes, refine top candidates
     int i, k = 0, m = (int)boxes.size();
+    TLSData<ScoreWorkspace> workspaces;
+    parallel_for_(Range(0, m), [&](const Range& range)
+    {
+        ScoreWorkspace &ws = *workspaces.get();
+        for (int bi = range.start; bi < range.end; bi++)
+        {
+            scoreBox(boxes[bi], ws);
+            if (!boxes[bi].score) continue;
+            refineBox(boxes[bi], ws);
+        }
+    }, max(1, m / 256));
     for (i = 0; i < m; i++)
     {
-        scoreBox(boxes[i]);
-        if (!boxes[i].score) continue;
-        k++;
-        refineBox(boxes[i]);
+        if (boxes[i].score) k++;
     }
     sort(boxes.rbegin(), boxes.rend(), boxesCompare);
     boxes.resize(k);
 }
 
 
-float EdgeBoxesImpl::boxesOverlap(Box &a, Box &b)
+float EdgeBoxesImpl::boxesOverlap(const Box &a, const Box &b)
 {
     float areai, areaj, areaij;
     int y0, y1, x0, x1, y1i, x1i, y1j, x1j;
@@ -850,7 +870,7 @@ float EdgeBoxesImpl::boxesOverlap(Box &a, Box &b)
 }
 
 
-void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
+void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes) const
 {
     sort(boxes.rbegin(), boxes.rend(), boxesCompare);
     if (thr > .99f) return;
@@ -858,41 +878,87 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
     const int nBin = 10000;
     const float step = 1 / thr;
     const float lstep = log(step);
+    const int batchSize = 256;
 
     vector<Boxes> kept;
     kept.resize(nBin + 1);
     int n = (int) boxes.size();
     int i = 0;
-    int j, k, b;
+    int j, k, b, t;
     int m = 0;
     int d = 1;
 
+    // Candidates are processed in batches: their overlaps with the boxes kept before the batch
+    // are computed in parallel for all the bins they can be compared with, then the greedy
+    // selection runs sequentially and only compares them with the boxes kept within the batch.
+    vector<int> rawBins(batchSize), binLo(batchSize), binHi(batchSize), binOffsets(batchSize + 1);
+    vector<float> binOverlaps;
+    vector<int> batchKept, batchBins;
+
     while (i < n && m < maxBoxes)
     {
-        b = boxes[i].w * boxes[i].h;
+        int count = min(batchSize, n - i);
 
-        bool keep = 1;
-        b = clamp((int)(ceil(log(float(b)) / lstep)), d, nBin - d);
-        for (j = b - d; j <= b + d; j++)
+        // largest comparison radius reachable within the batch
+        float thrMin = thr;
+        for (t = 0; t < count && eta < 1.0f && thrMin > .5f; t++) thrMin *= eta;
+        int dMax = max(d, (int)ceil(log(1.0f / thrMin) / lstep));
+
+        binOffsets[0] = 0;
+        for (t = 0; t < count; t++)
         {
-            for (k = 0; k < (int)kept[j].size(); k++)
-            {
-                if (keep)
-                    keep = boxesOverlap(boxes[i], kept[j][k]) <= thr;
-            }
+            const Box &box = boxes[i + t];
+            rawBins[t] = (int)(ceil(log(float(box.w * box.h)) / lstep));
+            binLo[t] = max(0, min(rawBins[t] - dMax, nBin - 2 * dMax));
+            binHi[t] = min(nBin, max(rawBins[t] + dMax, 2 * dMax));
+            binOffsets[t + 1] = binOffsets[t] + max(0, binHi[t] - binLo[t] + 1);
         }
+        binOverlaps.assign(binOffsets[count], 0.f);
 
-        if (keep)
+        parallel_for_(Range(0, count), [&](const Range& range)
         {
-            kept[b].push_back(boxes[i]);
-            m++;
-        }
+            for (int bt = range.start; bt < range.end; bt++)
+            {
+                const Box &box = boxes[i + bt];
+                float *overlaps = &binOverlaps[0] + binOffsets[bt] - binLo[bt];
+                for (int bj = binLo[bt]; bj <= binHi[bt]; bj++)
+                {
+                    for (int bk = 0; bk < (int)kept[bj].size(); bk++)
+                        overlaps[bj] = max(overlaps[bj], boxesOverlap(box, kept[bj][bk]));
+                }
+            }
+        });
 
-        i++;
-        if (keep && eta < 1.0f && thr > .5f)
+        batchKept.clear();
+        batchBins.clear();
+        for (t = 0; t < count && m < maxBoxes; t++)
         {
-            thr *= eta;
-            d = (int)ceil(log(1.0f / thr) / lstep);
+            bool keep = 1;
+            b = clamp(rawBins[t], d, nBin - d);
+            const float *overlaps = &binOverlaps[0] + binOffsets[t] - binLo[t];
+            for (j = b - d; j <= b + d && keep; j++)
+                keep = overlaps[j] <= thr;
+
+            for (k = 0; k < (int)batchKept.size() && keep; k++)
+            {
+                if (abs(batchBins[k] - b) <= d)
+                    keep = boxesOverlap(boxes[i], boxes[batchKept[k]]) <= thr;
+            }
+
+            if (keep)
+            {
+                kept[b].push_back(boxes[i]);
+                batchKept.push_back(i);
+                batchBins.push_back(b);
+                m++;
+            }
+
+            i++;
+            if (keep && eta < 1.0f && thr > .5f)
+            {
+                thr *= eta;
+                d = (int)ceil(log(1.0f / thr) / lstep);
+            }
         }
     }
 
@@ -909,20 +975,27 @@ void EdgeBoxesImpl::boxesNms(Boxes &boxes, float thr, float eta, int maxBoxes)
 }
 
 
-void EdgeBoxesImpl::getBoundingBoxes(InputArray edge_map, InputArray orientation_map, std::vector<Rect> &boxes, OutputArray scores)
+void EdgeBoxesImpl::computeEdgeGroups(InputArray edge_map, InputArray orientation_map)
 {
     CV_Assert(edge_map.depth() == CV_32F);
     CV_Assert(orientation_map.depth() == CV_32F);
 
     Mat E = edge_map.getMat().t();
     Mat O = orientation_map.getMat().t();
-    std::vector<float> _scores;
 
     h = E.cols;
     w = E.rows;
 
     clusterEdges(E, O);
     prepDataStructs(E);
+}
+
+
+void EdgeBoxesImpl::getBoundingBoxes(std::vector<Rect> &boxes, OutputArray scores)
+{
+    CV_Assert(!_segIImg.empty());
+
+    std::vector<float> _scores;
 
     Boxes b;
     scoreAllBoxes(b);
@@ -954,6 +1027,13 @@ void EdgeBoxesImpl::getBoundingBoxes(InputArray edge_map, InputArray orientation
 }
 
 
+void EdgeBoxesImpl::getBoundingBoxes(InputArray edge_map, InputArray orientation_map, std::vector<Rect> &boxes, OutputArray scores)
+{
+    computeEdgeGroups(edge_map, orientation_map);
+    getBoundingBoxes(boxes, scores);
+}
+
+
 Ptr<EdgeBoxes> createEdgeBoxes(float alpha,
                               float beta,
                               float eta,
@@ -42,6 +42,7 @@
 //M*/
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 namespace cv { namespace ximgproc {
 
@@ -67,6 +68,91 @@ SPECIALIZE_HOUGHOP(FHT_MAX, max(src0, src1, dst));
 SPECIALIZE_HOUGHOP(FHT_AVE, addWeighted(src0, 0.5, src1, 0.5, 0.0, dst));
 #undef SPECIALIZE_HOUGHOP
 
+// Line merges of 8u, 16u and 32f images are done directly with universal intrinsics,
+// avoiding the creation of Mat headers for every pair of lines. The results are the
+// same as the ones of add(), min(), max() and addWeighted(0.5, 0.5) used above.
+struct HoughAddVec
+{
+    template<typename V> static inline V vec(const V &a, const V &b) { return a + b; }
+    template<typename T> static inline T scalar(T a, T b) { return saturate_cast<T>(a + b); }
+};
+
+struct HoughMinVec
+{
+    template<typename V> static inline V vec(const V &a, const V &b) { return v_min(a, b); }
+    template<typename T> static inline T scalar(T a, T b) { return std::min(a, b); }
+};
+
+struct HoughMaxVec
+{
+    template<typename V> static inline V vec(const V &a, const V &b) { return v_max(a, b); }
+    template<typename T> static inline T scalar(T a, T b) { return std::max(a, b); }
+};
+
+// (a + b) / 2 rounded half to even, as addWeighted() rounds its result
+struct HoughAveVec
+{
+    template<typename V> static inline V roundEven(const V &a, const V &b, const V &lsb)
+    {
+        V x = a ^ b;
+        V q = v_avg(a, b) - (x & lsb);  // floor((a + b) / 2)
+        return q + (x & q & lsb);
+    }
+    static inline v_uint8x16 vec(const v_uint8x16 &a, const v_uint8x16 &b)
+    {
+        return roundEven(a, b, v_setall_u8(1));
+    }
+    static inline v_uint16x8 vec(const v_uint16x8 &a, const v_uint16x8 &b)
+    {
+        return roundEven(a, b, v_setall_u16(1));
+    }
+    static inline v_float32x4 vec(const v_float32x4 &a, const v_float32x4 &b)
+    {
+        v_float32x4 half = v_setall_f32(0.5f);
+        return v_muladd(a, half, b * half);
+    }
+    template<typename T> static inline T scalar(T a, T b)
+    {
+        int x = a ^ b;
+        int q = (a & b) + (x >> 1);
+        return (T)(q + (x & q & 1));
+    }
+    static inline float scalar(float a, float b) { return a * 0.5f + b * 0.5f; }
+};
+
+template<typename T, typename VT, typename VOp>
+static inline void houghOperateVec(T *pDst, const T *pSrc0, const T *pSrc1, int len)
+{
+    int i = 0;
+#if CV_SIMD128
+    for (; i <= len - VT::nlanes; i += VT::nlanes)
+        v_store(pDst + i, VOp::vec(v_load(pSrc0 + i), v_load(pSrc1 + i)));
+#endif
+    for (; i < len; i++)
+        pDst[i] = VOp::scalar(pSrc0[i], pSrc1[i]);
+}
+
+#define SPECIALIZE_HOUGHOP_VEC(T, D, VT, TOp, VOp)                            \
+    template<>                                                                \
+    struct HoughOperator<T, D, TOp> {                                         \
+        static void operate(T *pDst, T *pSrc0, T* pSrc1, int len) {           \
+            houghOperateVec<T, VT, VOp>(pDst, pSrc0, pSrc1, len);             \
+        }                                                                     \
+    };
+#define SPECIALIZE_HOUGHOP_VEC_ALL(T, D, VT)                                  \
+    SPECIALIZE_HOUGHOP_VEC(T, D, VT, FHT_ADD, HoughAddVec)                    \
+    SPECIALIZE_HOUGHOP_VEC(T, D, VT, FHT_MIN, HoughMinVec)                    \
+    SPECIALIZE_HOUGHOP_VEC(T, D, VT, FHT_MAX, HoughMaxVec)                    \
+    SPECIALIZE_HOUGHOP_VEC(T, D, VT, FHT_AVE, HoughAveVec)
+SPECIALIZE_HOUGHOP_VEC_ALL(uchar,  CV_8UC1,  v_uint8x16)
+SPECIALIZE_HOUGHOP_VEC_ALL(ushort, CV_16UC1, v_uint16x8)
+SPECIALIZE_HOUGHOP_VEC_ALL(float,  CV_32FC1, v_float32x4)
+#undef SPECIALIZE_HOUGHOP_VEC_ALL
+#undef SPECIALIZE_HOUGHOP_VEC
+
+// Minimal number of processed elements of a level merge to run it in parallel
+static const int FHT_PARALLEL_MIN_AREA = 1 << 16;
+
 //----------------------fht----------------------------------------------------
 
 template <typename T, int D, HoughOp OP>
@@ -117,90 +203,98 @@ void fhtCore(Mat     &img0,
     int w = img0.cols;
     int wm = (h / w + 1) * w;
 
-    for (int32_t s = 0; s < h; s++)
+    // Every line of the level is merged from two lines of the previous one independently
+    auto mergeLines = [&](const Range &range)
     {
-        int su = (s * au + b) / d;
-        int sd = (s * ad + b) / d;
-        int rd = isPositiveShift ? sd - s : s - sd;
-        rd = (rd + wm) % w;
-        uchar *pLine0 = img0.data + img0.step * (y0 + s);
-        uchar *pLineU = img1.data + img1.step * (y0 + su);
-        uchar *pLineD = img1.data + img1.step * (y0 + k + sd);
-        int w0 = img0.channels() * rd;
-        int w1 = img0.channels() * (w - rd);
-
-        if ((aspl != 0.0) && (level == 1))
+        for (int32_t s = range.start; s < range.end; s++)
         {
-            int dU = cvRound((y0 + su) * aspl);
-            dU = dU % w;
-            dU *= img0.channels();
-            int dD = cvRound((y0 + k + sd) * aspl);
-            dD = dD % w;
-            dD *= img0.channels();
-            int wB = w * img0.channels();
-
-            int dX = dD - dU;
-            if (w0 >= dX)
+            int su = (s * au + b) / d;
+            int sd = (s * ad + b) / d;
+            int rd = isPositiveShift ? sd - s : s - sd;
+            rd = (rd + wm) % w;
+            uchar *pLine0 = img0.data + img0.step * (y0 + s);
+            uchar *pLineU = img1.data + img1.step * (y0 + su);
+            uchar *pLineD = img1.data + img1.step * (y0 + k + sd);
+            int w0 = img0.channels() * rd;
+            int w1 = img0.channels() * (w - rd);
+
+            if ((aspl != 0.0) && (level == 1))
             {
-                if (w0 >= dD)
+                int dU = cvRound((y0 + su) * aspl);
+                dU = dU % w;
+                dU *= img0.channels();
+                int dD = cvRound((y0 + k + sd) * aspl);
+                dD = dD % w;
+                dD *= img0.channels();
+                int wB = w * img0.channels();
+
+                int dX = dD - dU;
+                if (w0 >= dX)
                 {
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                               (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               w1 + dX);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
-                                               (T *)pLineU + (w1 + dX),
-                                               (T *)pLineD,
-                                               w0 - dD);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 - dD),
-                                               dU);
+                    if (w0 >= dD)
+                    {
+                        HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
+                                                   (T *)pLineU,
+                                                   (T *)pLineD + (w0 - dX),
+                                                   w1 + dX);
+                        HoughOperator<T, D, OP>::operate((T *)pLine0 + (w1 + dD),
+                                                   (T *)pLineU + (w1 + dX),
+                                                   (T *)pLineD,
+                                                   w0 - dD);
+                        HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                                   (T *)pLineU + (wB - dU),
+                                                   (T *)pLineD + (w0 - dD),
+                                                   dU);
+                    }
+                    else
+                    {
+                        HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
+                                                   (T *)pLineU,
+                                                   (T *)pLineD + (w0 - dX),
+                                                   wB - dU);
+                        HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                                   (T *)pLineU + (wB - dU),
+                                                   (T *)pLineD + (w0 + wB - dD),
+                                                   dD - w0);
+                        HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
+                                                   (T *)pLineU + (w1 + dX),
+                                                   (T *)pLineD,
+                                                   w0 - dX);
+                    }
                 }
                 else
                 {
                     HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
                                                (T *)pLineU,
-                                               (T *)pLineD + (w0 - dX),
-                                               wB - dU);
-                    HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                               (T *)pLineU + (wB - dU),
-                                               (T *)pLineD + (w0 + wB - dD),
-                                               dD - w0);
+                                               (T *)pLineD + (wB - (dX - w0)),
+                                               dX - w0);
                     HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                               (T *)pLineU + (w1 + dX),
+                                               (T *)pLineU + (dX - w0),
                                                (T *)pLineD,
-                                               w0 - dX);
+                                               wB - (dX - w0) - dU);
+                    HoughOperator<T, D, OP>::operate((T *)pLine0,
+                                               (T *)pLineU + (wB - dU),
+                                               (T *)pLineD + (wB - (dX - w0) - dU),
+                                               dU);
                 }
             }
             else
             {
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + dU,
-                                           (T *)pLineU,
-                                           (T *)pLineD + (wB - (dX - w0)),
-                                           dX - w0);
-                HoughOperator<T, D, OP>::operate((T *)pLine0 + (dD - w0),
-                                           (T *)pLineU + (dX - w0),
-                                           (T *)pLineD,
-                                           wB - (dX - w0) - dU);
                 HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                           (T *)pLineU + (wB - dU),
-                                           (T *)pLineD + (wB - (dX - w0) - dU),
-                                           dU);
+                                            (T *)pLineU,
+                                            (T *)pLineD + w0,
+                                            w1);
+                HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
+                                            (T *)pLineU + w1,
+                                            (T *)pLineD,
+                                            w0);
             }
         }
-        else
-        {
-            HoughOperator<T, D, OP>::operate((T *)pLine0,
-                                        (T *)pLineU,
-                                        (T *)pLineD + w0,
-                                        w1);
-            HoughOperator<T, D, OP>::operate((T *)pLine0 + w1,
-                                        (T *)pLineU + w1,
-                                        (T *)pLineD,
-                                        w0);
-        }
-    }
+    };
+    if (h * w >= FHT_PARALLEL_MIN_AREA)
+        parallel_for_(Range(0, h), mergeLines);
+    else
+        mergeLines(Range(0, h));
 }
 
 template <typename T, int D, HoughOp Op>
@@ -284,7 +378,9 @@ static void FHT(Mat       &dst,
                 int        operation,
                 bool       isVertical,
                 bool       isClockwise,
-                double     aspl)
+                double     aspl,
+                Mat       &conv,
+                Mat       &tmp)
 {
     CV_Assert(dst.cols > 0 && dst.rows > 0);
     CV_Assert(src.channels() == dst.channels());
@@ -297,10 +393,15 @@ static void FHT(Mat       &dst,
     for (int thres = 1; dst.rows > thres; thres <<= 1)
         level++;
 
-    Mat tmp;
-    src.convertTo(tmp, dst.type());
-    if (!isVertical)
-        transpose(tmp, tmp);
+    if (isVertical)
+    {
+        src.convertTo(tmp, dst.type());
+    }
+    else
+    {
+        src.convertTo(conv, dst.type());
+        transpose(conv, tmp);
+    }
     tmp.copyTo(dst);
 
     fhtVo(dst, tmp,
@@ -311,7 +412,9 @@ static void FHT(Mat       &dst,
 static void calculateFHTQuadrant(Mat       &dst,
                                  const Mat &src,
                                  int        operation,
-                                 int        quadrant)
+                                 int        quadrant,
+                                 Mat       &conv,
+                                 Mat       &tmp)
 {
     bool bVert = true;
     bool bClock = true;
@@ -348,7 +451,7 @@ static void calculateFHTQuadrant(Mat       &dst,
         CV_Error_(CV_StsNotImplemented, ("Unknown quadrant %d", quadrant));
     }
 
-  FHT(dst, src, operation, bVert, bClock, aspl);
+  FHT(dst, src, operation, bVert, bClock, aspl, conv, tmp);
 }
 
 static void createDstFhtMat(OutputArray dst,
@@ -416,7 +519,7 @@ static void createFHTSrc(Mat       &srcFull,
 
     int wd = verticalTiling ? src.cols : src.cols + src.rows;
     int ht = verticalTiling ? src.cols + src.rows : src.rows;
-    srcFull = Mat(ht, wd, src.type());
+    srcFull.create(ht, wd, src.type());
 
     Mat imgReg;
     if (verticalTiling)
@@ -545,6 +648,106 @@ static void skewQuadrant(Mat         &quad,
     }
 }
 
+// Buffers of a Fast Hough transform, kept between the calls of FastHoughTransformer
+struct FHTWorkspace
+{
+    Mat srcFull[2];             // padded sources of vertical and horizontal quadrants
+    Mat quads[4];               // quadrants computed in parallel
+    Mat conv[4], tmp[4];        // per-quadrant buffers of FHT()
+    std::vector<uchar> buf[4];  // per-quadrant line buffers of skewQuadrant()
+};
+
+static void computeFHTQuadrant(Mat                &dst,
+                               const Mat          &imgSrc,
+                               int                 operation,
+                               int                 quadrant,
+                               int                 makeSkew,
+                               Mat                &conv,
+                               Mat                &tmp,
+                               std::vector<uchar> &buf)
+{
+    calculateFHTQuadrant(dst, imgSrc, operation, quadrant, conv, tmp);
+    if (quadrant == ARO_315_0 || quadrant == ARO_45_90 || quadrant == ARO_CTR_VER)
+        flip(dst, dst, 0);
+    if (HDO_DESKEW == makeSkew)
+    {
+        const int len = dst.cols * static_cast<int>(dst.elemSize());
+        CV_Assert(len > 0);
+        buf.resize(len);
+        skewQuadrant(dst, imgSrc, &buf[0], quadrant);
+    }
+}
+
+static void fastHoughTransform(const Mat    &srcMat,
+                               OutputArray   dst,
+                               int           dstMatDepth,
+                               int           angleRange,
+                               int           operation,
+                               int           makeSkew,
+                               FHTWorkspace &ws)
+{
+    CV_Assert(srcMat.cols > 0 && srcMat.rows > 0);
+
+    createDstFhtMat(dst, srcMat, dstMatDepth, angleRange);
+    Mat dstMat = dst.getMat();
+
+    // Quadrants of the requested range and the padded source each of them uses
+    int quadrants[4];
+    int sources[4];
+    int count = 0;
+    switch (angleRange)
+    {
+    case ARO_315_135:
+        createFHTSrc(ws.srcFull[0], srcMat, ARO_315_45);
+        createFHTSrc(ws.srcFull[1], srcMat, ARO_45_135);
+        quadrants[0] = ARO_315_0;  sources[0] = 0;
+        quadrants[1] = ARO_0_45;   sources[1] = 0;
+        quadrants[2] = ARO_45_90;  sources[2] = 1;
+        quadrants[3] = ARO_90_135; sources[3] = 1;
+        count = 4;
+        break;
+    case ARO_315_45:
+        createFHTSrc(ws.srcFull[0], srcMat, angleRange);
+        quadrants[0] = ARO_315_0;  sources[0] = 0;
+        quadrants[1] = ARO_0_45;   sources[1] = 0;
+        count = 2;
+        break;
+    case ARO_45_135:
+        createFHTSrc(ws.srcFull[0], srcMat, angleRange);
+        quadrants[0] = ARO_45_90;  sources[0] = 0;
+        quadrants[1] = ARO_90_135; sources[1] = 0;
+        count = 2;
+        break;
+    default:
+        createFHTSrc(ws.srcFull[0], srcMat, angleRange);
+        computeFHTQuadrant(dstMat, ws.srcFull[0], operation, angleRange, makeSkew,
+                           ws.conv[0], ws.tmp[0], ws.buf[0]);
+        return;
+    }
+
+    // The quadrants are independent. Neighbouring quadrants share a border line of
+    // the destination, so they are computed separately and copied in their order.
+    Mat imgRegDst;
+    for (int i = 0; i < count; i++)
+    {
+        setFHTDstRegion(imgRegDst, dstMat, srcMat, quadrants[i], angleRange);
+        ws.quads[i].create(imgRegDst.size(), imgRegDst.type());
+    }
+
+    parallel_for_(Range(0, count), [&](const Range &range)
+    {
+        for (int i = range.start; i < range.end; i++)
+            computeFHTQuadrant(ws.quads[i], ws.srcFull[sources[i]], operation, quadrants[i],
+                               makeSkew, ws.conv[i], ws.tmp[i], ws.buf[i]);
+    });
+
+    for (int i = 0; i < count; i++)
+    {
+        setFHTDstRegion(imgRegDst, dstMat, srcMat, quadrants[i], angleRange);
+        ws.quads[i].copyTo(imgRegDst);
+    }
+}
+
 void FastHoughTransform(InputArray  src,
                         OutputArray dst,
                         int         dstMatDepth,
@@ -555,117 +758,41 @@ void FastHoughTransform(InputArray  src,
     Mat srcMat = src.getMat();
     if (!srcMat.isContinuous())
         srcMat = srcMat.clone();
-    CV_Assert(srcMat.cols > 0 && srcMat.rows > 0);
 
-    createDstFhtMat(dst, src, dstMatDepth, angleRange);
-    Mat dstMat = dst.getMat();
+    FHTWorkspace ws;
+    fastHoughTransform(srcMat, dst, dstMatDepth, angleRange, operation, makeSkew, ws);
+}
 
-    Mat imgRegDst;
-    const int len = dstMat.cols * static_cast<int>(dstMat.elemSize());
-    CV_Assert(len > 0);
-    std::vector<uchar> buf_(len);
-    uchar *buf(&buf_[0]);
+class FastHoughTransformerImpl : public FastHoughTransformer
+{
+public:
+    FastHoughTransformerImpl(int _dstMatDepth, int _angleRange, int _operation, int _makeSkew)
+        : dstMatDepth(_dstMatDepth), angleRange(_angleRange), operation(_operation), makeSkew(_makeSkew)
+    { }
 
-    if (angleRange == ARO_315_135)
+    void apply(InputArray src, OutputArray dst) CV_OVERRIDE
     {
+        Mat srcMat = src.getMat();
+        if (!srcMat.isContinuous())
         {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_315_45);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
+            srcMat.copyTo(srcCopy);
+            srcMat = srcCopy;
         }
-        {
-            Mat imgSrc;
-            createFHTSrc(imgSrc, srcMat, ARO_45_135);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-            flip(imgRegDst, imgRegDst, 0);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-            setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-            calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-            if (HDO_DESKEW == makeSkew)
-                skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        }
-        return;
+        fastHoughTransform(srcMat, dst, dstMatDepth, angleRange, operation, makeSkew, ws);
     }
 
-    Mat imgSrc;
-    createFHTSrc(imgSrc, srcMat, angleRange);
+private:
+    int dstMatDepth, angleRange, operation, makeSkew;
+    Mat srcCopy;
+    FHTWorkspace ws;
+};
 
-    switch (angleRange)
-    {
-    case ARO_315_0:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_0_45:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_45_90:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_90_135:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_315_45:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_315_0, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_315_0);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_315_0);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_0_45, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_0_45);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_0_45);
-        return;
-    case ARO_45_135:
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_45_90, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_45_90);
-        flip(imgRegDst, imgRegDst, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_45_90);
-
-        setFHTDstRegion(imgRegDst, dstMat, srcMat, ARO_90_135, angleRange);
-        calculateFHTQuadrant(imgRegDst, imgSrc, operation, ARO_90_135);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(imgRegDst, imgSrc, buf, ARO_90_135);
-        return;
-    case ARO_CTR_VER:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        flip(dstMat, dstMat, 0);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    case ARO_CTR_HOR:
-        calculateFHTQuadrant(dstMat, imgSrc, operation, angleRange);
-        if (HDO_DESKEW == makeSkew)
-            skewQuadrant(dstMat, imgSrc, buf, angleRange);
-        return;
-    default:
-        CV_Error_(CV_StsNotImplemented, ("Unknown angleRange %d", angleRange));
-    }
+Ptr<FastHoughTransformer> createFastHoughTransformer(int dstMatDepth,
+                                                     int angleRange,
+                                                     int operation,
+                                                     int makeSkew)
+{
+    return makePtr<FastHoughTransformerImpl>(dstMatDepth, angleRange, operation, makeSkew);
 }
 
 //-----------------------------------------------------------------------------
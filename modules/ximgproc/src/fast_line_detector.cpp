@@ -62,34 +62,57 @@ class FastLineDetectorImpl : public FastLineDetector
          */
         void drawSegments(InputOutputArray _image, InputArray lines, bool draw_arrow = false) CV_OVERRIDE;
 
+        /**
+         * Detect lines in a batch of images, e.g. the current frames of several cameras.
+         *
+         * @param _images   A vector of grayscale(CV_8UC1) input images.
+         * @param _lines    Return: A vector holding the lines of each image, in the format of detect().
+         */
+        void detectBatch(InputArrayOfArrays _images, OutputArrayOfArrays _lines) CV_OVERRIDE;
+
     private:
-        int imagewidth, imageheight, threshold_length;
+        /**
+         * Buffers used to process one image. They are kept between calls, so that
+         * processing a stream of frames of the same size does not reallocate them.
+         */
+        struct FrameBuffers
+        {
+            Mat canny;
+            std::vector<Point2i> points;                  // pixels of all the edge chains
+            std::vector<int> chain_offsets;               // chain i is points[chain_offsets[i]..chain_offsets[i+1])
+            std::vector<std::vector<SEGMENT> > chain_segments;
+            std::vector<SEGMENT> segments;
+        };
+
+        int threshold_length;
         float threshold_dist;
         double canny_th1, canny_th2;
         int canny_aperture_size;
         bool do_merge;
+        std::vector<FrameBuffers> frame_buffers;
 
         FastLineDetectorImpl& operator= (const FastLineDetectorImpl&); // to quiet MSVC
         template<class T>
-            void incidentPoint(const Mat& l, T& pt);
+            void incidentPoint(const Mat& l, const Size& size, T& pt) const;
 
-        void mergeLines(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged);
+        void mergeLines(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged) const;
 
-        bool mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged);
+        bool mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged) const;
 
-        bool getPointChain(const Mat& img, Point pt, Point& chained_pt, float& direction, int step);
+        bool getPointChain(const Mat& img, Point pt, Point& chained_pt, float& direction, int step) const;
 
-        double distPointLine(const Mat& p, Mat& l);
+        double distPointLine(const Mat& p, Mat& l) const;
 
-        void extractSegments(const std::vector<Point2i>& points, std::vector<SEGMENT>& segments);
+        void extractSegments(const Point2i* points, int total, const Size& size,
+                std::vector<SEGMENT>& segments) const;
 
-        void lineDetection(const Mat& src, std::vector<SEGMENT>& segments_all);
+        void lineDetection(const Mat& src, FrameBuffers& buffers, std::vector<SEGMENT>& segments_all) const;
 
-        void pointInboardTest(const Mat& src, Point2i& pt);
+        void pointInboardTest(const Mat& src, Point2i& pt) const;
 
-        inline void getAngle(SEGMENT& seg);
+        inline void getAngle(SEGMENT& seg) const;
 
-        void additionalOperationsOnSegment(const Mat& src, SEGMENT& seg);
+        void additionalOperationsOnSegment(const Mat& src, SEGMENT& seg) const;
 
         void drawSegment(Mat& mat, const SEGMENT& seg, Scalar bgr = Scalar(0,255,0),
                 int thickness = 1, bool directed = true);
@@ -124,18 +147,57 @@ void FastLineDetectorImpl::detect(InputArray _image, OutputArray _lines)
     Mat image = _image.getMat();
     CV_Assert(!image.empty() && image.type() == CV_8UC1);
 
+    if(frame_buffers.empty())
+        frame_buffers.resize(1);
+    FrameBuffers& buffers = frame_buffers[0];
+
     std::vector<Vec4f> lines;
-    std::vector<SEGMENT> segments;
-    lineDetection(image, segments);
-    for(size_t i = 0; i < segments.size(); ++i)
+    lineDetection(image, buffers, buffers.segments);
+    for(size_t i = 0; i < buffers.segments.size(); ++i)
     {
-        const SEGMENT seg = segments[i];
+        const SEGMENT seg = buffers.segments[i];
         Vec4f line(seg.x1, seg.y1, seg.x2, seg.y2);
         lines.push_back(line);
     }
     Mat(lines).copyTo(_lines);
 }
 
+void FastLineDetectorImpl::detectBatch(InputArrayOfArrays _images, OutputArrayOfArrays _lines)
+{
+    CV_INSTRUMENT_REGION();
+
+    std::vector<Mat> images;
+    _images.getMatVector(images);
+    int n = (int)images.size();
+    for(int i = 0; i < n; ++i)
+        CV_Assert(!images[i].empty() && images[i].type() == CV_8UC1);
+
+    if((int)frame_buffers.size() < n)
+        frame_buffers.resize(n);
+
+    // Frames are independent; the processing of each frame runs sequentially inside this loop
+    parallel_for_(Range(0, n), [&](const Range& range)
+    {
+        for(int i = range.start; i < range.end; ++i)
+            lineDetection(images[i], frame_buffers[i], frame_buffers[i].segments);
+    });
+
+    _lines.create(n, 1, 0, -1, true);
+    for(int i = 0; i < n; ++i)
+    {
+        const std::vector<SEGMENT>& segments = frame_buffers[i].segments;
+        _lines.create((int)segments.size(), 1, CV_32FC4, i, true);
+        if(segments.empty())
+            continue;
+        Mat lines = _lines.getMat(i);
+        for(int j = 0; j < (int)segments.size(); ++j)
+        {
+            const SEGMENT& seg = segments[j];
+            lines.at<Vec4f>(j) = Vec4f(seg.x1, seg.y1, seg.x2, seg.y2);
+        }
+    }
+}
+
 void FastLineDetectorImpl::drawSegments(InputOutputArray _image, InputArray lines, bool draw_arrow)
 {
     CV_INSTRUMENT_REGION();
@@ -191,7 +253,7 @@ void FastLineDetectorImpl::drawSegments(InputOutputArray _image, InputArray line
     }
 }
 
-void FastLineDetectorImpl::mergeLines(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged)
+void FastLineDetectorImpl::mergeLines(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged) const
 {
     double xg = 0.0, yg = 0.0;
     double delta1x = 0.0, delta1y = 0.0, delta2x = 0.0, delta2y = 0.0;
@@ -261,7 +323,7 @@ void FastLineDetectorImpl::mergeLines(const SEGMENT& seg1, const SEGMENT& seg2,
     seg_merged.y2 = (float)delta2y;
 }
 
-double FastLineDetectorImpl::distPointLine(const Mat& p, Mat& l)
+double FastLineDetectorImpl::distPointLine(const Mat& p, Mat& l) const
 {
     double x = l.at<double>(0,0);
     double y = l.at<double>(1,0);
@@ -274,7 +336,7 @@ double FastLineDetectorImpl::distPointLine(const Mat& p, Mat& l)
     return l.dot(p);
 }
 
-bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged)
+bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg2, SEGMENT& seg_merged) const
 {
     double o[] = { 0.0, 0.0, 1.0 };
     double a[] = { 0.0, 0.0, 1.0 };
@@ -322,7 +384,7 @@ bool FastLineDetectorImpl::mergeSegments(const SEGMENT& seg1, const SEGMENT& seg
 }
 
 template<class T>
-    void FastLineDetectorImpl::incidentPoint(const Mat& l, T& pt)
+    void FastLineDetectorImpl::incidentPoint(const Mat& l, const Size& size, T& pt) const
     {
         double a[] = { (double)pt.x, (double)pt.y, 1.0 };
         double b[] = { l.at<double>(0,0), l.at<double>(1,0), 0.0 };
@@ -339,13 +401,14 @@ template<class T>
 
         Point2f pt_tmp;
         pt_tmp.x = (float)xk.at<double>(0,0) < 0.0f ? 0.0f : (float)xk.at<double>(0,0)
-            >= (imagewidth - 1.0f) ? (imagewidth - 1.0f) : (float)xk.at<double>(0,0);
+            >= (size.width - 1.0f) ? (size.width - 1.0f) : (float)xk.at<double>(0,0);
         pt_tmp.y = (float)xk.at<double>(1,0) < 0.0f ? 0.0f : (float)xk.at<double>(1,0)
-            >= (imageheight - 1.0f) ? (imageheight - 1.0f) : (float)xk.at<double>(1,0);
+            >= (size.height - 1.0f) ? (size.height - 1.0f) : (float)xk.at<double>(1,0);
         pt = T(pt_tmp);
     }
 
-void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, std::vector<SEGMENT>& segments)
+void FastLineDetectorImpl::extractSegments(const Point2i* points, int total, const Size& size,
+        std::vector<SEGMENT>& segments) const
 {
     bool is_line;
 
@@ -355,8 +418,6 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
 
     std::vector<Point2i> l_points;
 
-    int total = (int)points.size();
-
     for ( i = 0; i + threshold_length < total; i++ )
     {
         ps = points[i];
@@ -414,7 +475,7 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
 
         l = p1.cross(p2);
 
-        incidentPoint(l, ps);
+        incidentPoint(l, size, ps);
 
         // Extending line
         for ( j = threshold_length + 1; i + j < total; j++ )
@@ -465,8 +526,8 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
         e2.x = (float)pe.x;
         e2.y = (float)pe.y;
 
-        incidentPoint(l, e1);
-        incidentPoint(l, e2);
+        incidentPoint(l, size, e1);
+        incidentPoint(l, size, e2);
         seg.x1 = e1.x;
         seg.y1 = e1.y;
         seg.x2 = e2.x;
@@ -477,14 +538,14 @@ void FastLineDetectorImpl::extractSegments(const std::vector<Point2i>& points, s
     }
 }
 
-void FastLineDetectorImpl::pointInboardTest(const Mat& src, Point2i& pt)
+void FastLineDetectorImpl::pointInboardTest(const Mat& src, Point2i& pt) const
 {
     pt.x = pt.x <= 5 ? 5 : pt.x >= src.cols - 5 ? src.cols - 5 : pt.x;
     pt.y = pt.y <= 5 ? 5 : pt.y >= src.rows - 5 ? src.rows - 5 : pt.y;
 }
 
 bool FastLineDetectorImpl::getPointChain(const Mat& img, Point pt,
-        Point& chained_pt, float& direction, int step)
+        Point& chained_pt, float& direction, int step) const
 {
     int ri, ci;
     int indices[8][2] = { {1,1}, {1,0}, {1,-1}, {0,-1},
@@ -537,17 +598,20 @@ bool FastLineDetectorImpl::getPointChain(const Mat& img, Point pt,
     return false;
 }
 
-void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& segments_all)
+void FastLineDetectorImpl::lineDetection(const Mat& src, FrameBuffers& buffers,
+        std::vector<SEGMENT>& segments_all) const
 {
     int r, c;
-    imageheight=src.rows; imagewidth=src.cols;
+    const Size size = src.size();
+    const int imagewidth = size.width, imageheight = size.height;
 
-    std::vector<Point2i> points;
-    std::vector<SEGMENT> segments, segments_tmp;
-    Mat canny;
+    std::vector<Point2i>& points = buffers.points;
+    std::vector<int>& chain_offsets = buffers.chain_offsets;
+    Mat& canny = buffers.canny;
     if (canny_aperture_size == 0)
     {
-        canny = src;
+        // the chains are traced by clearing their pixels, do not modify the input
+        src.copyTo(canny);
     }
     else
     {
@@ -556,8 +620,10 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
     canny.colRange(0,6).rowRange(0,6) = 0;
     canny.colRange(src.cols-5,src.cols).rowRange(src.rows-5,src.rows) = 0;
 
-    SEGMENT seg, seg1, seg2;
-
+    // Trace the edge chains. The chains are grown greedily in raster order and
+    // consume their pixels, so this pass is sequential.
+    points.clear();
+    chain_offsets.assign(1, 0);
     for ( r = 0; r < imageheight; r++ )
     {
         for ( c = 0; c < imagewidth; c++ )
@@ -581,22 +647,36 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
                 canny.at<unsigned char>(pt.y, pt.x) = 0;
             }
 
-            if ( points.size() < (unsigned int)threshold_length + 1 )
+            if ( (int)points.size() - chain_offsets.back() < threshold_length + 1 )
             {
-                points.clear();
+                points.resize(chain_offsets.back());
                 continue;
             }
+            chain_offsets.push_back((int)points.size());
+        }
+    }
 
-            extractSegments(points, segments);
+    // Fit the segments of every chain in parallel, the chains are independent
+    int nchains = (int)chain_offsets.size() - 1;
+    std::vector<std::vector<SEGMENT> >& chain_segments = buffers.chain_segments;
+    if((int)chain_segments.size() < nchains)
+        chain_segments.resize(nchains);
+
+    parallel_for_(Range(0, nchains), [&](const Range& range)
+    {
+        std::vector<SEGMENT> segments;
+        for ( int k = range.start; k < range.end; k++ )
+        {
+            std::vector<SEGMENT>& kept = chain_segments[k];
+            kept.clear();
+
+            segments.clear();
+            extractSegments(&points[chain_offsets[k]], chain_offsets[k + 1] - chain_offsets[k],
+                    size, segments);
 
-            if ( segments.size() == 0 )
-            {
-                points.clear();
-                continue;
-            }
             for ( int i = 0; i < (int)segments.size(); i++ )
             {
-                seg = segments[i];
+                SEGMENT seg = segments[i];
                 float length = sqrt((seg.x1 - seg.x2)*(seg.x1 - seg.x2) +
                         (seg.y1 - seg.y2)*(seg.y1 - seg.y2));
                 if(length < threshold_length)
@@ -607,17 +687,23 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
                     (seg.y1 >= imageheight - 5.0f && seg.y2 >= imageheight - 5.0f) )
                     continue;
                 additionalOperationsOnSegment(src, seg);
-                if(!do_merge)
-                    segments_all.push_back(seg);
-                segments_tmp.push_back(seg);
+                kept.push_back(seg);
             }
-            points.clear();
-            segments.clear();
         }
-    }
+    });
+
+    // Collect the segments in the order of their chains
+    std::vector<SEGMENT> segments_tmp;
+    for ( int k = 0; k < nchains; k++ )
+        segments_tmp.insert(segments_tmp.end(), chain_segments[k].begin(), chain_segments[k].end());
+
     if(!do_merge)
+    {
+        segments_all.swap(segments_tmp);
         return;
+    }
 
+    SEGMENT seg1, seg2;
     bool is_merged = false;
     int ith = (int)segments_tmp.size() - 1;
     int jth = ith - 1;
@@ -646,15 +732,15 @@ void FastLineDetectorImpl::lineDetection(const Mat& src, std::vector<SEGMENT>& s
             jth = ith - 1;
         }
     }
-    segments_all = segments_tmp;
+    segments_all.swap(segments_tmp);
 }
 
-inline void FastLineDetectorImpl::getAngle(SEGMENT& seg)
+inline void FastLineDetectorImpl::getAngle(SEGMENT& seg) const
 {
     seg.angle = (float)(fastAtan2(seg.y2 - seg.y1, seg.x2 - seg.x1) / 180.0f * CV_PI);
 }
 
-void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT& seg)
+void FastLineDetectorImpl::additionalOperationsOnSegment(const Mat& src, SEGMENT& seg) const
 {
     if(seg.x1 == 0.0f && seg.x2 == 0.0f && seg.y1 == 0.0f && seg.y2 == 0.0f)
         return;
@@ -35,13 +35,11 @@
  */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include <cmath>
 #include <vector>
-#include <memory>
-#include <stdlib.h>
-#include <iostream>
-#include <iterator>
+#include <limits>
 #include <algorithm>
 
 
@@ -50,10 +48,6 @@
 #    pragma GCC diagnostic ignored "-Wshadow"
 #  endif
 #  include <Eigen/Dense>
-#  include <Eigen/SparseCore>
-#  include <Eigen/SparseCholesky>
-#  include <Eigen/IterativeLinearSolvers>
-#  include <Eigen/Sparse>
 
 
 
@@ -109,15 +103,23 @@ namespace ximgproc
 
             Mat conf = confidence.getMat();
 
-            for(int i=0;i<src.channels();i++)
+            // the previous solutions only serve as initial guesses for the same number of channels
+            if(!warm_start || prev_solution.size() != src_channels.size())
             {
-                Mat cur_res = src_channels[i].clone();
+                prev_solution.clear();
+                prev_solution.resize(src_channels.size());
+            }
 
-                solve(cur_res,conf,cur_res);
-                cur_res.convertTo(cur_res, src.type());
+            for(int i=0;i<src.channels();i++)
+            {
+                Mat cur_res;
+                solve(src_channels[i],conf,prev_solution[i],cur_res);
                 dst_channels.push_back(cur_res);
             }
 
+            if(!warm_start)
+                prev_solution.clear();
+
             dst.create(src.size(),src_channels[0].type());
             if(src.channels()==1)
             {
@@ -129,46 +131,66 @@ namespace ximgproc
             CV_Assert(src.type() == dst.type() && src.size() == dst.size());
         }
 
-    // protected:
-        void solve(cv::Mat& src, cv::Mat& confidence, cv::Mat& dst);
-        void init(cv::Mat& reference, double sigma_spatial, double sigma_luma, double sigma_chroma, double lambda, int num_iter, double max_tol);
-
-        void Splat(Eigen::VectorXf& input, Eigen::VectorXf& dst);
-        void Blur(Eigen::VectorXf& input, Eigen::VectorXf& dst);
-        void Slice(Eigen::VectorXf& input, Eigen::VectorXf& dst);
+        void setGuide(InputArray guide) CV_OVERRIDE
+        {
+            CV_Assert(guide.type() == CV_8UC1 || guide.type() == CV_8UC3);
+            buildGrid(guide.getMat());
+        }
 
-        void diagonal(Eigen::VectorXf& v,Eigen::SparseMatrix<float>& mat)
+        void setWarmStart(bool enable) CV_OVERRIDE
         {
-            mat = Eigen::SparseMatrix<float>(v.size(),v.size());
-            for (int i = 0; i < int(v.size()); i++)
-            {
-                mat.insert(i,i) = v(i);
-            }
+            warm_start = enable;
+            if(!warm_start)
+                prev_solution.clear();
         }
 
+        bool getWarmStart() const CV_OVERRIDE { return warm_start; }
+
+    // protected:
+        void solve(const cv::Mat& target, const cv::Mat& confidence, cv::Mat& solution, cv::Mat& output);
+        void init(cv::Mat& reference, double sigma_spatial, double sigma_luma, double sigma_chroma, double lambda, int num_iter, double max_tol);
+        void buildGrid(const cv::Mat& reference);
+
+        // pixels -> vertices
+        void Splat(const float* input, float* output) const;
+        // vertices -> vertices, input holds nvertices + 1 values, the last one being zero
+        void Blur(const float* input, float* output) const;
+        // vertices -> pixels
+        void Slice(const float* input, float* output) const;
 
+        // output = A * input with A = lam * (Dm - Dn * Blur * Dn) + diag(w_splat)
+        void applyA(const Eigen::VectorXf& w_splat, const Eigen::VectorXf& input, Eigen::VectorXf& output,
+                    Eigen::VectorXf& blur_input, Eigen::VectorXf& blur_output) const;
 
     private:
 
+        // number of grid vertices processed together by the parallel vertex loops
+        enum { VERTEX_BLOCK = 4096 };
+
         int npixels;
         int nvertices;
         int dim;
         int cols;
         int rows;
-        std::vector<int> splat_idx;
-        std::vector<std::pair<int, int> > blur_idx;
+        std::vector<int> splat_idx; //[pixel] vertex of the pixel
+        std::vector<int> vertex_pixels_ofs; //[vertex] first entry of the vertex in vertex_pixels
+        std::vector<int> vertex_pixels; // pixels of every vertex, in raster order
+        std::vector<int> blur_nb; //[k * nvertices + vertex] neighbour along the direction k
+        std::vector<long long> vertex_hash;
+        std::vector<long long> pixel_hash;
+        mapId hashed_coords;
+        Eigen::VectorXf vertex_count;
         Eigen::VectorXf m;
         Eigen::VectorXf n;
-        Eigen::SparseMatrix<float, Eigen::ColMajor> blurs;
-        Eigen::SparseMatrix<float, Eigen::ColMajor> S;
-        Eigen::SparseMatrix<float, Eigen::ColMajor> Dn;
-        Eigen::SparseMatrix<float, Eigen::ColMajor> Dm;
+
+        bool warm_start;
+        std::vector<Mat> prev_solution; //[channel] solution of the last filter() call, sliced to the pixels
 
         struct grid_params
         {
-            float spatialSigma;
-            float lumaSigma;
-            float chromaSigma;
+            double spatialSigma;
+            double lumaSigma;
+            double chromaSigma;
             grid_params()
             {
                 spatialSigma = 8.0;
@@ -206,400 +228,303 @@ namespace ximgproc
         bs_param.cg_maxiter = num_iter;
         bs_param.cg_tol = max_tol;
 
-        if(reference.channels()==1)
-        {
-            dim = 3;
-            cols = reference.cols;
-            rows = reference.rows;
-            npixels = cols*rows;
-            long long hash_vec[3];
-            for (int i = 0; i < 3; ++i)
-            hash_vec[i] = static_cast<long long>(std::pow(255, i));
-
-            mapId hashed_coords;
-#if __cplusplus <= 199711L
-#else
-            hashed_coords.reserve(cols*rows);
-#endif
+        grid_param.spatialSigma = sigma_spatial;
+        grid_param.lumaSigma = sigma_luma;
+        grid_param.chromaSigma = sigma_chroma;
 
-            const unsigned char* pref = (const unsigned char*)reference.data;
-            int vert_idx = 0;
-            int pix_idx = 0;
-
-            // construct Splat(Slice) matrices
-            splat_idx.resize(npixels);
-            for (int y = 0; y < rows; ++y)
-            {
-                for (int x = 0; x < cols; ++x)
-                {
-                    long long coord[3];
-                    coord[0] = int(x / sigma_spatial);
-                    coord[1] = int(y / sigma_spatial);
-                    coord[2] = int(pref[0] / sigma_luma);
-
-                    // convert the coordinate to a hash value
-                    long long hash_coord = 0;
-                    for (int i = 0; i < 3; ++i)
-                        hash_coord += coord[i] * hash_vec[i];
-
-                    // pixels whom are alike will have the same hash value.
-                    // We only want to keep a unique list of hash values, therefore make sure we only insert
-                    // unique hash values.
-                    mapId::iterator it = hashed_coords.find(hash_coord);
-                    if (it == hashed_coords.end())
-                    {
-                        hashed_coords.insert(std::pair<long long, int>(hash_coord, vert_idx));
-                        splat_idx[pix_idx] = vert_idx;
-                        ++vert_idx;
-                    }
-                    else
-                    {
-                        splat_idx[pix_idx] = it->second;
-                    }
-
-                    pref += 1; // skip 1 bytes (y)
-                    ++pix_idx;
-                }
-            }
-            nvertices = static_cast<int>(hashed_coords.size());
+        warm_start = false;
 
-            // construct Blur matrices
-            Eigen::VectorXf ones_nvertices = Eigen::VectorXf::Ones(nvertices);
-            diagonal(ones_nvertices,blurs);
-            blurs *= 10;
-            for(int offset = -1; offset <= 1;++offset)
-            {
-                if(offset == 0) continue;
-                for (int i = 0; i < dim; ++i)
-                {
-                    Eigen::SparseMatrix<float, Eigen::ColMajor> blur_temp(hashed_coords.size(), hashed_coords.size());
-                    blur_temp.reserve(Eigen::VectorXi::Constant(nvertices,6));
-                    long long offset_hash_coord = offset * hash_vec[i];
-                    for (mapId::iterator it = hashed_coords.begin(); it != hashed_coords.end(); ++it)
-                    {
-                        long long neighb_coord = it->first + offset_hash_coord;
-                        mapId::iterator it_neighb = hashed_coords.find(neighb_coord);
-                        if (it_neighb != hashed_coords.end())
-                        {
-                            blur_temp.insert(it->second,it_neighb->second) = 1.0f;
-                            blur_idx.push_back(std::pair<int,int>(it->second, it_neighb->second));
-                        }
-                    }
-                    blurs += blur_temp;
-                }
-            }
-            blurs.finalize();
-
-            //bistochastize
-            int maxiter = 10;
-            n = ones_nvertices;
-            m = Eigen::VectorXf::Zero(nvertices);
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                m(splat_idx[i]) += 1.0f;
-            }
-
-            Eigen::VectorXf bluredn(nvertices);
-
-            for (int i = 0; i < maxiter; i++)
-            {
-                Blur(n,bluredn);
-                n = ((n.array()*m.array()).array()/bluredn.array()).array().sqrt();
-            }
-            Blur(n,bluredn);
-
-            m = n.array() * (bluredn).array();
-            diagonal(m,Dm);
-            diagonal(n,Dn);
+        buildGrid(reference);
+    }
 
+    void FastBilateralSolverFilterImpl::buildGrid(const cv::Mat& reference)
+    {
+        cv::Mat reference_yuv;
+        if(reference.channels()==1)
+        {
+            dim = 3;
+            reference_yuv = reference;
         }
         else
         {
             dim = 5;
-            cv::Mat reference_yuv;
             cv::cvtColor(reference, reference_yuv, COLOR_BGR2YCrCb);
+        }
 
-            cols = reference_yuv.cols;
-            rows = reference_yuv.rows;
-            npixels = cols*rows;
-            long long hash_vec[5];
-            for (int i = 0; i < 5; ++i)
+        cols = reference_yuv.cols;
+        rows = reference_yuv.rows;
+        npixels = cols*rows;
+        long long hash_vec[5];
+        for (int i = 0; i < dim; ++i)
             hash_vec[i] = static_cast<long long>(std::pow(255, i));
 
-            mapId hashed_coords;
-#if __cplusplus <= 199711L
-#else
-            hashed_coords.reserve(cols*rows);
-#endif
-
-            const unsigned char* pref = (const unsigned char*)reference_yuv.data;
-            int vert_idx = 0;
-            int pix_idx = 0;
-
-            // construct Splat(Slice) matrices
-            splat_idx.resize(npixels);
-            for (int y = 0; y < rows; ++y)
+        // hash the grid coordinates of every pixel
+        pixel_hash.resize(npixels);
+        const int cn = reference_yuv.channels();
+        parallel_for_(Range(0, rows), [&](const Range& range)
+        {
+            for (int y = range.start; y < range.end; ++y)
             {
-                for (int x = 0; x < cols; ++x)
+                const unsigned char* pref = reference_yuv.ptr<unsigned char>(y);
+                long long* phash = &pixel_hash[(size_t)y * cols];
+                for (int x = 0; x < cols; ++x, pref += cn)
                 {
                     long long coord[5];
-                    coord[0] = int(x / sigma_spatial);
-                    coord[1] = int(y / sigma_spatial);
-                    coord[2] = int(pref[0] / sigma_luma);
-                    coord[3] = int(pref[1] / sigma_chroma);
-                    coord[4] = int(pref[2] / sigma_chroma);
+                    coord[0] = int(x / grid_param.spatialSigma);
+                    coord[1] = int(y / grid_param.spatialSigma);
+                    coord[2] = int(pref[0] / grid_param.lumaSigma);
+                    if (dim == 5)
+                    {
+                        coord[3] = int(pref[1] / grid_param.chromaSigma);
+                        coord[4] = int(pref[2] / grid_param.chromaSigma);
+                    }
 
                     // convert the coordinate to a hash value
                     long long hash_coord = 0;
-                    for (int i = 0; i < 5; ++i)
+                    for (int i = 0; i < dim; ++i)
                         hash_coord += coord[i] * hash_vec[i];
-
-                    // pixels whom are alike will have the same hash value.
-                    // We only want to keep a unique list of hash values, therefore make sure we only insert
-                    // unique hash values.
-                    mapId::iterator it = hashed_coords.find(hash_coord);
-                    if (it == hashed_coords.end())
-                    {
-                        hashed_coords.insert(std::pair<long long, int>(hash_coord, vert_idx));
-                        splat_idx[pix_idx] = vert_idx;
-                        ++vert_idx;
-                    }
-                    else
-                    {
-                        splat_idx[pix_idx] = it->second;
-                    }
-
-                    pref += 3; // skip 3 bytes (y u v)
-                    ++pix_idx;
+                    phash[x] = hash_coord;
                 }
             }
-            nvertices = static_cast<int>(hashed_coords.size());
-
-            // construct Blur matrices
-            Eigen::VectorXf ones_nvertices = Eigen::VectorXf::Ones(nvertices);
-            diagonal(ones_nvertices,blurs);
-            blurs *= 10;
-            for(int offset = -1; offset <= 1;++offset)
+        });
+
+        // pixels whom are alike will have the same hash value.
+        // We only want to keep a unique list of hash values, the vertices are numbered in raster order
+        // of their first pixel. Neighbouring pixels mostly share their vertex, so check the previous one first.
+        hashed_coords.clear();
+#if __cplusplus > 199711L
+        hashed_coords.reserve(npixels);
+#endif
+        vertex_hash.clear();
+        splat_idx.resize(npixels);
+        for (int i = 0; i < npixels; ++i)
+        {
+            if (i > 0 && pixel_hash[i] == pixel_hash[i - 1])
             {
-                if(offset == 0) continue;
-                for (int i = 0; i < dim; ++i)
-                {
-                    Eigen::SparseMatrix<float, Eigen::ColMajor> blur_temp(hashed_coords.size(), hashed_coords.size());
-                    blur_temp.reserve(Eigen::VectorXi::Constant(nvertices,6));
-                    long long offset_hash_coord = offset * hash_vec[i];
-                    for (mapId::iterator it = hashed_coords.begin(); it != hashed_coords.end(); ++it)
-                    {
-                        long long neighb_coord = it->first + offset_hash_coord;
-                        mapId::iterator it_neighb = hashed_coords.find(neighb_coord);
-                        if (it_neighb != hashed_coords.end())
-                        {
-                            blur_temp.insert(it->second,it_neighb->second) = 1.0f;
-                            blur_idx.push_back(std::pair<int,int>(it->second, it_neighb->second));
-                        }
-                    }
-                    blurs += blur_temp;
-                }
+                splat_idx[i] = splat_idx[i - 1];
+                continue;
             }
-            blurs.finalize();
-
-
-            //bistochastize
-            int maxiter = 10;
-            n = ones_nvertices;
-            m = Eigen::VectorXf::Zero(nvertices);
-            for (int i = 0; i < int(splat_idx.size()); i++)
+            std::pair<mapId::iterator, bool> it =
+                hashed_coords.insert(std::pair<long long, int>(pixel_hash[i], (int)vertex_hash.size()));
+            if (it.second)
+                vertex_hash.push_back(pixel_hash[i]);
+            splat_idx[i] = it.first->second;
+        }
+        nvertices = static_cast<int>(vertex_hash.size());
+
+        // pixels of every vertex, used to splat without write conflicts
+        vertex_pixels_ofs.assign(nvertices + 1, 0);
+        for (int i = 0; i < npixels; ++i)
+            vertex_pixels_ofs[splat_idx[i] + 1]++;
+        for (int v = 0; v < nvertices; ++v)
+            vertex_pixels_ofs[v + 1] += vertex_pixels_ofs[v];
+        vertex_pixels.resize(npixels);
+        std::vector<int> vertex_fill(vertex_pixels_ofs.begin(), vertex_pixels_ofs.end() - 1);
+        for (int i = 0; i < npixels; ++i)
+            vertex_pixels[vertex_fill[splat_idx[i]]++] = i;
+
+        // construct Blur neighbours, one array per direction (-1 then +1 along every dimension).
+        // Missing neighbours point to the zero entry padding the blur input.
+        blur_nb.resize((size_t)2 * dim * nvertices);
+        const int nblocks = (nvertices + VERTEX_BLOCK - 1) / VERTEX_BLOCK;
+        parallel_for_(Range(0, nblocks), [&](const Range& range)
+        {
+            const int v0 = range.start * VERTEX_BLOCK;
+            const int v1 = std::min(range.end * VERTEX_BLOCK, nvertices);
+            for (int k = 0; k < 2 * dim; ++k)
             {
-                m(splat_idx[i]) += 1.0f;
+                long long offset_hash_coord = (k < dim ? -1 : 1) * hash_vec[k % dim];
+                int* nb = &blur_nb[(size_t)k * nvertices];
+                for (int v = v0; v < v1; ++v)
+                {
+                    mapId::const_iterator it_neighb = hashed_coords.find(vertex_hash[v] + offset_hash_coord);
+                    nb[v] = it_neighb != hashed_coords.end() ? it_neighb->second : nvertices;
+                }
             }
+        });
 
-            Eigen::VectorXf bluredn(nvertices);
+        //bistochastize
+        int maxiter = 10;
+        vertex_count.resize(nvertices);
+        for (int v = 0; v < nvertices; ++v)
+            vertex_count(v) = float(vertex_pixels_ofs[v + 1] - vertex_pixels_ofs[v]);
 
-            for (int i = 0; i < maxiter; i++)
-            {
-                Blur(n,bluredn);
-                n = ((n.array()*m.array()).array()/bluredn.array()).array().sqrt();
-            }
-            Blur(n,bluredn);
+        Eigen::VectorXf n_padded = Eigen::VectorXf::Ones(nvertices + 1);
+        n_padded(nvertices) = 0.0f;
+        Eigen::VectorXf bluredn(nvertices);
 
-            m = n.array() * (bluredn).array();
-            diagonal(m,Dm);
-            diagonal(n,Dn);
+        for (int i = 0; i < maxiter; i++)
+        {
+            Blur(n_padded.data(),bluredn.data());
+            n_padded.head(nvertices) = ((n_padded.head(nvertices).array()*vertex_count.array())/bluredn.array()).sqrt().matrix();
         }
+        Blur(n_padded.data(),bluredn.data());
+
+        n = n_padded.head(nvertices);
+        m = (n.array() * bluredn.array()).matrix();
     }
 
-    void FastBilateralSolverFilterImpl::Splat(Eigen::VectorXf& input, Eigen::VectorXf& output)
+    void FastBilateralSolverFilterImpl::Splat(const float* input, float* output) const
     {
-        output.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
+        const int nblocks = (nvertices + VERTEX_BLOCK - 1) / VERTEX_BLOCK;
+        parallel_for_(Range(0, nblocks), [&](const Range& range)
         {
-            output(splat_idx[i]) += input(i);
-        }
-
+            const int v1 = std::min(range.end * VERTEX_BLOCK, nvertices);
+            for (int v = range.start * VERTEX_BLOCK; v < v1; v++)
+            {
+                float sum = 0.0f;
+                for (int j = vertex_pixels_ofs[v]; j < vertex_pixels_ofs[v + 1]; j++)
+                    sum += input[vertex_pixels[j]];
+                output[v] = sum;
+            }
+        });
     }
 
-    void FastBilateralSolverFilterImpl::Blur(Eigen::VectorXf& input, Eigen::VectorXf& output)
+    void FastBilateralSolverFilterImpl::Blur(const float* input, float* output) const
     {
-        output.setZero();
-        output = input * 10;
-        for (int i = 0; i < int(blur_idx.size()); i++)
+        const int nblocks = (nvertices + VERTEX_BLOCK - 1) / VERTEX_BLOCK;
+        const int nneighbours = 2 * dim;
+        parallel_for_(Range(0, nblocks), [&](const Range& range)
         {
-            output(blur_idx[i].first) += input(blur_idx[i].second);
-        }
+            const int v1 = std::min(range.end * VERTEX_BLOCK, nvertices);
+            int v = range.start * VERTEX_BLOCK;
+#if CV_SIMD128
+            const v_float32x4 v_ten = v_setall_f32(10.0f);
+            for (; v <= v1 - v_float32x4::nlanes; v += v_float32x4::nlanes)
+            {
+                v_float32x4 sum = v_load(input + v) * v_ten;
+                for (int k = 0; k < nneighbours; k++)
+                    sum += v_lut(input, v_load(&blur_nb[(size_t)k * nvertices + v]));
+                v_store(output + v, sum);
+            }
+#endif
+            for (; v < v1; v++)
+            {
+                float sum = input[v] * 10.0f;
+                for (int k = 0; k < nneighbours; k++)
+                    sum += input[blur_nb[(size_t)k * nvertices + v]];
+                output[v] = sum;
+            }
+        });
     }
 
 
-    void FastBilateralSolverFilterImpl::Slice(Eigen::VectorXf& input, Eigen::VectorXf& output)
+    void FastBilateralSolverFilterImpl::Slice(const float* input, float* output) const
     {
-        output.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
+        parallel_for_(Range(0, rows), [&](const Range& range)
         {
-            output(i) = input(splat_idx[i]);
-        }
+            for (int i = range.start * cols; i < range.end * cols; i++)
+                output[i] = input[splat_idx[i]];
+        });
+    }
+
+    void FastBilateralSolverFilterImpl::applyA(const Eigen::VectorXf& w_splat, const Eigen::VectorXf& input, Eigen::VectorXf& output,
+                                               Eigen::VectorXf& blur_input, Eigen::VectorXf& blur_output) const
+    {
+        blur_input.head(nvertices) = n.cwiseProduct(input);
+        Blur(blur_input.data(), blur_output.data());
+        output = bs_param.lam * (m.cwiseProduct(input) - n.cwiseProduct(blur_output)) + w_splat.cwiseProduct(input);
     }
 
 
-    void FastBilateralSolverFilterImpl::solve(cv::Mat& target,
-               cv::Mat& confidence,
+    void FastBilateralSolverFilterImpl::solve(const cv::Mat& target,
+               const cv::Mat& confidence,
+               cv::Mat& solution,
                cv::Mat& output)
     {
-
-        Eigen::SparseMatrix<float, Eigen::ColMajor> M(nvertices,nvertices);
-        Eigen::SparseMatrix<float, Eigen::ColMajor> A_data(nvertices,nvertices);
-        Eigen::SparseMatrix<float, Eigen::ColMajor> A(nvertices,nvertices);
         Eigen::VectorXf b(nvertices);
         Eigen::VectorXf y(nvertices);
-        Eigen::VectorXf y0(nvertices);
-        Eigen::VectorXf y1(nvertices);
         Eigen::VectorXf w_splat(nvertices);
 
-        Eigen::VectorXf x(npixels);
-        Eigen::VectorXf w(npixels);
-
+        // x and w hold the target and the confidence in [0, 1], as continuous float images
+        cv::Mat x, w, xw;
         if(target.depth() == CV_16S)
-        {
-            const int16_t *pft = reinterpret_cast<const int16_t*>(target.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                x(i) = (cv::saturate_cast<float>(pft[i])+32768.0f)/65535.0f;
-            }
-        }
+            target.convertTo(x, CV_32F, 1.0/65535.0, 32768.0/65535.0);
         else if(target.depth() == CV_16U)
-        {
-            const uint16_t *pft = reinterpret_cast<const uint16_t*>(target.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                x(i) = cv::saturate_cast<float>(pft[i])/65535.0f;
-            }
-        }
+            target.convertTo(x, CV_32F, 1.0/65535.0);
         else if(target.depth() == CV_8U)
-        {
-            const uchar *pft = reinterpret_cast<const uchar*>(target.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                x(i) = cv::saturate_cast<float>(pft[i])/255.0f;
-            }
-        }
-        else if(target.depth() == CV_32F)
-        {
-            const float *pft = reinterpret_cast<const float*>(target.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                x(i) = pft[i];
-            }
-        }
+            target.convertTo(x, CV_32F, 1.0/255.0);
+        else
+            x = target.isContinuous() ? target : target.clone();
 
         if(confidence.depth() == CV_8U)
-        {
-            const uchar *pfc = reinterpret_cast<const uchar*>(confidence.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                w(i) = cv::saturate_cast<float>(pfc[i])/255.0f;
-            }
-        }
-        else if(confidence.depth() == CV_32F)
-        {
-            const float *pfc = reinterpret_cast<const float*>(confidence.data);
-            for (int i = 0; i < npixels; i++)
-            {
-                w(i) = pfc[i];
-            }
-        }
+            confidence.convertTo(w, CV_32F, 1.0/255.0);
+        else
+            w = confidence.isContinuous() ? confidence : confidence.clone();
 
         //construct A
-        Splat(w,w_splat);
-
-        diagonal(w_splat,A_data);
-        A = bs_param.lam * (Dm - Dn * (blurs*Dn)) + A_data ;
+        Splat(w.ptr<float>(), w_splat.data());
 
         //construct b
-        b.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
-        {
-            b(splat_idx[i]) += x(i) * w(i);
-        }
+        cv::multiply(x, w, xw);
+        Splat(xw.ptr<float>(), b.data());
 
-        //construct guess for y
-        y0.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
-        {
-            y0(splat_idx[i]) += x(i);
-        }
-        y1.setZero();
-        for (int i = 0; i < int(splat_idx.size()); i++)
-        {
-            y1(splat_idx[i]) += 1.0f;
-        }
+        //construct guess for y, the average target of every vertex or the previous solution
+        const bool use_solution = warm_start && solution.size() == x.size() && solution.type() == CV_32F;
+        Splat(use_solution ? solution.ptr<float>() : x.ptr<float>(), y.data());
+        y = y.cwiseQuotient(vertex_count);
+
+        // solve Ay = b by a conjugate gradient with diagonal preconditioner, as Eigen::ConjugateGradient does,
+        // without forming A
+        Eigen::VectorXf invdiag(nvertices);
         for (int i = 0; i < nvertices; i++)
         {
-            y0(i) = y0(i)/y1(i);
+            float a_ii = bs_param.lam * (m(i) - 10.0f * n(i) * n(i)) + w_splat(i);
+            invdiag(i) = a_ii != 0.0f ? 1.0f / a_ii : 1.0f;
         }
 
+        Eigen::VectorXf residual(nvertices), p(nvertices), z(nvertices), tmp(nvertices);
+        Eigen::VectorXf blur_input(nvertices + 1), blur_output(nvertices);
+        blur_input(nvertices) = 0.0f;
 
-        // solve Ay = b
-        Eigen::ConjugateGradient<Eigen::SparseMatrix<float>, Eigen::Lower|Eigen::Upper> cg;
-        cg.compute(A);
-        cg.setMaxIterations(bs_param.cg_maxiter);
-        cg.setTolerance(bs_param.cg_tol);
-        // y = cg.solve(b);
-        y = cg.solveWithGuess(b,y0);
-        std::cout << "#iterations:     " << cg.iterations() << std::endl;
-        std::cout << "estimated error: " << cg.error()      << std::endl;
-
-        //slice
-        if(target.depth() == CV_16S)
-        {
-            int16_t *pftar = (int16_t*) output.data;
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = cv::saturate_cast<short>(y(splat_idx[i]) * 65535.0f - 32768.0f);
-            }
-        }
-        else if(target.depth() == CV_16U)
-        {
-            uint16_t *pftar = (uint16_t*) output.data;
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = cv::saturate_cast<ushort>(y(splat_idx[i]) * 65535.0f);
-            }
-        }
-        else if (target.depth() == CV_8U)
+        const float rhsNorm2 = b.squaredNorm();
+        if(rhsNorm2 == 0.0f)
         {
-            uchar *pftar = (uchar*) output.data;
-            for (int i = 0; i < int(splat_idx.size()); i++)
-            {
-                pftar[i] = cv::saturate_cast<uchar>(y(splat_idx[i]) * 255.0f);
-            }
+            y.setZero();
         }
         else
         {
-            float *pftar = (float*)(output.data);
-            for (int i = 0; i < int(splat_idx.size()); i++)
+            const float threshold = std::max(bs_param.cg_tol * bs_param.cg_tol * rhsNorm2,
+                                             (std::numeric_limits<float>::min)());
+            applyA(w_splat, y, tmp, blur_input, blur_output);
+            residual = b - tmp;
+            if(residual.squaredNorm() >= threshold)
             {
-                pftar[i] = y(splat_idx[i]);
+                p = invdiag.cwiseProduct(residual);
+                float absNew = residual.dot(p);
+                for (int i = 0; i < bs_param.cg_maxiter; i++)
+                {
+                    applyA(w_splat, p, tmp, blur_input, blur_output);
+                    float alpha = absNew / p.dot(tmp);
+                    y += alpha * p;
+                    residual -= alpha * tmp;
+                    if(residual.squaredNorm() < threshold)
+                        break;
+                    z = invdiag.cwiseProduct(residual);
+                    float absOld = absNew;
+                    absNew = residual.dot(z);
+                    p = z + (absNew / absOld) * p;
+                }
             }
         }
 
+        //slice
+        cv::Mat sliced;
+        if(warm_start)
+            sliced = solution;
+        sliced.create(rows, cols, CV_32F);
+        Slice(y.data(), sliced.ptr<float>());
+        if(warm_start)
+            solution = sliced;
 
+        if(target.depth() == CV_16S)
+            sliced.convertTo(output, CV_16S, 65535.0, -32768.0);
+        else if(target.depth() == CV_16U)
+            sliced.convertTo(output, CV_16U, 65535.0);
+        else if (target.depth() == CV_8U)
+            sliced.convertTo(output, CV_8U, 255.0);
+        else
+            output = warm_start ? sliced.clone() : sliced;
     }
 
 
@@ -63,6 +63,7 @@ class FastGlobalSmootherFilterImpl : public FastGlobalSmootherFilter
 public:
     static Ptr<FastGlobalSmootherFilterImpl> create(InputArray guide, double lambda, double sigma_color, int num_iter,double lambda_attenuation);
     void filter(InputArray src, OutputArray dst) CV_OVERRIDE;
+    void setGuide(InputArray guide) CV_OVERRIDE;
 
 protected:
     int w,h;
@@ -153,6 +154,12 @@ void FastGlobalSmootherFilterImpl::init(InputArray guide,double _lambda,double _
     WorkType* LUT = (WorkType*)weights_LUT.ptr(0);
     parallel_for_(Range(0,num_stripes),ComputeLUT_ParBody(*this,LUT,num_stripes,num_levels));
 
+    setGuide(guide);
+}
+
+void FastGlobalSmootherFilterImpl::setGuide(InputArray guide)
+{
+    CV_Assert( !guide.empty() && guide.depth() == CV_8U && (guide.channels() == 1 || guide.channels() == 3) );
     w = guide.cols();
     h = guide.rows();
     Chor.  create(h,w,traits::Type<WorkVec>::value);
@@ -40,6 +40,7 @@ the use of this software, even if advised of the possibility of such damage.
 
 #include "precomp.hpp"
 #include "opencv2/ximgproc/segmentation.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 #include <iostream>
 
@@ -79,10 +80,11 @@ namespace cv {
             class PointSet {
                 public:
                     PointSet(int nb_elements_);
-                    ~PointSet();
 
                     int nb_elements;
 
+                    // Note: sets of disjoint points can be joined concurrently
+
                     // Return the main point of the point's set
                     int getBasePoint(int p);
 
@@ -93,7 +95,7 @@ namespace cv {
                     int size(unsigned int p) { return mapping[p].size; }
 
                 private:
-                    PointSetElement* mapping;
+                    std::vector<PointSetElement> mapping;
 
             };
 
@@ -103,6 +105,7 @@ namespace cv {
                         sigma = 0.5;
                         k = 300;
                         min_size = 100;
+                        tile_size = 0;
                         name_ = "GraphSegmentation";
                     }
 
@@ -120,11 +123,15 @@ namespace cv {
                     virtual void setMinSize(int min_size_) CV_OVERRIDE { min_size = min_size_; }
                     virtual int getMinSize() CV_OVERRIDE { return min_size; }
 
+                    virtual void setTileSize(int tile_size_) CV_OVERRIDE { tile_size = std::max(tile_size_, 0); }
+                    virtual int getTileSize() CV_OVERRIDE { return tile_size; }
+
                     virtual void write(FileStorage& fs) const CV_OVERRIDE {
                         fs << "name" << name_
                         << "sigma" << sigma
                         << "k" << k
-                        << "min_size" << (int)min_size;
+                        << "min_size" << (int)min_size
+                        << "tile_size" << tile_size;
                     }
 
                     virtual void read(const FileNode& fn) CV_OVERRIDE {
@@ -133,28 +140,33 @@ namespace cv {
                         sigma = (double)fn["sigma"];
                         k = (float)fn["k"];
                         min_size = (int)(int)fn["min_size"];
+                        tile_size = fn["tile_size"].empty() ? 0 : (int)fn["tile_size"];
                     }
 
                 private:
                     double sigma;
                     float k;
                     int min_size;
+                    int tile_size;
                     String name_;
 
                     // Pre-filter the image
                     void filter(const Mat &img, Mat &img_filtered);
 
                     // Build the graph between each pixels
-                    void buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered);
+                    void buildGraph(std::vector<Edge> &edges, const Mat &img_filtered);
 
                     // Segment the graph
-                    void segmentGraph(Edge * edges, const int &nb_edges, const Mat & img_filtered, PointSet **es);
+                    void segmentGraph(std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es);
+
+                    // Segment the graph tile by tile, then merge the tiles along their seams
+                    void segmentGraphTiled(std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es);
 
                     // Remove areas too small
-                    void filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es);
+                    void filterSmallAreas(const std::vector<Edge> &edges, PointSet &es);
 
                     // Map the segemented graph to a Mat with uniques, sequentials ids
-                    void finalMapping(PointSet *es, Mat &output);
+                    void finalMapping(PointSet &es, Mat &output);
             };
 
             void GraphSegmentationImpl::filter(const Mat &img, Mat &img_filtered) {
@@ -168,96 +180,256 @@ namespace cv {
                 GaussianBlur(img_converted, img_filtered, Size(0, 0), sigma, sigma);
             }
 
-            void GraphSegmentationImpl::buildGraph(Edge **edges, int &nb_edges, const Mat &img_filtered) {
+            // Color distance between the pixels of two rows, pixel by pixel
+            static void computeEdgeWeights(const float* a, const float* b, float* weights, int n, int nb_channels) {
+
+                int j = 0;
+
+#if CV_SIMD128
+                if (nb_channels == 1) {
+                    for (; j <= n - v_float32x4::nlanes; j += v_float32x4::nlanes) {
+                        v_float32x4 d = v_load(a + j) - v_load(b + j);
+                        v_store(weights + j, v_sqrt(d * d));
+                    }
+                } else if (nb_channels == 3) {
+                    for (; j <= n - v_float32x4::nlanes; j += v_float32x4::nlanes) {
+                        v_float32x4 a0, a1, a2, b0, b1, b2;
+                        v_load_deinterleave(a + j * 3, a0, a1, a2);
+                        v_load_deinterleave(b + j * 3, b0, b1, b2);
+                        a0 -= b0;
+                        a1 -= b1;
+                        a2 -= b2;
+                        v_store(weights + j, v_sqrt(v_muladd(a2, a2, v_muladd(a1, a1, a0 * a0))));
+                    }
+                }
+#endif
 
-                *edges = new Edge[img_filtered.rows * img_filtered.cols * 4];
+                for (; j < n; j++) {
+                    float tmp_total = 0;
 
-                nb_edges = 0;
+                    for (int channel = 0; channel < nb_channels; channel++) {
+                        float diff = a[j * nb_channels + channel] - b[j * nb_channels + channel];
+                        tmp_total += diff * diff;
+                    }
 
+                    weights[j] = sqrt(tmp_total);
+                }
+            }
+
+            void GraphSegmentationImpl::buildGraph(std::vector<Edge> &edges, const Mat &img_filtered) {
+
+                int rows = img_filtered.rows;
+                int cols = img_filtered.cols;
                 int nb_channels = img_filtered.channels();
 
-                for (int i = 0; i < (int)img_filtered.rows; i++) {
-                    const float* p = img_filtered.ptr<float>(i);
+                if (rows == 0 || cols == 0) {
+                    edges.clear();
+                    return;
+                }
 
-                    for (int j = 0; j < (int)img_filtered.cols; j++) {
+                // Each pixel is linked to its bottom and right neighbours, so row i starts at i * (2 * cols - 1)
+                int row_edges = 2 * cols - 1;
+                edges.resize((size_t)(rows - 1) * row_edges + cols - 1);
 
-                        //Take the right, left, top and down pixel
-                        for (int delta = -1; delta <= 1; delta += 2) {
-                            for (int delta_j = 0, delta_i = 1; delta_j <= 1; delta_j++ || delta_i--) {
+                parallel_for_(Range(0, rows), [&](const Range& range) {
 
-                                int i2 = i + delta * delta_i;
-                                int j2 = j + delta * delta_j;
+                    AutoBuffer<float> weights_buf(cols);
+                    float* weights = weights_buf.data();
 
-                                if (i2 >= 0 && i2 < img_filtered.rows && j2 >= 0 && j2 < img_filtered.cols) {
-                                    const float* p2 = img_filtered.ptr<float>(i2);
+                    for (int i = range.start; i < range.end; i++) {
+                        const float* p = img_filtered.ptr<float>(i);
+                        Edge* e = edges.data() + (size_t)i * row_edges;
 
-                                    float tmp_total = 0;
+                        if (i + 1 < rows) {
+                            computeEdgeWeights(p, img_filtered.ptr<float>(i + 1), weights, cols, nb_channels);
 
-                                    for ( int channel = 0; channel < nb_channels; channel++) {
-                                        tmp_total += pow(p[j * nb_channels + channel] - p2[j2 * nb_channels + channel], 2);
-                                    }
+                            for (int j = 0; j < cols; j++, e++) {
+                                e->weight = weights[j];
+                                e->from = i * cols + j;
+                                e->to = (i + 1) * cols + j;
+                            }
+                        }
 
-                                    float diff = 0;
-                                    diff = sqrt(tmp_total);
+                        computeEdgeWeights(p, p + nb_channels, weights, cols - 1, nb_channels);
 
-                                    (*edges)[nb_edges].weight = diff;
-                                    (*edges)[nb_edges].from = i * img_filtered.cols +  j;
-                                    (*edges)[nb_edges].to = i2 * img_filtered.cols + j2;
+                        for (int j = 0; j < cols - 1; j++, e++) {
+                            e->weight = weights[j];
+                            e->from = i * cols + j;
+                            e->to = i * cols + j + 1;
+                        }
+                    }
+                });
+            }
 
-                                    nb_edges++;
-                                }
+            // Stable parallel LSD radix sort of the edges by weight.
+            // Weights are non-negative, so their bit patterns have the same order as the values.
+            static void sortEdges(std::vector<Edge> &edges) {
+
+                const int nb_edges = (int)edges.size();
+                const int nb_bins = 256;
+                const int nb_stripes = std::max(1, std::min(nb_edges >> 16, 64));
+                const int stripe_size = (nb_edges + nb_stripes - 1) / nb_stripes;
+
+                if (nb_edges < 2) {
+                    return;
+                }
+
+                std::vector<Edge> buffer(nb_edges);
+                std::vector<int> histograms(nb_stripes * nb_bins);
+
+                Edge* src = edges.data();
+                Edge* dst = buffer.data();
+
+                for (int shift = 0; shift < 32; shift += 8) {
+
+                    std::fill(histograms.begin(), histograms.end(), 0);
+
+                    parallel_for_(Range(0, nb_stripes), [&](const Range& range) {
+                        for (int s = range.start; s < range.end; s++) {
+                            int* histogram = &histograms[s * nb_bins];
+                            int end = std::min((s + 1) * stripe_size, nb_edges);
+
+                            for (int i = s * stripe_size; i < end; i++) {
+                                Cv32suf key;
+                                key.f = src[i].weight;
+                                histogram[(key.u >> shift) & (nb_bins - 1)]++;
                             }
                         }
+                    });
+
+                    // Offsets, bin by bin and stripe by stripe inside a bin, which keeps the sort stable
+                    int total = 0;
+                    bool single_bin = false;
+
+                    for (int bin = 0; bin < nb_bins && !single_bin; bin++) {
+                        int bin_total = 0;
+
+                        for (int s = 0; s < nb_stripes; s++) {
+                            int count = histograms[s * nb_bins + bin];
+                            histograms[s * nb_bins + bin] = total;
+                            total += count;
+                            bin_total += count;
+                        }
+
+                        single_bin = bin_total == nb_edges;
                     }
+
+                    // Nothing to reorder on this digit
+                    if (single_bin) {
+                        continue;
+                    }
+
+                    parallel_for_(Range(0, nb_stripes), [&](const Range& range) {
+                        for (int s = range.start; s < range.end; s++) {
+                            int* offsets = &histograms[s * nb_bins];
+                            int end = std::min((s + 1) * stripe_size, nb_edges);
+
+                            for (int i = s * stripe_size; i < end; i++) {
+                                Cv32suf key;
+                                key.f = src[i].weight;
+                                dst[offsets[(key.u >> shift) & (nb_bins - 1)]++] = src[i];
+                            }
+                        }
+                    });
+
+                    std::swap(src, dst);
+                }
+
+                if (src != edges.data()) {
+                    std::copy(src, src + nb_edges, edges.data());
                 }
             }
 
-            void GraphSegmentationImpl::segmentGraph(Edge *edges, const int &nb_edges, const Mat &img_filtered, PointSet **es) {
+            // Join the sets of the edge's points if the edge is not heavier than both internal differences
+            static inline void joinEdge(Edge &edge, PointSet &es, float* thresholds, float k) {
 
-                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                int p_a = es.getBasePoint(edge.from);
+                int p_b = es.getBasePoint(edge.to);
 
-                // Sort edges
-                std::sort(edges, edges + nb_edges);
+                if (p_a != p_b) {
+                    if (edge.weight <= thresholds[p_a] && edge.weight <= thresholds[p_b]) {
+                        es.joinPoints(p_a, p_b);
+                        p_a = es.getBasePoint(p_a);
+                        thresholds[p_a] = edge.weight + k / es.size(p_a);
+
+                        edge.weight = 0;
+                    }
+                }
+            }
 
-                // Create a set with all point (by default mapped to themselves)
-                *es = new PointSet(img_filtered.cols * img_filtered.rows);
+            void GraphSegmentationImpl::segmentGraph(std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es) {
+
+                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
 
                 // Thresholds
-                float* thresholds = new float[total_points];
+                std::vector<float> thresholds(total_points, k);
+
+                for (size_t i = 0; i < edges.size(); i++) {
+                    joinEdge(edges[i], es, thresholds.data(), k);
+                }
+            }
+
+            void GraphSegmentationImpl::segmentGraphTiled(std::vector<Edge> &edges, const Mat &img_filtered, PointSet &es) {
+
+                int cols = img_filtered.cols;
+                int total_points = ( int)(img_filtered.rows * img_filtered.cols);
+                int tiles_x = (cols + tile_size - 1) / tile_size;
+                int tiles_y = (img_filtered.rows + tile_size - 1) / tile_size;
+                int nb_tiles = tiles_x * tiles_y;
+
+                std::vector<float> thresholds(total_points, k);
 
-                for (int i = 0; i < total_points; i++)
-                    thresholds[i] = k;
+                // Bucket of each edge: its tile, or nb_tiles for the edges crossing a seam
+                std::vector<int> buckets(edges.size());
+                std::vector<int> offsets(nb_tiles + 2, 0);
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
+                    int from = edges[i].from, to = edges[i].to;
+                    int tile_from = (from / cols / tile_size) * tiles_x + (from % cols) / tile_size;
+                    int tile_to = (to / cols / tile_size) * tiles_x + (to % cols) / tile_size;
 
-                    int p_a = (*es)->getBasePoint(edges[i].from);
-                    int p_b = (*es)->getBasePoint(edges[i].to);
+                    buckets[i] = tile_from == tile_to ? tile_from : nb_tiles;
+                    offsets[buckets[i] + 1]++;
+                }
+
+                for (int t = 0; t <= nb_tiles; t++) {
+                    offsets[t + 1] += offsets[t];
+                }
 
-                    if (p_a != p_b) {
-                        if (edges[i].weight <= thresholds[p_a] && edges[i].weight <= thresholds[p_b]) {
-                            (*es)->joinPoints(p_a, p_b);
-                            p_a = (*es)->getBasePoint(p_a);
-                            thresholds[p_a] = edges[i].weight + k / (*es)->size(p_a);
+                // Edge indexes grouped by bucket, in increasing weight order inside each bucket
+                std::vector<int> order(edges.size());
+                std::vector<int> positions(offsets.begin(), offsets.end() - 1);
 
-                            edges[i].weight = 0;
+                for (size_t i = 0; i < edges.size(); i++) {
+                    order[positions[buckets[i]]++] = (int)i;
+                }
+
+                // Tiles have disjoint points, so they can be segmented concurrently
+                parallel_for_(Range(0, nb_tiles), [&](const Range& range) {
+                    for (int t = range.start; t < range.end; t++) {
+                        for (int i = offsets[t]; i < offsets[t + 1]; i++) {
+                            joinEdge(edges[order[i]], es, thresholds.data(), k);
                         }
                     }
-                }
+                });
 
-                delete [] thresholds;
+                // Merge the tiles along their seams
+                for (int i = offsets[nb_tiles]; i < offsets[nb_tiles + 1]; i++) {
+                    joinEdge(edges[order[i]], es, thresholds.data(), k);
+                }
             }
 
-            void GraphSegmentationImpl::filterSmallAreas(Edge *edges, const int &nb_edges, PointSet *es) {
+            void GraphSegmentationImpl::filterSmallAreas(const std::vector<Edge> &edges, PointSet &es) {
 
-                for ( int i = 0; i < nb_edges; i++) {
+                for (size_t i = 0; i < edges.size(); i++) {
 
                     if (edges[i].weight > 0) {
 
-                        int p_a = es->getBasePoint(edges[i].from);
-                        int p_b = es->getBasePoint(edges[i].to);
+                        int p_a = es.getBasePoint(edges[i].from);
+                        int p_b = es.getBasePoint(edges[i].to);
 
-                        if (p_a != p_b && (es->size(p_a) < min_size || es->size(p_b) < min_size)) {
-                            es->joinPoints(p_a, p_b);
+                        if (p_a != p_b && (es.size(p_a) < min_size || es.size(p_b) < min_size)) {
+                            es.joinPoints(p_a, p_b);
 
                         }
                     }
@@ -265,15 +437,12 @@ namespace cv {
 
             }
 
-            void GraphSegmentationImpl::finalMapping(PointSet *es, Mat &output) {
+            void GraphSegmentationImpl::finalMapping(PointSet &es, Mat &output) {
 
                 int maximum_size = ( int)(output.rows * output.cols);
 
                 int last_id = 0;
-                int * mapped_id = new int[maximum_size];
-
-                for ( int i = 0; i < maximum_size; i++)
-                    mapped_id[i] = -1;
+                std::vector<int> mapped_id(maximum_size, -1);
 
                 int rows = output.rows;
                 int cols = output.cols;
@@ -289,7 +458,7 @@ namespace cv {
 
                     for (int j = 0; j < cols; j++) {
 
-                        int point = es->getBasePoint(i * cols + j);
+                        int point = es.getBasePoint(i * cols + j);
 
                         if (mapped_id[point] == -1) {
                             mapped_id[point] = last_id;
@@ -299,8 +468,6 @@ namespace cv {
                         p[j] = mapped_id[point];
                     }
                 }
-
-                delete [] mapped_id;
             }
 
             void GraphSegmentationImpl::processImage(InputArray src, OutputArray dst) {
@@ -316,25 +483,26 @@ namespace cv {
                 filter(img, img_filtered);
 
                 // Build graph
-                Edge *edges;
-                int nb_edges;
+                std::vector<Edge> edges;
+                buildGraph(edges, img_filtered);
 
-                buildGraph(&edges, nb_edges, img_filtered);
+                // Sort edges
+                sortEdges(edges);
 
                 // Segment graph
-                PointSet *es;
+                PointSet es(img_filtered.cols * img_filtered.rows);
 
-                segmentGraph(edges, nb_edges, img_filtered, &es);
+                if (tile_size > 0 && (img_filtered.rows > tile_size || img_filtered.cols > tile_size)) {
+                    segmentGraphTiled(edges, img_filtered, es);
+                } else {
+                    segmentGraph(edges, img_filtered, es);
+                }
 
                 // Remove small areas
-                filterSmallAreas(edges, nb_edges, es);
+                filterSmallAreas(edges, es);
 
                 // Map to final output
                 finalMapping(es, output);
-
-                delete [] edges;
-                delete es;
-
             }
 
             Ptr<GraphSegmentation> createGraphSegmentation(double sigma, float k, int min_size) {
@@ -351,17 +519,13 @@ namespace cv {
             PointSet::PointSet(int nb_elements_) {
                 nb_elements = nb_elements_;
 
-                mapping = new PointSetElement[nb_elements];
+                mapping.reserve(nb_elements);
 
                 for ( int i = 0; i < nb_elements; i++) {
-                    mapping[i] = PointSetElement(i);
+                    mapping.push_back(PointSetElement(i));
                 }
             }
 
-            PointSet::~PointSet() {
-                delete [] mapping;
-            }
-
             int PointSet::getBasePoint( int p) {
 
                  int base_p = p;
@@ -384,8 +548,6 @@ namespace cv {
 
                 mapping[p_b].p = p_a;
                 mapping[p_a].size += mapping[p_b].size;
-
-                nb_elements--;
             }
 
         }
@@ -35,6 +35,7 @@
  */
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <climits>
 #include <iostream>
 using namespace std;
@@ -59,6 +60,27 @@ void jointBilateralFilter_32f(Mat& joint, Mat& src, Mat& dst, int radius, double
 
 void jointBilateralFilter_8u(Mat& joint, Mat& src, Mat& dst, int radius, double sigmaColor, double sigmaSpace, int borderType);
 
+#if CV_SIMD128
+// Loads the channels of 4 consecutive pixels into separate vectors
+template<int cn> struct LoadPixels4;
+
+template<> struct LoadPixels4<1>
+{
+    static inline void load(const float* p, v_float32x4* v) { v[0] = v_load(p); }
+    static inline void load(const uchar* p, v_int32x4* v) { v[0] = v_reinterpret_as_s32(v_load_expand_q(p)); }
+};
+
+template<> struct LoadPixels4<3>
+{
+    static inline void load(const float* p, v_float32x4* v) { v_load_deinterleave(p, v[0], v[1], v[2]); }
+    static inline void load(const uchar* p, v_int32x4* v)
+    {
+        for (int c = 0; c < 3; c++)
+            v[c] = v_int32x4(p[c], p[c + 3], p[c + 6], p[c + 9]);
+    }
+};
+#endif
+
 template<typename JointVec, typename SrcVec>
 class JointBilateralFilter_32f : public ParallelLoopBody
 {
@@ -86,7 +108,54 @@ public:
     {
         for (int i = radius + range.start; i < radius + range.end; i++)
         {
-            for (int j = radius; j < src.cols - radius; j++)
+            int j = radius;
+#if CV_SIMD128
+            // 4 neighbouring pixels at once, with the same operations as below
+            const int jcn = JointVec::channels, scn = SrcVec::channels;
+            const v_float32x4 v_scale = v_setall_f32(scaleIndex);
+            for (; j <= src.cols - radius - 4; j += 4)
+            {
+                const float *jointCenter = joint.ptr<float>(i) + j*jcn;
+                const float *srcCenter = src.ptr<float>(i) + j*scn;
+                v_float32x4 jointPix0[jcn], jointPix[jcn], srcPix[scn], srcSum[scn];
+                LoadPixels4<jcn>::load(jointCenter, jointPix0);
+                for (int cn = 0; cn < scn; cn++)
+                    srcSum[cn] = v_setzero_f32();
+                v_float32x4 wSum = v_setzero_f32();
+
+                for (int k = 0; k < maxk; k++)
+                {
+                    LoadPixels4<jcn>::load(jointCenter + spaceOfs[k]*jcn, jointPix);
+                    v_float32x4 alpha = v_abs(jointPix0[0] - jointPix[0]);
+                    for (int cn = 1; cn < jcn; cn++)
+                        alpha += v_abs(jointPix0[cn] - jointPix[cn]);
+                    alpha *= v_scale;
+                    v_int32x4 idx = v_trunc(alpha);
+                    alpha -= v_cvt_f32(idx);
+                    v_float32x4 lut0 = v_lut(expLUT, idx), lut1 = v_lut(expLUT + 1, idx);
+                    v_float32x4 weight = v_setall_f32(spaceWeights[k]) * (lut0 + alpha*(lut1 - lut0));
+
+                    LoadPixels4<scn>::load(srcCenter + spaceOfs[k]*scn, srcPix);
+                    for (int cn = 0; cn < scn; cn++)
+                        srcSum[cn] += weight*srcPix[cn];
+                    wSum += weight;
+                }
+
+                float sums[scn][4], wSums[4];
+                for (int cn = 0; cn < scn; cn++)
+                    v_store(sums[cn], srcSum[cn]);
+                v_store(wSums, wSum);
+                SrcVec *dstPix = dst.ptr<SrcVec>(i - radius) + j - radius;
+                for (int p = 0; p < 4; p++)
+                {
+                    SrcVec sum;
+                    for (int cn = 0; cn < scn; cn++)
+                        sum[cn] = sums[cn][p];
+                    dstPix[p] = sum / wSums[p];
+                }
+            }
+#endif
+            for (; j < src.cols - radius; j++)
             {
                 JointVec *jointCenterPixPtr = joint.ptr<JointVec>(i) + j;
                 SrcVec *srcCenterPixPtr = src.ptr<SrcVec>(i) + j;
@@ -235,7 +304,50 @@ public:
 
         for (int i = radius + range.start; i < radius + range.end; i++)
         {
-            for (int j = radius; j < src.cols - radius; j++)
+            int j = radius;
+#if CV_SIMD128
+            // 4 neighbouring pixels at once, with the same operations as below
+            const int jcn = JointVec::channels, scn = SrcVec::channels;
+            for (; j <= src.cols - radius - 4; j += 4)
+            {
+                const uchar *jointCenter = joint.ptr<uchar>(i) + j*jcn;
+                const uchar *srcCenter = src.ptr<uchar>(i) + j*scn;
+                v_int32x4 jointPix0[jcn], jointPix[jcn], srcPix[scn];
+                v_float32x4 srcSum[scn];
+                LoadPixels4<jcn>::load(jointCenter, jointPix0);
+                for (int cn = 0; cn < scn; cn++)
+                    srcSum[cn] = v_setzero_f32();
+                v_float32x4 wSum = v_setzero_f32();
+
+                for (int k = 0; k < maxk; k++)
+                {
+                    LoadPixels4<jcn>::load(jointCenter + spaceOfs[k]*jcn, jointPix);
+                    v_uint32x4 alpha = v_absdiff(jointPix0[0], jointPix[0]);
+                    for (int cn = 1; cn < jcn; cn++)
+                        alpha += v_absdiff(jointPix0[cn], jointPix[cn]);
+                    v_float32x4 weight = v_setall_f32(spaceWeights[k]) * v_lut(expLUT, v_reinterpret_as_s32(alpha));
+
+                    LoadPixels4<scn>::load(srcCenter + spaceOfs[k]*scn, srcPix);
+                    for (int cn = 0; cn < scn; cn++)
+                        srcSum[cn] += weight*v_cvt_f32(srcPix[cn]);
+                    wSum += weight;
+                }
+
+                float sums[scn][4], wSums[4];
+                for (int cn = 0; cn < scn; cn++)
+                    v_store(sums[cn], srcSum[cn]);
+                v_store(wSums, wSum);
+                SrcVec *dstPix = dst.ptr<SrcVec>(i - radius) + j - radius;
+                for (int p = 0; p < 4; p++)
+                {
+                    SrcVecf sum;
+                    for (int cn = 0; cn < scn; cn++)
+                        sum[cn] = sums[cn][p];
+                    dstPix[p] = SrcVec(sum / wSums[p]);
+                }
+            }
+#endif
+            for (; j < src.cols - radius; j++)
             {
                 JointVec *jointCenterPixPtr = joint.ptr<JointVec>(i) + j;
                 SrcVec *srcCenterPixPtr = src.ptr<SrcVec>(i) + j;
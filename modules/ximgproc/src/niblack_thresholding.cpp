@@ -41,11 +41,311 @@
 
 
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 #include <cmath>
 
 namespace cv {
 namespace ximgproc {
 
+namespace {
+
+// Rows per band of the 8-bit implementation. Every band keeps its own sliding window,
+// so the memory used does not depend on the image height.
+enum { NIBLACK_BAND_ROWS = 64 };
+
+template<typename T>
+struct NiblackCoeffs
+{
+    T k, invR, srcMin, invStddevMax, zero, one;
+};
+
+static inline float niblackSqrt(float x) { return std::sqrt(x); }
+static inline float niblackMax(float a, float b) { return std::max(a, b); }
+#if CV_SIMD128
+static inline v_float32x4 niblackSqrt(const v_float32x4& x) { return v_sqrt(x); }
+static inline v_float32x4 niblackMax(const v_float32x4& a, const v_float32x4& b) { return v_max(a, b); }
+#endif
+
+// Local threshold from the local mean and mean of squares
+template<int method, typename T>
+static inline T niblackThresholdValue(const T& mean, const T& sqmean, const NiblackCoeffs<T>& c)
+{
+    T variance = niblackMax(sqmean - mean * mean, c.zero);
+    switch (method)
+    {
+    case BINARIZATION_NIBLACK:
+        return mean + niblackSqrt(variance) * c.k;
+    case BINARIZATION_SAUVOLA:
+        return mean * (c.one + c.k * (niblackSqrt(variance) * c.invR - c.one));
+    case BINARIZATION_WOLF:
+    {
+        T a = mean - c.srcMin;
+        return mean - c.k * (a - niblackSqrt(variance) * a * c.invStddevMax);
+    }
+    default: // BINARIZATION_NICK
+        return mean + c.k * niblackSqrt(variance + sqmean);
+    }
+}
+
+// Sliding window sums of an 8-bit image over blockSize x blockSize neighbourhoods,
+// with replicated borders. The column sums are kept for the rows of the current window only.
+class LocalStats8u
+{
+public:
+    LocalStats8u(const Mat& _src, int blockSize)
+        : src(_src), radius(blockSize / 2), y(0),
+          scale(1. / ((double)blockSize * blockSize)),
+          colSum(_src.cols), colSqSum(_src.cols), zeros(_src.cols)
+    {
+        memset(zeros.data(), 0, src.cols);
+    }
+
+    // Places the window at row y0
+    void start(int y0)
+    {
+        y = y0;
+        memset(colSum.data(), 0, src.cols * sizeof(int));
+        memset(colSqSum.data(), 0, src.cols * sizeof(int));
+        for (int i = y - radius; i <= y + radius; i++)
+            updateColumns(rowPtr(i), zeros.data());
+    }
+
+    // Moves the window one row down
+    void next()
+    {
+        y++;
+        updateColumns(rowPtr(y + radius), rowPtr(y - radius - 1));
+    }
+
+    // Local mean and mean of squares along the current row
+    void row(float* mean, float* sqmean) const
+    {
+        const int cols = src.cols;
+        const int* cs = colSum.data();
+        const int* csq = colSqSum.data();
+        int s = 0;
+        int64 sq = 0;
+        for (int j = -radius; j <= radius; j++)
+        {
+            int c = std::min(std::max(j, 0), cols - 1);
+            s += cs[c];
+            sq += csq[c];
+        }
+        for (int x = 0; x < cols; x++)
+        {
+            mean[x] = (float)(s * scale);
+            sqmean[x] = (float)(sq * scale);
+            int xa = std::min(x + radius + 1, cols - 1), xr = std::max(x - radius, 0);
+            s += cs[xa] - cs[xr];
+            sq += csq[xa] - csq[xr];
+        }
+    }
+
+private:
+    const uchar* rowPtr(int i) const
+    {
+        return src.ptr<uchar>(std::min(std::max(i, 0), src.rows - 1));
+    }
+
+    // Adds row "add" and removes row "sub" from the column sums
+    void updateColumns(const uchar* add, const uchar* sub)
+    {
+        int* cs = colSum.data();
+        int* csq = colSqSum.data();
+        int j = 0;
+#if CV_SIMD128
+        for (; j <= src.cols - v_uint8x16::nlanes; j += v_uint8x16::nlanes)
+        {
+            v_uint16x8 a[2], b[2];
+            v_expand(v_load(add + j), a[0], a[1]);
+            v_expand(v_load(sub + j), b[0], b[1]);
+            for (int h = 0; h < 2; h++)
+            {
+                // a^2 - b^2 = (a - b) * (a + b)
+                v_int16x8 d = v_reinterpret_as_s16(a[h]) - v_reinterpret_as_s16(b[h]);
+                v_int16x8 e = v_reinterpret_as_s16(a[h] + b[h]);
+                v_int32x4 d0, d1, q0, q1;
+                v_expand(d, d0, d1);
+                v_mul_expand(d, e, q0, q1);
+                int* p = cs + j + h * 8;
+                int* q = csq + j + h * 8;
+                v_store(p, v_load(p) + d0);
+                v_store(p + 4, v_load(p + 4) + d1);
+                v_store(q, v_load(q) + q0);
+                v_store(q + 4, v_load(q + 4) + q1);
+            }
+        }
+#endif
+        for (; j < src.cols; j++)
+        {
+            int a = add[j], b = sub[j];
+            cs[j] += a - b;
+            csq[j] += a * a - b * b;
+        }
+    }
+
+    const Mat& src;
+    int radius, y;
+    double scale;
+    AutoBuffer<int> colSum, colSqSum;
+    AutoBuffer<uchar> zeros;
+};
+
+// Calls op(y, mean, sqmean, rowBuf) for every row of an 8-bit image, bands of rows being processed
+// in parallel. rowBuf is a scratch row of src.cols bytes.
+template<typename RowOp>
+static void forEachLocalStatsRow(const Mat& src, int blockSize, const RowOp& op)
+{
+    const int bandRows = std::max((int)NIBLACK_BAND_ROWS, blockSize);
+    const int nbands = (src.rows + bandRows - 1) / bandRows;
+    parallel_for_(Range(0, nbands), [&](const Range& range)
+    {
+        LocalStats8u stats(src, blockSize);
+        AutoBuffer<float> buf(src.cols * 2);
+        AutoBuffer<uchar> rowBuf(src.cols);
+        float* mean = buf.data();
+        float* sqmean = mean + src.cols;
+        for (int b = range.start; b < range.end; b++)
+        {
+            int y0 = b * bandRows, y1 = std::min(y0 + bandRows, src.rows);
+            stats.start(y0);
+            for (int y = y0; y < y1; y++)
+            {
+                if (y > y0)
+                    stats.next();
+                stats.row(mean, sqmean);
+                op(y, mean, sqmean, rowBuf.data());
+            }
+        }
+    }, nbands);
+}
+
+template<int method>
+static void niblackThresholdRow(const float* mean, const float* sqmean, uchar* thresh, int cols,
+                                const NiblackCoeffs<float>& c)
+{
+    int j = 0;
+#if CV_SIMD128
+    NiblackCoeffs<v_float32x4> vc;
+    vc.k = v_setall_f32(c.k);
+    vc.invR = v_setall_f32(c.invR);
+    vc.srcMin = v_setall_f32(c.srcMin);
+    vc.invStddevMax = v_setall_f32(c.invStddevMax);
+    vc.zero = v_setzero_f32();
+    vc.one = v_setall_f32(1.f);
+    for (; j <= cols - v_uint8x16::nlanes; j += v_uint8x16::nlanes)
+    {
+        v_int32x4 t[4];
+        for (int h = 0; h < 4; h++)
+            t[h] = v_round(niblackThresholdValue<method>(v_load(mean + j + h * 4),
+                                                         v_load(sqmean + j + h * 4), vc));
+        v_store(thresh + j, v_pack_u(v_pack(t[0], t[1]), v_pack(t[2], t[3])));
+    }
+#endif
+    for (; j < cols; j++)
+        thresh[j] = saturate_cast<uchar>(niblackThresholdValue<method>(mean[j], sqmean[j], c));
+}
+
+static void applyThresholdRow(const uchar* src, const uchar* thresh, uchar* dst, int cols,
+                              int type, uchar maxVal)
+{
+    int j = 0;
+#if CV_SIMD128
+    const v_uint8x16 vmax = v_setall_u8(maxVal);
+    for (; j <= cols - v_uint8x16::nlanes; j += v_uint8x16::nlanes)
+    {
+        v_uint8x16 s = v_load(src + j), t = v_load(thresh + j);
+        v_uint8x16 gt = s > t, d;
+        switch (type)
+        {
+        case THRESH_BINARY:     d = gt & vmax; break;
+        case THRESH_BINARY_INV: d = v_andnot(vmax, gt); break;
+        case THRESH_TRUNC:      d = v_min(s, t); break;
+        case THRESH_TOZERO:     d = gt & s; break;
+        default:                d = v_andnot(s, gt); break; // THRESH_TOZERO_INV
+        }
+        v_store(dst + j, d);
+    }
+#endif
+    for (; j < cols; j++)
+    {
+        uchar s = src[j], t = thresh[j];
+        switch (type)
+        {
+        case THRESH_BINARY:     dst[j] = s > t ? maxVal : 0; break;
+        case THRESH_BINARY_INV: dst[j] = s > t ? 0 : maxVal; break;
+        case THRESH_TRUNC:      dst[j] = std::min(s, t); break;
+        case THRESH_TOZERO:     dst[j] = s > t ? s : 0; break;
+        default:                dst[j] = s > t ? 0 : s; break; // THRESH_TOZERO_INV
+        }
+    }
+}
+
+template<int method>
+static void niBlackThreshold8u(const Mat& src, Mat& dst, uchar maxVal, int type, int blockSize,
+                               const NiblackCoeffs<float>& c)
+{
+    forEachLocalStatsRow(src, blockSize, [&](int y, const float* mean, const float* sqmean, uchar* thresh)
+    {
+        niblackThresholdRow<method>(mean, sqmean, thresh, src.cols, c);
+        applyThresholdRow(src.ptr<uchar>(y), thresh, dst.ptr<uchar>(y), src.cols, type, maxVal);
+    });
+}
+
+// Fused implementation for 8-bit images: the local statistics, the threshold and its
+// application are computed row by row, without any intermediate image
+static void niBlackThreshold8u(const Mat& src, Mat& dst, double maxValue, int type, int blockSize,
+                               double k, int binarizationMethod, double r)
+{
+    CV_Assert(!src.empty());
+    NiblackCoeffs<float> c;
+    c.k = static_cast<float>(k);
+    c.invR = binarizationMethod == BINARIZATION_SAUVOLA ? static_cast<float>(1. / r) : 0.f;
+    c.srcMin = 0.f;
+    c.invStddevMax = 0.f;
+    c.zero = 0.f;
+    c.one = 1.f;
+    uchar maxVal = saturate_cast<uchar>(maxValue);
+
+    switch (binarizationMethod)
+    {
+    case BINARIZATION_NIBLACK:
+        niBlackThreshold8u<BINARIZATION_NIBLACK>(src, dst, maxVal, type, blockSize, c);
+        break;
+    case BINARIZATION_SAUVOLA:
+        niBlackThreshold8u<BINARIZATION_SAUVOLA>(src, dst, maxVal, type, blockSize, c);
+        break;
+    case BINARIZATION_WOLF:
+    {
+        // Wolf's method needs the global maximum of the local standard deviation:
+        // a first sweep collects it row by row
+        double srcMin;
+        minMaxIdx(src, &srcMin);
+        std::vector<float> rowStddevMax(src.rows);
+        forEachLocalStatsRow(src, blockSize, [&](int y, const float* mean, const float* sqmean, uchar*)
+        {
+            float m = 0.f;
+            for (int x = 0; x < src.cols; x++)
+                m = std::max(m, sqmean[x] - mean[x] * mean[x]);
+            rowStddevMax[y] = std::sqrt(m);
+        });
+        float stddevMax = *std::max_element(rowStddevMax.begin(), rowStddevMax.end());
+        c.srcMin = static_cast<float>(srcMin);
+        c.invStddevMax = 1.f / stddevMax;
+        niBlackThreshold8u<BINARIZATION_WOLF>(src, dst, maxVal, type, blockSize, c);
+        break;
+    }
+    case BINARIZATION_NICK:
+        niBlackThreshold8u<BINARIZATION_NICK>(src, dst, maxVal, type, blockSize, c);
+        break;
+    default:
+        CV_Error(CV_StsBadArg, "Unknown binarization method");
+        break;
+    }
+}
+
+} // namespace
+
 void niBlackThreshold( InputArray _src, OutputArray _dst, double maxValue,
         int type, int blockSize, double k, int binarizationMethod, double r)
 {
@@ -58,6 +358,18 @@ void niBlackThreshold( InputArray _src, OutputArray _dst, double maxValue,
         CV_Assert(r != 0);
     }
     type &= THRESH_MASK;
+    if (type != THRESH_BINARY && type != THRESH_BINARY_INV && type != THRESH_TRUNC &&
+        type != THRESH_TOZERO && type != THRESH_TOZERO_INV)
+        CV_Error( CV_StsBadArg, "Unknown threshold type" );
+
+    if (src.depth() == CV_8U)
+    {
+        _dst.create(src.size(), src.type());
+        Mat dst = _dst.getMat();
+        CV_Assert(src.data != dst.data);  // no inplace processing
+        niBlackThreshold8u(src, dst, maxValue, type, blockSize, k, binarizationMethod, r);
+        return;
+    }
 
     // Compute local threshold (T = mean + k * stddev)
     // using mean and standard deviation in the neighborhood of each pixel
@@ -69,8 +69,12 @@ namespace ximgproc
 
         if (srcCnNum == 1 || srcCnNum == 3)
         {
+            // ping-pong between two guidance buffers, so that no iteration has to copy its guidance
+            // or allocate a new result
+            Mat next(src.size(), src.type());
             while(numOfIter--){
-                jointBilateralFilter(guidance, src, guidance, d, sigmaColor, sigmaSpace, borderType);
+                jointBilateralFilter(guidance, src, next, d, sigmaColor, sigmaSpace, borderType);
+                std::swap(guidance, next);
             }
             guidance.copyTo(dst_);
         }
@@ -54,6 +54,37 @@ struct rlType
 
 typedef std::vector<rlType> rlVec;
 
+// Number of rows processed by a single task of the parallel operations
+enum { RL_BAND_ROWS = 32 };
+
+// Calls bandOp(rowBegin, rowEnd, bandRuns) for bands of the rows [rowBegin, rowEnd) in parallel and
+// concatenates the runs produced by the bands. Every band produces the runs of its own rows only,
+// so the result is sorted whenever the bands produce sorted runs.
+template <class BandOp>
+static void forEachRowBand(int rowBegin, int rowEnd, rlVec& res, const BandOp& bandOp)
+{
+    res.clear();
+    if (rowEnd <= rowBegin)
+        return;
+    int nBands = (rowEnd - rowBegin + RL_BAND_ROWS - 1) / RL_BAND_ROWS;
+    std::vector<rlVec> bandRuns(nBands);
+    parallel_for_(Range(0, nBands), [&](const Range& range)
+    {
+        for (int b = range.start; b < range.end; ++b)
+        {
+            int r0 = rowBegin + b * RL_BAND_ROWS;
+            bandOp(r0, std::min(r0 + RL_BAND_ROWS, rowEnd), bandRuns[b]);
+        }
+    });
+
+    size_t nRuns = 0;
+    for (int b = 0; b < nBands; ++b)
+        nRuns += bandRuns[b].size();
+    res.reserve(nRuns);
+    for (int b = 0; b < nBands; ++b)
+        res.insert(res.end(), bandRuns[b].begin(), bandRuns[b].end());
+}
+
 template <class T>
 void _thresholdLine(T* pData, int nWidth, int nRow, T threshold, int type, rlVec& res)
 {
@@ -83,41 +114,47 @@ void _thresholdLine(T* pData, int nWidth, int nRow, T threshold, int type, rlVec
   }
 }
 
-static void _threshold(cv::Mat& img, rlVec& res, double threshold, int type)
+template <class T>
+static void _thresholdRows(const cv::Mat& img, int rowBegin, int rowEnd, T threshold, int type, rlVec& res)
 {
   res.clear();
+  for (int i = rowBegin; i < rowEnd; ++i)
+    _thresholdLine<T>((T*) img.ptr(i), img.cols, i, threshold, type, res);
+}
+
+template <class T>
+static void _thresholdParallel(const cv::Mat& img, rlVec& res, T threshold, int type)
+{
+  forEachRowBand(0, img.rows, res, [&](int rowBegin, int rowEnd, rlVec& bandRuns)
+  {
+    _thresholdRows<T>(img, rowBegin, rowEnd, threshold, type, bandRuns);
+  });
+}
+
+static void _threshold(cv::Mat& img, rlVec& res, double threshold, int type)
+{
   switch (img.depth())
   {
   case CV_8U:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<uchar>(img.ptr(i), img.cols, i, (uchar) threshold, type, res);
+    _thresholdParallel<uchar>(img, res, (uchar) threshold, type);
     break;
   case CV_8S:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<schar>((schar*) img.ptr(i), img.cols, i, (schar) threshold, type, res);
+    _thresholdParallel<schar>(img, res, (schar) threshold, type);
     break;
   case CV_16U:
-      for (int i = 0; i < img.rows; ++i)
-      {
-          _thresholdLine<unsigned short>((unsigned short*)img.ptr(i), img.cols, i,
-              (unsigned short)threshold, type, res);
-      }
+    _thresholdParallel<unsigned short>(img, res, (unsigned short) threshold, type);
     break;
   case CV_16S:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<short>((short*) img.ptr(i), img.cols, i, (short) threshold, type, res);
+    _thresholdParallel<short>(img, res, (short) threshold, type);
     break;
   case CV_32S:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<int>((int*) img.ptr(i), img.cols, i, (int) threshold, type, res);
+    _thresholdParallel<int>(img, res, (int) threshold, type);
     break;
   case CV_32F:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<float>((float*) img.ptr(i), img.cols, i, (float) threshold, type, res);
+    _thresholdParallel<float>(img, res, (float) threshold, type);
     break;
   case CV_64F:
-    for (int i = 0; i < img.rows; ++i)
-      _thresholdLine<double>((double*) img.ptr(i), img.cols, i, threshold, type, res);
+    _thresholdParallel<double>(img, res, threshold, type);
     break;
   default:
     CV_Error( CV_StsUnsupportedFormat, "unsupported image type" );
@@ -237,56 +274,20 @@ CV_EXPORTS Mat getStructuringElement(int shape, Size ksize)
   return rlDest;
 }
 
-static void erode_rle (rlVec& regIn, rlVec& regOut, rlVec& se)
+// Computes the result rows [rowBegin, rowEnd) of erode_rle
+static void erodeRows(const rlVec& regIn, const rlVec& se, const std::vector<int>& pIdxChord1,
+    const std::vector<int>& pIdxNextRow, int nMinRow, int rowBegin, int rowEnd, rlVec& regOut)
 {
-  using namespace std;
+    using namespace std;
 
     regOut.clear();
-
-    if (regIn.size() == 0)
-        return;
-
-    int nMinRow = regIn[0].r;
-    int nMaxRow = regIn.back().r;
-
-    int nRows = nMaxRow - nMinRow + 1;
-
-
-    const int EMPTY = -1;
-
-    // setup a table which holds the index of the first chord for each row
-    vector<int> pIdxChord1(nRows);
-    vector<int> pIdxNextRow(nRows);
-
-    int i,j;
-
-    for (i=1;i<nRows;i++)
-    {
-        pIdxChord1[i] = EMPTY;
-        pIdxNextRow[i] = EMPTY;
-    }
-
-    pIdxChord1[0] = 0;
-    pIdxNextRow[nRows-1] = (int) regIn.size();
-
-    for (i=1; i < (int) regIn.size();i++)
-        if (regIn[i].r != regIn[i-1].r)
-        {
-            pIdxChord1[regIn[i].r - nMinRow] = i;
-            pIdxNextRow[regIn[i-1].r - nMinRow] = i;
-        }
-
     int nMinRowSE = se[0].r;
-    int nMaxRowSE = se.back().r;
-
-    int nRowsSE = nMaxRowSE - nMinRowSE + 1;
-
-    assert(nRowsSE == (int) se.size());
-
+    int nRowsSE = (int) se.size();
     vector<int> pCurIdxRow(nRowsSE);
+    int i, j;
 
     // loop through all possible rows
-    for (i=nMinRow - nMinRowSE; i<= nMaxRow - nMaxRowSE; i++)
+    for (i=rowBegin; i<rowEnd; i++)
     {
         // check whether all relevant rows are available
         bool bNextRow = false;
@@ -361,7 +362,60 @@ static void erode_rle (rlVec& regIn, rlVec& regOut, rlVec& se)
         }
         } // end while (!bNextRow
     } // end for
+}
+
+static void erode_rle (rlVec& regIn, rlVec& regOut, rlVec& se)
+{
+  using namespace std;
 
+    regOut.clear();
+
+    if (regIn.size() == 0)
+        return;
+
+    int nMinRow = regIn[0].r;
+    int nMaxRow = regIn.back().r;
+
+    int nRows = nMaxRow - nMinRow + 1;
+
+
+    const int EMPTY = -1;
+
+    // setup a table which holds the index of the first chord for each row
+    vector<int> pIdxChord1(nRows);
+    vector<int> pIdxNextRow(nRows);
+
+    int i;
+
+    for (i=1;i<nRows;i++)
+    {
+        pIdxChord1[i] = EMPTY;
+        pIdxNextRow[i] = EMPTY;
+    }
+
+    pIdxChord1[0] = 0;
+    pIdxNextRow[nRows-1] = (int) regIn.size();
+
+    for (i=1; i < (int) regIn.size();i++)
+        if (regIn[i].r != regIn[i-1].r)
+        {
+            pIdxChord1[regIn[i].r - nMinRow] = i;
+            pIdxNextRow[regIn[i-1].r - nMinRow] = i;
+        }
+
+    int nMinRowSE = se[0].r;
+    int nMaxRowSE = se.back().r;
+
+    int nRowsSE = nMaxRowSE - nMinRowSE + 1;
+
+    CV_Assert(nRowsSE == (int) se.size());
+
+    // the result rows are independent of each other
+    forEachRowBand(nMinRow - nMinRowSE, nMaxRow - nMaxRowSE + 1, regOut,
+        [&](int rowBegin, int rowEnd, rlVec& bandRuns)
+    {
+        erodeRows(regIn, se, pIdxChord1, pIdxNextRow, nMinRow, rowBegin, rowEnd, bandRuns);
+    });
 }
 
 static void convertInputArrayToRuns(InputArray& theArray, rlVec& runs, Size& theSize)
@@ -807,6 +861,144 @@ CV_EXPORTS void morphologyEx(InputArray rlSrc, OutputArray rlDest, int op, Input
     }
 }
 
+static int findRoot(std::vector<int>& parent, int i)
+{
+    while (parent[i] != i)
+    {
+        parent[i] = parent[parent[i]];
+        i = parent[i];
+    }
+    return i;
+}
+
+// The root of a component is its first run in raster order
+static void unite(std::vector<int>& parent, int i, int j)
+{
+    i = findRoot(parent, i);
+    j = findRoot(parent, j);
+    if (i < j)
+        parent[j] = i;
+    else if (j < i)
+        parent[i] = j;
+}
+
+// Joins the touching runs of two consecutive rows [a0, a1) and [b0, b1)
+static void linkRows(const rlVec& runs, int a0, int a1, int b0, int b1, int nGap, std::vector<int>& parent)
+{
+    int i = a0, j = b0;
+    while (i < a1 && j < b1)
+    {
+        if (runs[i].ce + nGap < runs[j].cb)
+            ++i;
+        else if (runs[j].ce + nGap < runs[i].cb)
+            ++j;
+        else
+        {
+            unite(parent, i, j);
+            if (runs[i].ce < runs[j].ce)
+                ++i;
+            else
+                ++j;
+        }
+    }
+}
+
+CV_EXPORTS int connectedComponentsWithStats(InputArray rlSrc, OutputArray labels, OutputArray stats,
+    int connectivity)
+{
+    CV_INSTRUMENT_REGION();
+    CV_Assert(connectivity == 8 || connectivity == 4);
+
+    rlVec runs;
+    Size size;
+    convertInputArrayToRuns(rlSrc, runs, size);
+    int nRuns = (int) runs.size();
+    int nGap = (connectivity == 8) ? 1 : 0;
+
+    // first run of every row holding runs
+    std::vector<int> rowStart;
+    for (int i = 0; i < nRuns; ++i)
+    {
+        CV_Assert(i == 0 || runs[i - 1].r < runs[i].r || (runs[i - 1].r == runs[i].r && runs[i - 1].ce < runs[i].cb));
+        if (i == 0 || runs[i].r != runs[i - 1].r)
+            rowStart.push_back(i);
+    }
+    int nRows = (int) rowStart.size();
+    rowStart.push_back(nRuns);
+
+    // bands of rows are linked in parallel, every band only touches the parents of its own runs,
+    // then the rows at the band boundaries are linked
+    std::vector<int> parent(nRuns);
+    int nBands = (nRows + RL_BAND_ROWS - 1) / RL_BAND_ROWS;
+    parallel_for_(Range(0, nBands), [&](const Range& range)
+    {
+        for (int b = range.start; b < range.end; ++b)
+        {
+            int k0 = b * RL_BAND_ROWS, k1 = std::min(k0 + RL_BAND_ROWS, nRows);
+            for (int i = rowStart[k0]; i < rowStart[k1]; ++i)
+            {
+                parent[i] = i;
+                // runs of the same row may touch when they were not merged
+                if (i > rowStart[k0] && runs[i].r == runs[i - 1].r && runs[i].cb == runs[i - 1].ce + 1)
+                    unite(parent, i - 1, i);
+            }
+            for (int k = k0 + 1; k < k1; ++k)
+            {
+                if (runs[rowStart[k]].r == runs[rowStart[k - 1]].r + 1)
+                    linkRows(runs, rowStart[k - 1], rowStart[k], rowStart[k], rowStart[k + 1], nGap, parent);
+            }
+        }
+    });
+    for (int b = 1; b < nBands; ++b)
+    {
+        int k = b * RL_BAND_ROWS;
+        if (runs[rowStart[k]].r == runs[rowStart[k - 1]].r + 1)
+            linkRows(runs, rowStart[k - 1], rowStart[k], rowStart[k], rowStart[k + 1], nGap, parent);
+    }
+
+    // components are numbered in the raster order of their first run
+    Mat labelsMat(nRuns, 1, CV_32S);
+    int* pLabels = labelsMat.ptr<int>();
+    int nLabels = 0;
+    for (int i = 0; i < nRuns; ++i)
+    {
+        int root = findRoot(parent, i);
+        pLabels[i] = (root == i) ? nLabels++ : pLabels[root];
+    }
+
+    Mat statsMat(nLabels, CC_STAT_MAX, CV_32S);
+    for (int l = 0; l < nLabels; ++l)
+    {
+        int* st = statsMat.ptr<int>(l);
+        st[CC_STAT_LEFT] = std::numeric_limits<int>::max();
+        st[CC_STAT_TOP] = std::numeric_limits<int>::max();
+        st[CC_STAT_WIDTH] = std::numeric_limits<int>::min();
+        st[CC_STAT_HEIGHT] = std::numeric_limits<int>::min();
+        st[CC_STAT_AREA] = 0;
+    }
+    // width and height hold the right and bottom coordinates until the end
+    for (int i = 0; i < nRuns; ++i)
+    {
+        const rlType& run = runs[i];
+        int* st = statsMat.ptr<int>(pLabels[i]);
+        st[CC_STAT_LEFT] = std::min(st[CC_STAT_LEFT], run.cb);
+        st[CC_STAT_TOP] = std::min(st[CC_STAT_TOP], run.r);
+        st[CC_STAT_WIDTH] = std::max(st[CC_STAT_WIDTH], run.ce);
+        st[CC_STAT_HEIGHT] = std::max(st[CC_STAT_HEIGHT], run.r);
+        st[CC_STAT_AREA] += run.ce - run.cb + 1;
+    }
+    for (int l = 0; l < nLabels; ++l)
+    {
+        int* st = statsMat.ptr<int>(l);
+        st[CC_STAT_WIDTH] = st[CC_STAT_WIDTH] - st[CC_STAT_LEFT] + 1;
+        st[CC_STAT_HEIGHT] = st[CC_STAT_HEIGHT] - st[CC_STAT_TOP] + 1;
+    }
+
+    labelsMat.copyTo(labels);
+    statsMat.copyTo(stats);
+    return nLabels;
+}
+
 }
 } //end of cv::ximgproc
 } //end of cv
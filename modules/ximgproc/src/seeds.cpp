@@ -61,6 +61,13 @@ using namespace std;
 
 #define MINIMUM_NR_SUBLABELS 1
 
+// height (width) of the bands of rows (columns) updated concurrently by the pixel updates,
+// must be at least 2 so that bands of the same parity never touch each other
+#define PIXEL_UPDATE_BAND 16
+
+// same for the block updates, in rows (columns) of blocks
+#define BLOCK_UPDATE_BAND 4
+
 
 // the type of the histogram and the T array
 typedef float HISTN;
@@ -98,17 +105,40 @@ private:
 
 
     /* pixel operations */
+    // Changes of the top level histograms made by the pixel or block updates of one band.
+    // The shared histograms are not modified while the bands are processed, each band
+    // sees them plus its own changes. The changes are merged once all bands are done.
+    struct HistogramDelta
+    {
+        vector<HISTN> histogram; //[label * histogram_size_aligned + j]
+        vector<HISTN> T; //[label]
+        vector<Vec3i> updates; // (image_idx or sublabel, label_old, label_new) in the order of updating
+
+        // block updates only
+        vector<int> nr_partitions; //[label]
+        vector<uchar> touched; //[label] whether the histogram of label has changed
+        Mat merged; // 2 top level histograms plus their changes, see deltaHistogram
+    };
+
+    void initHistogramDelta(HistogramDelta& delta);
+
     inline void update(int label_new, int image_idx, int label_old);
+    inline void update(HistogramDelta& delta, int label_new, int image_idx, int label_old);
     //image_idx = y*width+x
     inline void addPixel(int level, int label, int image_idx);
     inline void deletePixel(int level, int label, int image_idx);
-    inline bool probability(int image_idx, int label1, int label2, int prior1, int prior2);
+    inline bool probability(const HistogramDelta& delta, int image_idx, int label1, int label2,
+            int prior1, int prior2);
     inline int threebyfour(int x, int y, int label);
     inline int fourbythree(int x, int y, int label);
 
     inline void updateLabels();
     // main loop for pixel updating
     void updatePixels();
+    // pixel updates of rows [y0, y1) and columns [x0, x1)
+    void updatePixelsHorizontal(int y0, int y1, HistogramDelta& delta);
+    void updatePixelsVertical(int x0, int x1, HistogramDelta& delta);
+    void mergeHistogramDelta(HistogramDelta& delta, vector<Vec3i>& updates);
 
 
     /* block operations */
@@ -116,12 +146,25 @@ private:
     inline void addBlockToplevel(int label, int sublevel, int sublabel);
     void deleteBlockToplevel(int label, int sublevel, int sublabel);
 
-    // intersection on label1A and intersection_delete on label1B
+    // intersection on h1A and intersection_delete on h1B
     // returns intA - intB
-    float intersectConf(int level1, int label1A, int label1B, int level2, int label2);
+    float intersectConf(const HISTN* h1A, const HISTN* h1B, const HISTN* h2,
+            float count1A, float count1B, float count2);
+    // same on the top level labels label1A and label1B, with the changes of the delta
+    float intersectConf(HistogramDelta& delta, int label1A, int label1B, int level2, int label2);
+    const HISTN* deltaHistogram(HistogramDelta& delta, int label, int slot);
+    inline int nrPartitions(const HistogramDelta& delta, int label) const {
+        return (int)nr_partitions[label] + delta.nr_partitions[label];
+    }
+    // move the block (level, sublabel) from label_old to label_new, recording the change in the delta
+    void updateBlock(HistogramDelta& delta, int level, int label_new, int sublabel, int label_old);
+    void mergeBlockDelta(HistogramDelta& delta, vector<Vec3i>& updates);
 
     //main loop for block updates
     void updateBlocks(int level, float req_confidence = 0.0f);
+    // block updates of block rows [y0, y1) and block columns [x0, x1)
+    void updateBlocksHorizontal(int level, float req_confidence, int y0, int y1, HistogramDelta& delta);
+    void updateBlocksVertical(int level, float req_confidence, int x0, int x1, HistogramDelta& delta);
 
     /* go to next block level */
     int goDownOneLevel();
@@ -339,17 +382,20 @@ void SuperpixelSEEDSImpl::initImageBins(const Mat& img, int max_value)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const _Tp* ptr = img.ptr<_Tp>(y, x);
-            int bin = 0;
-            for (int i = 0; i < channels; ++i)
-                bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
-            image_bins[y * img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const _Tp* ptr = img.ptr<_Tp>(y, x);
+                int bin = 0;
+                for (int i = 0; i < channels; ++i)
+                    bin = bin * nr_bins + (int) ptr[i] * nr_bins / max_value;
+                image_bins[y * img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 /* specialization for float: max_value is assumed to be 1.0f */
@@ -360,17 +406,20 @@ void SuperpixelSEEDSImpl::initImageBins<float>(const Mat& img, int)
     int img_height = img.size().height;
     int channels = img.channels();
 
-    for (int y = 0; y < img_height; ++y)
+    parallel_for_(Range(0, img_height), [&](const Range& range)
     {
-        for (int x = 0; x < img_width; ++x)
+        for (int y = range.start; y < range.end; ++y)
         {
-            const float* ptr = img.ptr<float>(y, x);
-            int bin = 0;
-            for(int i=0; i<channels; ++i)
-                bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
-            image_bins[y*img_width + x] = bin;
+            for (int x = 0; x < img_width; ++x)
+            {
+                const float* ptr = img.ptr<float>(y, x);
+                int bin = 0;
+                for(int i=0; i<channels; ++i)
+                    bin = bin * nr_bins + std::min((int)(ptr[i] * (float)nr_bins), nr_bins-1);
+                image_bins[y*img_width + x] = bin;
+            }
         }
-    }
+    });
 }
 
 void SuperpixelSEEDSImpl::initImage(InputArray img)
@@ -472,6 +521,55 @@ void SuperpixelSEEDSImpl::computeHistograms(int until_level)
 }
 
 void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
+{
+    // Bands of block rows (then block columns) are updated in two passes like the pixel
+    // updates: first the even bands then the odd ones, see updatePixels.
+    const int nr_row_bands = std::max(nr_wh[2 * level + 1] - 2 + BLOCK_UPDATE_BAND - 1, 0) / BLOCK_UPDATE_BAND;
+    const int nr_col_bands = std::max(nr_wh[2 * level] - 2 + BLOCK_UPDATE_BAND - 1, 0) / BLOCK_UPDATE_BAND;
+    TLSData<HistogramDelta> deltas;
+    vector<vector<Vec3i> > band_updates(std::max(nr_row_bands, nr_col_bands));
+
+    for (int vertical = 0; vertical < 2; vertical++)
+    {
+        const int nr_bands = vertical ? nr_col_bands : nr_row_bands;
+        const int end = vertical ? nr_wh[2 * level] - 1 : nr_wh[2 * level + 1] - 1;
+        for (int parity = 0; parity < 2; parity++)
+        {
+            if( nr_bands <= parity )
+                continue;
+
+            parallel_for_(Range(0, (nr_bands - parity + 1) / 2), [&](const Range& range)
+            {
+                HistogramDelta& delta = *deltas.get();
+                initHistogramDelta(delta);
+                for (int i = range.start; i < range.end; i++)
+                {
+                    const int band = 2 * i + parity;
+                    const int start = 1 + band * BLOCK_UPDATE_BAND;
+                    const int stop = std::min(start + BLOCK_UPDATE_BAND, end);
+                    if( vertical )
+                        updateBlocksVertical(level, req_confidence, start, stop, delta);
+                    else
+                        updateBlocksHorizontal(level, req_confidence, start, stop, delta);
+                    mergeBlockDelta(delta, band_updates[band]);
+                }
+            });
+
+            for (int band = parity; band < nr_bands; band += 2)
+            {
+                const vector<Vec3i>& updates = band_updates[band];
+                for (size_t k = 0; k < updates.size(); k++)
+                {
+                    deleteBlockToplevel(updates[k][1], level, updates[k][0]);
+                    addBlockToplevel(updates[k][2], level, updates[k][0]);
+                }
+            }
+        }
+    }
+}
+
+void SuperpixelSEEDSImpl::updateBlocksHorizontal(int level, float req_confidence, int y0, int y1,
+        HistogramDelta& delta)
 {
     int labelA;
     int labelB;
@@ -480,7 +578,7 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
     int step = nr_wh[2 * level];
 
     // horizontal bidirectional block updating
-    for (int y = 1; y < nr_wh[2 * level + 1] - 1; y++)
+    for (int y = y0; y < y1; y++)
     {
         for (int x = 1; x < nr_wh[2 * level] - 2; x++)
         {
@@ -503,20 +601,21 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
             int a32 = parent[level][(y + 1) * step + (x)];
             done = false;
 
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+            int partitionsA = nrPartitions(delta, labelA);
+            if( partitionsA == 2 || (partitionsA > 2 // 3 or more partitions
                     && checkSplit_hf(a11, a12, a21, a22, a31, a32)) )
             {
                 // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+                float conf = intersectConf(delta, labelB, labelA, level, sublabel);
                 if( conf > req_confidence )
                 {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
+                    updateBlock(delta, level, labelB, sublabel, labelA);
                     done = true;
                 }
             }
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+            int partitionsB = nrPartitions(delta, labelB);
+            if( !done && (partitionsB > MINIMUM_NR_SUBLABELS) )
             {
                 // try opposite direction
                 sublabel = y * step + x + 1;
@@ -526,24 +625,33 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
                 int a24 = parent[level][(y) * step + (x + 2)];
                 int a33 = parent[level][(y + 1) * step + (x + 1)];
                 int a34 = parent[level][(y + 1) * step + (x + 2)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
+                if( partitionsB <= 2 // == 2
+                        || (partitionsB > 2 && checkSplit_hb(a13, a14, a23, a24, a33, a34)) )
                 {
                     // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+                    float conf = intersectConf(delta, labelA, labelB, level, sublabel);
                     if( conf > req_confidence )
                     {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
+                        updateBlock(delta, level, labelA, sublabel, labelB);
                         x++;
                     }
                 }
             }
         }
     }
+}
+
+void SuperpixelSEEDSImpl::updateBlocksVertical(int level, float req_confidence, int x0, int x1,
+        HistogramDelta& delta)
+{
+    int labelA;
+    int labelB;
+    int sublabel;
+    bool done;
+    int step = nr_wh[2 * level];
 
     // vertical bidirectional
-    for (int x = 1; x < nr_wh[2 * level] - 1; x++)
+    for (int x = x0; x < x1; x++)
     {
         for (int y = 1; y < nr_wh[2 * level + 1] - 2; y++)
         {
@@ -565,20 +673,21 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
             int a23 = parent[level][(y) * step + (x + 1)];
 
             done = false;
-            if( nr_partitions[labelA] == 2 || (nr_partitions[labelA] > 2 // 3 or more partitions
+            int partitionsA = nrPartitions(delta, labelA);
+            if( partitionsA == 2 || (partitionsA > 2 // 3 or more partitions
                     && checkSplit_vf(a11, a12, a13, a21, a22, a23)) )
             {
                 // run algorithm as usual
-                float conf = intersectConf(seeds_top_level, labelB, labelA, level, sublabel);
+                float conf = intersectConf(delta, labelB, labelA, level, sublabel);
                 if( conf > req_confidence )
                 {
-                    deleteBlockToplevel(labelA, level, sublabel);
-                    addBlockToplevel(labelB, level, sublabel);
+                    updateBlock(delta, level, labelB, sublabel, labelA);
                     done = true;
                 }
             }
 
-            if( !done && (nr_partitions[labelB] > MINIMUM_NR_SUBLABELS) )
+            int partitionsB = nrPartitions(delta, labelB);
+            if( !done && (partitionsB > MINIMUM_NR_SUBLABELS) )
             {
                 // try opposite direction
                 sublabel = (y + 1) * step + x;
@@ -588,15 +697,14 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
                 int a41 = parent[level][(y + 2) * step + (x - 1)];
                 int a42 = parent[level][(y + 2) * step + (x)];
                 int a43 = parent[level][(y + 2) * step + (x + 1)];
-                if( nr_partitions[labelB] <= 2 // == 2
-                        || (nr_partitions[labelB] > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
+                if( partitionsB <= 2 // == 2
+                        || (partitionsB > 2 && checkSplit_vb(a31, a32, a33, a41, a42, a43)) )
                 {
                     // run algorithm as usual
-                    float conf = intersectConf(seeds_top_level, labelA, labelB, level, sublabel);
+                    float conf = intersectConf(delta, labelA, labelB, level, sublabel);
                     if( conf > req_confidence )
                     {
-                        deleteBlockToplevel(labelB, level, sublabel);
-                        addBlockToplevel(labelA, level, sublabel);
+                        updateBlock(delta, level, labelA, sublabel, labelB);
                         y++;
                     }
                 }
@@ -605,6 +713,70 @@ void SuperpixelSEEDSImpl::updateBlocks(int level, float req_confidence)
     }
 }
 
+void SuperpixelSEEDSImpl::updateBlock(HistogramDelta& delta, int level, int label_new, int sublabel, int label_old)
+{
+    const HISTN* h_sublabel = &histogram[level][sublabel * histogram_size_aligned];
+    HISTN* h_old = &delta.histogram[label_old * histogram_size_aligned];
+    HISTN* h_new = &delta.histogram[label_new * histogram_size_aligned];
+    for (int n = 0; n < histogram_size; n++)
+    {
+        h_old[n] -= h_sublabel[n];
+        h_new[n] += h_sublabel[n];
+    }
+    delta.T[label_old] -= T[level][sublabel];
+    delta.T[label_new] += T[level][sublabel];
+    delta.nr_partitions[label_old]--;
+    delta.nr_partitions[label_new]++;
+    delta.touched[label_old] = delta.touched[label_new] = 1;
+    delta.updates.push_back(Vec3i(sublabel, label_old, label_new));
+    parent[level][sublabel] = label_new;
+}
+
+void SuperpixelSEEDSImpl::mergeBlockDelta(HistogramDelta& delta, vector<Vec3i>& updates)
+{
+    // hand the updates over and clear the delta for the next band
+    for (size_t k = 0; k < delta.updates.size(); k++)
+    {
+        for (int i = 1; i <= 2; i++)
+        {
+            const int label = delta.updates[k][i];
+            if( !delta.touched[label] )
+                continue;
+            std::fill(delta.histogram.begin() + label * histogram_size_aligned,
+                      delta.histogram.begin() + (label + 1) * histogram_size_aligned, (HISTN)0);
+            delta.T[label] = 0;
+            delta.nr_partitions[label] = 0;
+            delta.touched[label] = 0;
+        }
+    }
+    updates.swap(delta.updates);
+    delta.updates.clear();
+}
+
+const HISTN* SuperpixelSEEDSImpl::deltaHistogram(HistogramDelta& delta, int label, int slot)
+{
+    const HISTN* h = &histogram[seeds_top_level][label * histogram_size_aligned];
+    if( !delta.touched[label] )
+        return h;
+
+    // aligned copy for the SIMD loads of intersectConf
+    HISTN* merged = delta.merged.ptr<HISTN>(slot);
+    const HISTN* d = &delta.histogram[label * histogram_size_aligned];
+    for (int n = 0; n < histogram_size; n++)
+        merged[n] = h[n] + d[n];
+    return merged;
+}
+
+float SuperpixelSEEDSImpl::intersectConf(HistogramDelta& delta, int label1A, int label1B,
+        int level2, int label2)
+{
+    const float count2 = T[level2][label2];
+    return intersectConf(deltaHistogram(delta, label1A, 0), deltaHistogram(delta, label1B, 1),
+            &histogram[level2][label2 * histogram_size_aligned],
+            T[seeds_top_level][label1A] + delta.T[label1A],
+            T[seeds_top_level][label1B] + delta.T[label1B] - count2, count2);
+}
+
 int SuperpixelSEEDSImpl::goDownOneLevel()
 {
     int old_level = seeds_current_level;
@@ -635,14 +807,14 @@ int SuperpixelSEEDSImpl::goDownOneLevel()
     return new_level;
 }
 
-void SuperpixelSEEDSImpl::updatePixels()
+void SuperpixelSEEDSImpl::updatePixelsHorizontal(int y0, int y1, HistogramDelta& delta)
 {
     int labelA;
     int labelB;
     int priorA = 0;
     int priorB = 0;
 
-    for (int y = 1; y < height - 1; y++)
+    for (int y = y0; y < y1; y++)
     {
         for (int x = 1; x < width - 2; x++)
         {
@@ -670,9 +842,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = threebyfour(x, y, labelB);
                         }
 
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                        if( probability(delta, y * width + x, labelA, labelB, priorA, priorB) )
                         {
-                            update(labelB, y * width + x, labelA);
+                            update(delta, labelB, y * width + x, labelA);
                         }
                         else
                         {
@@ -683,9 +855,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a34 = labels[(y + 1) * width + (x + 2)];
                             if( checkSplit_hb(a13, a14, a23, a24, a33, a34) )
                             {
-                                if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                                if( probability(delta, y * width + x + 1, labelB, labelA, priorB, priorA) )
                                 {
-                                    update(labelA, y * width + x + 1, labelB);
+                                    update(delta, labelA, y * width + x + 1, labelB);
                                     x++;
                                 }
                             }
@@ -708,9 +880,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = threebyfour(x, y, labelB);
                         }
 
-                        if( probability(y * width + x + 1, labelB, labelA, priorB, priorA) )
+                        if( probability(delta, y * width + x + 1, labelB, labelA, priorB, priorA) )
                         {
-                            update(labelA, y * width + x + 1, labelB);
+                            update(delta, labelA, y * width + x + 1, labelB);
                             x++;
                         }
                         else
@@ -722,9 +894,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a32 = labels[(y + 1) * width + (x)];
                             if( checkSplit_hf(a11, a12, a21, a22, a31, a32) )
                             {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                if( probability(delta, y * width + x, labelA, labelB, priorA, priorB) )
                                 {
-                                    update(labelB, y * width + x, labelA);
+                                    update(delta, labelB, y * width + x, labelA);
                                 }
                             }
                         }
@@ -733,8 +905,16 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for x
     } // for y
+}
+
+void SuperpixelSEEDSImpl::updatePixelsVertical(int x0, int x1, HistogramDelta& delta)
+{
+    int labelA;
+    int labelB;
+    int priorA = 0;
+    int priorB = 0;
 
-    for (int x = 1; x < width - 1; x++)
+    for (int x = x0; x < x1; x++)
     {
         for (int y = 1; y < height - 2; y++)
         {
@@ -762,9 +942,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = fourbythree(x, y, labelB);
                         }
 
-                        if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                        if( probability(delta, y * width + x, labelA, labelB, priorA, priorB) )
                         {
-                            update(labelB, y * width + x, labelA);
+                            update(delta, labelB, y * width + x, labelA);
                         }
                         else
                         {
@@ -775,9 +955,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a43 = labels[(y + 2) * width + (x + 1)];
                             if( checkSplit_vb(a31, a32, a33, a41, a42, a43) )
                             {
-                                if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                                if( probability(delta, (y + 1) * width + x, labelB, labelA, priorB, priorA) )
                                 {
-                                    update(labelA, (y + 1) * width + x, labelB);
+                                    update(delta, labelA, (y + 1) * width + x, labelB);
                                     y++;
                                 }
                             }
@@ -800,9 +980,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             priorB = fourbythree(x, y, labelB);
                         }
 
-                        if( probability((y + 1) * width + x, labelB, labelA, priorB, priorA) )
+                        if( probability(delta, (y + 1) * width + x, labelB, labelA, priorB, priorA) )
                         {
-                            update(labelA, (y + 1) * width + x, labelB);
+                            update(delta, labelA, (y + 1) * width + x, labelB);
                             y++;
                         }
                         else
@@ -814,9 +994,9 @@ void SuperpixelSEEDSImpl::updatePixels()
                             int a23 = labels[(y) * width + (x + 1)];
                             if( checkSplit_vf(a11, a12, a13, a21, a22, a23) )
                             {
-                                if( probability(y * width + x, labelA, labelB, priorA, priorB) )
+                                if( probability(delta, y * width + x, labelA, labelB, priorA, priorB) )
                                 {
-                                    update(labelB, y * width + x, labelA);
+                                    update(delta, labelB, y * width + x, labelA);
                                 }
                             }
                         }
@@ -825,6 +1005,55 @@ void SuperpixelSEEDSImpl::updatePixels()
             } // labelA != labelB
         } // for y
     } // for x
+}
+
+void SuperpixelSEEDSImpl::updatePixels()
+{
+    int labelA;
+    int labelB;
+
+    // Bands of rows (then columns) are updated in two passes, first the even bands then
+    // the odd ones, so that concurrently updated bands are not adjacent. The band layout
+    // does not depend on the number of threads, nor does the result.
+    const int nr_row_bands = (height - 2 + PIXEL_UPDATE_BAND - 1) / PIXEL_UPDATE_BAND;
+    const int nr_col_bands = (width - 2 + PIXEL_UPDATE_BAND - 1) / PIXEL_UPDATE_BAND;
+    TLSData<HistogramDelta> deltas;
+    vector<vector<Vec3i> > band_updates(std::max(nr_row_bands, nr_col_bands));
+
+    for (int vertical = 0; vertical < 2; vertical++)
+    {
+        const int nr_bands = vertical ? nr_col_bands : nr_row_bands;
+        const int end = vertical ? width - 1 : height - 1;
+        for (int parity = 0; parity < 2; parity++)
+        {
+            parallel_for_(Range(0, (nr_bands - parity + 1) / 2), [&](const Range& range)
+            {
+                HistogramDelta& delta = *deltas.get();
+                initHistogramDelta(delta);
+                for (int i = range.start; i < range.end; i++)
+                {
+                    const int band = 2 * i + parity;
+                    const int start = 1 + band * PIXEL_UPDATE_BAND;
+                    const int stop = std::min(start + PIXEL_UPDATE_BAND, end);
+                    if( vertical )
+                        updatePixelsVertical(start, stop, delta);
+                    else
+                        updatePixelsHorizontal(start, stop, delta);
+                    mergeHistogramDelta(delta, band_updates[band]);
+                }
+            });
+
+            for (int band = parity; band < nr_bands; band += 2)
+            {
+                const vector<Vec3i>& updates = band_updates[band];
+                for (size_t k = 0; k < updates.size(); k++)
+                {
+                    deletePixel(seeds_top_level, updates[k][1], updates[k][0]);
+                    addPixel(seeds_top_level, updates[k][2], updates[k][0]);
+                }
+            }
+        }
+    }
     forwardbackward = !forwardbackward;
 
     // update border pixels
@@ -852,6 +1081,18 @@ void SuperpixelSEEDSImpl::updatePixels()
     }
 }
 
+void SuperpixelSEEDSImpl::initHistogramDelta(HistogramDelta& delta)
+{
+    if( !delta.T.empty() )
+        return;
+    const int nr_labels = nrLabels(seeds_top_level);
+    delta.histogram.assign((size_t)histogram_size_aligned * nr_labels, 0);
+    delta.T.assign(nr_labels, 0);
+    delta.nr_partitions.assign(nr_labels, 0);
+    delta.touched.assign(nr_labels, 0);
+    delta.merged.create(2, histogram_size_aligned, CV_32F);
+}
+
 void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
 {
     //change the label of a single pixel
@@ -860,6 +1101,34 @@ void SuperpixelSEEDSImpl::update(int label_new, int image_idx, int label_old)
     labels[image_idx] = label_new;
 }
 
+void SuperpixelSEEDSImpl::update(HistogramDelta& delta, int label_new, int image_idx, int label_old)
+{
+    //change the label of a single pixel, recording the histogram change in the delta
+    unsigned int color = image_bins[image_idx];
+    delta.histogram[label_old * histogram_size_aligned + color]--;
+    delta.T[label_old]--;
+    delta.histogram[label_new * histogram_size_aligned + color]++;
+    delta.T[label_new]++;
+    delta.updates.push_back(Vec3i(image_idx, label_old, label_new));
+    labels[image_idx] = label_new;
+}
+
+void SuperpixelSEEDSImpl::mergeHistogramDelta(HistogramDelta& delta, vector<Vec3i>& updates)
+{
+    // hand the updates over and clear the delta for the next band
+    for (size_t k = 0; k < delta.updates.size(); k++)
+    {
+        const Vec3i& u = delta.updates[k];
+        unsigned int color = image_bins[u[0]];
+        delta.histogram[u[1] * histogram_size_aligned + color] = 0;
+        delta.histogram[u[2] * histogram_size_aligned + color] = 0;
+        delta.T[u[1]] = 0;
+        delta.T[u[2]] = 0;
+    }
+    updates.swap(delta.updates);
+    delta.updates.clear();
+}
+
 void SuperpixelSEEDSImpl::addPixel(int level, int label, int image_idx)
 {
     histogram[level][label * histogram_size_aligned + image_bins[image_idx]]++;
@@ -937,18 +1206,23 @@ void SuperpixelSEEDSImpl::deleteBlockToplevel(int label, int sublevel, int subla
 
 void SuperpixelSEEDSImpl::updateLabels()
 {
-    for (int i = 0; i < width * height; ++i)
-        labels[i] = parent[0][labels_bottom[i]];
+    parallel_for_(Range(0, height), [&](const Range& range)
+    {
+        for (int i = range.start * width; i < range.end * width; ++i)
+            labels[i] = parent[0][labels_bottom[i]];
+    });
 }
 
-bool SuperpixelSEEDSImpl::probability(int image_idx, int label1, int label2,
+bool SuperpixelSEEDSImpl::probability(const HistogramDelta& delta, int image_idx, int label1, int label2,
         int prior1, int prior2)
 {
     unsigned int color = image_bins[image_idx];
-    float P_label1 = histogram[seeds_top_level][label1 * histogram_size_aligned + color]
-                                                * T[seeds_top_level][label2];
-    float P_label2 = histogram[seeds_top_level][label2 * histogram_size_aligned + color]
-                                                * T[seeds_top_level][label1];
+    const HISTN T1 = T[seeds_top_level][label1] + delta.T[label1];
+    const HISTN T2 = T[seeds_top_level][label2] + delta.T[label2];
+    float P_label1 = (histogram[seeds_top_level][label1 * histogram_size_aligned + color]
+                      + delta.histogram[label1 * histogram_size_aligned + color]) * T2;
+    float P_label2 = (histogram[seeds_top_level][label2 * histogram_size_aligned + color]
+                      + delta.histogram[label2 * histogram_size_aligned + color]) * T1;
 
     if( seeds_prior )
     {
@@ -967,8 +1241,8 @@ bool SuperpixelSEEDSImpl::probability(int image_idx, int label1, int label2,
             /* fallthrough */
         case 2:
             p *= p;
-            P_label1 *= T[seeds_top_level][label2];
-            P_label2 *= T[seeds_top_level][label1];
+            P_label1 *= T2;
+            P_label2 *= T1;
             /* fallthrough */
         case 1:
             P_label1 *= p;
@@ -1086,16 +1360,10 @@ int SuperpixelSEEDSImpl::fourbythree(int x, int y, int label)
 #endif
 }
 
-float SuperpixelSEEDSImpl::intersectConf(int level1, int label1A, int label1B,
-        int level2, int label2)
+float SuperpixelSEEDSImpl::intersectConf(const HISTN* h1A, const HISTN* h1B, const HISTN* h2,
+        float count1A, float count1B, float count2)
 {
     float sumA = 0, sumB = 0;
-    float* h1A = &histogram[level1][label1A * histogram_size_aligned];
-    float* h1B = &histogram[level1][label1B * histogram_size_aligned];
-    float* h2 = &histogram[level2][label2 * histogram_size_aligned];
-    const float count1A = T[level1][label1A];
-    const float count2 = T[level2][label2];
-    const float count1B = T[level1][label1B] - count2;
 
     /* this calculates several things:
      * - normalized intersection of a histogram. which is equal to:
@@ -111,6 +111,111 @@ namespace cv {
                     }
             };
 
+            // Max-heap of neighbours addressed by handles, so an entry can be updated or removed in place
+            class NeighbourQueue {
+                public:
+                    void reserve(size_t n) {
+                        items.reserve(n);
+                        heap.reserve(n);
+                        position.reserve(n);
+                    }
+
+                    bool empty() const {
+                        return heap.empty();
+                    }
+
+                    bool contains(int handle) const {
+                        return position[handle] >= 0;
+                    }
+
+                    Neighbour& item(int handle) {
+                        return items[handle];
+                    }
+
+                    int top() const {
+                        return heap[0];
+                    }
+
+                    int push(const Neighbour& n) {
+                        int handle = (int)items.size();
+                        items.push_back(n);
+                        position.push_back((int)heap.size());
+                        heap.push_back(handle);
+                        siftUp(position[handle]);
+                        return handle;
+                    }
+
+                    void remove(int handle) {
+                        int pos = position[handle];
+                        int last = heap.back();
+                        heap.pop_back();
+                        position[handle] = -1;
+                        if (last != handle) {
+                            heap[pos] = last;
+                            position[last] = pos;
+                            update(last);
+                        }
+                    }
+
+                    // Restore the heap order after the similarity of an entry has been changed
+                    void update(int handle) {
+                        int pos = position[handle];
+                        if (pos > 0 && higher(handle, heap[(pos - 1) / 2])) {
+                            siftUp(pos);
+                        } else {
+                            siftDown(pos);
+                        }
+                    }
+
+                private:
+                    std::vector<Neighbour> items; // [Handle]
+                    std::vector<int> heap;        // Handles
+                    std::vector<int> position;    // [Handle] -> index in heap or -1 if removed
+
+                    // Ties are broken by handle to keep the merging order deterministic
+                    bool higher(int a, int b) const {
+                        return items[a].similarity > items[b].similarity || (items[a].similarity == items[b].similarity && a < b);
+                    }
+
+                    void place(int pos, int handle) {
+                        heap[pos] = handle;
+                        position[handle] = pos;
+                    }
+
+                    void siftUp(int pos) {
+                        int handle = heap[pos];
+                        while (pos > 0) {
+                            int parent = (pos - 1) / 2;
+                            if (!higher(handle, heap[parent])) {
+                                break;
+                            }
+                            place(pos, heap[parent]);
+                            pos = parent;
+                        }
+                        place(pos, handle);
+                    }
+
+                    void siftDown(int pos) {
+                        int handle = heap[pos];
+                        int size = (int)heap.size();
+                        for (;;) {
+                            int child = 2 * pos + 1;
+                            if (child >= size) {
+                                break;
+                            }
+                            if (child + 1 < size && higher(heap[child + 1], heap[child])) {
+                                child++;
+                            }
+                            if (!higher(heap[child], handle)) {
+                                break;
+                            }
+                            place(pos, heap[child]);
+                            pos = child;
+                        }
+                        place(pos, handle);
+                    }
+            };
+
             /****************************************
              * Stragegy / Color
              ***************************************/
@@ -162,38 +267,73 @@ namespace cv {
 
                     histograms = Mat_<float>(nb_segs, histogram_size);
 
-                    for (int r = 0; r < nb_segs; r++) {
-
-                        // Generate mask
-                        Mat mask = regions == r;
+                    if (img.depth() == CV_8U) {
 
-                        // Compute histogram for each channels
-                        float tt = 0;
+                        // Fill the histograms of all regions in a single pass over the image
+                        Mat_<int> tmp_histograms = Mat_<int>::zeros(nb_segs, histogram_size);
+                        std::vector<int> totals(nb_segs, 0);
+                        int channels = img.channels();
 
-                        Mat tmp_hists = Mat(histogram_size, 1, CV_32F);
-                        float *tmp_histogram = tmp_hists.ptr<float>(0);
-                        int h_pos = 0;
-                        Mat tmp_hist;
+                        for (int i = 0; i < img.rows; i++) {
+                            const uchar* pixel = img.ptr<uchar>(i);
+                            const int* region = regions.ptr<int>(i);
 
-                        for (int p = 0; p < img.channels(); p++) {
+                            for (int j = 0; j < img.cols; j++, pixel += channels) {
+                                int* histogram = tmp_histograms.ptr<int>(region[j]);
 
-                            calcHist(&img_planes[p], 1, 0, mask, tmp_hist, 1, &histogram_bins_size, &histogram_ranges);
+                                for (int p = 0; p < channels; p++) {
+                                    // Same bins as calcHist with a uniform [0, 256) range
+                                    histogram[p * histogram_bins_size + ((int)pixel[p] * histogram_bins_size >> 8)]++;
+                                }
+                                totals[region[j]] += channels;
+                            }
+                        }
 
-                            float *tmp_hist_ = tmp_hist.ptr<float>(0);
+                        for (int r = 0; r < nb_segs; r++) {
+                            float* histogram = histograms.ptr<float>(r);
+                            const int* tmp_histogram = tmp_histograms.ptr<int>(r);
+                            float tt = (float)totals[r];
 
-                            // Copy local histogram to global histogram
-                            for (int pos = 0; pos < histogram_bins_size; pos++) {
-                                tmp_histogram[pos + h_pos] = tmp_hist_[pos];
-                                tt += tmp_histogram[pos + h_pos];
+                            for (int h_pos2 = 0; h_pos2 < histogram_size; h_pos2++) {
+                                histogram[h_pos2] = (float)tmp_histogram[h_pos2] / tt;
                             }
-                            h_pos += histogram_bins_size;
                         }
+                    } else {
 
-                        // Normalize historgrams
-                        float* histogram = histograms.ptr<float>(r);
+                        // Generic path, one calcHist per region
+                        for (int r = 0; r < nb_segs; r++) {
 
-                        for (int h_pos2 = 0; h_pos2 < histogram_size; h_pos2++) {
-                            histogram[h_pos2] = tmp_histogram[h_pos2] / tt;
+                            // Generate mask
+                            Mat mask = regions == r;
+
+                            // Compute histogram for each channels
+                            float tt = 0;
+
+                            Mat tmp_hists = Mat(histogram_size, 1, CV_32F);
+                            float *tmp_histogram = tmp_hists.ptr<float>(0);
+                            int h_pos = 0;
+                            Mat tmp_hist;
+
+                            for (int p = 0; p < img.channels(); p++) {
+
+                                calcHist(&img_planes[p], 1, 0, mask, tmp_hist, 1, &histogram_bins_size, &histogram_ranges);
+
+                                float *tmp_hist_ = tmp_hist.ptr<float>(0);
+
+                                // Copy local histogram to global histogram
+                                for (int pos = 0; pos < histogram_bins_size; pos++) {
+                                    tmp_histogram[pos + h_pos] = tmp_hist_[pos];
+                                    tt += tmp_histogram[pos + h_pos];
+                                }
+                                h_pos += histogram_bins_size;
+                            }
+
+                            // Normalize historgrams
+                            float* histogram = histograms.ptr<float>(r);
+
+                            for (int h_pos2 = 0; h_pos2 < histogram_size; h_pos2++) {
+                                histogram[h_pos2] = tmp_histogram[h_pos2] / tt;
+                            }
                         }
                     }
 
@@ -258,6 +398,9 @@ namespace cv {
                     virtual void addStrategy(Ptr<SelectiveSearchSegmentationStrategy> g, float weight) CV_OVERRIDE;
                     virtual void clearStrategies() CV_OVERRIDE;
 
+                    // Appends the strategy objects reachable from this one, including itself
+                    void getSubStrategies(std::vector<const SelectiveSearchSegmentationStrategy*>& objects) const;
+
                 private:
                     String name_;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
@@ -277,6 +420,27 @@ namespace cv {
                 weights_total = 0;
             }
 
+            static void collectSubStrategies(const Ptr<SelectiveSearchSegmentationStrategy>& s, std::vector<const SelectiveSearchSegmentationStrategy*>& objects) {
+                const SelectiveSearchSegmentationStrategyMultipleImpl* m = dynamic_cast<const SelectiveSearchSegmentationStrategyMultipleImpl*>(s.get());
+
+                if (m) {
+                    m->getSubStrategies(objects);
+                } else if (std::find(objects.begin(), objects.end(), s.get()) == objects.end()) {
+                    objects.push_back(s.get());
+                }
+            }
+
+            void SelectiveSearchSegmentationStrategyMultipleImpl::getSubStrategies(std::vector<const SelectiveSearchSegmentationStrategy*>& objects) const {
+                if (std::find(objects.begin(), objects.end(), this) != objects.end()) {
+                    return;
+                }
+                objects.push_back(this);
+
+                for (size_t i = 0; i < strategies.size(); i++) {
+                    collectSubStrategies(strategies[i], objects);
+                }
+            }
+
             void SelectiveSearchSegmentationStrategyMultipleImpl::setImage(InputArray img_, InputArray regions_, InputArray sizes_, int image_id) {
                 for (unsigned int i = 0; i < strategies.size(); i++) {
                     strategies[i]->setImage(img_, regions_, sizes_, image_id);
@@ -731,7 +895,7 @@ namespace cv {
                     std::vector<Ptr<GraphSegmentation> > segmentations;
                     std::vector<Ptr<SelectiveSearchSegmentationStrategy> > strategies;
 
-                    void hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int region_id);
+                    void hierarchicalGrouping(const Mat& img, const Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const std::vector<Vec2i>& neighbours, const Mat_<int>& sizes, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id);
             };
 
             void SelectiveSearchSegmentationImpl::setBaseImage(InputArray img) {
@@ -884,76 +1048,153 @@ namespace cv {
                 addStrategy(size3);
             }
 
-            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
+            // Initial segmentation of one (image, graph segmentation) pair
+            struct InitialSegmentation {
+                Mat img_regions;
+                Mat_<int> sizes;
+                int nb_segs;
+                std::vector<Rect> bounding_rects;
+                std::vector<Vec2i> neighbours; // Sorted pairs (i, j) with i < j
+            };
 
-                std::vector<Region> all_regions;
+            static void computeInitialSegmentation(const Mat& image, const Ptr<GraphSegmentation>& gs, InitialSegmentation& seg) {
 
-                int image_id = 0;
+                Mat& img_regions = seg.img_regions;
 
-                for(std::vector<Mat>::iterator image = images.begin(); image != images.end(); ++image) {
-                    for(std::vector<Ptr<GraphSegmentation> >::iterator gs = segmentations.begin(); gs != segmentations.end(); ++gs) {
+                // Compute initial segmentation
+                gs->processImage(image, img_regions);
 
-                        Mat img_regions;
-                        Mat_<char> is_neighbour;
-                        Mat_<int> sizes;
+                // Get number of regions
+                double min, max;
+                minMaxLoc(img_regions, &min, &max);
+                int nb_segs = (int)max + 1;
+                seg.nb_segs = nb_segs;
 
-                        // Compute initial segmentation
-                        (*gs)->processImage(*image, img_regions);
+                // Compute bouding rects, sizes and neighbours
+                std::vector<Point> tl(nb_segs, Point(img_regions.cols, img_regions.rows));
+                std::vector<Point> br(nb_segs, Point(-1, -1));
 
-                        // Get number of regions
-                        double min, max;
-                        minMaxLoc(img_regions, &min, &max);
-                        int nb_segs = (int)max + 1;
+                seg.sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                int* sizes = seg.sizes.ptr<int>(0);
 
-                        // Compute bouding rects and neighbours
-                        std::vector<Rect> bounding_rects;
-                        bounding_rects.resize(nb_segs);
+                std::vector<Vec2i>& neighbours = seg.neighbours;
+                neighbours.clear();
 
-                        std::vector<std::vector<cv::Point> > points;
+                const int* previous_p = NULL;
 
-                        points.resize(nb_segs);
+                for (int i = 0; i < (int)img_regions.rows; i++) {
+                    const int* p = img_regions.ptr<int>(i);
 
-                        is_neighbour = Mat::zeros(nb_segs, nb_segs, CV_8UC1);
-                        sizes = Mat::zeros(nb_segs, 1, CV_32SC1);
+                    for (int j = 0; j < (int)img_regions.cols; j++) {
+                        int r = p[j];
 
-                        const int* previous_p = NULL;
+                        sizes[r]++;
+                        tl[r].x = std::min(tl[r].x, j);
+                        tl[r].y = std::min(tl[r].y, i);
+                        br[r].x = std::max(br[r].x, j);
+                        br[r].y = std::max(br[r].y, i);
 
-                        for (int i = 0; i < (int)img_regions.rows; i++) {
-                            const int* p = img_regions.ptr<int>(i);
+                        if (i > 0 && j > 0) {
+                            const int others[3] = {p[j - 1], previous_p[j], previous_p[j - 1]};
 
-                            for (int j = 0; j < (int)img_regions.cols; j++) {
+                            for (int n = 0; n < 3; n++) {
+                                if (others[n] != r) {
+                                    neighbours.push_back(Vec2i(std::min(r, others[n]), std::max(r, others[n])));
+                                }
+                            }
+                        }
+                    }
+                    previous_p = p;
+                }
+
+                seg.bounding_rects.resize(nb_segs);
+                for (int r = 0; r < nb_segs; r++) {
+                    seg.bounding_rects[r] = br[r].x < 0 ? Rect() : Rect(tl[r], br[r] + Point(1, 1));
+                }
+
+                std::sort(neighbours.begin(), neighbours.end(), [](const Vec2i& a, const Vec2i& b) {
+                    return a[0] < b[0] || (a[0] == b[0] && a[1] < b[1]);
+                });
+                neighbours.erase(std::unique(neighbours.begin(), neighbours.end()), neighbours.end());
+            }
 
-                                points[p[j]].push_back(cv::Point(j, i));
-                                sizes.at<int>(p[j], 0) = sizes.at<int>(p[j], 0) + 1;
+            void SelectiveSearchSegmentationImpl::process(std::vector<Rect>& rects) {
+
+                const int nb_images = (int)images.size();
+                const int nb_gs = (int)segmentations.size();
+                const int nb_strategies = (int)strategies.size();
 
-                                if (i > 0 && j > 0) {
+                // Initial segmentations are independent
+                std::vector<InitialSegmentation> segs(nb_images * nb_gs);
+
+                parallel_for_(Range(0, (int)segs.size()), [&](const Range& range) {
+                    for (int image_id = range.start; image_id < range.end; image_id++) {
+                        computeInitialSegmentation(images[image_id / nb_gs], segmentations[image_id % nb_gs], segs[image_id]);
+                    }
+                });
 
-                                    is_neighbour.at<char>(p[j], p[j - 1]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j]) = 1;
-                                    is_neighbour.at<char>(p[j], previous_p[j - 1]) = 1;
+                // Strategies keep per-image state, so the groupings are distributed by the strategy objects
+                // they use: strategies sharing an object, directly or through sub-strategies, are always
+                // processed by the same task, in the original order.
+                std::vector<std::vector<int> > strategy_groups;
+                std::vector<std::vector<const SelectiveSearchSegmentationStrategy*> > group_objects;
 
-                                    is_neighbour.at<char>(p[j - 1], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j], p[j]) = 1;
-                                    is_neighbour.at<char>(previous_p[j - 1], p[j]) = 1;
+                for (int i = 0; i < nb_strategies; i++) {
+                    std::vector<const SelectiveSearchSegmentationStrategy*> objects;
+                    collectSubStrategies(strategies[i], objects);
+
+                    std::vector<int> group(1, i);
+
+                    // Merge every group sharing an object with this strategy
+                    for (size_t g = 0; g < strategy_groups.size(); ) {
+                        bool shared = false;
+                        for (size_t k = 0; k < objects.size() && !shared; k++) {
+                            shared = std::find(group_objects[g].begin(), group_objects[g].end(), objects[k]) != group_objects[g].end();
+                        }
+
+                        if (shared) {
+                            group.insert(group.end(), strategy_groups[g].begin(), strategy_groups[g].end());
+                            for (size_t k = 0; k < group_objects[g].size(); k++) {
+                                if (std::find(objects.begin(), objects.end(), group_objects[g][k]) == objects.end()) {
+                                    objects.push_back(group_objects[g][k]);
                                 }
                             }
-                            previous_p = p;
+                            strategy_groups.erase(strategy_groups.begin() + g);
+                            group_objects.erase(group_objects.begin() + g);
+                        } else {
+                            g++;
                         }
+                    }
 
-                        for(int seg = 0; seg < nb_segs; seg++) {
-                            bounding_rects[seg] = cv::boundingRect(points[seg]);
-                        }
+                    std::sort(group.begin(), group.end());
+                    strategy_groups.push_back(group);
+                    group_objects.push_back(objects);
+                }
+
+                std::vector<std::vector<Region> > groupings(segs.size() * nb_strategies);
 
-                        for(std::vector<Ptr<SelectiveSearchSegmentationStrategy> >::iterator strategy = strategies.begin(); strategy != strategies.end(); ++strategy) {
-                            std::vector<Region> regions;
-                            hierarchicalGrouping(*image, *strategy, img_regions, is_neighbour, sizes, nb_segs, bounding_rects, regions, image_id);
+                parallel_for_(Range(0, (int)strategy_groups.size()), [&](const Range& range) {
+                    for (int g = range.start; g < range.end; g++) {
+                        for (int image_id = 0; image_id < (int)segs.size(); image_id++) {
+                            for (size_t i = 0; i < strategy_groups[g].size(); i++) {
+                                int strategy = strategy_groups[g][i];
+                                const InitialSegmentation& seg = segs[image_id];
 
-                            for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                                all_regions.push_back(*region);
+                                hierarchicalGrouping(images[image_id / nb_gs], strategies[strategy], seg.img_regions, seg.neighbours, seg.sizes, seg.nb_segs, seg.bounding_rects, groupings[image_id * nb_strategies + strategy], image_id);
                             }
                         }
+                    }
+                });
 
-                        image_id++;
+                std::vector<Region> all_regions;
+
+                for (size_t i = 0; i < groupings.size(); i++) {
+                    for(std::vector<Region>::iterator region = groupings[i].begin(); region != groupings[i].end(); ++region) {
+                        // Compute regions' rank (sequentially, in the order of the groupings)
+                        // Note: this is inverted from the paper, but we keep the lover region first so it's works
+                        (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
+
+                        all_regions.push_back(*region);
                     }
                 }
 
@@ -973,13 +1214,21 @@ namespace cv {
 
             }
 
-            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const Mat_<char>& is_neighbour, const Mat_<int>& sizes_, int& nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
+            void SelectiveSearchSegmentationImpl::hierarchicalGrouping(const Mat& img, const Ptr<SelectiveSearchSegmentationStrategy>& s, const Mat& img_regions, const std::vector<Vec2i>& neighbours, const Mat_<int>& sizes_, int nb_segs, const std::vector<Rect>& bounding_rects, std::vector<Region>& regions, int image_id) {
 
                 Mat sizes = sizes_.clone();
 
-                std::vector<Neighbour> similarities;
+                NeighbourQueue similarities;
                 regions.clear();
 
+                // Each merge adds one region, so there is at most 2 * nb_segs regions
+                regions.reserve(2 * nb_segs);
+                similarities.reserve(neighbours.size());
+
+                // Handles of the similarities attached to each region
+                std::vector<std::vector<int> > region_neighbours(2 * nb_segs);
+                std::vector<int> visited(2 * nb_segs, -1);
+
                 /////////////////////////////////////////
 
                 s->setImage(img, img_regions, sizes, image_id);
@@ -994,29 +1243,24 @@ namespace cv {
                     r.bounding_box = bounding_rects[i];
 
                     regions.push_back(r);
-
-                    for (int j = i + 1; j < nb_segs; j++) {
-                        if (is_neighbour.at<char>(i, j)) {
-                            Neighbour n;
-                            n.from = i;
-                            n.to = j;
-                            n.similarity = s->get(i, j);
-
-                            similarities.push_back(n);
-                        }
-                    }
                 }
 
-                while(similarities.size() > 0) {
+                for (size_t k = 0; k < neighbours.size(); k++) {
+                    Neighbour n;
+                    n.from = neighbours[k][0];
+                    n.to = neighbours[k][1];
+                    n.similarity = s->get(n.from, n.to);
 
-                    std::sort(similarities.begin(), similarities.end());
+                    int handle = similarities.push(n);
+                    region_neighbours[n.from].push_back(handle);
+                    region_neighbours[n.to].push_back(handle);
+                }
 
-                    // for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end(); ++similarity) {
-                    //     std::cout << *similarity << std::endl;
-                    // }
+                while(!similarities.empty()) {
 
-                    Neighbour p = similarities.back();
-                    similarities.pop_back();
+                    int best = similarities.top();
+                    Neighbour p = similarities.item(best);
+                    similarities.remove(best);
 
                     Region region_from = regions[p.from];
                     Region region_to = regions[p.to];
@@ -1029,8 +1273,10 @@ namespace cv {
 
                     regions.push_back(new_r);
 
-                    regions[p.from].merged_to = (int)regions.size() - 1;
-                    regions[p.to].merged_to = (int)regions.size() - 1;
+                    int new_idx = (int)regions.size() - 1;
+
+                    regions[p.from].merged_to = new_idx;
+                    regions[p.to].merged_to = new_idx;
 
                     // Merge
                     s->merge(region_from.id, region_to.id);
@@ -1039,53 +1285,43 @@ namespace cv {
                     sizes.at<int>(region_from.id, 0) += sizes.at<int>(region_to.id, 0);
                     sizes.at<int>(region_to.id, 0) = sizes.at<int>(region_from.id, 0);
 
-                    std::vector<int> local_neighbours;
+                    // Neighbours of the merged regions become neighbours of the new one: the first similarity
+                    // to each of them is redirected to the new region and updated in place, the others are removed.
+                    visited[p.from] = visited[p.to] = new_idx;
 
-                    for(std::vector<Neighbour>::iterator similarity = similarities.begin(); similarity != similarities.end();) {
-                        if ((*similarity).from == p.from || (*similarity).to == p.from || (*similarity).from == p.to || (*similarity).to == p.to) {
-                            int from = 0;
+                    const int merged[2] = {p.from, p.to};
 
-                            if ((*similarity).from == p.from || (*similarity).from == p.to) {
-                                from = (*similarity).to;
-                            } else {
-                                from = (*similarity).from;
-                            }
+                    for (int m = 0; m < 2; m++) {
+                        std::vector<int>& handles = region_neighbours[merged[m]];
 
-                            bool already_neighboor = false;
+                        for (size_t k = 0; k < handles.size(); k++) {
+                            int handle = handles[k];
 
-                            for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
-                                if (*local_neighbour == from) {
-                                    already_neighboor = true;
-                                }
+                            if (!similarities.contains(handle)) {
+                                continue;
                             }
 
-                            if (!already_neighboor) {
-                                local_neighbours.push_back(from);
-                            }
+                            Neighbour& n = similarities.item(handle);
+                            int other = n.from == merged[m] ? n.to : n.from;
 
-                            similarity = similarities.erase(similarity);
-                        } else {
-                            similarity++;
-                        }
-                    }
+                            if (visited[other] == new_idx) {
+                                similarities.remove(handle);
+                                continue;
+                            }
+                            visited[other] = new_idx;
 
-                    for(std::vector<int>::iterator local_neighbour = local_neighbours.begin(); local_neighbour != local_neighbours.end(); local_neighbour++) {
+                            n.from = new_idx;
+                            n.to = other;
+                            n.similarity = s->get(regions[n.from].id, regions[n.to].id);
+                            similarities.update(handle);
 
-                        Neighbour n;
-                        n.from = (int)regions.size() - 1;
-                        n.to = *local_neighbour;
-                        n.similarity = s->get(regions[n.from].id, regions[n.to].id);
+                            region_neighbours[new_idx].push_back(handle);
+                        }
 
-                        similarities.push_back(n);
+                        std::vector<int>().swap(handles);
                     }
                 }
 
-                // Compute regions' rank
-                for(std::vector<Region>::iterator region = regions.begin(); region != regions.end(); ++region) {
-                    // Note: this is inverted from the paper, but we keep the lover region first so it's works
-                    (*region).rank = ((double) rand() / (RAND_MAX)) * ((*region).level);
-                }
-
             }
 
             Ptr<SelectiveSearchSegmentation> createSelectiveSearchSegmentation() {
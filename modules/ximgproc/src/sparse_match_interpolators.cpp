@@ -71,6 +71,46 @@ struct node
     node(int l,float d): dist(d), label(l) {}
 };
 
+static void computeGeodesicKNN(const vector<vector<node> >& g, int k, Mat& NNlabels, Mat& NNdistances);
+
+// Key of the geodesic structures (match graph and geodesic nearest neighbours), which only
+// depend on the cost map, its scaling, the number of neighbours and the match positions
+struct GeodesicCacheKey
+{
+    Mat cost;
+    vector<Point2f> positions;
+    float lambda;
+    int k;
+
+    GeodesicCacheKey(): lambda(0.0f), k(0) {}
+
+    bool equals(const Mat& _cost, const vector<SparseMatch>& matches, float _lambda, int _k) const
+    {
+        if(cost.empty() || cost.size()!=_cost.size() || lambda!=_lambda || k!=_k || positions.size()!=matches.size())
+            return false;
+        for(size_t i=0;i<matches.size();i++)
+            if(positions[i]!=matches[i].reference_image_pos)
+                return false;
+        return norm(cost,_cost,NORM_INF)==0;
+    }
+
+    void set(const Mat& _cost, const vector<SparseMatch>& matches, float _lambda, int _k)
+    {
+        _cost.copyTo(cost);
+        positions.resize(matches.size());
+        for(size_t i=0;i<matches.size();i++)
+            positions[i] = matches[i].reference_image_pos;
+        lambda = _lambda;
+        k = _k;
+    }
+
+    void clear()
+    {
+        cost.release();
+        positions.clear();
+    }
+};
+
 
 
 class EdgeAwareInterpolatorImpl CV_FINAL : public EdgeAwareInterpolator
@@ -83,11 +123,14 @@ protected:
     int match_num;
     int w, h;
     //internal buffers:
-    vector<node>* g;
+    vector<vector<node> > g;
     Mat NNlabels;
     Mat NNdistances;
+    Mat NNgeodesic;
     Mat labels;
     Mat costMap;
+    bool use_geodesic_cache;
+    GeodesicCacheKey geodesic_cache_key;
     //tunable parameters:
     float lambda;
     int k;
@@ -110,16 +153,6 @@ protected:
     void ransacInterpolation(vector<SparseMatch>& matches, Mat& dst_dense_flow);
 
 protected:
-    struct GetKNNMatches_ParBody : public ParallelLoopBody
-    {
-        EdgeAwareInterpolatorImpl* inst;
-        int num_stripes;
-        int stripe_sz;
-
-        GetKNNMatches_ParBody(EdgeAwareInterpolatorImpl& _inst, int _num_stripes);
-        void operator () (const Range& range) const CV_OVERRIDE;
-    };
-
     struct RansacInterpolation_ParBody : public ParallelLoopBody
     {
         EdgeAwareInterpolatorImpl* inst;
@@ -149,6 +182,13 @@ public:
     float getFGSLambda() CV_OVERRIDE {return fgs_lambda;}
     void  setFGSSigma(float _sigma) CV_OVERRIDE {fgs_sigma = _sigma;}
     float getFGSSigma() CV_OVERRIDE {return fgs_sigma;}
+    void  setUseGeodesicCache(bool _use_cache) CV_OVERRIDE {use_geodesic_cache = _use_cache; geodesic_cache_key.clear();}
+    bool  getUseGeodesicCache() CV_OVERRIDE {return use_geodesic_cache;}
+    void  getGeodesicNeighbors(OutputArray _labels, OutputArray _distances) CV_OVERRIDE
+    {
+        NNlabels.copyTo(_labels);
+        NNgeodesic.copyTo(_distances);
+    }
 };
 
 void EdgeAwareInterpolatorImpl::init()
@@ -161,6 +201,7 @@ void EdgeAwareInterpolatorImpl::init()
     fgs_sigma     = 1.5f;
     regularization_coef = 0.01f;
     costMap = Mat();
+    use_geodesic_cache = false;
 }
 
 Ptr<EdgeAwareInterpolatorImpl> EdgeAwareInterpolatorImpl::create()
@@ -190,15 +231,32 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
     CV_Assert(match_num<SHRT_MAX);
 
     Mat src = from_image.getMat();
-    labels = Mat(h,w,CV_32S);
-    labels = Scalar(-1);
-    NNlabels = Mat(match_num,k,CV_32S);
-    NNlabels = Scalar(-1);
-    NNdistances = Mat(match_num,k,CV_32F);
-    NNdistances = Scalar(0.0f);
-    g = new vector<node>[match_num];
+    if (costMap.empty())
+    {
+        costMap.create(h, w, CV_32FC1);
+        computeGradientMagnitude(src, costMap);
+    }
+    else
+        CV_Assert(costMap.cols == w && costMap.rows == h);
 
-    preprocessData(src,matches_vector);
+    // the geodesic structures of the previous call are still valid for the same cost map and match positions
+    if(use_geodesic_cache && geodesic_cache_key.equals(costMap,matches_vector,lambda,k))
+        NNgeodesic.copyTo(NNdistances);
+    else
+    {
+        if(use_geodesic_cache)
+            geodesic_cache_key.set(costMap,matches_vector,lambda,k);
+        labels = Mat(h,w,CV_32S);
+        labels = Scalar(-1);
+        NNlabels = Mat(match_num,k,CV_32S);
+        NNlabels = Scalar(-1);
+        NNdistances = Mat(match_num,k,CV_32F);
+        NNdistances = Scalar(0.0f);
+        g.assign(match_num,vector<node>());
+
+        preprocessData(src,matches_vector);
+        NNdistances.copyTo(NNgeodesic);
+    }
 
     dense_flow.create(from_image.size(),CV_32FC2);
     Mat dst = dense_flow.getMat();
@@ -207,7 +265,6 @@ void EdgeAwareInterpolatorImpl::interpolate(InputArray from_image, InputArray fr
         fastGlobalSmootherFilter(src,dst,dst,fgs_lambda,fgs_sigma);
 
     costMap.release();
-    delete[] g;
 }
 
 void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& matches)
@@ -225,17 +282,10 @@ void EdgeAwareInterpolatorImpl::preprocessData(Mat& src, vector<SparseMatch>& ma
         labels.at<int>(y,x) = (int)i;
     }
 
-    if (costMap.empty())
-    {
-        costMap.create(h, w, CV_32FC1);
-        computeGradientMagnitude(src, costMap);
-    }
-    else
-        CV_Assert(costMap.cols == w && costMap.rows == h);
-    costMap = (1000.0f-lambda) + lambda* costMap;
-    geodesicDistanceTransform(distances, costMap);
-    buildGraph(distances, costMap);
-    parallel_for_(Range(0,getNumThreads()),GetKNNMatches_ParBody(*this,getNumThreads()));
+    Mat cost_map = (1000.0f-lambda) + lambda* costMap;
+    geodesicDistanceTransform(distances, cost_map);
+    buildGraph(distances, cost_map);
+    computeGeodesicKNN(g, k, NNlabels, NNdistances);
 }
 
 void EdgeAwareInterpolatorImpl::geodesicDistanceTransform(Mat& distances, Mat& cost_map)
@@ -421,182 +471,136 @@ void EdgeAwareInterpolatorImpl::buildGraph(Mat& distances, Mat& cost_map)
     }
 }
 
-struct nodeHeap
+// Priority queue of the Dijkstra searches with buckets of quantized distances. The smallest entry of the
+// lowest non-empty bucket is extracted, so the nodes come out in the same order as from a binary heap.
+// Outdated entries are not removed, the search skips them instead.
+struct nodeBucketQueue
 {
-    // start indexing from 1 (root)
-    // children: 2*i, 2*i+1
-    // parent: i>>1
-    node* heap;
-    int* heap_pos;
-    node tmp_node;
+    enum { MAX_BUCKETS = 4096 };
+    vector<vector<node> > buckets;
+    vector<int> used_buckets;
+    float inv_width;
+    int cur;
     int size;
-    int num_labels;
 
-    nodeHeap(int _num_labels)
-    {
-        num_labels = _num_labels;
-        heap = new node[num_labels+1];
-        heap[0] = node(-1,-1.0f);
-        heap_pos = new int[num_labels];
-        memset(heap_pos,0,sizeof(int)*num_labels);
-        size=0;
-    }
-
-    ~nodeHeap()
-    {
-        delete[] heap;
-        delete[] heap_pos;
-    }
+    nodeBucketQueue(float bucket_width): inv_width(1.0f/bucket_width), cur(0), size(0) {}
 
     void clear()
     {
-        size=0;
-        memset(heap_pos,0,sizeof(int)*num_labels);
+        for(size_t i=0;i<used_buckets.size();i++)
+            buckets[used_buckets[i]].clear();
+        used_buckets.clear();
+        cur = 0;
+        size = 0;
     }
 
-    inline bool empty()
+    inline bool empty() const
     {
         return (size==0);
     }
 
-    inline void nodeSwap(int idx1, int idx2)
-    {
-        heap_pos[heap[idx1].label] = idx2;
-        heap_pos[heap[idx2].label] = idx1;
-
-        tmp_node   = heap[idx1];
-        heap[idx1] = heap[idx2];
-        heap[idx2] = tmp_node;
-    }
-
     void add(node n)
     {
+        float q = n.dist*inv_width;
+        int b = q < (float)(MAX_BUCKETS-1) ? (int)q : MAX_BUCKETS-1;
+        if(b>=(int)buckets.size())
+            buckets.resize(b+1);
+        if(buckets[b].empty())
+            used_buckets.push_back(b);
+        buckets[b].push_back(n);
+        cur = min(cur,b);
         size++;
-        heap[size] = n;
-        heap_pos[n.label] = size;
-        int i = size;
-        int parent_i = i>>1;
-        while(heap[i].dist<heap[parent_i].dist)
-        {
-            nodeSwap(i,parent_i);
-            i=parent_i;
-            parent_i = i>>1;
-        }
     }
 
     node getMin()
     {
-        node res = heap[1];
-        heap_pos[res.label] = 0;
-
-        int i=1;
-        int left,right;
-        while( (left=i<<1) < size )
-        {
-            right = left+1;
-            if(heap[left].dist<heap[right].dist)
-            {
-                heap[i] = heap[left];
-                heap_pos[heap[i].label] = i;
-                i = left;
-            }
-            else
-            {
-                heap[i] = heap[right];
-                heap_pos[heap[i].label] = i;
-                i = right;
-            }
-        }
-
-        if(i==size)
-        {
-            size--;
-            return res;
-        }
-
-        heap[i] = heap[size];
-        heap_pos[heap[i].label] = i;
-
-        int parent_i = i>>1;
-        while(heap[i].dist<heap[parent_i].dist)
-        {
-            nodeSwap(i,parent_i);
-            i=parent_i;
-            parent_i = i>>1;
-        }
-
+        while(buckets[cur].empty())
+            cur++;
+        vector<node>& bucket = buckets[cur];
+        size_t min_idx = 0;
+        for(size_t i=1;i<bucket.size();i++)
+            if(bucket[i].dist<bucket[min_idx].dist)
+                min_idx = i;
+        node res = bucket[min_idx];
+        bucket[min_idx] = bucket.back();
+        bucket.pop_back();
         size--;
         return res;
     }
-
-    //checks if node is already in the heap
-    //if not - add it
-    //if it is - update it with the min dist of the two
-    void updateNode(node n)
-    {
-        if(heap_pos[n.label])
-        {
-            int i = heap_pos[n.label];
-            heap[i].dist = min(heap[i].dist,n.dist);
-            int parent_i = i>>1;
-            while(heap[i].dist<heap[parent_i].dist)
-            {
-                nodeSwap(i,parent_i);
-                i=parent_i;
-                parent_i = i>>1;
-            }
-        }
-        else
-            add(n);
-    }
 };
 
-EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::GetKNNMatches_ParBody(EdgeAwareInterpolatorImpl& _inst, int _num_stripes):
-inst(&_inst),num_stripes(_num_stripes)
-{
-    stripe_sz = (int)ceil(inst->match_num/(double)num_stripes);
-}
-
-void EdgeAwareInterpolatorImpl::GetKNNMatches_ParBody::operator() (const Range& range) const
+// Geodesic k nearest neighbours of every match, found by a Dijkstra search over the match graph
+static void computeGeodesicKNN(const vector<vector<node> >& g, int k, Mat& NNlabels, Mat& NNdistances)
 {
-    int start = std::min(range.start * stripe_sz, inst->match_num);
-    int end   = std::min(range.end   * stripe_sz, inst->match_num);
-    nodeHeap q((int)inst->match_num);
-    int num_expanded_vertices;
-    unsigned char* expanded_flag = new unsigned char[inst->match_num];
-    node* neighbors;
+    int match_num = (int)g.size();
 
-    for(int i=start;i<end;i++)
+    // buckets as wide as an average edge hold a few nodes each
+    double dist_sum = 0.0;
+    size_t edge_num = 0;
+    for(int i=0;i<match_num;i++)
     {
-        if(inst->g[i].empty())
-            continue;
+        for(size_t j=0;j<g[i].size();j++)
+            dist_sum += g[i][j].dist;
+        edge_num += g[i].size();
+    }
+    float bucket_width = edge_num>0 ? (float)(dist_sum/edge_num) : 1.0f;
+    if(!(bucket_width>0.0f))
+        bucket_width = 1.0f;
 
-        num_expanded_vertices = 0;
-        memset(expanded_flag,0,inst->match_num);
-        q.clear();
-        q.add(node((int)i,0.0f));
-        int* NNlabels_row    = inst->NNlabels.ptr<int>(i);
-        float* NNdistances_row = inst->NNdistances.ptr<float>(i);
-        while(num_expanded_vertices<inst->k && !q.empty())
+    parallel_for_(Range(0,match_num),[&](const Range& range)
+    {
+        nodeBucketQueue q(bucket_width);
+        vector<unsigned char> expanded_flag(match_num,0);
+        vector<float> best_dist(match_num,std::numeric_limits<float>::max());
+        vector<int> visited;
+        for(int i=range.start;i<range.end;i++)
         {
-            node vert_for_expansion = q.getMin();
-            expanded_flag[vert_for_expansion.label] = 1;
+            if(g[i].empty())
+                continue;
+
+            int num_expanded_vertices = 0;
+            q.clear();
+            q.add(node(i,0.0f));
+            best_dist[i] = 0.0f;
+            visited.push_back(i);
+            int* NNlabels_row = NNlabels.ptr<int>(i);
+            float* NNdistances_row = NNdistances.ptr<float>(i);
+            while(num_expanded_vertices<k && !q.empty())
+            {
+                node vert_for_expansion = q.getMin();
+                if(expanded_flag[vert_for_expansion.label])
+                    continue;
+                expanded_flag[vert_for_expansion.label] = 1;
 
-            //write the expanded vertex to the dst:
-            NNlabels_row[num_expanded_vertices] = vert_for_expansion.label;
-            NNdistances_row[num_expanded_vertices] = vert_for_expansion.dist;
-            num_expanded_vertices++;
+                //write the expanded vertex to the dst:
+                NNlabels_row[num_expanded_vertices] = vert_for_expansion.label;
+                NNdistances_row[num_expanded_vertices] = vert_for_expansion.dist;
+                num_expanded_vertices++;
+
+                //update the queue:
+                const vector<node>& neighbors = g[vert_for_expansion.label];
+                for(size_t j=0;j<neighbors.size();j++)
+                {
+                    int l = neighbors[j].label;
+                    float d = vert_for_expansion.dist+neighbors[j].dist;
+                    if(!expanded_flag[l] && d<best_dist[l])
+                    {
+                        if(best_dist[l]==std::numeric_limits<float>::max())
+                            visited.push_back(l);
+                        best_dist[l] = d;
+                        q.add(node(l,d));
+                    }
+                }
+            }
 
-            //update the heap:
-            neighbors = &inst->g[vert_for_expansion.label].front();
-            for(int j=0;j<(int)inst->g[vert_for_expansion.label].size();j++)
+            for(size_t j=0;j<visited.size();j++)
             {
-                if(!expanded_flag[neighbors[j].label])
-                    q.updateNode(node(neighbors[j].label,vert_for_expansion.dist+neighbors[j].dist));
+                expanded_flag[visited[j]] = 0;
+                best_dist[visited[j]] = std::numeric_limits<float>::max();
             }
+            visited.clear();
         }
-    }
-    delete[] expanded_flag;
+    }, 4*getNumThreads());
 }
 
 static void weightedLeastSquaresAffineFit(int* labels, float* weights, int count, float lambda, const SparseMatch* matches, Mat& dst)
@@ -904,6 +908,16 @@ protected:
     static const int distance_transform_num_iter = 1;
     float lambda;
 
+    // structures kept between calls in cached mode
+    bool use_geodesic_cache;
+    GeodesicCacheKey geodesic_cache_key;
+    Mat sp_cache_image;
+    int sp_cache_size;
+    float sp_cache_ruler;
+    SLICType sp_cache_type;
+    int spCnt;
+    Mat spLabels, spNN, spPos, spItems;
+
     //tunable parameters:
     int max_neighbors;
     float alpha;
@@ -966,6 +980,18 @@ public:
     float getFGSLambda() const CV_OVERRIDE { return fgs_lambda; }
     void  setFGSSigma(float _sigma) CV_OVERRIDE { fgs_sigma = _sigma; }
     float getFGSSigma() const CV_OVERRIDE { return fgs_sigma; }
+    void  setUseGeodesicCache(bool val) CV_OVERRIDE
+    {
+        use_geodesic_cache = val;
+        geodesic_cache_key.clear();
+        sp_cache_image.release();
+    }
+    bool  getUseGeodesicCache() const CV_OVERRIDE { return use_geodesic_cache; }
+    void  getGeodesicNeighbors(OutputArray _labels, OutputArray _distances) const CV_OVERRIDE
+    {
+        NNlabels.copyTo(_labels);
+        NNdistances.copyTo(_distances);
+    }
 };
 
 Ptr<RICInterpolatorImpl> RICInterpolatorImpl::create()
@@ -993,6 +1019,11 @@ void RICInterpolatorImpl::init()
     fgs_sigma = 1.5f;
     slic_type = SLIC;
     costMap = Mat();
+    use_geodesic_cache = false;
+    sp_cache_size = 0;
+    sp_cache_ruler = 0.f;
+    sp_cache_type = SLIC;
+    spCnt = 0;
 }
 
 struct MinHeap
@@ -1117,16 +1148,6 @@ void RICInterpolatorImpl::interpolate(InputArray from_image, InputArray from_poi
     Mat src = from_image.getMat();
     Size src_size = src.size();
 
-    labels = Mat(src_size, CV_32SC1);
-    labels.setTo(-1);
-    NNlabels = Mat(match_num, max_neighbors, CV_32S);
-    NNlabels = Scalar(-1);
-    NNdistances = Mat(match_num, max_neighbors, CV_32F);
-    NNdistances = Scalar(0.0f);
-
-    Mat matDistanceMap(src_size, CV_32FC1);
-    matDistanceMap.setTo(1e10);
-
     if (costMap.empty())
     {
         costMap.create(src_size, CV_32FC1);
@@ -1135,68 +1156,55 @@ void RICInterpolatorImpl::interpolate(InputArray from_image, InputArray from_poi
     else
         CV_Assert(costMap.rows == src.rows && costMap.cols == src.cols );
 
-    costMap = (1000.0f - lambda) + lambda * costMap;
-
-    for (unsigned int i = 0; i < matches_vector.size(); i++)
+    // the geodesic structures of the previous call are still valid for the same cost map and match positions
+    if (!use_geodesic_cache || !geodesic_cache_key.equals(costMap, matches_vector, lambda, max_neighbors))
     {
-        const SparseMatch & p = matches_vector[i];
-        Point pos(static_cast<int>(p.reference_image_pos.x), static_cast<int>(p.reference_image_pos.y));
-        labels.at<int>(pos) = i;
-        matDistanceMap.at<float>(pos) = costMap.at<float>(pos);
-    }
+        if (use_geodesic_cache)
+            geodesic_cache_key.set(costMap, matches_vector, lambda, max_neighbors);
 
-    geodesicDistanceTransform(matDistanceMap, costMap);
+        labels = Mat(src_size, CV_32SC1);
+        labels.setTo(-1);
+        NNlabels = Mat(match_num, max_neighbors, CV_32S);
+        NNlabels = Scalar(-1);
+        NNdistances = Mat(match_num, max_neighbors, CV_32F);
+        NNdistances = Scalar(0.0f);
 
-    g.resize(match_num);
-    buildGraph(matDistanceMap, costMap);
-    parallel_for_(Range(0, getNumThreads()), [&](const Range & range)
-    {
-        int stripe_sz = (int)ceil(match_num / (double)getNumThreads());
-        int start = std::min(range.start * stripe_sz, match_num);
-        int end = std::min(range.end   * stripe_sz, match_num);
-        nodeHeap q((int)match_num);
-        int num_expanded_vertices;
-        vector<unsigned int> expanded_flag(match_num);
-        node* neighbors;
-        for (int i = start; i < end; i++)
-        {
-            if (g[i].empty())
-                continue;
-            num_expanded_vertices = 0;
-            fill(expanded_flag.begin(), expanded_flag.end(), 0);
-            q.clear();
-            q.add(node((int)i, 0.0f));
-            int* NNlabels_row = NNlabels.ptr<int>(i);
-            float* NNdistances_row = NNdistances.ptr<float>(i);
-            while (num_expanded_vertices < max_neighbors && !q.empty())
-            {
-                node vert_for_expansion = q.getMin();
-                expanded_flag[vert_for_expansion.label] = 1;
+        Mat matDistanceMap(src_size, CV_32FC1);
+        matDistanceMap.setTo(1e10);
 
-                //write the expanded vertex to the dst:
-                NNlabels_row[num_expanded_vertices] = vert_for_expansion.label;
-                NNdistances_row[num_expanded_vertices] = vert_for_expansion.dist;
-                num_expanded_vertices++;
+        Mat cost_map = (1000.0f - lambda) + lambda * costMap;
 
-                //update the heap:
-                neighbors = &g[vert_for_expansion.label].front();
-                for (int j = 0; j < (int)g[vert_for_expansion.label].size(); j++)
-                {
-                    if (!expanded_flag[neighbors[j].label])
-                        q.updateNode(node(neighbors[j].label, vert_for_expansion.dist + neighbors[j].dist));
-                }
-            }
+        for (unsigned int i = 0; i < matches_vector.size(); i++)
+        {
+            const SparseMatch & p = matches_vector[i];
+            Point pos(static_cast<int>(p.reference_image_pos.x), static_cast<int>(p.reference_image_pos.y));
+            labels.at<int>(pos) = i;
+            matDistanceMap.at<float>(pos) = cost_map.at<float>(pos);
         }
-    });
 
-    Mat spLabels;
-    Mat spNN;
-    Mat spPos;
-    Mat spItems;
+        geodesicDistanceTransform(matDistanceMap, cost_map);
+
+        g.assign(match_num, vector<node>());
+        buildGraph(matDistanceMap, cost_map);
+        computeGeodesicKNN(g, max_neighbors, NNlabels, NNdistances);
+    }
 
-    int spCnt = overSegmentaion(src, spLabels, sp_size);
-    superpixelNeighborConstruction(spLabels, spCnt, spNN);
-    superpixelLayoutAnalysis(spLabels, spCnt, spPos, spItems);
+    // the superpixels only depend on the reference image
+    if (!use_geodesic_cache || sp_cache_image.empty() || sp_cache_image.size() != src.size() ||
+        sp_cache_image.type() != src.type() || sp_cache_size != sp_size || sp_cache_ruler != sp_ruler ||
+        sp_cache_type != slic_type || norm(sp_cache_image, src, NORM_INF) != 0)
+    {
+        spCnt = overSegmentaion(src, spLabels, sp_size);
+        superpixelNeighborConstruction(spLabels, spCnt, spNN);
+        superpixelLayoutAnalysis(spLabels, spCnt, spPos, spItems);
+        if (use_geodesic_cache)
+        {
+            src.copyTo(sp_cache_image);
+            sp_cache_size = sp_size;
+            sp_cache_ruler = sp_ruler;
+            sp_cache_type = slic_type;
+        }
+    }
 
     vector<int> srcMatchIds(spCnt);
     for (int i = 0; i < spCnt; i++)
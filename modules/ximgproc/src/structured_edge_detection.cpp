@@ -47,14 +47,6 @@
 
 #include "advanced_types.hpp"
 
-#ifdef CV_CXX11
-#define CV_USE_PARALLEL_PREDICT_EDGES_1 1
-#define CV_USE_PARALLEL_PREDICT_EDGES_2 0  //1, see https://github.com/opencv/opencv_contrib/issues/2346
-#else
-#define CV_USE_PARALLEL_PREDICT_EDGES_1 0
-#define CV_USE_PARALLEL_PREDICT_EDGES_2 0
-#endif
-
 /********************* Helper functions *********************/
 
 /*!
@@ -689,8 +681,6 @@ protected:
         NChannelsMat regFeatures = imsmooth(features, cvRound(rfs / float(shrink)));
         NChannelsMat  ssFeatures = imsmooth(features, cvRound(sfs / float(shrink)));
 
-        NChannelsMat indexes(height, width, CV_MAKETYPE(DataType<int>::type, nTreesEval));
-
         std::vector <int> offsetI(/**/ CV_SQR(pSize/shrink)*nchannels, 0);
         for (int i = 0; i < CV_SQR(pSize/shrink)*nchannels; ++i)
         {
@@ -705,13 +695,13 @@ protected:
         std::vector <int> offsetE(/**/ CV_SQR(ipSize)*outNum, 0);
         for (int i = 0; i < CV_SQR(ipSize)*outNum; ++i)
         {
-            int z = i / CV_SQR(ipSize);
             int y = ( i % CV_SQR(ipSize) )/ipSize;
             int x = ( i % CV_SQR(ipSize) )%ipSize;
 
-            offsetE[i] = x*dst.cols*outNum + y*outNum + z;
+            offsetE[i] = x*dst.cols + y;
         }
         // lookup table for mapping linear index to offsets
+        // (output channels are summed in the end, so they all map to the same pixel)
 
         std::vector <int> offsetX( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
         std::vector <int> offsetY( CV_SQR(gridSize)*(CV_SQR(gridSize) - 1)/2 * nchannels, 0);
@@ -738,100 +728,119 @@ protected:
             }
             // lookup tables for mapping linear index to offset pairs
 
-        #if CV_USE_PARALLEL_PREDICT_EDGES_1
-        parallel_for_(cv::Range(0, height), [&](const cv::Range& range)
-        #else
-        const cv::Range range(0, height);
-        #endif
+        const int nNodes = int( __rf.childs.size() );
+        std::vector <int> nodeOffsetA(nNodes, 0), nodeOffsetB(nNodes, -1), nodeLeft(nNodes, -1);
+
+        for (int node = 0; node < nNodes; ++node)
+        {
+            if (__rf.childs[node] == 0)
+                continue;
+
+            int currentId = __rf.featureIds[node];
+            if (currentId >= nFeatures)
+            {
+                nodeOffsetA[node] = offsetX[currentId - nFeatures];
+                nodeOffsetB[node] = offsetY[currentId - nFeatures];
+            }
+            else
+                nodeOffsetA[node] = offsetI[currentId];
+
+            nodeLeft[node] = (node/nTreesNodes)*nTreesNodes + __rf.childs[node] - 1;
+        }
+        // flat forest layout for this image size: node -> offset(s) of its feature
+        // (the difference of two ssFeatures when nodeOffsetB >= 0, a regFeature otherwise)
+        // and absolute index of its left child (the right one follows it, -1 for leaves)
+
+        const float *thresholds = &__rf.thresholds[0];
+        const int nBnds = ( int(__rf.edgeBoundaries.size()) - 1 )/(nTreesNodes*nTrees);
+        const float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
+
+        // Rows of patches are processed in bands, each band accumulates its
+        // edges in its own buffer and the buffers are summed up in order
+        const int bandHeight = 8;
+        const int nBands = (height + bandHeight - 1)/bandHeight;
+        const int bufferRows = (bandHeight - 1)*stride + ipSize;
+
+        std::vector <cv::Mat> buffers(nBands);
+
+        parallel_for_(cv::Range(0, nBands), [&](const cv::Range& range)
         {
-            for(int i = range.start; i < range.end; ++i) {
-                float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
-                float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+            std::vector <int> nodes(nTreesEval);
+
+            for (int band = range.start; band < range.end; ++band)
+            {
+                cv::Mat &buffer = buffers[band];
+                buffer = cv::Mat::zeros(bufferRows, dst.cols, CV_32FC1);
 
-                int *indexPtr = indexes.ptr<int>(i);
+                const int iStart = band*bandHeight;
+                const int iEnd = std::min(iStart + bandHeight, height);
 
-                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                    // for j,k in [0;width)x[0;nTreesEval)
+                for (int i = iStart; i < iEnd; ++i)
                 {
-                    int baseNode = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
-                    int currentNode = baseNode;
-                    // select root node of the tree to evaluate
+                    const float *regFeaturesPtr = regFeatures.ptr<float>(i*stride/shrink);
+                    const float  *ssFeaturesPtr = ssFeatures.ptr<float>(i*stride/shrink);
+
+                    float *pDst = buffer.ptr<float>((i - iStart)*stride);
 
-                    int offset = (j*stride/shrink)*nchannels;
-                    while ( __rf.childs[currentNode] != 0 )
+                    for (int j = 0; j < width; ++j)
                     {
-                        int currentId = __rf.featureIds[currentNode];
-                        float currentFeature;
+                        int offset = (j*stride/shrink)*nchannels;
+                        const float *regPtr = regFeaturesPtr + offset;
+                        const float  *ssPtr = ssFeaturesPtr + offset;
 
-                        if (currentId >= nFeatures)
+                        for (int k = 0; k < nTreesEval; ++k)
+                            nodes[k] = ( ((i + j)%(2*nTreesEval) + k)%nTrees )*nTreesNodes;
+                        // select root nodes of the trees to evaluate
+
+                        for (int active = nTreesEval; active > 0; )
                         {
-                            int xIndex = offsetX[currentId - nFeatures];
-                            float A = ssFeaturesPtr[offset + xIndex];
+                            active = 0;
+                            for (int k = 0; k < nTreesEval; ++k)
+                            {
+                                int currentNode = nodes[k];
+                                int left = nodeLeft[currentNode];
+                                if (left < 0)
+                                    continue;
+
+                                int offsetB = nodeOffsetB[currentNode];
+                                float currentFeature = offsetB < 0
+                                    ? regPtr[nodeOffsetA[currentNode]]
+                                    : ssPtr[nodeOffsetA[currentNode]] - ssPtr[offsetB];
+
+                                // compare feature to threshold and move left or right accordingly
+                                nodes[k] = left + (currentFeature < thresholds[currentNode] ? 0 : 1);
+                                ++active;
+                            }
+                        }
+                        // walk down all the trees in lockstep, so their memory accesses overlap
 
-                            int yIndex = offsetY[currentId - nFeatures];
-                            float B = ssFeaturesPtr[offset + yIndex];
+                        for (int k = 0; k < nTreesEval; ++k)
+                        {
+                            int start = __rf.edgeBoundaries[nodes[k]*nBnds];
+                            int finish = __rf.edgeBoundaries[nodes[k]*nBnds + 1];
 
-                            currentFeature = A - B;
+                            float *pPatch = pDst + j*stride;
+                            for (int p = start; p < finish; ++p)
+                                pPatch[offsetE[__rf.edgeBins[p]]] += step;
                         }
-                        else
-                            currentFeature = regFeaturesPtr[offset + offsetI[currentId]];
-
-                        // compare feature to threshold and move left or right accordingly
-                        if (currentFeature < __rf.thresholds[currentNode])
-                            currentNode = baseNode + __rf.childs[currentNode] - 1;
-                        else
-                            currentNode = baseNode + __rf.childs[currentNode];
                     }
-
-                    indexPtr[j*nTreesEval + k] = currentNode;
                 }
             }
-        }
-        #if CV_USE_PARALLEL_PREDICT_EDGES_1
-        );
-        #endif
-
-        NChannelsMat dstM(dst.size(),
-            CV_MAKETYPE(DataType<float>::type, outNum));
-        dstM.setTo(0);
-
-        float step = 2.0f * CV_SQR(stride) / CV_SQR(ipSize) / nTreesEval;
-        #if CV_USE_PARALLEL_PREDICT_EDGES_2
-        parallel_for_(cv::Range(0, height), [&](const cv::Range& range)
-        #elif CV_USE_PARALLEL_PREDICT_EDGES_1
-        const cv::Range range(0, height);
-        #endif
-        {
-            for(int i = range.start; i < range.end; ++i)
-            {
-                int *pIndex = indexes.ptr<int>(i);
-                float *pDst = dstM.ptr<float>(i*stride);
-
-                for (int j = 0, k = 0; j < width; ++k, j += !(k %= nTreesEval))
-                {// for j,k in [0;width)x[0;nTreesEval)
-
-                    int currentNode = pIndex[j*nTreesEval + k];
-                    size_t sizeBoundaries = __rf.edgeBoundaries.size();
-                    int convertedBoundaries = static_cast<int>(sizeBoundaries);
-                    int nBnds = (convertedBoundaries - 1) / (nTreesNodes * nTrees);
-                    int start = __rf.edgeBoundaries[currentNode * nBnds];
-                    int finish = __rf.edgeBoundaries[currentNode * nBnds + 1];
+        });
 
-                    if (start == finish)
-                        continue;
+        cv::Mat edgeMap = cv::Mat::zeros(dst.size(), CV_32FC1);
+        for (int band = 0; band < nBands; ++band)
+        {
+            int rowStart = band*bandHeight*stride;
+            int rowEnd = std::min(rowStart + bufferRows, dst.rows);
+            if (rowStart >= rowEnd)
+                continue;
 
-                    int offset = j*stride*outNum;
-                    for (int p = start; p < finish; ++p)
-                        pDst[offset + offsetE[__rf.edgeBins[p]]] += step;
-                }
-            }
+            cv::Mat roi = edgeMap.rowRange(rowStart, rowEnd);
+            roi += buffers[band].rowRange(0, rowEnd - rowStart);
         }
-        #if CV_USE_PARALLEL_PREDICT_EDGES_2
-        );
-        #endif
 
-        cv::reduce( dstM.reshape(1, int( dstM.total() ) ), dstM, 2, CV_REDUCE_SUM);
-        imsmooth( dstM.reshape(1, dst.rows), 1 ).copyTo(dst);
+        imsmooth( edgeMap, 1 ).copyTo(dst);
     }
 
 /********************* Members *********************/
@@ -1,87 +1,221 @@
 #include "precomp.hpp"
+#include "opencv2/core/hal/intrin.hpp"
 
 using namespace std;
 
 namespace cv {
 namespace ximgproc {
 
-// Applies a thinning iteration to a binary image
-static void thinningIteration(Mat img, int iter, int thinningType){
-    Mat marker = Mat::zeros(img.size(), CV_8UC1);
-
+// Decides whether a pixel is removed by a thinning iteration, given its neighbours
+//   p9 p2 p3
+//   p8 p1 p4
+//   p7 p6 p5
+static bool thinningCondition(int iter, int thinningType,
+                              int p2, int p3, int p4, int p5, int p6, int p7, int p8, int p9)
+{
     if(thinningType == THINNING_ZHANGSUEN){
-        for (int i = 1; i < img.rows-1; i++)
+        int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
+                 (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
+                 (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                 (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+        int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+        int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+        int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+
+        return A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0;
+    }
+    if(thinningType == THINNING_GUOHALL){
+        int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
+                 ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
+        int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
+        int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
+        int N  = N1 < N2 ? N1 : N2;
+        int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
+
+        return (C == 1) && ((N >= 2) && ((N <= 3)) & (m == 0));
+    }
+    return false;
+}
+
+// Neighbourhood codes: bit k is set when neighbour p(k+2) is set
+static void buildThinningLut(uchar lut[2][256], int thinningType)
+{
+    for (int iter = 0; iter < 2; iter++)
+    {
+        for (int code = 0; code < 256; code++)
         {
-            for (int j = 1; j < img.cols-1; j++)
+            lut[iter][code] = thinningCondition(iter, thinningType,
+                    code & 1, (code >> 1) & 1, (code >> 2) & 1, (code >> 3) & 1,
+                    (code >> 4) & 1, (code >> 5) & 1, (code >> 6) & 1, (code >> 7) & 1);
+        }
+    }
+}
+
+static inline int neighbourCode(const uchar* p, size_t step)
+{
+    return  p[-(ptrdiff_t)step]            | (p[1 - (ptrdiff_t)step] << 1) |
+           (p[1] << 2)                     | (p[step + 1] << 3) |
+           (p[step] << 4)                  | (p[step - 1] << 5) |
+           (p[-1] << 6)                    | (p[-1 - (ptrdiff_t)step] << 7);
+}
+
+// Computes the neighbourhood codes of the interior pixels of row i
+static void rowNeighbourCodes(const Mat& img, int i, uchar* codes)
+{
+    const uchar* r0 = img.ptr<uchar>(i - 1);
+    const uchar* r1 = img.ptr<uchar>(i);
+    const uchar* r2 = img.ptr<uchar>(i + 1);
+    int j = 1;
+#if CV_SIMD128
+    const v_uint8x16 z = v_setzero_u8();
+    for (; j <= img.cols - 1 - v_uint8x16::nlanes; j += v_uint8x16::nlanes)
+    {
+        v_uint8x16 c =  (v_load(r0 + j)     != z) & v_setall_u8(1);
+        c = c | ((v_load(r0 + j + 1) != z) & v_setall_u8(2));
+        c = c | ((v_load(r1 + j + 1) != z) & v_setall_u8(4));
+        c = c | ((v_load(r2 + j + 1) != z) & v_setall_u8(8));
+        c = c | ((v_load(r2 + j)     != z) & v_setall_u8(16));
+        c = c | ((v_load(r2 + j - 1) != z) & v_setall_u8(32));
+        c = c | ((v_load(r1 + j - 1) != z) & v_setall_u8(64));
+        c = c | ((v_load(r0 + j - 1) != z) & v_setall_u8(128));
+        v_store(codes + j, c);
+    }
+#endif
+    for (; j < img.cols - 1; j++)
+        codes[j] = (uchar)neighbourCode(r1 + j, img.step);
+}
+
+// Applies a thinning iteration to all the interior pixels of a binary image,
+// appending the removed pixels to "removed"
+static void thinningIterationDense(Mat& img, const uchar* lut,
+                                   vector<vector<int> >& rowRemoved, vector<int>& removed)
+{
+    const int rows = img.rows, cols = img.cols;
+    rowRemoved.resize(rows);
+
+    parallel_for_(Range(1, rows - 1), [&](const Range& range)
+    {
+        vector<uchar> codes(cols);
+        for (int i = range.start; i < range.end; i++)
+        {
+            const uchar* r1 = img.ptr<uchar>(i);
+            vector<int>& rm = rowRemoved[i];
+            rm.clear();
+            rowNeighbourCodes(img, i, &codes[0]);
+            for (int j = 1; j < cols - 1; j++)
             {
-                uchar p2 = img.at<uchar>(i-1, j);
-                uchar p3 = img.at<uchar>(i-1, j+1);
-                uchar p4 = img.at<uchar>(i, j+1);
-                uchar p5 = img.at<uchar>(i+1, j+1);
-                uchar p6 = img.at<uchar>(i+1, j);
-                uchar p7 = img.at<uchar>(i+1, j-1);
-                uchar p8 = img.at<uchar>(i, j-1);
-                uchar p9 = img.at<uchar>(i-1, j-1);
-
-                int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
-                         (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
-                         (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
-                         (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
-                int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
-                int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
-                int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
-
-                if (A == 1 && (B >= 2 && B <= 6) && m1 == 0 && m2 == 0)
-                    marker.at<uchar>(i,j) = 1;
+                if (r1[j] && lut[codes[j]])
+                    rm.push_back(i * cols + j);
             }
         }
+    });
+
+    removed.clear();
+    for (int i = 1; i < rows - 1; i++)
+        removed.insert(removed.end(), rowRemoved[i].begin(), rowRemoved[i].end());
+    uchar* data = img.ptr<uchar>();
+    for (size_t k = 0; k < removed.size(); k++)
+        data[removed[k]] = 0;
+}
+
+// Applies a thinning iteration to the candidate pixels only
+static void thinningIterationFrontier(Mat& img, const uchar* lut, const vector<int>& candidates,
+                                      vector<uchar>& decisions, vector<int>& removed)
+{
+    const int cols = img.cols;
+    const size_t step = img.step;
+    uchar* data = img.ptr<uchar>();
+    const int n = (int)candidates.size();
+    decisions.resize(n);
+
+    parallel_for_(Range(0, n), [&](const Range& range)
+    {
+        for (int k = range.start; k < range.end; k++)
+        {
+            int idx = candidates[k];
+            const uchar* p = data + (size_t)(idx / cols) * step + idx % cols;
+            decisions[k] = lut[neighbourCode(p, step)];
+        }
+    });
+
+    removed.clear();
+    for (int k = 0; k < n; k++)
+    {
+        if (decisions[k])
+            removed.push_back(candidates[k]);
     }
-    if(thinningType == THINNING_GUOHALL){
-        for (int i = 1; i < img.rows-1; i++)
+    for (size_t k = 0; k < removed.size(); k++)
+        data[removed[k]] = 0;
+}
+
+// Collects the interior foreground pixels next to the pixels removed by the two previous iterations.
+// Their neighbourhood may have changed since they were examined with the same iteration type,
+// the decision for any other pixel is the same as two iterations ago.
+static void collectCandidates(const Mat& img, const vector<int>& removed0, const vector<int>& removed1,
+                              vector<int>& stamp, int iteration, vector<int>& candidates)
+{
+    const int rows = img.rows, cols = img.cols;
+    const uchar* data = img.ptr<uchar>();
+    candidates.clear();
+    const vector<int>* lists[2] = { &removed0, &removed1 };
+    for (int l = 0; l < 2; l++)
+    {
+        const vector<int>& removed = *lists[l];
+        for (size_t k = 0; k < removed.size(); k++)
         {
-            for (int j = 1; j < img.cols-1; j++)
+            int i0 = removed[k] / cols, j0 = removed[k] % cols;
+            for (int di = -1; di <= 1; di++)
             {
-                uchar p2 = img.at<uchar>(i-1, j);
-                uchar p3 = img.at<uchar>(i-1, j+1);
-                uchar p4 = img.at<uchar>(i, j+1);
-                uchar p5 = img.at<uchar>(i+1, j+1);
-                uchar p6 = img.at<uchar>(i+1, j);
-                uchar p7 = img.at<uchar>(i+1, j-1);
-                uchar p8 = img.at<uchar>(i, j-1);
-                uchar p9 = img.at<uchar>(i-1, j-1);
-
-                int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
-                         ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
-                int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
-                int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
-                int N  = N1 < N2 ? N1 : N2;
-                int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
-
-                if ((C == 1) && ((N >= 2) && ((N <= 3)) & (m == 0)))
-                    marker.at<uchar>(i,j) = 1;
+                int i = i0 + di;
+                if (i < 1 || i >= rows - 1)
+                    continue;
+                for (int dj = -1; dj <= 1; dj++)
+                {
+                    int j = j0 + dj;
+                    if (j < 1 || j >= cols - 1)
+                        continue;
+                    int idx = i * cols + j;
+                    if (data[idx] && stamp[idx] != iteration)
+                    {
+                        stamp[idx] = iteration;
+                        candidates.push_back(idx);
+                    }
+                }
             }
         }
     }
-
-    img &= ~marker;
+    // keep the memory accesses of the next iteration in raster order
+    std::sort(candidates.begin(), candidates.end());
 }
 
 // Apply the thinning procedure to a given image
 void thinning(InputArray input, OutputArray output, int thinningType){
     Mat processed = input.getMat().clone();
+    CV_Assert(processed.type() == CV_8UC1);
     // Enforce the range of the input image to be in between 0 - 255
     processed /= 255;
 
-    Mat prev = Mat::zeros(processed.size(), CV_8UC1);
-    Mat diff;
+    uchar lut[2][256];
+    buildThinningLut(lut, thinningType);
+
+    // The two first iterations examine all the pixels. Every following iteration only
+    // examines the pixels whose neighbourhood changed since they were examined last.
+    vector<vector<int> > rowRemoved;
+    vector<int> removed[2], candidates, stamp;
+    vector<uchar> decisions;
+    if (processed.rows > 2 && processed.cols > 2)
+    {
+        thinningIterationDense(processed, lut[0], rowRemoved, removed[0]);
+        thinningIterationDense(processed, lut[1], rowRemoved, removed[1]);
+        stamp.assign(processed.total(), -1);
 
-    do {
-        thinningIteration(processed, 0, thinningType);
-        thinningIteration(processed, 1, thinningType);
-        absdiff(processed, prev, diff);
-        processed.copyTo(prev);
+        for (int iteration = 2; !removed[0].empty() || !removed[1].empty(); iteration++)
+        {
+            int iter = iteration & 1;
+            collectCandidates(processed, removed[0], removed[1], stamp, iteration, candidates);
+            thinningIterationFrontier(processed, lut[iter], candidates, decisions, removed[iter]);
+        }
     }
-    while (countNonZero(diff) > 0);
 
     processed *= 255;
 
@@ -36,6 +36,7 @@
 
 #include "precomp.hpp"
 #include <opencv2/imgproc.hpp>
+#include "opencv2/core/hal/intrin.hpp"
 
 using namespace std;
 using namespace cv;
@@ -187,36 +188,13 @@ void float2D_release(float **p)
     delete []p;
 }
 
-/***************************************************************
- * Function: int2D
- * Description: allocate a 2D integer array with dimension "dim1 x dim2"
- ***************************************************************/
-int** int2D(int dim1, int dim2)
-{
-    int **ret = new int*[dim1];
-    ret[0] = new int[dim1*dim2];
-    for(int i=1;i<dim1;i++)ret[i] = ret[i-1]+dim2;
-
-    return ret;
-}
-
-/***************************************************************
- * Function: int2D_release
- * Description: deallocate the 2D array created by int2D()
- ***************************************************************/
-void int2D_release(int **p)
-{
-    delete []p[0];
-    delete []p;
-}
-
 /***************************************************************
  * Function: updateBCB
  * Description: maintain the necklace table of BCB
  ***************************************************************/
-inline void updateBCB(int &num,int *f,int *b,int i,int v)
+inline void updateBCB(int &num,int *f,int *b,int i,int v,int &linked)
 {
-    static int p1,p2;
+    int p1,p2;
 
     if(i)
     {
@@ -227,12 +205,14 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
             f[i]=p2;
             b[p2]=i;
             b[i]=0;
+            linked++;
         }
         else if(!(num+v))
         {// cell is becoming empty
             p1=b[i],p2=f[i];
             f[p1]=p2;
             b[p2]=p1;
+            linked--;
         }
     }
 
@@ -242,9 +222,9 @@ inline void updateBCB(int &num,int *f,int *b,int i,int v)
 
 /***************************************************************
  * Function: featureIndexing
- * Description: convert uchar feature image "F" to CV_32SC1 type.
- *                If F is 3-channel, perform k-means clustering
- *                If F is 1-channel, only perform type-casting
+ * Description: convert uchar feature image "F" to an image of feature indexes.
+ *                If F is 3-channel, perform k-means clustering, the indexes are CV_32SC1
+ *                If F is 1-channel, its values are used as indexes
  ***************************************************************/
 void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightType){
     // Configuration and Declaration
@@ -258,8 +238,8 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     {
         nF = 256;
 
-        // Type-casting
-        F.convertTo(FNew, CV_32S);
+        // The 8-bit values are used as feature indexes directly
+        FNew = F;
 
         // Compute weight map (weight between each pair of feature index)
         wMap = float2D(nF,nF);
@@ -294,9 +274,8 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     {
         const int shift = 2; // 256(8-bit)->64(6-bit)
         const int LOW_NUM = 256>>shift;
-        static int hash[LOW_NUM][LOW_NUM][LOW_NUM]={{{0}}};
-
-        memset(hash,0,sizeof(hash));
+        std::vector<int> hashBuf(LOW_NUM*LOW_NUM*LOW_NUM, 0);
+        int (*hash)[LOW_NUM][LOW_NUM] = (int (*)[LOW_NUM][LOW_NUM])&hashBuf[0];
 
         // throw pixels into a 2D histogram
         int candCnt = 0;
@@ -409,246 +388,311 @@ void featureIndexing(Mat &F, float **&wMap, int &nF, float sigmaI, int weightTyp
     F = FNew;
 }
 
-Mat filterCore(Mat &I, Mat &F, float **wMap, int r=20, int nF=256, int nI=256, Mat mask=Mat())
+/***************************************************************
+ * Struct: HistWorkspace
+ * Description: joint-histogram, BCB and their necklace tables used to filter one column.
+ *                Every column leaves the histograms empty, so a workspace is cleared only once
+ *                and then reused by all the columns processed by a thread.
+ ***************************************************************/
+struct HistWorkspace
 {
-    // Check validation
-    assert(I.depth() == CV_32S && I.channels()==1);//input image: 32SC1
-    assert(F.depth() == CV_32S && F.channels()==1);//feature image: 32SC1
-
-    // Configuration and declaration
-    int rows = I.rows, cols = I.cols;
-    Mat outImg = I.clone();
+    std::vector<int> H, Hf, Hb;
+    std::vector<int> BCB, BCBf, BCBb;
 
-    // Handle Mask
-    if(mask.empty())
+    void create(int nI, int nF)
     {
-        mask = Mat(I.size(),CV_8U);
-        mask = Scalar(1);
+        if((int)BCB.size() == nF && (int)H.size() == nI*nF)
+            return;
+        H.assign(nI*nF, 0);
+        Hf.assign(nI*nF, 0);
+        Hb.assign(nI*nF, 0);
+        BCB.assign(nF, 0);
+        BCBf.assign(nF, 0);
+        BCBb.assign(nF, 0);
     }
+};
 
-    // Allocate memory for joint-histogram and BCB
-    int **H = int2D(nI,nF);
-    int *BCB = new int[nF];
+/***************************************************************
+ * Function: balanceDense
+ * Description: dot product of the whole BCB with a row of the weight map.
+ *                Used instead of the necklace walk when most of the BCB cells are non-empty.
+ ***************************************************************/
+inline float balanceDense(const int *BCB, const float *fPtr, int nF)
+{
+    int i = 0;
+    float sum = 0;
+#if CV_SIMD128
+    v_float32x4 vsum = v_setzero_f32();
+    for(; i <= nF - 4; i += 4)
+        vsum = v_muladd(v_cvt_f32(v_load(BCB + i)), v_load(fPtr + i), vsum);
+    sum = v_reduce_sum(vsum);
+#endif
+    for(; i < nF; i++)
+        sum += BCB[i]*fPtr[i];
+    return sum;
+}
 
-    // Allocate links for necklace table
-    int **Hf = int2D(nI,nF);//forward link
-    int **Hb = int2D(nI,nF);//backward link
-    int *BCBf = new int[nF];//forward link
-    int *BCBb = new int[nF];//backward link
+/***************************************************************
+ * Function: filterColumn
+ * Description: joint-histogram filtering of column "x" of the quantized image "I" guided by
+ *                the feature index image "F". Input indexes are read as TI (uchar for 8-bit
+ *                sources, int for quantized floating-point sources), feature indexes as TF.
+ ***************************************************************/
+template<typename TI, typename TF>
+void filterColumn(const Mat &I, const Mat &F, const Mat &mask, Mat &outImg, HistWorkspace &ws,
+                  float **wMap, int x, int r, int nF, int nI)
+{
+    int rows = I.rows, cols = I.cols;
 
-    // Column Scanning
-    for(int x=0;x<cols;x++)
-    {
-        // Reset histogram and BCB for each column
-        memset(BCB, 0, sizeof(int)*nF);
-        memset(H[0], 0, sizeof(int)*nF*nI);
-        for(int i=0;i<nI;i++)Hf[i][0]=Hb[i][0]=0;
-        BCBf[0]=BCBb[0]=0;
-
-        // Reset cut-point
-        int medianVal = -1;
-
-        // Precompute "x" range and checks boundary
-        int downX = max(0,x-r);
-        int upX = min(cols-1,x+r);
-
-        // Initialize joint-histogram and BCB for the first window
-        int upY = min(rows-1,r);
-        for(int i=0;i<=upY;i++)
-        {
-            int *IPtr = I.ptr<int>(i);
-            int *FPtr = F.ptr<int>(i);
-            uchar *maskPtr = mask.ptr<uchar>(i);
+    int *BCB = &ws.BCB[0];
+    int *BCBf = &ws.BCBf[0];
+    int *BCBb = &ws.BCBb[0];
+    int *H0 = &ws.H[0];
+    int *Hf0 = &ws.Hf[0];
+    int *Hb0 = &ws.Hb[0];
 
-            for(int j=downX;j<=upX;j++)
-            {
-                if(!maskPtr[j])continue;
+    // Reset necklace tables; the histograms are empty
+    for(int i=0;i<nI;i++)Hf0[i*nF]=Hb0[i*nF]=0;
+    BCBf[0]=BCBb[0]=0;
+    int linked = 0;
 
-                int fval = IPtr[j];
-                int *curHist = H[fval];
-                int gval = FPtr[j];
+    // Reset cut-point
+    int medianVal = -1;
 
-                // Maintain necklace table of joint-histogram
-                if(!curHist[gval] && gval)
-                {
-                    int *curHf = Hf[fval];
-                    int *curHb = Hb[fval];
+    // Precompute "x" range and checks boundary
+    int downX = max(0,x-r);
+    int upX = min(cols-1,x+r);
 
-                    int p1=0,p2=curHf[0];
-                    curHf[p1]=gval;
-                    curHf[gval]=p2;
-                    curHb[p2]=gval;
-                    curHb[gval]=p1;
-                }
+    // Initialize joint-histogram and BCB for the first window
+    int upY = min(rows-1,r);
+    for(int i=0;i<=upY;i++)
+    {
+        const TI *IPtr = I.ptr<TI>(i);
+        const TF *FPtr = F.ptr<TF>(i);
+        const uchar *maskPtr = mask.ptr<uchar>(i);
 
-                curHist[gval]++;
-                // Maintain necklace table of BCB
-                updateBCB(BCB[gval],BCBf,BCBb,gval,-1);
+        for(int j=downX;j<=upX;j++)
+        {
+            if(!maskPtr[j])continue;
+
+            int fval = IPtr[j];
+            int *curHist = H0 + fval*nF;
+            int gval = FPtr[j];
+
+            // Maintain necklace table of joint-histogram
+            if(!curHist[gval] && gval)
+            {
+                int *curHf = Hf0 + fval*nF;
+                int *curHb = Hb0 + fval*nF;
+
+                int p1=0,p2=curHf[0];
+                curHf[p1]=gval;
+                curHf[gval]=p2;
+                curHb[p2]=gval;
+                curHb[gval]=p1;
             }
+
+            curHist[gval]++;
+            // Maintain necklace table of BCB
+            updateBCB(BCB[gval],BCBf,BCBb,gval,-1,linked);
         }
+    }
 
-        for(int y=0;y<rows;y++)
+    for(int y=0;y<rows;y++)
+    {
+        // Find weighted median with help of BCB and joint-histogram
+        float balanceWeight = 0;
+        int curIndex = F.ptr<TF>(y)[x];
+        float *fPtr = wMap[curIndex];
+        int &curMedianVal = medianVal;
+
+        // Compute current balance
+        if(linked*8 >= nF)
+        {
+            balanceWeight = balanceDense(BCB, fPtr, nF);
+        }
+        else
         {
-            // Find weighted median with help of BCB and joint-histogram
-            float balanceWeight = 0;
-            int curIndex = F.ptr<int>(y,x)[0];
-            float *fPtr = wMap[curIndex];
-            int &curMedianVal = medianVal;
+            int i=0;
+            do
+            {
+                balanceWeight += BCB[i]*fPtr[i];
+                i=BCBf[i];
+            }while(i);
+        }
 
-            // Compute current balance
+        // Move cut-point to the left
+        if(balanceWeight >= 0)
+        {
+            for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
             {
+                float curWeight = 0;
+                int *nextHist = H0 + curMedianVal*nF;
+                int *nextHf = Hf0 + curMedianVal*nF;
+
+                // Compute weight change by shift cut-point
                 int i=0;
                 do
                 {
-                    balanceWeight += BCB[i]*fPtr[i];
-                    i=BCBf[i];
+                    curWeight += (nextHist[i]<<1)*fPtr[i];
+
+                    // Update BCB and maintain the necklace table of BCB
+                    updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1),linked);
+
+                    i=nextHf[i];
                 }while(i);
-            }
 
-            // Move cut-point to the left
-            if(balanceWeight >= 0)
+                balanceWeight -= curWeight;
+            }
+        }
+        // Move cut-point to the right
+        else if(balanceWeight < 0)
+        {
+            for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
             {
-                for(;balanceWeight >= 0 && curMedianVal > 0; curMedianVal--)
+                float curWeight = 0;
+                int *nextHist = H0 + (curMedianVal+1)*nF;
+                int *nextHf = Hf0 + (curMedianVal+1)*nF;
+
+                // Compute weight change by shift cut-point
+                int i=0;
+                do
                 {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal];
-                    int *nextHf = Hf[curMedianVal];
+                    curWeight += (nextHist[i]<<1)*fPtr[i];
+
+                    // Update BCB and maintain the necklace table of BCB
+                    updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1,linked);
+
+                    i=nextHf[i];
+                }while(i);
+                balanceWeight += curWeight;
+            }
+        }
 
-                    // Compute weight change by shift cut-point
-                    int i=0;
-                    do
-                    {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
+        // Weighted median is found and written to the output image
+        if(curMedianVal != -1)
+        {
+            if(balanceWeight < 0)
+                outImg.ptr<TI>(y)[x] = saturate_cast<TI>(curMedianVal+1);
+            else
+                outImg.ptr<TI>(y)[x] = saturate_cast<TI>(curMedianVal);
+        }
 
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,-(nextHist[i]<<1));
+        // Update joint-histogram and BCB when local window is shifted.
+        int fval,gval,*curHist;
 
-                        i=nextHf[i];
-                    }while(i);
+        // Add entering pixels into joint-histogram and BCB
+        int rownum = y + r + 1;
+        if(rownum < rows)
+        {
+            const TI *inputImgPtr = I.ptr<TI>(rownum);
+            const TF *guideImgPtr = F.ptr<TF>(rownum);
+            const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
-                    balanceWeight -= curWeight;
-                }
-            }
-            // Move cut-point to the right
-            else if(balanceWeight < 0)
+            for(int j=downX;j<=upX;j++)
             {
-                for(;balanceWeight < 0 && curMedianVal != nI-1; curMedianVal++)
+                if(!maskPtr[j])continue;
+
+                fval = inputImgPtr[j];
+                curHist = H0 + fval*nF;
+                gval = guideImgPtr[j];
+
+                // Maintain necklace table of joint-histogram
+                if(!curHist[gval] && gval)
                 {
-                    float curWeight = 0;
-                    int *nextHist = H[curMedianVal+1];
-                    int *nextHf = Hf[curMedianVal+1];
-
-                    // Compute weight change by shift cut-point
-                    int i=0;
-                    do
-                    {
-                        curWeight += (nextHist[i]<<1)*fPtr[i];
-
-                        // Update BCB and maintain the necklace table of BCB
-                        updateBCB(BCB[i],BCBf,BCBb,i,nextHist[i]<<1);
-
-                        i=nextHf[i];
-                    }while(i);
-                    balanceWeight += curWeight;
+                    int *curHf = Hf0 + fval*nF;
+                    int *curHb = Hb0 + fval*nF;
+
+                    int p1=0,p2=curHf[0];
+                    curHf[gval]=p2;
+                    curHb[gval]=p1;
+                    curHf[p1]=curHb[p2]=gval;
                 }
-            }
 
-            // Weighted median is found and written to the output image
-            if(curMedianVal != -1)
-            {
-                if(balanceWeight < 0)
-                    outImg.ptr<int>(y,x)[0] = curMedianVal+1;
-                else
-                    outImg.ptr<int>(y,x)[0] = curMedianVal;
+                curHist[gval]++;
+
+                // Maintain necklace table of BCB
+                updateBCB(BCB[gval],BCBf,BCBb,gval,((fval <= medianVal)<<1)-1,linked);
             }
+        }
 
-            // Update joint-histogram and BCB when local window is shifted.
-            int fval,gval,*curHist;
+        // Delete leaving pixels into joint-histogram and BCB
+        rownum = y - r;
+        if(rownum >= 0)
+        {
+            const TI *inputImgPtr = I.ptr<TI>(rownum);
+            const TF *guideImgPtr = F.ptr<TF>(rownum);
+            const uchar *maskPtr = mask.ptr<uchar>(rownum);
 
-            // Add entering pixels into joint-histogram and BCB
-            int rownum = y + r + 1;
-            if(rownum < rows)
+            for(int j=downX;j<=upX;j++)
             {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
-
-                    for(int j=downX;j<=upX;j++)
-                    {
-                        if(!maskPtr[j])continue;
-
-                        fval = inputImgPtr[j];
-                        curHist = H[fval];
-                        gval = guideImgPtr[j];
-
-                        // Maintain necklace table of joint-histogram
-                        if(!curHist[gval] && gval)
-                        {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
-
-                            int p1=0,p2=curHf[0];
-                            curHf[gval]=p2;
-                            curHb[gval]=p1;
-                            curHf[p1]=curHb[p2]=gval;
-                        }
-
-                        curHist[gval]++;
-
-                        // Maintain necklace table of BCB
-                        updateBCB(BCB[gval],BCBf,BCBb,gval,((fval <= medianVal)<<1)-1);
-                    }
-                }
+                if(!maskPtr[j])continue;
 
+                fval = inputImgPtr[j];
+                curHist = H0 + fval*nF;
+                gval = guideImgPtr[j];
 
-                // Delete leaving pixels into joint-histogram and BCB
-                rownum = y - r;
-                if(rownum >= 0)
+                curHist[gval]--;
+
+                // Maintain necklace table of joint-histogram
+                if(!curHist[gval] && gval)
                 {
-                    int *inputImgPtr = I.ptr<int>(rownum);
-                    int *guideImgPtr = F.ptr<int>(rownum);
-                    uchar *maskPtr = mask.ptr<uchar>(rownum);
-
-                    for(int j=downX;j<=upX;j++)
-                    {
-                        if(!maskPtr[j])continue;
-
-                        fval = inputImgPtr[j];
-                        curHist = H[fval];
-                        gval = guideImgPtr[j];
-
-                        curHist[gval]--;
-
-                        // Maintain necklace table of joint-histogram
-                        if(!curHist[gval] && gval)
-                        {
-                            int *curHf = Hf[fval];
-                            int *curHb = Hb[fval];
-
-                            int p1=curHb[gval],p2=curHf[gval];
-                            curHf[p1]=p2;
-                            curHb[p2]=p1;
-                        }
-
-                        // Maintain necklace table of BCB
-                        updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1);
-                    }
+                    int *curHf = Hf0 + fval*nF;
+                    int *curHb = Hb0 + fval*nF;
+
+                    int p1=curHb[gval],p2=curHf[gval];
+                    curHf[p1]=p2;
+                    curHb[p2]=p1;
                 }
+
+                // Maintain necklace table of BCB
+                updateBCB(BCB[gval],BCBf,BCBb,gval,-((fval <= medianVal)<<1)+1,linked);
+            }
         }
     }
 
-    // Deallocate the memory
+    // Empty the histograms for the next column: only the cells of the last window can be non-zero
+    for(int i=max(0,rows-1-r);i<rows;i++)
     {
-        delete []BCB;
-        delete []BCBf;
-        delete []BCBb;
-        int2D_release(H);
-        int2D_release(Hf);
-        int2D_release(Hb);
+        const TI *IPtr = I.ptr<TI>(i);
+        const TF *FPtr = F.ptr<TF>(i);
+        for(int j=downX;j<=upX;j++)
+        {
+            H0[IPtr[j]*nF + FPtr[j]] = 0;
+            BCB[FPtr[j]] = 0;
+        }
     }
+}
 
-    // end of the function
-    return outImg;
+/***************************************************************
+ * Function: filterCore
+ * Description: joint-histogram filtering of all channels of "Is".
+ *                The columns of all channels are independent and are filtered in parallel,
+ *                each thread reusing its own histogram workspace.
+ ***************************************************************/
+template<typename TI, typename TF>
+void filterCore(std::vector<Mat> &Is, const Mat &F, float **wMap, int r, int nF, int nI, const Mat &mask)
+{
+    int cn = (int)Is.size();
+    int cols = F.cols;
+
+    std::vector<Mat> outImgs(cn);
+    for(int c=0;c<cn;c++)
+        outImgs[c] = Is[c].clone();
+
+    TLSData<HistWorkspace> workspaces;
+    parallel_for_(Range(0, cn*cols), [&](const Range& range)
+    {
+        HistWorkspace &ws = *workspaces.get();
+        ws.create(nI, nF);
+        for(int k=range.start;k<range.end;k++)
+        {
+            int c = k / cols;
+            filterColumn<TI, TF>(Is[c], F, mask, outImgs[c], ws, wMap, k - c*cols, r, nF, nI);
+        }
+    });
+
+    Is.swap(outImgs);
 }
 }
 
@@ -687,7 +731,8 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
     //OUTPUT OF THIS STEP: Is, iMap
     //If I is floating point image, "adaptive quantization" is done in from32FTo32S.
     //The mapping of floating value to integer value is stored in iMap (for each channel).
-    //"Is" stores each channel of "I". The channels are converted to CV_32S type after this step.
+    //"Is" stores each channel of "I". Floating-point channels are converted to CV_32S type after this step,
+    //8-bit channels are filtered as they are.
     vector<float *> iMap(I.channels());
     vector<Mat> Is;
     split(I,Is);
@@ -698,26 +743,38 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
             iMap[i] = new float[nI];
             from32FTo32S(Is[i],Is[i],nI,iMap[i]);
         }
-        else if(I.depth() == CV_8U)
-        {
-            Is[i].convertTo(Is[i],CV_32S);
-        }
     }
 
     //Preprocess F
     //OUTPUT OF THIS STEP: F(new), wMap
     //If "F" is 3-channel image, "clustering feature image" is done in featureIndexing.
-    //If "F" is 1-channel image, featureIndexing only does a type-casting on "F".
-    //The output "F" is CV_32S type, containing indexes of feature values.
+    //If "F" is 1-channel image, featureIndexing keeps "F" as it is.
+    //The output "F" is CV_32S (3-channel input) or CV_8U (1-channel input) type, containing indexes of feature values.
     //"wMap" is a 2D array that defines the distance between each pair of feature indexes.
     // wMap[i][j] is the weight between feature index "i" and "j".
     float **wMap = NULL;
     featureIndexing(F, wMap, nF, float(sigma), weightType);
 
+    Mat M = mask.getMat();
+    if(M.empty())
+        M = Mat(I.size(), CV_8U, Scalar(1));
+    CV_Assert(M.size() == I.size() && M.type() == CV_8UC1);
+
     //Filtering - Joint-Histogram Framework
-    for(int i=0; i<(int)Is.size(); i++)
+    //8-bit images and 1-channel feature images are read directly, without conversion to 32S.
+    if(I.depth() == CV_8U)
     {
-        Is[i] = filterCore(Is[i], F, wMap, r, nF, nI, mask.getMat());
+        if(F.depth() == CV_8U)
+            filterCore<uchar, uchar>(Is, F, wMap, r, nF, nI, M);
+        else
+            filterCore<uchar, int>(Is, F, wMap, r, nF, nI, M);
+    }
+    else
+    {
+        if(F.depth() == CV_8U)
+            filterCore<int, uchar>(Is, F, wMap, r, nF, nI, M);
+        else
+            filterCore<int, int>(Is, F, wMap, r, nF, nI, M);
     }
     float2D_release(wMap);
 
@@ -730,10 +787,6 @@ void weightedMedianFilter(InputArray joint, InputArray src, OutputArray dst, int
             from32STo32F(Is[i],Is[i],iMap[i]);
             delete []iMap[i];
         }
-        else if(I.depth()==CV_8U)
-        {
-            Is[i].convertTo(Is[i],CV_8U);
-        }
     }
 
     //merge the channels
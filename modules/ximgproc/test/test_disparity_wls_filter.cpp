@@ -113,5 +113,45 @@ TEST_P(DisparityWLSFilterTest, MultiThreadReproducibility)
 }
 INSTANTIATE_TEST_CASE_P(FullSet,DisparityWLSFilterTest,Combine(Values(szODD, szQVGA), SrcTypes::all(), GuideTypes::all(),Values(true,false),Values(true,false)));
 
+TEST(DisparityWLSFilterTest, VideoModeReusesUnchangedTiles)
+{
+    for (int use_conf = 0; use_conf <= 1; use_conf++)
+    {
+        Size size(szQVGA);
+        RNG rng(0);
+        Mat left(size, CV_8UC3);
+        rng.fill(left, RNG::UNIFORM, 0, 255);
+        int max_disp = 32;
+        Mat left_disp(size, CV_16S), right_disp(size, CV_16S);
+        rng.fill(left_disp, RNG::UNIFORM, 0, 16*max_disp);
+        rng.fill(right_disp, RNG::UNIFORM, -16*max_disp, 0);
+        Rect ROI(max_disp, 0, size.width - max_disp, size.height);
+
+        Ptr<DisparityWLSFilter> reference = createDisparityWLSFilterGeneric(use_conf != 0);
+        Ptr<DisparityWLSFilter> video = createDisparityWLSFilterGeneric(use_conf != 0);
+        video->setVideoMode(true);
+        EXPECT_TRUE(video->getVideoMode());
+
+        Mat res_ref, res0, res1, res2;
+        reference->filter(left_disp, left, res_ref, right_disp, ROI);
+        video->filter(left_disp, left, res0, right_disp, ROI);
+        EXPECT_EQ(0, cvtest::norm(res_ref, res0, NORM_INF));
+
+        // nothing changed: the previous result is returned
+        video->filter(left_disp, left, res1, right_disp, ROI);
+        EXPECT_EQ(0, cvtest::norm(res0, res1, NORM_INF));
+
+        // a change in the top left corner leaves the far tiles untouched
+        Rect patch(ROI.x + 8, 8, 16, 16);
+        left(patch).setTo(Scalar::all(128));
+        left_disp(patch).setTo(Scalar::all(160));
+        right_disp(patch).setTo(Scalar::all(-160));
+        video->filter(left_disp, left, res2, right_disp, ROI);
+        Rect far(ROI.x + ROI.width / 2, ROI.height / 2, ROI.width / 2, ROI.height / 2);
+        EXPECT_EQ(0, cvtest::norm(res0(far), res2(far), NORM_INF));
+        EXPECT_GT(cvtest::norm(res0(patch), res2(patch), NORM_INF), 0);
+    }
+}
+
 
 }} // namespace
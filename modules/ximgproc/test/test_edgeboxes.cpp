@@ -45,4 +45,48 @@ TEST(ximgproc_Edgeboxes, regression)
     EXPECT_EQ(expectedProposal.width, boxes[0].width);
 }
 
+TEST(ximgproc_Edgeboxes, reuse_edge_groups)
+{
+    cv::String testImagePath = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/" + "pascal_voc_bird.png";
+    Mat testImg = imread(testImagePath);
+    ASSERT_FALSE(testImg.empty()) << "Could not load input image " << testImagePath;
+    cvtColor(testImg, testImg, COLOR_BGR2RGB);
+    testImg.convertTo(testImg, CV_32F, 1.0 / 255.0f);
+
+    cv::String model_path = cvtest::TS::ptr()->get_data_path() + "cv/ximgproc/" + "model.yml.gz";
+    Ptr<StructuredEdgeDetection> sed = createStructuredEdgeDetection(model_path);
+    Mat edgeImage, edgeOrientations;
+    sed->detectEdges(testImg, edgeImage);
+    sed->computeOrientation(edgeImage, edgeOrientations);
+
+    Ptr<EdgeBoxes> edgeboxes = createEdgeBoxes();
+    edgeboxes->setMaxBoxes(50);
+    edgeboxes->computeEdgeGroups(edgeImage, edgeOrientations);
+
+    //Several box search settings evaluated on the same edge groups
+    //must match the one-shot call with the same settings.
+    const float betas[] = { 0.75f, 0.5f };
+    for (size_t i = 0; i < sizeof(betas) / sizeof(betas[0]); i++)
+    {
+        edgeboxes->setBeta(betas[i]);
+
+        std::vector<Rect> boxes, expectedBoxes;
+        std::vector<float> scores, expectedScores;
+        edgeboxes->getBoundingBoxes(boxes, scores);
+
+        Ptr<EdgeBoxes> reference = createEdgeBoxes();
+        reference->setMaxBoxes(50);
+        reference->setBeta(betas[i]);
+        reference->getBoundingBoxes(edgeImage, edgeOrientations, expectedBoxes, expectedScores);
+
+        ASSERT_EQ(expectedBoxes.size(), boxes.size());
+        ASSERT_EQ(expectedScores.size(), scores.size());
+        for (size_t j = 0; j < boxes.size(); j++)
+        {
+            EXPECT_EQ(expectedBoxes[j], boxes[j]);
+            EXPECT_EQ(expectedScores[j], scores[j]);
+        }
+    }
+}
+
 }} // namespace
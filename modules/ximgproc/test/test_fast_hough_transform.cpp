@@ -459,4 +459,42 @@ INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformTest,
 #undef FHT_ALL_DEPTHS
 #undef FHT_ALL_CHANNELS
 
+//----------------------vectorized operations----------------------------------
+typedef tuple<int, int> Op_Depth;
+typedef TestWithParam<Op_Depth> FastHoughTransformOpTest;
+
+// The results of the vectorized 8u, 16u and 32f paths must match the results of the
+// generic path for a wider depth when no saturation occurs.
+TEST_P(FastHoughTransformOpTest, matchesGenericDepth)
+{
+    int const op    = get<0>(GetParam());
+    int const depth = get<1>(GetParam());
+    int const refDepth = depth == CV_8U ? CV_16S : depth == CV_16U ? CV_32S : CV_64F;
+
+    RNG rng(0x5eed);
+    Mat src(61, 47, CV_8UC1);
+    rng.fill(src, RNG::UNIFORM, 0, 256);
+    if (op == FHT_ADD && depth == CV_8U)
+        src &= Scalar::all(3);  // line sums must not saturate
+
+    Mat ref;
+    FastHoughTransform(src, ref, refDepth, ARO_315_135, op);
+
+    Ptr<FastHoughTransformer> transformer = createFastHoughTransformer(depth, ARO_315_135, op);
+    for (int iter = 0; iter < 2; iter++)
+    {
+        Mat fht;
+        transformer->apply(src, fht);
+        ASSERT_EQ(depth, fht.depth());
+        ASSERT_EQ(ref.size(), fht.size());
+
+        fht.convertTo(fht, refDepth);
+        EXPECT_EQ(0, cvtest::norm(ref, fht, NORM_INF)) << "iteration " << iter;
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(FullSet, FastHoughTransformOpTest,
+                        Combine(Values((int)FHT_MIN, (int)FHT_MAX, (int)FHT_ADD, (int)FHT_AVE),
+                                Values(CV_8U, CV_16U, CV_32F)));
+
 }} // namespace
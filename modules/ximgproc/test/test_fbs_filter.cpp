@@ -123,6 +123,34 @@ TEST(FastBilateralSolverTest, ReferenceAccuracy)
 #endif
 }
 
+TEST(FastBilateralSolverTest, ReuseGridAndWarmStart)
+{
+    Size sz(320, 240);
+    Mat guide1(sz, CV_8UC3), guide2(sz, CV_8UC3);
+    randu(guide1, 0, 255);
+    randu(guide2, 0, 255);
+    Mat src(sz, CV_8UC1);
+    randu(src, 0, 255);
+    Mat confidence(sz, CV_MAKE_TYPE(CV_8U, 1), 255);
+
+    Ptr<FastBilateralSolverFilter> fbs = createFastBilateralSolverFilter(guide1, 16.0, 16.0, 16.0);
+    Mat res, ref;
+    fbs->filter(src, confidence, res);
+    fbs->setGuide(guide2);
+    fbs->filter(src, confidence, res);
+
+    fastBilateralSolverFilter(guide2, src, confidence, ref, 16.0, 16.0, 16.0);
+    EXPECT_EQ(0, cvtest::norm(res, ref, NORM_INF));
+
+    // starting from the solution of the same frame should stay at the solution
+    fbs->setWarmStart(true);
+    ASSERT_TRUE(fbs->getWarmStart());
+    Mat warm;
+    fbs->filter(src, confidence, warm);
+    fbs->filter(src, confidence, warm);
+    EXPECT_LE(cvtest::norm(warm, ref, NORM_L1)/src.total(), 1.0);
+}
+
 INSTANTIATE_TEST_CASE_P(FullSet, FastBilateralSolverTest,Combine(Values(szODD, szQVGA), SrcTypes::all(), GuideTypes::all()));
 
 }
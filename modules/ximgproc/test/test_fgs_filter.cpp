@@ -64,6 +64,25 @@ TEST(FastGlobalSmootherTest, ReferenceAccuracy)
     EXPECT_LE(cvtest::norm(res, ref, NORM_INF), 1);
 }
 
+TEST(FastGlobalSmootherTest, ReuseWithNewGuide)
+{
+    Size sz(320, 240);
+    Mat guide1(sz, CV_8UC3), guide2(sz, CV_8UC3);
+    randu(guide1, 0, 255);
+    randu(guide2, 0, 255);
+    Mat src(sz, CV_8UC1);
+    randu(src, 0, 255);
+
+    Ptr<FastGlobalSmootherFilter> fgs = createFastGlobalSmootherFilter(guide1, 1000.0, 10.0);
+    Mat res, ref;
+    fgs->filter(src, res);
+    fgs->setGuide(guide2);
+    fgs->filter(src, res);
+
+    fastGlobalSmootherFilter(guide2, src, ref, 1000.0, 10.0);
+    EXPECT_EQ(0, cvtest::norm(res, ref, NORM_INF));
+}
+
 TEST_P(FastGlobalSmootherTest, MultiThreadReproducibility)
 {
     if (cv::getNumberOfCPUs() == 1)
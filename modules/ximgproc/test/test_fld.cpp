@@ -199,5 +199,31 @@ TEST_F(ximgproc_FLD, rotatedRect)
     ASSERT_EQ(EPOCHS, passedtests);
 }
 
+TEST_F(ximgproc_FLD, batch)
+{
+    vector<Mat> images;
+    for (int i = 0; i < 4; ++i)
+    {
+        GenerateRotatedRect(test_image);
+        images.push_back(test_image.clone());
+    }
+
+    Ptr<FastLineDetector> detector = createFastLineDetector();
+    for (int frame = 0; frame < 2; ++frame)
+    {
+        vector<vector<Vec4f> > batch_lines;
+        detector->detectBatch(images, batch_lines);
+        ASSERT_EQ(images.size(), batch_lines.size());
+
+        for (size_t i = 0; i < images.size(); ++i)
+        {
+            detector->detect(images[i], lines);
+            ASSERT_EQ(lines.size(), batch_lines[i].size());
+            for (size_t j = 0; j < lines.size(); ++j)
+                EXPECT_EQ(lines[j], batch_lines[i][j]);
+        }
+    }
+}
+
 
 }} // namespace
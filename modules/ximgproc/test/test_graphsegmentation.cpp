@@ -0,0 +1,67 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+static void checkLabels(const Mat& labels, const Size& size, int& nb_segs)
+{
+    ASSERT_EQ(CV_32SC1, labels.type());
+    ASSERT_EQ(size, labels.size());
+
+    double minVal, maxVal;
+    minMaxLoc(labels, &minVal, &maxVal);
+    EXPECT_EQ(0, minVal);
+    nb_segs = (int)maxVal + 1;
+
+    // ids are sequential
+    std::vector<int> used(nb_segs, 0);
+    for (int i = 0; i < labels.rows; i++)
+        for (int j = 0; j < labels.cols; j++)
+            used[labels.at<int>(i, j)] = 1;
+    EXPECT_EQ(nb_segs, countNonZero(used));
+}
+
+TEST(ximgproc_GraphSegmentation, regression)
+{
+    Mat img(120, 160, CV_8UC3, Scalar::all(0));
+    rectangle(img, Rect(20, 20, 60, 50), Scalar(255, 0, 0), FILLED);
+    circle(img, Point(110, 80), 25, Scalar(0, 255, 0), FILLED);
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation(0.5, 300, 50);
+    Mat labels;
+    gs->processImage(img, labels);
+
+    int nb_segs = 0;
+    checkLabels(labels, img.size(), nb_segs);
+    EXPECT_GE(nb_segs, 3);
+    EXPECT_NE(labels.at<int>(40, 40), labels.at<int>(5, 5));
+    EXPECT_NE(labels.at<int>(80, 110), labels.at<int>(5, 5));
+    EXPECT_NE(labels.at<int>(40, 40), labels.at<int>(80, 110));
+}
+
+TEST(ximgproc_GraphSegmentation, tiled)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+
+    Ptr<GraphSegmentation> gs = createGraphSegmentation();
+    Mat labels;
+    gs->processImage(img, labels);
+    int nb_segs = 0;
+    checkLabels(labels, img.size(), nb_segs);
+
+    gs->setTileSize(128);
+    EXPECT_EQ(128, gs->getTileSize());
+    Mat tiledLabels;
+    gs->processImage(img, tiledLabels);
+    int nb_tiled_segs = 0;
+    checkLabels(tiledLabels, img.size(), nb_tiled_segs);
+
+    EXPECT_NEAR(nb_segs, nb_tiled_segs, 0.25 * nb_segs);
+}
+
+}} // namespace
@@ -26,4 +26,76 @@ TEST(ximgproc_niBlackThreshold, sauvola)
     EXPECT_EQ(255, dst.at<uchar>(2, 2));
 }
 
+// Threshold computed with floating-point filters over the whole image
+static Mat referenceThreshold(const Mat& src, int blockSize, double k, int method, double r)
+{
+    Mat mean, sqmean, variance, stddev, thresh;
+    boxFilter(src, mean, CV_32F, Size(blockSize, blockSize), Point(-1, -1), true, BORDER_REPLICATE);
+    sqrBoxFilter(src, sqmean, CV_32F, Size(blockSize, blockSize), Point(-1, -1), true, BORDER_REPLICATE);
+    variance = max(sqmean - mean.mul(mean), 0);
+    sqrt(variance, stddev);
+    double srcMin, stddevMax;
+    switch (method)
+    {
+    case BINARIZATION_NIBLACK:
+        thresh = mean + stddev * k;
+        break;
+    case BINARIZATION_SAUVOLA:
+        thresh = mean.mul(1. + k * (stddev / r - 1.));
+        break;
+    case BINARIZATION_WOLF:
+        minMaxIdx(src, &srcMin);
+        minMaxIdx(stddev, NULL, &stddevMax);
+        thresh = mean - k * (mean - srcMin - stddev.mul(mean - srcMin) / stddevMax);
+        break;
+    default:
+        sqrt(variance + sqmean, thresh);
+        thresh = mean + k * thresh;
+        break;
+    }
+    thresh.convertTo(thresh, CV_8U);
+    return thresh;
+}
+
+typedef tuple<int, int> NiblackParams;
+typedef TestWithParam<NiblackParams> ximgproc_niBlackThreshold_methods;
+
+TEST_P(ximgproc_niBlackThreshold_methods, accuracy)
+{
+    int method = get<0>(GetParam());
+    int blockSize = get<1>(GetParam());
+    double k = method == BINARIZATION_NIBLACK ? -0.2 : 0.3;
+    double r = 128;
+
+    // odd width to exercise the scalar tails, several bands of rows
+    Mat src(203, 131, CV_8UC1);
+    RNG rng(0x5a1e);
+    rng.fill(src, RNG::UNIFORM, 0, 256);
+    GaussianBlur(src, src, Size(5, 5), 2);
+
+    Mat thresh = referenceThreshold(src, blockSize, k, method, r);
+    const int types[] = { THRESH_BINARY, THRESH_BINARY_INV, THRESH_TRUNC, THRESH_TOZERO, THRESH_TOZERO_INV };
+    for (int t = 0; t < 5; t++)
+    {
+        Mat dst, ref;
+        niBlackThreshold(src, dst, 200, types[t], blockSize, k, method, r);
+        Mat gt = src > thresh;
+        switch (types[t])
+        {
+        case THRESH_BINARY:     ref = Mat::zeros(src.size(), CV_8U); ref.setTo(200, gt); break;
+        case THRESH_BINARY_INV: ref = Mat(src.size(), CV_8U, Scalar(200)); ref.setTo(0, gt); break;
+        case THRESH_TRUNC:      ref = min(src, thresh); break;
+        case THRESH_TOZERO:     ref = Mat::zeros(src.size(), CV_8U); src.copyTo(ref, gt); break;
+        default:                ref = src.clone(); ref.setTo(0, gt); break;
+        }
+        ASSERT_EQ(CV_8UC1, dst.type());
+        // the local statistics may round differently from the filters by one float ulp
+        EXPECT_LE(countNonZero(dst != ref), (int)src.total() / 500) << "type=" << types[t];
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(/**/, ximgproc_niBlackThreshold_methods, Combine(
+    Values((int)BINARIZATION_NIBLACK, (int)BINARIZATION_SAUVOLA, (int)BINARIZATION_WOLF, (int)BINARIZATION_NICK),
+    Values(3, 15, 81)));
+
 }} // namespace
@@ -245,5 +245,68 @@ TEST_P(RL_Paint, same_result)
 
 INSTANTIATE_TEST_CASE_P(TypicalSET, RL_Paint, Values(CV_8U, CV_16U, CV_16S, CV_32F, CV_64F));
 
+typedef tuple<int, int> RLCCParams;
+
+class RL_ConnectedComponents : public RLTestBase, public ::testing::TestWithParam<RLCCParams>
+{
+public:
+    RL_ConnectedComponents() { }
+protected:
+    virtual void SetUp() { setUp_impl(); }
+};
+
+TEST_P(RL_ConnectedComponents, same_as_pixel_labeling)
+{
+    RLCCParams param = GetParam();
+    int image = get<0>(param);
+    int connectivity = get<1>(param);
+
+    // blurred noise gives blobs of various shapes
+    Mat rle = test_image_rle[0];
+    if (image == 1)
+    {
+        Mat noise, blurred;
+        generateRandomImage(noise);
+        GaussianBlur(noise, blurred, Size(7, 7), 2.0);
+        rl::threshold(blurred, rle, 135.0, THRESH_BINARY);
+    }
+    Mat pix = Mat::zeros(img_size, CV_8UC1);
+    rl::paint(pix, rle, Scalar(255.0));
+
+    Mat labelsRLE, statsRLE, labelsPix, statsPix, centroids;
+    int nRLE = rl::connectedComponentsWithStats(rle, labelsRLE, statsRLE, connectivity);
+    int nPix = cv::connectedComponentsWithStats(pix, labelsPix, statsPix, centroids, connectivity, CV_32S);
+    ASSERT_EQ(nPix - 1, nRLE); // no background label
+    ASSERT_EQ(rle.rows - 1, labelsRLE.rows);
+    ASSERT_EQ(nRLE, statsRLE.rows);
+
+    std::vector<int> pixLabelOf(nRLE, -1), seen(nPix, 0);
+    for (int i = 1; i < rle.rows; ++i)
+    {
+        Point3i run = rle.at<Point3i>(i);
+        int l = labelsRLE.at<int>(i - 1);
+        ASSERT_GE(l, 0);
+        ASSERT_LT(l, nRLE);
+        for (int x = run.x; x <= run.y; ++x)
+        {
+            int lp = labelsPix.at<int>(run.z, x);
+            if (pixLabelOf[l] < 0)
+            {
+                ASSERT_EQ(0, seen[lp]);
+                seen[lp] = 1;
+                pixLabelOf[l] = lp;
+            }
+            ASSERT_EQ(pixLabelOf[l], lp);
+        }
+    }
+    for (int l = 0; l < nRLE; ++l)
+    {
+        for (int c = 0; c < CC_STAT_MAX; ++c)
+            EXPECT_EQ(statsPix.at<int>(pixLabelOf[l], c), statsRLE.at<int>(l, c));
+    }
+}
+
+INSTANTIATE_TEST_CASE_P(TypicalSET, RL_ConnectedComponents, Combine(Values(0, 1), Values(4, 8)));
+
+}
 }
-}
\ No newline at end of file
@@ -0,0 +1,66 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+static Mat computeSEEDSLabels(const Mat& img, int& numSuperpixels)
+{
+    Ptr<SuperpixelSEEDS> seeds = createSuperpixelSEEDS(img.cols, img.rows, img.channels(), 200, 4, 2, 5, true);
+    seeds->iterate(img, 4);
+    numSuperpixels = seeds->getNumberOfSuperpixels();
+    Mat labels;
+    seeds->getLabels(labels);
+    return labels.clone();
+}
+
+TEST(ximgproc_SuperpixelSEEDS, sanity)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    Mat hsv;
+    cvtColor(img, hsv, COLOR_BGR2HSV);
+
+    int numSuperpixels = 0;
+    Mat labels = computeSEEDSLabels(hsv, numSuperpixels);
+    ASSERT_EQ(CV_32SC1, labels.type());
+    ASSERT_EQ(img.size(), labels.size());
+    ASSERT_GT(numSuperpixels, 0);
+
+    // the result does not depend on the number of threads
+    const int nthreads = getNumThreads();
+    setNumThreads(1);
+    int numSuperpixels1 = 0;
+    Mat labels1 = computeSEEDSLabels(hsv, numSuperpixels1);
+    setNumThreads(nthreads);
+    EXPECT_EQ(numSuperpixels, numSuperpixels1);
+    EXPECT_EQ(0, cvtest::norm(labels, labels1, NORM_INF));
+
+    double minLabel = 0, maxLabel = 0;
+    minMaxLoc(labels, &minLabel, &maxLabel);
+    ASSERT_GE(minLabel, 0);
+    ASSERT_LT(maxLabel, numSuperpixels);
+
+    // most of the initial superpixels survive, and each one is essentially a single
+    // connected region: its largest 8-connected component holds most of its pixels
+    int nonEmpty = 0;
+    for (int label = 0; label < numSuperpixels; label++)
+    {
+        Mat mask = labels == label;
+        int area = countNonZero(mask);
+        if (area == 0)
+            continue;
+        nonEmpty++;
+
+        Mat components, stats, centroids;
+        int n = connectedComponentsWithStats(mask, components, stats, centroids, 8);
+        int largest = 0;
+        for (int c = 1; c < n; c++)
+            largest = std::max(largest, stats.at<int>(c, CC_STAT_AREA));
+        EXPECT_GE(largest, 0.9 * area) << "label " << label;
+    }
+    EXPECT_GE(nonEmpty, numSuperpixels / 2);
+}
+
+}} // namespace
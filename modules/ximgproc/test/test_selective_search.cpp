@@ -0,0 +1,104 @@
+// This file is part of OpenCV project.
+// It is subject to the license terms in the LICENSE file found in the top-level directory
+// of this distribution and at http://opencv.org/license.html.
+#include "test_precomp.hpp"
+
+namespace opencv_test { namespace {
+
+using namespace cv::ximgproc::segmentation;
+
+TEST(ximgproc_SelectiveSearchSegmentation, smoke)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    resize(img, img, Size(), 0.25, 0.25, INTER_AREA);
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->switchToSelectiveSearchFast();
+
+    std::vector<Rect> rects;
+    ss->process(rects);
+    ASSERT_FALSE(rects.empty());
+
+    const Rect imageRect(Point(), img.size());
+    bool hasImageRect = false;
+    for (size_t i = 0; i < rects.size(); i++)
+    {
+        EXPECT_EQ(rects[i], rects[i] & imageRect);
+        EXPECT_FALSE(rects[i].empty());
+        hasImageRect = hasImageRect || rects[i] == imageRect;
+    }
+    // the last merge of every grouping covers the whole image
+    EXPECT_TRUE(hasImageRect);
+}
+
+typedef std::tuple<int, int, int, int> RectKey;
+
+static std::set<RectKey> toSet(const std::vector<Rect>& rects)
+{
+    std::set<RectKey> result;
+    for (size_t i = 0; i < rects.size(); i++)
+        result.insert(RectKey(rects[i].x, rects[i].y, rects[i].width, rects[i].height));
+    return result;
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, shared_strategy)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    resize(img, img, Size(), 0.25, 0.25, INTER_AREA);
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->switchToSingleStrategy();
+
+    // the same strategy object added twice produces the same boxes as once
+    Ptr<SelectiveSearchSegmentationStrategy> fill = createSelectiveSearchSegmentationStrategyFill();
+    ss->clearStrategies();
+    ss->addStrategy(fill);
+    std::vector<Rect> once;
+    ss->process(once);
+
+    ss->addStrategy(fill);
+    std::vector<Rect> twice;
+    ss->process(twice);
+
+    ASSERT_FALSE(once.empty());
+    EXPECT_TRUE(toSet(once) == toSet(twice));
+}
+
+TEST(ximgproc_SelectiveSearchSegmentation, shared_sub_strategy)
+{
+    Mat img = imread(cvtest::findDataFile("cv/shared/lena.png"), IMREAD_COLOR);
+    ASSERT_FALSE(img.empty());
+    resize(img, img, Size(), 0.25, 0.25, INTER_AREA);
+
+    Ptr<SelectiveSearchSegmentation> ss = createSelectiveSearchSegmentation();
+    ss->setBaseImage(img);
+    ss->switchToSingleStrategy();
+
+    // two combined strategies sharing their fill sub-strategy...
+    Ptr<SelectiveSearchSegmentationStrategy> fill = createSelectiveSearchSegmentationStrategyFill();
+    ss->clearStrategies();
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyMultiple(createSelectiveSearchSegmentationStrategyColor(), fill));
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyMultiple(createSelectiveSearchSegmentationStrategySize(), fill));
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyTexture());
+    std::vector<Rect> shared;
+    ss->process(shared);
+
+    // ...produce the same boxes as with separate sub-strategies
+    ss->clearStrategies();
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyMultiple(createSelectiveSearchSegmentationStrategyColor(),
+                                                                      createSelectiveSearchSegmentationStrategyFill()));
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyMultiple(createSelectiveSearchSegmentationStrategySize(),
+                                                                      createSelectiveSearchSegmentationStrategyFill()));
+    ss->addStrategy(createSelectiveSearchSegmentationStrategyTexture());
+    std::vector<Rect> separate;
+    ss->process(separate);
+
+    ASSERT_FALSE(separate.empty());
+    EXPECT_TRUE(toSet(shared) == toSet(separate));
+}
+
+}} // namespace
@@ -201,5 +201,57 @@ TEST_P(InterpolatorTest, MultiThreadReproducibility)
 }
 INSTANTIATE_TEST_CASE_P(FullSet,InterpolatorTest, Combine(Values(szODD,szVGA), GuideTypes::all()));
 
+TEST(InterpolatorTest, GeodesicCacheReuse)
+{
+    Size size(szVGA);
+    RNG rng(0);
+    Mat from(size, CV_8UC3);
+    randu(from, 0, 255);
+    GaussianBlur(from, from, Size(5, 5), 2.0);
+
+    vector<Point2f> from_points, to_points, shifted_points;
+    for (int i = 0; i < 2000; i++)
+    {
+        Point2f p(rng.uniform(0.01f, (float)size.width - 1.01f), rng.uniform(0.01f, (float)size.height - 1.01f));
+        Point2f d(rng.uniform(-5.f, 5.f), rng.uniform(-5.f, 5.f));
+        from_points.push_back(p);
+        to_points.push_back(p + d);
+        shifted_points.push_back(p + d + Point2f(1.f, -2.f));
+    }
+
+    {
+        Ptr<EdgeAwareInterpolator> reference = createEdgeAwareInterpolator();
+        Ptr<EdgeAwareInterpolator> cached = createEdgeAwareInterpolator();
+        cached->setUseGeodesicCache(true);
+        EXPECT_TRUE(cached->getUseGeodesicCache());
+
+        Mat res_ref, res_cached, labels_ref, labels_cached, dist_ref, dist_cached;
+        cached->interpolate(from, from_points, Mat(), to_points, res_cached);
+        // the second call only changes the target positions and reuses the geodesic structures
+        cached->interpolate(from, from_points, Mat(), shifted_points, res_cached);
+        reference->interpolate(from, from_points, Mat(), shifted_points, res_ref);
+        EXPECT_EQ(0, cvtest::norm(res_ref, res_cached, NORM_INF));
+
+        reference->getGeodesicNeighbors(labels_ref, dist_ref);
+        cached->getGeodesicNeighbors(labels_cached, dist_cached);
+        ASSERT_EQ((int)from_points.size(), labels_cached.rows);
+        EXPECT_EQ(0, cvtest::norm(labels_ref, labels_cached, NORM_INF));
+        EXPECT_EQ(0, cvtest::norm(dist_ref, dist_cached, NORM_INF));
+    }
+
+    {
+        Ptr<RICInterpolator> reference = createRICInterpolator();
+        Ptr<RICInterpolator> cached = createRICInterpolator();
+        cached->setUseGeodesicCache(true);
+        EXPECT_TRUE(cached->getUseGeodesicCache());
+
+        Mat res_ref, res_cached;
+        cached->interpolate(from, from_points, Mat(), to_points, res_cached);
+        cached->interpolate(from, from_points, Mat(), shifted_points, res_cached);
+        reference->interpolate(from, from_points, Mat(), shifted_points, res_ref);
+        EXPECT_EQ(0, cvtest::norm(res_ref, res_cached, NORM_INF));
+    }
+}
+
 
 }} // namespace
@@ -48,5 +48,80 @@ TEST(ximgproc_Thinning, simple_GUOHALL)
 #endif
 }
 
+// Straightforward implementation: every iteration examines all the pixels
+static void thinningReference(const Mat& src, Mat& dst, int thinningType)
+{
+    Mat img = src / 255;
+    for (bool changed = true; changed; )
+    {
+        changed = false;
+        for (int iter = 0; iter < 2; iter++)
+        {
+            Mat marker = Mat::zeros(img.size(), CV_8UC1);
+            for (int i = 1; i < img.rows - 1; i++)
+            {
+                for (int j = 1; j < img.cols - 1; j++)
+                {
+                    int p2 = img.at<uchar>(i-1, j),   p3 = img.at<uchar>(i-1, j+1);
+                    int p4 = img.at<uchar>(i, j+1),   p5 = img.at<uchar>(i+1, j+1);
+                    int p6 = img.at<uchar>(i+1, j),   p7 = img.at<uchar>(i+1, j-1);
+                    int p8 = img.at<uchar>(i, j-1),   p9 = img.at<uchar>(i-1, j-1);
+                    bool remove;
+                    if (thinningType == THINNING_ZHANGSUEN)
+                    {
+                        int A  = (p2 == 0 && p3 == 1) + (p3 == 0 && p4 == 1) +
+                                 (p4 == 0 && p5 == 1) + (p5 == 0 && p6 == 1) +
+                                 (p6 == 0 && p7 == 1) + (p7 == 0 && p8 == 1) +
+                                 (p8 == 0 && p9 == 1) + (p9 == 0 && p2 == 1);
+                        int B  = p2 + p3 + p4 + p5 + p6 + p7 + p8 + p9;
+                        int m1 = iter == 0 ? (p2 * p4 * p6) : (p2 * p4 * p8);
+                        int m2 = iter == 0 ? (p4 * p6 * p8) : (p2 * p6 * p8);
+                        remove = A == 1 && B >= 2 && B <= 6 && m1 == 0 && m2 == 0;
+                    }
+                    else
+                    {
+                        int C  = ((!p2) & (p3 | p4)) + ((!p4) & (p5 | p6)) +
+                                 ((!p6) & (p7 | p8)) + ((!p8) & (p9 | p2));
+                        int N1 = (p9 | p2) + (p3 | p4) + (p5 | p6) + (p7 | p8);
+                        int N2 = (p2 | p3) + (p4 | p5) + (p6 | p7) + (p8 | p9);
+                        int N  = std::min(N1, N2);
+                        int m  = iter == 0 ? ((p6 | p7 | (!p9)) & p8) : ((p2 | p3 | (!p5)) & p4);
+                        remove = C == 1 && N >= 2 && N <= 3 && m == 0;
+                    }
+                    if (remove && img.at<uchar>(i, j))
+                    {
+                        marker.at<uchar>(i, j) = 1;
+                        changed = true;
+                    }
+                }
+            }
+            img &= ~marker;
+        }
+    }
+    dst = img * 255;
+}
+
+TEST(ximgproc_Thinning, reference)
+{
+    Mat src;
+    createTestImage(src);
+    RNG rng(0x7417);
+    for (int i = 0; i < 40; i++)
+    {
+        Point p1(rng.uniform(0, src.cols), rng.uniform(0, src.rows));
+        Point p2(rng.uniform(0, src.cols), rng.uniform(0, src.rows));
+        line(src, p1, p2, Scalar(255), rng.uniform(1, 8));
+    }
+
+    const int types[] = { THINNING_ZHANGSUEN, THINNING_GUOHALL };
+    for (int t = 0; t < 2; t++)
+    {
+        Mat dst, ref;
+        thinning(src, dst, types[t]);
+        thinningReference(src, ref, types[t]);
+        EXPECT_EQ(0, cvtest::norm(dst, ref, NORM_INF)) << "thinning type " << types[t];
+    }
+}
+
 
 }} // namespace